@@ -0,0 +1,267 @@
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../InterestRateModels/ShortRateModels.h"
+
+/*
+ Strong convergence benchmark of the Euler, Milstein and adaptive schemes.
+
+ Every run follows the same Brownian paths: the grid increments come from
+ the counter-based source, and finer steps split them with the Brownian
+ bridge draws that AdaptiveScheme<> uses, so each scheme can be compared
+ path by path with a reference of uniform Milstein steps 2^10 times finer
+ than the grid. The error is the root mean square of the difference in the
+ rate at the horizon. Paths on which a scheme leaves the domain of the
+ model (a negative CEV rate gives NaN powers) are counted as failures
+ rather than errors, and paths on which the reference fails are left out.
+ The timings run the same schemes through the path engine.
+
+ Both models violate the Feller condition, so many paths spend time near
+ zero where the diffusion is steep; that is where uniform steps stop
+ converging and the adaptive scheme spends its steps.
+ */
+
+const double timeHorizon = 1.0;
+const double gridStep = 1.0 / 16.0;
+const int referenceRefinements = 10;
+const std::uint64_t seed = 7;
+
+/*
+ The error of one scheme against the reference.
+ */
+struct SchemeError
+{
+    double rootMeanSquareError = 0.0;
+    double stepsPerPath = 0.0;
+    int failedPaths = 0;
+};
+
+/*
+ Splits the standard normal increment of a step into those of its 2^refinements
+ equal substeps, along the refinement tree of bridgeMidpointNormal().
+
+ @param bridgeStream The substream of the path that holds the bridge draws.
+ @param node The node of the step in the tree.
+ @param randomIncrement The standard normal increment of the step.
+ @param refinements The number of times to halve the step.
+ @param increments Receives the standard normal increments of the substeps.
+ */
+void refineIncrement(
+    const CounterRandomStream& bridgeStream,
+    const std::uint32_t& node,
+    const double& randomIncrement,
+    const int& refinements,
+    double* increments)
+{
+    if (refinements == 0)
+    {
+        increments[0] = randomIncrement;
+        return;
+    }
+    const double halfSquareRoot = 0.70710678118654752440;
+    double midpointNormal = bridgeMidpointNormal(bridgeStream, node);
+    refineIncrement(bridgeStream, 2 * node, halfSquareRoot * (randomIncrement + midpointNormal), refinements - 1, increments);
+    refineIncrement(bridgeStream, 2 * node + 1, halfSquareRoot * (randomIncrement - midpointNormal), refinements - 1, increments + (1 << (refinements - 1)));
+}
+
+/*
+ Returns the rate at the horizon of every path with uniform steps 2^refinements times finer than the grid.
+
+ @param model The model to simulate.
+ @param milstein Whether to take Milstein steps rather than Euler steps.
+ @param refinements The number of times to halve the grid step.
+ @param numberOfPaths The number of paths.
+ */
+template <typename Model>
+std::vector<double> uniformTerminalRates(const Model& model, const bool& milstein, const int& refinements, const int& numberOfPaths)
+{
+    int numberOfGridSteps = static_cast<int>(timeHorizon / gridStep + 0.5);
+    CounterIncrementSource incrementSource(seed);
+    incrementSource.prepare(numberOfGridSteps, 1, numberOfPaths, 1);
+    incrementSource.beginBlock(0, 0, numberOfPaths);
+
+    std::vector<double> rates(static_cast<std::size_t>(numberOfPaths), model.initialInterestRate);
+    std::vector<double> increments(static_cast<std::size_t>(1) << refinements);
+    double fineLength = std::ldexp(gridStep, -refinements);
+    TimeStep step;
+    step.length = fineLength;
+    step.squareRootLength = std::sqrt(fineLength);
+    for (int i = 1; i <= numberOfGridSteps; ++i)
+    {
+        const double* randomIncrements = incrementSource.increments(0, i, 0);
+        for (int path = 0; path < numberOfPaths; ++path)
+        {
+            CounterRandomStream bridgeStream(seed, static_cast<std::uint64_t>(path), static_cast<std::uint32_t>(i));
+            refineIncrement(bridgeStream, 1, randomIncrements[path], refinements, increments.data());
+            for (std::size_t fine = 0; fine < increments.size(); ++fine)
+            {
+                step.startTime = (i - 1) * gridStep + fine * fineLength;
+                step.endTime = step.startTime + fineLength;
+                rates[path] = milstein ? milsteinStep(model, step, rates[path], increments[fine]) : eulerStep(model, step, rates[path], increments[fine]);
+            }
+        }
+    }
+    return rates;
+}
+
+/*
+ Returns the rate at the horizon of every path with adaptive Milstein steps.
+
+ @param model The model to simulate.
+ @param tolerance The allowed local error per square root of unit time.
+ @param numberOfPaths The number of paths.
+ @param substeps Receives the total number of steps taken.
+ */
+template <typename Model>
+std::vector<double> adaptiveTerminalRates(const Model& model, const double& tolerance, const int& numberOfPaths, long long& substeps)
+{
+    int numberOfGridSteps = static_cast<int>(timeHorizon / gridStep + 0.5);
+    CounterIncrementSource incrementSource(seed);
+    incrementSource.prepare(numberOfGridSteps, 1, numberOfPaths, 1);
+    incrementSource.beginBlock(0, 0, numberOfPaths);
+
+    std::vector<double> rates(static_cast<std::size_t>(numberOfPaths), model.initialInterestRate);
+    AdaptiveMilsteinStepper<Model> stepper(model, tolerance, referenceRefinements);
+    TimeStep step;
+    step.length = gridStep;
+    step.squareRootLength = std::sqrt(gridStep);
+    for (int i = 1; i <= numberOfGridSteps; ++i)
+    {
+        step.startTime = (i - 1) * gridStep;
+        step.endTime = i * gridStep;
+        const double* randomIncrements = incrementSource.increments(0, i, 0);
+        for (int path = 0; path < numberOfPaths; ++path)
+        {
+            CounterRandomStream bridgeStream(seed, static_cast<std::uint64_t>(path), static_cast<std::uint32_t>(i));
+            rates[path] = stepper.advance(step, rates[path], randomIncrements[path], bridgeStream);
+        }
+    }
+    substeps = stepper.substepCount();
+    return rates;
+}
+
+SchemeError compareWithReference(const std::vector<double>& rates, const std::vector<double>& referenceRates, const double& stepsPerPath)
+{
+    SchemeError error;
+    error.stepsPerPath = stepsPerPath;
+    int finitePaths = 0;
+    for (std::size_t path = 0; path < rates.size(); ++path)
+    {
+        if (!std::isfinite(referenceRates[path]))
+        {
+            continue;
+        }
+        if (!std::isfinite(rates[path]))
+        {
+            ++error.failedPaths;
+            continue;
+        }
+        double difference = rates[path] - referenceRates[path];
+        error.rootMeanSquareError += difference * difference;
+        ++finitePaths;
+    }
+    error.rootMeanSquareError = std::sqrt(error.rootMeanSquareError / std::max(1, finitePaths));
+    return error;
+}
+
+// Path sink that keeps nothing, for timing the engine alone
+struct DiscardingSink
+{
+    void beginSimulation(const std::vector<double>&, const int&, const int&)
+    {
+    }
+
+    void observeStep(const int&, const int&, const int&, const double*, const int&)
+    {
+    }
+
+    void endSimulation()
+    {
+    }
+};
+
+template <typename SchemeModel>
+double engineMilliseconds(const SchemeModel& model, const double& timeStep, const int& numberOfPaths)
+{
+    DiscardingSink sink;
+    auto start = std::chrono::steady_clock::now();
+    simulatePaths(model, timeHorizon + 0.5 * timeStep, timeStep, numberOfPaths, seed, sink);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e3;
+}
+
+void printRow(const std::string& scheme, const SchemeError& error, const double& milliseconds)
+{
+    std::cout << std::setw(24) << scheme << std::fixed << std::setprecision(1) << std::setw(12) << error.stepsPerPath
+        << std::scientific << std::setprecision(3) << std::setw(14) << error.rootMeanSquareError
+        << std::setw(9) << error.failedPaths << std::fixed << std::setprecision(1) << std::setw(12) << milliseconds
+        << std::defaultfloat << "\n";
+}
+
+/*
+ Prints the error, steps and time of every scheme for one model.
+
+ @param modelName The name of the model.
+ @param model The short-rate model to simulate.
+ */
+template <typename Model>
+void runConvergence(const std::string& modelName, const Model& model)
+{
+    const int numberOfPaths = 4096;
+    const int timedPaths = 16384;
+    int numberOfGridSteps = static_cast<int>(timeHorizon / gridStep + 0.5);
+    std::vector<double> referenceRates = uniformTerminalRates(model, true, referenceRefinements, numberOfPaths);
+
+    int referenceFailures = 0;
+    for (double rate : referenceRates)
+    {
+        referenceFailures += std::isfinite(rate) ? 0 : 1;
+    }
+
+    std::cout << modelName << ": " << numberOfGridSteps << " grid steps, reference with " << (numberOfGridSteps << referenceRefinements)
+        << " Milstein steps (" << referenceFailures << " of " << numberOfPaths << " paths left out)\n";
+    std::cout << std::setw(24) << "Scheme" << std::setw(12) << "Steps/path" << std::setw(14) << "RMS error" << std::setw(9) << "Failed"
+        << std::setw(12) << "Engine ms" << "\n";
+    for (int refinements = 0; refinements <= 6; refinements += 2)
+    {
+        double timeStep = std::ldexp(gridStep, -refinements);
+        double stepsPerPath = static_cast<double>(numberOfGridSteps << refinements);
+        printRow("Euler h/" + std::to_string(1 << refinements),
+            compareWithReference(uniformTerminalRates(model, false, refinements, numberOfPaths), referenceRates, stepsPerPath),
+            engineMilliseconds(model, timeStep, timedPaths));
+        printRow("Milstein h/" + std::to_string(1 << refinements),
+            compareWithReference(uniformTerminalRates(model, true, refinements, numberOfPaths), referenceRates, stepsPerPath),
+            engineMilliseconds(MilsteinScheme<Model>{ model }, timeStep, timedPaths));
+    }
+    for (double tolerance : { 1e-3, 1e-4, 1e-5, 1e-6 })
+    {
+        long long substeps = 0;
+        std::vector<double> rates = adaptiveTerminalRates(model, tolerance, numberOfPaths, substeps);
+        std::ostringstream scheme;
+        scheme << "Adaptive tol " << std::defaultfloat << tolerance;
+        printRow(scheme.str(), compareWithReference(rates, referenceRates, static_cast<double>(substeps) / numberOfPaths),
+            engineMilliseconds(AdaptiveScheme<Model>{ { model }, tolerance, referenceRefinements }, gridStep, timedPaths));
+    }
+    std::cout << "\n";
+}
+
+int main()
+{
+    // Square-root diffusions, with the powers compiled to square roots
+    ChanKarolyiLongstaffSandersModel chanKarolyiLongstaffSandersModel{ 0.004, 0.1, 0.5, 0.15, 0.04 };
+    withSpecializedElasticity(chanKarolyiLongstaffSandersModel, [](const auto& model)
+    {
+        runConvergence("Chan-Karolyi-Longstaff-Sanders, elasticity 0.5", model);
+    });
+    ConstantElasticityVarianceModel constantElasticityVarianceModel{ -0.15, 0.002, 1.0, 0.1, 0.02 };
+    withSpecializedElasticity(constantElasticityVarianceModel, [](const auto& model)
+    {
+        runConvergence("Constant Elasticity of Variance, elasticity 1", model);
+    });
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include "../InterestRateModels/AdjointGreeks.h"
+#include "../InterestRateModels/BondPricing.h"
+
+/*
+ Benchmark of the adjoint bond sensitivities against bump-and-revalue.
+
+ For each model prices a 10-year bond on weekly steps once plainly and once
+ with all its sensitivities, and compares them with central differences
+ that rerun the simulation with the same seed twice per parameter. With the
+ same paths the two agree to the size of the bump, so the columns show the
+ cost: the adjoint run as a multiple of one pricing run, and the bumps as a
+ multiple of the adjoint run. Hull-White has a 30-knot theta curve, as after
+ fitting to a yield curve. Then varies the checkpoint interval of CIR on a
+ 30-year bond to show the rows kept per block against the time taken.
+ */
+
+const double maturity = 10.0;
+const double timeStep = 1.0 / 52.0;
+const int numberOfPaths = 16384;
+const std::uint64_t seed = 17;
+const double bumpSize = 1e-6;
+
+/*
+ Returns the time of a call in milliseconds.
+
+ @param call The call to time.
+ */
+template <typename Call>
+double millisecondsFor(const Call& call)
+{
+    auto start = std::chrono::steady_clock::now();
+    call();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e3;
+}
+
+/*
+ Returns the plain Monte Carlo price of the bond, on the paths the adjoint run uses.
+ */
+template <typename Model>
+double plainBondPrice(const Model& model, const double& bondMaturity)
+{
+    return priceZeroCouponBonds(model, { bondMaturity }, timeStep, numberOfPaths, seed).front().plainPrice;
+}
+
+/*
+ Prints one row comparing the adjoint and bumped sensitivities of a model.
+
+ @param name The name of the model.
+ @param model The model.
+ @param bumps One function per sensitivity, in the order of priceZeroCouponBondGreeks(), that shifts the parameter by an amount.
+ */
+template <typename Model>
+void compareSensitivities(const std::string& name, const Model& model, const std::vector<std::function<void(Model&, double)>>& bumps)
+{
+    double pricingTime = millisecondsFor([&]() { plainBondPrice(model, maturity); });
+    BondGreeks greeks;
+    double adjointTime = millisecondsFor([&]() { greeks = priceZeroCouponBondGreeks(model, maturity, timeStep, numberOfPaths, seed); });
+
+    std::vector<double> bumpedSensitivities;
+    double bumpTime = millisecondsFor([&]()
+    {
+        for (const auto& bump : bumps)
+        {
+            Model up = model;
+            Model down = model;
+            bump(up, bumpSize);
+            bump(down, -bumpSize);
+            bumpedSensitivities.push_back((plainBondPrice(up, maturity) - plainBondPrice(down, maturity)) / (2.0 * bumpSize));
+        }
+    });
+
+    double largestDifference = 0.0;
+    for (std::size_t parameter = 0; parameter < bumps.size(); ++parameter)
+    {
+        double difference = std::abs(greeks.sensitivities[parameter].value - bumpedSensitivities[parameter]);
+        largestDifference = std::max(largestDifference, difference / std::max(1.0, std::abs(bumpedSensitivities[parameter])));
+    }
+
+    std::cout << std::setw(6) << name << std::setw(8) << greeks.sensitivities.size() << std::fixed << std::setprecision(1)
+        << std::setw(10) << pricingTime << std::setw(10) << adjointTime << std::setw(10) << bumpTime
+        << std::setw(9) << adjointTime / pricingTime << "x" << std::setw(9) << bumpTime / adjointTime << "x"
+        << std::scientific << std::setprecision(1) << std::setw(12) << largestDifference
+        << std::setw(12) << std::to_string(greeks.storedRows) + "/" + std::to_string(greeks.fullTapeRows) << std::defaultfloat << "\n";
+}
+
+int main()
+{
+    VasicekModel vasicek{ 0.1, 0.05, 0.01, 0.03 };
+    CoxIngersollRossModel coxIngersollRoss{ 0.06, 0.2, 0.08, 0.04 };
+    ChanKarolyiLongstaffSandersModel chanKarolyiLongstaffSanders{ 0.01, 0.2, 0.75, 0.05, 0.04 };
+
+    // theta with a knot every four months, alpha and sigma with a few knots
+    std::vector<double> thetaTimes;
+    std::vector<double> thetaValues;
+    for (int knot = 0; knot < 30; ++knot)
+    {
+        thetaTimes.push_back(knot / 3.0);
+        thetaValues.push_back(0.004 + 0.0001 * knot);
+    }
+    HullWhiteModel hullWhite{ TimeCurve{ thetaTimes, thetaValues, CurveInterpolation::Linear },
+        TimeCurve{ { 0.0, 5.0, 10.0 }, { 0.1, 0.12, 0.15 }, CurveInterpolation::Linear },
+        TimeCurve{ { 0.0, 5.0, 10.0 }, { 0.01, 0.012, 0.011 }, CurveInterpolation::Linear }, 0.03 };
+
+    std::cout << "10-year bond, weekly steps, " << numberOfPaths << " paths; times in ms, difference relative to the bumped sensitivity\n\n";
+    std::cout << std::setw(6) << "model" << std::setw(8) << "params" << std::setw(10) << "price" << std::setw(10) << "adjoint" << std::setw(10) << "bumped"
+        << std::setw(10) << "adj/price" << std::setw(10) << "bump/adj" << std::setw(12) << "difference" << std::setw(12) << "rows" << "\n";
+
+    compareSensitivities<VasicekModel>("Vas", vasicek, {
+        [](VasicekModel& model, double shift) { model.initialInterestRate += shift; },
+        [](VasicekModel& model, double shift) { model.meanReversionSpeed += shift; },
+        [](VasicekModel& model, double shift) { model.longTermInterestRate += shift; },
+        [](VasicekModel& model, double shift) { model.volatility += shift; } });
+    compareSensitivities<CoxIngersollRossModel>("CIR", coxIngersollRoss, {
+        [](CoxIngersollRossModel& model, double shift) { model.initialInterestRate += shift; },
+        [](CoxIngersollRossModel& model, double shift) { model.meanReversionLevel += shift; },
+        [](CoxIngersollRossModel& model, double shift) { model.meanReversionRate += shift; },
+        [](CoxIngersollRossModel& model, double shift) { model.volatility += shift; } });
+    compareSensitivities<ChanKarolyiLongstaffSandersModel>("CKLS", chanKarolyiLongstaffSanders, {
+        [](ChanKarolyiLongstaffSandersModel& model, double shift) { model.initialInterestRate += shift; },
+        [](ChanKarolyiLongstaffSandersModel& model, double shift) { model.driftTerm += shift; },
+        [](ChanKarolyiLongstaffSandersModel& model, double shift) { model.meanReversionRate += shift; },
+        [](ChanKarolyiLongstaffSandersModel& model, double shift) { model.elasticity += shift; },
+        [](ChanKarolyiLongstaffSandersModel& model, double shift) { model.volatility += shift; } });
+
+    std::vector<std::function<void(HullWhiteModel&, double)>> hullWhiteBumps = { [](HullWhiteModel& model, double shift) { model.initialInterestRate += shift; } };
+    for (TimeCurve HullWhiteModel::*curve : { &HullWhiteModel::theta, &HullWhiteModel::alpha, &HullWhiteModel::sigma })
+    {
+        for (std::size_t knot = 0; knot < (hullWhite.*curve).values.size(); ++knot)
+        {
+            hullWhiteBumps.push_back([curve, knot](HullWhiteModel& model, double shift) { (model.*curve).values[knot] += shift; });
+        }
+    }
+    compareSensitivities<HullWhiteModel>("HW", hullWhite, hullWhiteBumps);
+
+    // Memory against time for the reverse pass on a long path
+    std::cout << "\nCIR, 30-year bond, weekly steps\n\n";
+    std::cout << std::setw(12) << "interval" << std::setw(12) << "rows" << std::setw(12) << "ms" << std::setw(14) << "dP/dsigma" << "\n";
+    for (int checkpointInterval : { 2, 8, 0, 160, 520 })
+    {
+        AdjointSettings settings;
+        settings.checkpointInterval = checkpointInterval;
+        BondGreeks greeks;
+        double milliseconds = millisecondsFor([&]() { greeks = priceZeroCouponBondGreeks(coxIngersollRoss, 30.0, timeStep, numberOfPaths, seed, settings); });
+        std::cout << std::setw(12) << (checkpointInterval > 0 ? std::to_string(checkpointInterval) : "auto")
+            << std::setw(12) << std::to_string(greeks.storedRows) + "/" + std::to_string(greeks.fullTapeRows)
+            << std::fixed << std::setprecision(1) << std::setw(12) << milliseconds << std::setprecision(8) << std::setw(14) << greeks.sensitivities.back().value << std::defaultfloat << "\n";
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,668 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../InterestRateModels/CsvWriter.h"
+#include "../InterestRateModels/HeathJarrowMortonEngine.h"
+#include "../InterestRateModels/ResultFile.h"
+#include "../InterestRateModels/ShortRateModels.h"
+#include "../InterestRateModels/StreamingStatistics.h"
+
+/*
+ Throughput benchmark of every model, with a JSON report and a baseline check.
+
+ Simulates the seven models of the programs (Vasicek, CIR, CKLS, CEV,
+ Ho-Lee, Hull-White and HJM) over 5 years and measures path steps per
+ second, the number of paths times the number of time steps over the
+ median wall time of repeated runs. The engine alone is measured across
+ path counts, weekly and daily steps, and on one thread and on a fixed
+ pool of four, so the cases are the same on every machine; then each model
+ is run on four threads with the output modes of the programs: per-date
+ statistics, a binary result file and a CSV file, written to the working
+ directory and removed.
+
+ Usage:
+   BenchmarkSuite [--quick] [--output results.json] [--baseline baseline.json] [--tolerance 0.2]
+
+ --quick runs the cases of the full suite with 1024 paths and weekly
+ steps, and the output modes. --output writes the results as JSON, with the
+ machine they were measured on. --baseline compares the results with a
+ JSON file written earlier by the suite, case by case, and lists the cases
+ it does not have. The suite exits with status 1 if any case is slower
+ than the baseline by more than the tolerance (20% by default) in two
+ measurements, or if the baseline was recorded on a machine with other
+ hardware threads, SIMD level or compiler: a baseline only means something
+ on the machine and build it came from.
+ */
+
+enum class OutputMode
+{
+    None,
+    Statistics,
+    Binary,
+    Csv
+};
+
+const char* const modelNames[] = { "Vasicek", "CoxIngersollRoss", "ChanKarolyiLongstaffSanders", "ConstantElasticityVariance", "HoAndLee", "HullWhite", "HeathJarrowMorton" };
+const double timeHorizon = 5.0;
+const std::uint64_t seed = 7;
+const std::string scratchPath = "benchmark_suite_output";
+const std::vector<int> threadCounts = { 1, 4 };  // fixed, so that baselines from machines of different sizes have the same cases
+const int outputThreads = 4;
+
+/*
+ One measured configuration.
+ */
+struct SuiteCase
+{
+    std::string model;
+    int numberOfPaths = 0;
+    std::string stepName;
+    double timeStep = 0.0;
+    int numberOfThreads = 1;
+    OutputMode outputMode = OutputMode::None;
+};
+
+/*
+ The measurement of one configuration.
+ */
+struct SuiteResult
+{
+    SuiteCase suiteCase;
+    int numberOfTimeSteps = 0;
+    int repeats = 0;
+    double seconds = 0.0;  // median wall time of one run
+    double pathStepsPerSecond = 0.0;
+};
+
+/*
+ The machine a report was measured on.
+ */
+struct SuiteMachine
+{
+    int hardwareThreads = 0;
+    std::string simd;
+    std::string compiler;
+};
+
+const char* outputModeName(const OutputMode& outputMode)
+{
+    switch (outputMode)
+    {
+    case OutputMode::Statistics:
+        return "stats";
+    case OutputMode::Binary:
+        return "binary";
+    case OutputMode::Csv:
+        return "csv";
+    default:
+        return "none";
+    }
+}
+
+/*
+ Returns the name that identifies a case in the reports and baselines.
+ */
+std::string caseName(const SuiteCase& suiteCase)
+{
+    return suiteCase.model + " paths=" + std::to_string(suiteCase.numberOfPaths) + " step=" + suiteCase.stepName
+        + " threads=" + std::to_string(suiteCase.numberOfThreads) + " output=" + outputModeName(suiteCase.outputMode);
+}
+
+/*
+ A path sink that only sums the final rates, so the simulation cannot be optimized away.
+ */
+class ChecksumSink
+{
+public:
+    void beginSimulation(const std::vector<double>& timeValues, const int&, const int& numberOfThreads)
+    {
+        lastStep = static_cast<int>(timeValues.size()) - 1;
+        sums.assign(static_cast<std::size_t>(numberOfThreads) * 8, 0.0);
+    }
+
+    void observeStep(const int& threadIndex, const int& stepIndex, const int&, const double* rates, const int& numberOfPaths)
+    {
+        if (stepIndex == lastStep)
+        {
+            sums[static_cast<std::size_t>(threadIndex) * 8] += std::accumulate(rates, rates + numberOfPaths, 0.0);
+        }
+    }
+
+    void endSimulation()
+    {
+    }
+
+    // The same for forward curves, from simulateForwardCurves()
+
+    void beginSimulation(const std::vector<double>& recordTimes, const std::vector<double>& maturities, const int&, const int& numberOfThreads)
+    {
+        lastStep = static_cast<int>(recordTimes.size()) - 1;
+        numberOfMaturities = static_cast<int>(maturities.size());
+        sums.assign(static_cast<std::size_t>(numberOfThreads) * 8, 0.0);
+    }
+
+    void observeRecord(const int& threadIndex, const int& record, const int&, const double* curves, const int& numberOfPaths)
+    {
+        if (record == lastStep)
+        {
+            sums[static_cast<std::size_t>(threadIndex) * 8] += std::accumulate(curves, curves + static_cast<std::size_t>(numberOfPaths) * numberOfMaturities, 0.0);
+        }
+    }
+
+    double checksum() const
+    {
+        return std::accumulate(sums.begin(), sums.end(), 0.0);
+    }
+
+private:
+    int lastStep = 0;
+    int numberOfMaturities = 0;
+    std::vector<double> sums;  // one per thread, a cache line apart
+};
+
+/*
+ Runs one case of a short-rate model once.
+
+ @param model The model, as its program simulates it.
+ @param suiteCase The case to run.
+ @param context The thread pool and buffers of the case's thread count.
+ @param pathStore The store for the file outputs, reused between runs.
+ @param checksum Collects a sum of the results.
+ */
+template <typename Model>
+void runShortRateCase(const Model& model, const SuiteCase& suiteCase, SimulationContext& context, PathStore& pathStore, double& checksum)
+{
+    if (suiteCase.outputMode == OutputMode::None)
+    {
+        ChecksumSink sink;
+        simulatePaths(model, timeHorizon, suiteCase.timeStep, suiteCase.numberOfPaths, seed, sink, context);
+        checksum += sink.checksum();
+        return;
+    }
+    if (suiteCase.outputMode == OutputMode::Statistics)
+    {
+        PathStatisticsSink sink;
+        simulatePaths(model, timeHorizon, suiteCase.timeStep, suiteCase.numberOfPaths, seed, sink, context);
+        checksum += sink.statistics.rateMoments.back().mean;
+        return;
+    }
+
+    simulatePathBatch(model, timeHorizon, suiteCase.timeStep, suiteCase.numberOfPaths, seed, pathStore, context);
+    if (suiteCase.outputMode == OutputMode::Binary)
+    {
+        writeResultFile(scratchPath + ".irm", suiteCase.model, {}, seed, pathStore);
+        std::remove((scratchPath + ".irm").c_str());
+        return;
+    }
+
+    // One row per path and date, as for HJM curves
+    CsvWriter csvWriter(scratchPath + ".csv");
+    csvWriter.writeRow("Time", "Path", "InterestRate");
+    for (int i = 0; i <= pathStore.numberOfTimeSteps; ++i)
+    {
+        const double* rates = pathStore.ratesAtStep(i);
+        for (int path = 0; path < pathStore.numberOfPaths; ++path)
+        {
+            csvWriter.writeRow(pathStore.timeValues[i], path + 1, rates[path]);
+        }
+    }
+    csvWriter.close();
+    std::remove((scratchPath + ".csv").c_str());
+}
+
+/*
+ Runs one case of the HJM model once.
+
+ @param model The model.
+ @param suiteCase The case to run.
+ @param context The thread pool and buffers of the case's thread count.
+ @param forwardCurveStore The store for the file outputs, reused between runs.
+ @param checksum Collects a sum of the results.
+ */
+void runForwardCurveCase(const HeathJarrowMortonModel& model, const SuiteCase& suiteCase, SimulationContext& context, ForwardCurveStore& forwardCurveStore, double& checksum)
+{
+    if (suiteCase.outputMode == OutputMode::None)
+    {
+        ChecksumSink sink;
+        simulateForwardCurves(model, timeHorizon, suiteCase.timeStep, suiteCase.numberOfPaths, seed, 1, sink, context);
+        checksum += sink.checksum();
+        return;
+    }
+    if (suiteCase.outputMode == OutputMode::Statistics)
+    {
+        ForwardCurveStatisticsSink sink;
+        simulateForwardCurves(model, timeHorizon, suiteCase.timeStep, suiteCase.numberOfPaths, seed, 1, sink, context);
+        checksum += sink.statistics.forwardRateMoments.back().mean;
+        return;
+    }
+
+    simulateForwardCurves(model, timeHorizon, suiteCase.timeStep, suiteCase.numberOfPaths, seed, 1, forwardCurveStore, context);
+    if (suiteCase.outputMode == OutputMode::Binary)
+    {
+        writeResultFile(scratchPath + ".irm", suiteCase.model, {}, seed, forwardCurveStore);
+        std::remove((scratchPath + ".irm").c_str());
+        return;
+    }
+
+    CsvWriter csvWriter(scratchPath + ".csv");
+    csvWriter.writeField("Time");
+    csvWriter.writeField("Path");
+    for (double maturity : forwardCurveStore.maturities)
+    {
+        csvWriter.writeField("ForwardRate", maturity);
+    }
+    csvWriter.endRow();
+    for (int record = 0; record < forwardCurveStore.numberOfRecords(); ++record)
+    {
+        for (int path = 0; path < forwardCurveStore.numberOfPaths; ++path)
+        {
+            csvWriter.writeField(forwardCurveStore.timeValues[record]);
+            csvWriter.writeField(path + 1);
+            const double* forwardCurve = forwardCurveStore.curve(record, path);
+            for (int maturity = 0; maturity < forwardCurveStore.numberOfMaturities; ++maturity)
+            {
+                csvWriter.writeField(forwardCurve[maturity]);
+            }
+            csvWriter.endRow();
+        }
+    }
+    csvWriter.close();
+    std::remove((scratchPath + ".csv").c_str());
+}
+
+/*
+ Runs the models with the parameters of their programs.
+ */
+class ModelRunner
+{
+public:
+    ModelRunner()
+    {
+        std::vector<double> curveTimes = { 0.0, 1.0 / 3.0, 2.0 / 3.0 };
+        hullWhite = HullWhiteModel{ TimeCurve{ curveTimes, { 0.03, 0.02, 0.025 }, CurveInterpolation::PiecewiseConstant },
+            TimeCurve{ curveTimes, { 0.01, 0.015, 0.012 }, CurveInterpolation::PiecewiseConstant },
+            TimeCurve{ curveTimes, { 0.01, 0.015, 0.02 }, CurveInterpolation::PiecewiseConstant }, 0.02 };
+        heathJarrowMorton.initialForwardCurve = TimeCurve::constant(0.03);
+        heathJarrowMorton.maturities = { 0.25, 0.5, 1.0, 2.0, 3.0, 5.0, 7.0, 10.0 };
+        heathJarrowMorton.factors = { { 0.01, 0.0 }, { 0.015, 0.5 } };
+    }
+
+    /*
+     Runs one case once.
+
+     @param suiteCase The case to run.
+     @param context The thread pool and buffers of the case's thread count.
+     */
+    void run(const SuiteCase& suiteCase, SimulationContext& context)
+    {
+        auto runShortRate = [&](const auto& model) { runShortRateCase(model, suiteCase, context, pathStore, checksum); };
+        if (suiteCase.model == "Vasicek")
+        {
+            runShortRate(vasicek);
+        }
+        else if (suiteCase.model == "CoxIngersollRoss")
+        {
+            runShortRate(coxIngersollRoss);
+        }
+        else if (suiteCase.model == "ChanKarolyiLongstaffSanders")
+        {
+            withSpecializedElasticity(chanKarolyiLongstaffSanders, runShortRate);
+        }
+        else if (suiteCase.model == "ConstantElasticityVariance")
+        {
+            withSpecializedElasticity(constantElasticityVariance, runShortRate);
+        }
+        else if (suiteCase.model == "HoAndLee")
+        {
+            runShortRate(hoAndLee);
+        }
+        else if (suiteCase.model == "HullWhite")
+        {
+            runShortRate(hullWhite);
+        }
+        else
+        {
+            runForwardCurveCase(heathJarrowMorton, suiteCase, context, forwardCurveStore, checksum);
+        }
+    }
+
+    double checksum = 0.0;
+
+private:
+    VasicekModel vasicek{ 0.1, 0.2, 0.02, 0.05 };
+    CoxIngersollRossModel coxIngersollRoss{ 0.1, 0.2, 0.02, 0.05 };
+    ChanKarolyiLongstaffSandersModel chanKarolyiLongstaffSanders{ 0.1, 0.2, 0.5, 0.02, 0.05 };
+    ConstantElasticityVarianceModel constantElasticityVariance{ 0.1, 0.2, 0.5, 0.02, 0.05 };
+    HoAndLeeModel hoAndLee{ 0.02, 0.01, 0.0 };
+    HullWhiteModel hullWhite;
+    HeathJarrowMortonModel heathJarrowMorton;
+    PathStore pathStore;
+    ForwardCurveStore forwardCurveStore;
+};
+
+/*
+ Measures one case: a warm-up run, then runs until both the minimum time and
+ the minimum number of repeats are reached.
+
+ @param runner The models.
+ @param suiteCase The case to measure.
+ @param context The thread pool and buffers of the case's thread count.
+ @param minimumSeconds The least total time to spend on the repeats.
+ */
+SuiteResult measureCase(ModelRunner& runner, const SuiteCase& suiteCase, SimulationContext& context, const double& minimumSeconds)
+{
+    const int minimumRepeats = 3;
+    const int maximumRepeats = 50;
+    runner.run(suiteCase, context);
+
+    std::vector<double> times;
+    double totalSeconds = 0.0;
+    while (static_cast<int>(times.size()) < maximumRepeats && (static_cast<int>(times.size()) < minimumRepeats || totalSeconds < minimumSeconds))
+    {
+        auto start = std::chrono::steady_clock::now();
+        runner.run(suiteCase, context);
+        times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        totalSeconds += times.back();
+    }
+    std::sort(times.begin(), times.end());
+
+    SuiteResult result;
+    result.suiteCase = suiteCase;
+    result.numberOfTimeSteps = static_cast<int>(timeHorizon / suiteCase.timeStep);
+    result.repeats = static_cast<int>(times.size());
+    result.seconds = times[times.size() / 2];
+    result.pathStepsPerSecond = static_cast<double>(suiteCase.numberOfPaths) * result.numberOfTimeSteps / result.seconds;
+    return result;
+}
+
+/*
+ Returns the cases to run.
+
+ @param quick Whether to run the small subset.
+ */
+std::vector<SuiteCase> suiteCases(const bool& quick)
+{
+    std::vector<int> pathCounts = quick ? std::vector<int>{ 1024 } : std::vector<int>{ 1024, 16384 };
+    std::vector<std::pair<std::string, double>> timeSteps = { { "weekly", 1.0 / 52.0 } };
+    if (!quick)
+    {
+        timeSteps.push_back({ "daily", 1.0 / 252.0 });
+    }
+
+    std::vector<SuiteCase> cases;
+    for (const char* model : modelNames)
+    {
+        // The engine alone
+        for (const int& numberOfPaths : pathCounts)
+        {
+            for (const std::pair<std::string, double>& timeStep : timeSteps)
+            {
+                for (const int& numberOfThreads : threadCounts)
+                {
+                    cases.push_back({ model, numberOfPaths, timeStep.first, timeStep.second, numberOfThreads, OutputMode::None });
+                }
+            }
+        }
+
+        // The output modes, on a run small enough to write out
+        for (OutputMode outputMode : { OutputMode::Statistics, OutputMode::Binary, OutputMode::Csv })
+        {
+            cases.push_back({ model, 4096, "weekly", 1.0 / 52.0, outputThreads, outputMode });
+        }
+    }
+    return cases;
+}
+
+const char* simdLevelName()
+{
+    switch (activeSimdLevel())
+    {
+    case SimdLevel::Avx512:
+        return "avx512";
+    case SimdLevel::Avx2:
+        return "avx2";
+    default:
+        return "scalar";
+    }
+}
+
+std::string compilerName()
+{
+#if defined(__clang__)
+    return std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+    return std::string("gcc ") + __VERSION__;
+#elif defined(_MSC_VER)
+    return "msvc " + std::to_string(_MSC_VER);
+#else
+    return "unknown";
+#endif
+}
+
+/*
+ Returns the machine the suite runs on.
+ */
+SuiteMachine currentMachine()
+{
+    return { std::max(1, static_cast<int>(std::thread::hardware_concurrency())), simdLevelName(), compilerName() };
+}
+
+/*
+ Writes the results as JSON.
+
+ @param path The path of the file.
+ @param results The results.
+ @param machine The machine they were measured on.
+ */
+void writeResults(const std::string& path, const std::vector<SuiteResult>& results, const SuiteMachine& machine)
+{
+    std::ofstream output(path);
+    if (!output)
+    {
+        throw std::runtime_error("Cannot create " + path);
+    }
+    output << std::setprecision(6);
+    output << "{\n  \"suite\": \"InterestRateModels\",\n  \"version\": 1,\n";
+    output << "  \"machine\": {\n    \"hardwareThreads\": " << machine.hardwareThreads << ",\n    \"simd\": \"" << machine.simd
+        << "\",\n    \"compiler\": \"" << machine.compiler << "\"\n  },\n";
+    output << "  \"timeHorizon\": " << timeHorizon << ",\n  \"cases\": [";
+    for (std::size_t index = 0; index < results.size(); ++index)
+    {
+        const SuiteResult& result = results[index];
+        const SuiteCase& suiteCase = result.suiteCase;
+        output << (index == 0 ? "\n" : ",\n") << "    {\n"
+            << "      \"name\": \"" << caseName(suiteCase) << "\",\n"
+            << "      \"model\": \"" << suiteCase.model << "\",\n"
+            << "      \"paths\": " << suiteCase.numberOfPaths << ",\n"
+            << "      \"timeStep\": " << suiteCase.timeStep << ",\n"
+            << "      \"steps\": " << result.numberOfTimeSteps << ",\n"
+            << "      \"threads\": " << suiteCase.numberOfThreads << ",\n"
+            << "      \"output\": \"" << outputModeName(suiteCase.outputMode) << "\",\n"
+            << "      \"repeats\": " << result.repeats << ",\n"
+            << "      \"seconds\": " << result.seconds << ",\n"
+            << "      \"pathStepsPerSecond\": " << result.pathStepsPerSecond << "\n"
+            << "    }";
+    }
+    output << "\n  ]\n}\n";
+}
+
+/*
+ Reads the machine and the throughput of every case from a JSON file written by writeResults().
+
+ @param path The path of the file.
+ @param machine Receives the machine the baseline was measured on.
+ @return The path steps per second of each case, by name.
+ */
+std::map<std::string, double> readBaseline(const std::string& path, SuiteMachine& machine)
+{
+    std::ifstream input(path);
+    if (!input)
+    {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    std::stringstream buffer;
+    buffer << input.rdbuf();
+    std::string text = buffer.str();
+
+    // The machine block comes before the cases
+    auto valueAfter = [&](const std::string& key)
+    {
+        std::size_t position = text.find(key);
+        if (position == std::string::npos)
+        {
+            throw std::runtime_error(path + " has no " + key + " in its machine block");
+        }
+        return position + key.size();
+    };
+    machine.hardwareThreads = std::atoi(text.c_str() + valueAfter("\"hardwareThreads\": "));
+    std::size_t simdStart = valueAfter("\"simd\": \"");
+    machine.simd = text.substr(simdStart, text.find('"', simdStart) - simdStart);
+    std::size_t compilerStart = valueAfter("\"compiler\": \"");
+    machine.compiler = text.substr(compilerStart, text.find('"', compilerStart) - compilerStart);
+
+    std::map<std::string, double> throughputs;
+    const std::string nameKey = "\"name\": \"";
+    const std::string throughputKey = "\"pathStepsPerSecond\": ";
+    std::size_t position = text.find(nameKey);
+    while (position != std::string::npos)
+    {
+        std::size_t nameStart = position + nameKey.size();
+        std::size_t nameEnd = text.find('"', nameStart);
+        std::size_t throughput = text.find(throughputKey, nameEnd);
+        if (nameEnd == std::string::npos || throughput == std::string::npos)
+        {
+            throw std::runtime_error(path + " is not a benchmark report");
+        }
+        throughputs[text.substr(nameStart, nameEnd - nameStart)] = std::strtod(text.c_str() + throughput + throughputKey.size(), nullptr);
+        position = text.find(nameKey, throughput);
+    }
+    return throughputs;
+}
+
+int main(int argc, char* argv[])
+{
+    bool quick = false;
+    std::string outputPath;
+    std::string baselinePath;
+    double tolerance = 0.2;
+    for (int argument = 1; argument < argc; ++argument)
+    {
+        std::string flag = argv[argument];
+        bool hasValue = argument + 1 < argc;
+        if (flag == "--quick")
+        {
+            quick = true;
+        }
+        else if (flag == "--output" && hasValue)
+        {
+            outputPath = argv[++argument];
+        }
+        else if (flag == "--baseline" && hasValue)
+        {
+            baselinePath = argv[++argument];
+        }
+        else if (flag == "--tolerance" && hasValue)
+        {
+            tolerance = std::stod(argv[++argument]);
+        }
+        else
+        {
+            std::cerr << "Usage: BenchmarkSuite [--quick] [--output results.json] [--baseline baseline.json] [--tolerance 0.2]" << std::endl;
+            return 1;
+        }
+    }
+
+    SuiteMachine machine = currentMachine();
+    std::vector<SuiteCase> cases = suiteCases(quick);
+    double minimumSeconds = quick ? 0.05 : 0.25;
+
+    // One pool and context per thread count
+    std::map<int, std::unique_ptr<ThreadPool>> threadPools;
+    std::map<int, std::unique_ptr<SimulationContext>> contexts;
+    for (const SuiteCase& suiteCase : cases)
+    {
+        if (threadPools.count(suiteCase.numberOfThreads) == 0)
+        {
+            threadPools[suiteCase.numberOfThreads] = std::make_unique<ThreadPool>(suiteCase.numberOfThreads);
+            contexts[suiteCase.numberOfThreads] = std::make_unique<SimulationContext>(*threadPools[suiteCase.numberOfThreads]);
+        }
+    }
+
+    std::cout << std::setw(28) << "model" << std::setw(8) << "paths" << std::setw(8) << "step" << std::setw(9) << "threads" << std::setw(8) << "output"
+        << std::setw(10) << "ms" << std::setw(16) << "path steps/s" << "\n";
+    ModelRunner runner;
+    std::vector<SuiteResult> results;
+    for (const SuiteCase& suiteCase : cases)
+    {
+        results.push_back(measureCase(runner, suiteCase, *contexts[suiteCase.numberOfThreads], minimumSeconds));
+        const SuiteResult& result = results.back();
+        std::cout << std::setw(28) << suiteCase.model << std::setw(8) << suiteCase.numberOfPaths << std::setw(8) << suiteCase.stepName
+            << std::setw(9) << suiteCase.numberOfThreads << std::setw(8) << outputModeName(suiteCase.outputMode) << std::fixed << std::setprecision(2)
+            << std::setw(10) << 1e3 * result.seconds << std::scientific << std::setprecision(3) << std::setw(16) << result.pathStepsPerSecond << std::defaultfloat << std::endl;
+    }
+
+    if (!outputPath.empty())
+    {
+        writeResults(outputPath, results, machine);
+        std::cout << "\nResults written to " << outputPath << " (checksum " << runner.checksum << ")\n";
+    }
+
+    // Compare with the baseline, case by case
+    if (baselinePath.empty())
+    {
+        return 0;
+    }
+    SuiteMachine baselineMachine;
+    std::map<std::string, double> baseline = readBaseline(baselinePath, baselineMachine);
+    int regressions = 0;
+    int compared = 0;
+    std::cout << "\nAgainst " << baselinePath << ", tolerance " << 100.0 * tolerance << "%\n";
+    bool sameMachine = baselineMachine.hardwareThreads == machine.hardwareThreads && baselineMachine.simd == machine.simd
+        && baselineMachine.compiler == machine.compiler;
+    if (!sameMachine)
+    {
+        std::cerr << "\nERROR: the baseline was recorded on another machine, so the comparison below means nothing.\n"
+            << "  baseline: " << baselineMachine.hardwareThreads << " hardware threads, " << baselineMachine.simd << ", " << baselineMachine.compiler << "\n"
+            << "  this run: " << machine.hardwareThreads << " hardware threads, " << machine.simd << ", " << machine.compiler << "\n"
+            << "  Record a baseline on this machine with the benchmark-baseline target.\n\n";
+    }
+    for (const SuiteResult& result : results)
+    {
+        std::string name = caseName(result.suiteCase);
+        auto entry = baseline.find(name);
+        if (entry == baseline.end() || entry->second <= 0.0)
+        {
+            std::cout << "  not in the baseline: " << name << "\n";
+            continue;
+        }
+        ++compared;
+        double ratio = result.pathStepsPerSecond / entry->second;
+        if (ratio < 1.0 - tolerance)
+        {
+            // Measure again before reporting, as one slow measurement is often noise
+            SuiteResult again = measureCase(runner, result.suiteCase, *contexts[result.suiteCase.numberOfThreads], minimumSeconds);
+            ratio = std::max(ratio, again.pathStepsPerSecond / entry->second);
+        }
+        if (ratio < 1.0 - tolerance)
+        {
+            ++regressions;
+            std::cout << "  slower: " << name << std::fixed << std::setprecision(2) << " at " << ratio << "x the baseline" << std::defaultfloat << "\n";
+        }
+    }
+    std::cout << "  " << compared << " of " << results.size() << " cases in the baseline, " << regressions << " slower than the tolerance\n";
+    return regressions > 0 || !sameMachine ? 1 : 0;
+}
\ No newline at end of file
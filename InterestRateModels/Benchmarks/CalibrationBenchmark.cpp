@@ -0,0 +1,149 @@
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include "../InterestRateModels/Calibration.h"
+#include "../InterestRateModels/CsvWriter.h"
+#include "../InterestRateModels/PathEngine.h"
+
+/*
+ Benchmark of maximum-likelihood calibration on 10^7 daily observations.
+
+ Simulates a long series from known Vasicek, CIR and CKLS parameters, writes
+ it to a Time,InterestRate CSV file, then times reading it back through the
+ memory mapping and calibrating each model to it. The fitted parameters
+ should be close to the ones simulated. For comparison, one CKLS likelihood
+ evaluation is also timed as a plain loop over the series with std::pow.
+ */
+
+const std::size_t numberOfObservations = 10000000;
+const double observationInterval = 1.0 / 252.0;
+const std::uint64_t seed = 11;
+
+double millisecondsSince(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e3;
+}
+
+/*
+ Simulates one long path of a model and writes it to a CSV file.
+
+ @param model The model to simulate, possibly wrapped in a scheme.
+ @param outputPath The path to the output CSV file.
+ */
+template <typename Model>
+void writeSeries(const Model& model, const std::string& outputPath)
+{
+    double timeHorizon = (numberOfObservations - 0.5) * observationInterval;
+    PathStore pathStore = simulatePathBatch(model, timeHorizon, observationInterval, 1, seed);
+    CsvWriter csvWriter(outputPath);
+    csvWriter.writeRow("Time", "InterestRate");
+    for (int i = 0; i <= pathStore.numberOfTimeSteps; ++i)
+    {
+        csvWriter.writeRow(pathStore.timeValues[i], pathStore.rate(i, 0));
+    }
+    csvWriter.close();
+}
+
+/*
+ Returns the CKLS Euler log-likelihood of a series, one observation at a time.
+ */
+double plainLogLikelihood(const std::vector<double>& rates, const ChanKarolyiLongstaffSandersModel& model)
+{
+    const double pi = 3.14159265358979323846;
+    double logLikelihood = 0.0;
+    for (std::size_t i = 0; i + 1 < rates.size(); ++i)
+    {
+        double mean = rates[i] + model.drift(0.0, rates[i]) * observationInterval;
+        double standardDeviation = model.volatility * std::pow(std::abs(rates[i]), model.elasticity) * std::sqrt(observationInterval);
+        double residual = (rates[i + 1] - mean) / standardDeviation;
+        logLikelihood -= 0.5 * std::log(2.0 * pi) + std::log(standardDeviation) + 0.5 * residual * residual;
+    }
+    return logLikelihood;
+}
+
+void printParameter(const std::string& name, const double& simulated, const double& fitted)
+{
+    std::cout << std::setprecision(6) << std::setw(24) << name << std::setw(14) << simulated << std::setw(14) << fitted << "\n";
+}
+
+void printTiming(const double& readMilliseconds, const double& calibrationMilliseconds, const double& logLikelihood, const int& likelihoodPasses)
+{
+    std::cout << std::fixed << std::setprecision(1) << "  read " << readMilliseconds << " ms, calibrate " << calibrationMilliseconds
+        << " ms (" << likelihoodPasses << " likelihood passes), log-likelihood " << logLikelihood << std::defaultfloat << "\n\n";
+}
+
+int main()
+{
+    std::cout << numberOfObservations << " daily observations per series, " << defaultThreadPool().numberOfThreads() << " threads\n\n";
+
+    // Vasicek, simulated exactly
+    VasicekModel vasicekModel{ 0.3, 0.04, 0.01, 0.03 };
+    writeSeries(ExactScheme<VasicekModel>{ vasicekModel }, "calibration_vasicek.csv");
+    auto start = std::chrono::steady_clock::now();
+    std::vector<double> rates = readRateSeries("calibration_vasicek.csv");
+    double readMilliseconds = millisecondsSince(start);
+    start = std::chrono::steady_clock::now();
+    CalibrationResult<VasicekModel> vasicek = calibrateVasicekModel(rates, observationInterval);
+    double calibrationMilliseconds = millisecondsSince(start);
+    std::cout << "Vasicek, exact density" << std::setw(16) << "simulated" << std::setw(14) << "fitted" << "\n";
+    printParameter("meanReversionSpeed", vasicekModel.meanReversionSpeed, vasicek.model.meanReversionSpeed);
+    printParameter("longTermInterestRate", vasicekModel.longTermInterestRate, vasicek.model.longTermInterestRate);
+    printParameter("volatility", vasicekModel.volatility, vasicek.model.volatility);
+    printTiming(readMilliseconds, calibrationMilliseconds, vasicek.logLikelihood, vasicek.likelihoodPasses);
+
+    // CIR, simulated exactly
+    CoxIngersollRossModel coxIngersollRossModel{ 0.05, 0.5, 0.08, 0.03 };
+    writeSeries(ExactScheme<CoxIngersollRossModel>{ coxIngersollRossModel }, "calibration_cir.csv");
+    start = std::chrono::steady_clock::now();
+    rates = readRateSeries("calibration_cir.csv");
+    readMilliseconds = millisecondsSince(start);
+    start = std::chrono::steady_clock::now();
+    CalibrationResult<CoxIngersollRossModel> coxIngersollRoss = calibrateCoxIngersollRossModel(rates, observationInterval);
+    calibrationMilliseconds = millisecondsSince(start);
+    std::cout << "CIR, Euler density" << std::setw(20) << "simulated" << std::setw(14) << "fitted" << "\n";
+    printParameter("meanReversionLevel", coxIngersollRossModel.meanReversionLevel, coxIngersollRoss.model.meanReversionLevel);
+    printParameter("meanReversionRate", coxIngersollRossModel.meanReversionRate, coxIngersollRoss.model.meanReversionRate);
+    printParameter("volatility", coxIngersollRossModel.volatility, coxIngersollRoss.model.volatility);
+    printTiming(readMilliseconds, calibrationMilliseconds, coxIngersollRoss.logLikelihood, coxIngersollRoss.likelihoodPasses);
+
+    // CKLS with elasticity 3/2, simulated with Euler steps
+    ChanKarolyiLongstaffSandersModel chanKarolyiLongstaffSandersModel{ 0.01, 0.2, 1.5, 1.0, 0.05 };
+    withSpecializedElasticity(chanKarolyiLongstaffSandersModel, [](const auto& model)
+    {
+        writeSeries(model, "calibration_ckls.csv");
+    });
+    start = std::chrono::steady_clock::now();
+    rates = readRateSeries("calibration_ckls.csv");
+    readMilliseconds = millisecondsSince(start);
+    start = std::chrono::steady_clock::now();
+    CalibrationResult<ChanKarolyiLongstaffSandersModel> chanKarolyiLongstaffSanders = calibrateChanKarolyiLongstaffSandersModel(rates, observationInterval);
+    calibrationMilliseconds = millisecondsSince(start);
+    std::cout << "CKLS, Euler density" << std::setw(19) << "simulated" << std::setw(14) << "fitted" << "\n";
+    printParameter("driftTerm", chanKarolyiLongstaffSandersModel.driftTerm, chanKarolyiLongstaffSanders.model.driftTerm);
+    printParameter("meanReversionRate", chanKarolyiLongstaffSandersModel.meanReversionRate, chanKarolyiLongstaffSanders.model.meanReversionRate);
+    printParameter("elasticity", chanKarolyiLongstaffSandersModel.elasticity, chanKarolyiLongstaffSanders.model.elasticity);
+    printParameter("volatility", chanKarolyiLongstaffSandersModel.volatility, chanKarolyiLongstaffSanders.model.volatility);
+    printTiming(readMilliseconds, calibrationMilliseconds, chanKarolyiLongstaffSanders.logLikelihood, chanKarolyiLongstaffSanders.likelihoodPasses);
+
+    // One likelihood evaluation as a plain loop, at the fitted parameters
+    start = std::chrono::steady_clock::now();
+    double plain = plainLogLikelihood(rates, chanKarolyiLongstaffSanders.model);
+    double plainMilliseconds = millisecondsSince(start);
+    start = std::chrono::steady_clock::now();
+    TransitionSums sums = sumTransitions<true>(rates, chanKarolyiLongstaffSanders.model.elasticity, defaultThreadPool());
+    double passMilliseconds = millisecondsSince(start);
+    WeightedRegression regression = solveWeightedRegression(sums, rates.size() - 1, chanKarolyiLongstaffSanders.model.elasticity);
+    std::cout << std::fixed << std::setprecision(1) << "CKLS likelihood at the fit: plain loop " << plainMilliseconds << " ms, pass "
+        << passMilliseconds << " ms (log-likelihood " << plain << " and " << regression.logLikelihood << ")\n";
+
+    std::remove("calibration_vasicek.csv");
+    std::remove("calibration_cir.csv");
+    std::remove("calibration_ckls.csv");
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+#include "../InterestRateModels/CsvWriter.h"
+#include "../InterestRateModels/HeathJarrowMortonEngine.h"
+
+/*
+ Benchmark of CSV output for a 10^5-path HJM run.
+
+ Writes the same forward curves with the iostream loop the simulators used
+ to have and with CsvWriter, both at 15 significant digits, and reports the
+ time and throughput of each.
+ */
+
+/*
+ Writes the curves one value at a time through std::ofstream.
+
+ @param forwardCurveStore The curves to write.
+ @param outputPath The path to the output CSV file.
+ */
+void writeWithOfstream(const ForwardCurveStore& forwardCurveStore, const std::string& outputPath)
+{
+    std::ofstream outputFile(outputPath);
+    outputFile << std::setprecision(15) << "Time,Path";
+    for (double maturity : forwardCurveStore.maturities)
+    {
+        outputFile << ",ForwardRate" << maturity;
+    }
+    outputFile << "\n";
+    for (int i = 0; i < forwardCurveStore.numberOfRecords(); ++i)
+    {
+        for (int path = 0; path < forwardCurveStore.numberOfPaths; ++path)
+        {
+            outputFile << forwardCurveStore.timeValues[i] << "," << path + 1;
+            const double* forwardCurve = forwardCurveStore.curve(i, path);
+            for (int maturity = 0; maturity < forwardCurveStore.numberOfMaturities; ++maturity)
+            {
+                outputFile << "," << forwardCurve[maturity];
+            }
+            outputFile << "\n";
+        }
+    }
+    outputFile.close();
+}
+
+/*
+ Writes the curves through CsvWriter.
+
+ @param forwardCurveStore The curves to write.
+ @param outputPath The path to the output CSV file.
+ */
+void writeWithCsvWriter(const ForwardCurveStore& forwardCurveStore, const std::string& outputPath)
+{
+    CsvWriter csvWriter(outputPath);
+    csvWriter.writeField("Time");
+    csvWriter.writeField("Path");
+    for (double maturity : forwardCurveStore.maturities)
+    {
+        csvWriter.writeField("ForwardRate", maturity);
+    }
+    csvWriter.endRow();
+    for (int i = 0; i < forwardCurveStore.numberOfRecords(); ++i)
+    {
+        for (int path = 0; path < forwardCurveStore.numberOfPaths; ++path)
+        {
+            csvWriter.writeField(forwardCurveStore.timeValues[i]);
+            csvWriter.writeField(path + 1);
+            const double* forwardCurve = forwardCurveStore.curve(i, path);
+            for (int maturity = 0; maturity < forwardCurveStore.numberOfMaturities; ++maturity)
+            {
+                csvWriter.writeField(forwardCurve[maturity]);
+            }
+            csvWriter.endRow();
+        }
+    }
+    csvWriter.close();
+}
+
+/*
+ Runs a writer once and returns the elapsed time in seconds and the file size in bytes.
+ */
+template <typename Writer>
+double measureSeconds(Writer write, const std::string& outputPath, long long& fileSize)
+{
+    auto start = std::chrono::steady_clock::now();
+    write();
+    auto stop = std::chrono::steady_clock::now();
+
+    std::ifstream writtenFile(outputPath, std::ios::binary | std::ios::ate);
+    fileSize = static_cast<long long>(writtenFile.tellg());
+    writtenFile.close();
+    std::remove(outputPath.c_str());
+    return std::chrono::duration<double>(stop - start).count();
+}
+
+int main()
+{
+    // Benchmark parameters: 10^5 paths, ten maturities, quarterly curves over one year
+    const int numberOfPaths = 100000;
+    const double timeHorizon = 1.0;
+    const double timeStep = 1.0 / 52.0;
+    const int recordInterval = 13;
+    const std::uint64_t seed = 42;
+
+    HeathJarrowMortonModel model;
+    model.initialForwardCurve = TimeCurve::constant(0.03);
+    model.maturities = { 0.25, 0.5, 1.0, 2.0, 3.0, 5.0, 7.0, 10.0, 20.0, 30.0 };
+    model.factors = { { 0.01, 0.0 }, { 0.015, 0.5 } };
+
+    ForwardCurveStore forwardCurveStore;
+    simulateForwardCurves(model, timeHorizon, timeStep, numberOfPaths, seed, recordInterval, forwardCurveStore);
+
+    std::string outputPath = "csv_writer_benchmark.csv";
+    long long ofstreamBytes = 0;
+    long long csvWriterBytes = 0;
+    double ofstreamTime = measureSeconds([&]() { writeWithOfstream(forwardCurveStore, outputPath); }, outputPath, ofstreamBytes);
+    double csvWriterTime = measureSeconds([&]() { writeWithCsvWriter(forwardCurveStore, outputPath); }, outputPath, csvWriterBytes);
+
+    std::cout << "Rows written: " << static_cast<long long>(forwardCurveStore.numberOfRecords()) * numberOfPaths << "\n";
+    std::cout << "std::ofstream: " << ofstreamTime << " s, " << ofstreamBytes / ofstreamTime / 1e6 << " MB/s\n";
+    std::cout << "CsvWriter:     " << csvWriterTime << " s, " << csvWriterBytes / csvWriterTime / 1e6 << " MB/s ("
+        << ofstreamTime / csvWriterTime << "x)\n";
+
+    return 0;
+}
\ No newline at end of file
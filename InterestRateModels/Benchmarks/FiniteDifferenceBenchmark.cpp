@@ -0,0 +1,143 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include "../InterestRateModels/BondPricing.h"
+#include "../InterestRateModels/FiniteDifferenceEngine.h"
+
+/*
+ Benchmark of the finite-difference engine against Monte Carlo.
+
+ Prices bonds maturing from 1 to 30 years for Vasicek, CIR and CKLS, by
+ finite differences on a few grids and by simulation, and reports the
+ largest error of each against the closed form, or for CKLS against a much
+ finer finite-difference grid. Then prices a batch of bond options, one
+ column per strike, and a batch of caps, one per cap rate, to show the cost
+ of a price once a sweep is shared.
+ */
+
+const std::vector<double> maturities = { 1.0, 2.0, 5.0, 10.0, 30.0 };
+const int numberOfPaths = 16384;
+const std::uint64_t seed = 5;
+
+/*
+ Returns the time of a call in milliseconds.
+
+ @param call The call to time.
+ */
+template <typename Call>
+double millisecondsFor(const Call& call)
+{
+    auto start = std::chrono::steady_clock::now();
+    call();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e3;
+}
+
+/*
+ Returns the largest absolute difference between two lists of prices.
+ */
+double largestError(const std::vector<double>& prices, const std::vector<double>& referencePrices)
+{
+    double error = 0.0;
+    for (std::size_t index = 0; index < prices.size(); ++index)
+    {
+        error = std::max(error, std::abs(prices[index] - referencePrices[index]));
+    }
+    return error;
+}
+
+/*
+ Prints one row per grid and one for Monte Carlo.
+
+ @param name The name of the model.
+ @param model The model.
+ @param referencePrices The prices to measure the errors against.
+ */
+template <typename Model>
+void compareBondPrices(const std::string& name, const Model& model, const std::vector<double>& referencePrices)
+{
+    for (int numberOfNodes : { 101, 201, 401 })
+    {
+        for (bool extrapolate : { false, true })
+        {
+            FiniteDifferenceSettings settings;
+            settings.numberOfNodes = numberOfNodes;
+            settings.extrapolate = extrapolate;
+            std::vector<double> prices;
+            double milliseconds = millisecondsFor([&]()
+            {
+                FiniteDifferenceEngine engine(model, maturities.back(), settings);
+                prices = engine.bondPrices(maturities);
+            });
+            std::string method = "FD " + std::to_string(numberOfNodes) + " nodes" + (extrapolate ? ", extrapolated" : "");
+            std::cout << std::setw(6) << name << std::setw(32) << method << std::scientific << std::setprecision(1)
+                << std::setw(12) << largestError(prices, referencePrices) << std::fixed << std::setprecision(2) << std::setw(12) << milliseconds << std::defaultfloat << "\n";
+        }
+    }
+
+    std::vector<BondPriceEstimate> estimates;
+    double milliseconds = millisecondsFor([&]() { estimates = priceZeroCouponBonds(model, maturities, 1.0 / 52.0, numberOfPaths, seed); });
+    std::vector<double> prices;
+    for (const BondPriceEstimate& estimate : estimates)
+    {
+        prices.push_back(estimate.price);
+    }
+    std::cout << std::setw(6) << name << std::setw(32) << "Monte Carlo, " + std::to_string(numberOfPaths) + " paths" << std::scientific << std::setprecision(1)
+        << std::setw(12) << largestError(prices, referencePrices) << std::fixed << std::setprecision(2) << std::setw(12) << milliseconds << std::defaultfloat << "\n";
+}
+
+int main()
+{
+    VasicekModel vasicek{ 0.1, 0.05, 0.01, 0.03 };
+    CoxIngersollRossModel coxIngersollRoss{ 0.06, 0.2, 0.08, 0.04 };
+    ChanKarolyiLongstaffSandersModel chanKarolyiLongstaffSanders{ 0.01, 0.2, 0.75, 0.05, 0.04 };
+
+    std::cout << "Bonds maturing at 1, 2, 5, 10 and 30 years\n\n";
+    std::cout << std::setw(6) << "model" << std::setw(32) << "method" << std::setw(12) << "max error" << std::setw(12) << "ms" << "\n";
+
+    std::vector<double> vasicekPrices;
+    std::vector<double> coxIngersollRossPrices;
+    for (const double& maturity : maturities)
+    {
+        vasicekPrices.push_back(analyticBondPrice(vasicek, maturity));
+        coxIngersollRossPrices.push_back(analyticBondPrice(coxIngersollRoss, maturity));
+    }
+    compareBondPrices("Vas", vasicek, vasicekPrices);
+    compareBondPrices("CIR", coxIngersollRoss, coxIngersollRossPrices);
+
+    FiniteDifferenceSettings referenceSettings;
+    referenceSettings.numberOfNodes = 1601;
+    referenceSettings.stepsPerYear = 400;
+    compareBondPrices("CKLS", chanKarolyiLongstaffSanders,
+        FiniteDifferenceEngine(chanKarolyiLongstaffSanders, maturities.back(), referenceSettings).bondPrices(maturities));
+
+    // A batch of European and American puts on the 10-year bond, expiring at 5 years
+    std::vector<BondOption> options;
+    for (int strike = 0; strike < 32; ++strike)
+    {
+        options.push_back({ 5.0, 10.0, 0.70 + 0.005 * strike, false, false });
+        options.push_back({ 5.0, 10.0, 0.70 + 0.005 * strike, false, true });
+    }
+    FiniteDifferenceEngine engine(vasicek, 10.0);
+    std::vector<double> prices;
+    double milliseconds = millisecondsFor([&]() { prices = engine.bondOptionPrices(options); });
+    std::cout << "\n" << options.size() << " bond options in one sweep: " << std::fixed << std::setprecision(2) << milliseconds << " ms, "
+        << 1e3 * milliseconds / options.size() << " us per option\n";
+
+    // A batch of 10-year caps on the quarterly rate, around the initial rate
+    std::vector<double> capRates;
+    for (int capRate = 0; capRate < 32; ++capRate)
+    {
+        capRates.push_back(0.01 + 0.001 * capRate);
+    }
+    milliseconds = millisecondsFor([&]() { prices = engine.capPrices(capRates, 10.0, 0.25); });
+    std::cout << capRates.size() << " quarterly 10-year caps in one sweep: " << milliseconds << " ms, "
+        << 1e3 * milliseconds / capRates.size() << " us per cap\n";
+
+    return 0;
+}
\ No newline at end of file
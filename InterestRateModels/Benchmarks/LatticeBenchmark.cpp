@@ -0,0 +1,90 @@
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <vector>
+
+#include "../InterestRateModels/BondPricing.h"
+#include "../InterestRateModels/TrinomialLattice.h"
+
+/*
+ Benchmark of the Hull-White trinomial lattice against Monte Carlo.
+
+ Prices a 30-year payer Bermudan swaption, exercisable yearly, on lattices
+ fitted to a flat curve with a growing number of steps per year, timing the
+ build and the backward induction separately, and checks the 30-year bond
+ against the curve. Then prices the same bond by simulating the model with
+ theta fitted to the same curve, which is all Monte Carlo gets for the time.
+ */
+
+const double meanReversion = 0.1;
+const double volatility = 0.01;
+const double zeroRate = 0.04;
+const double maturity = 30.0;
+const int numberOfRepeats = 20;
+const std::uint64_t seed = 11;
+
+/*
+ Returns the average time of a call in microseconds.
+
+ @param call The call to repeat.
+ */
+template <typename Call>
+double microsecondsPerCall(const Call& call)
+{
+    call();
+    auto start = std::chrono::steady_clock::now();
+    for (int repeat = 0; repeat < numberOfRepeats; ++repeat)
+    {
+        call();
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e6 / numberOfRepeats;
+}
+
+int main()
+{
+    HullWhiteModel model{ TimeCurve::constant(0.0), TimeCurve::constant(meanReversion), TimeCurve::constant(volatility), zeroRate };
+    TimeCurve zeroRates = TimeCurve::constant(zeroRate);
+    BermudanSwaption swaption = makeBermudanSwaption(zeroRate, 1.0, maturity, 1.0, true);
+    double exactBondPrice = std::exp(-zeroRate * maturity);
+
+    std::cout << "30-year payer Bermudan swaption at " << zeroRate << ", a = " << meanReversion << ", sigma = " << volatility << "\n\n";
+    std::cout << std::setw(12) << "steps/year" << std::setw(10) << "nodes" << std::setw(14) << "price"
+        << std::setw(14) << "bond error" << std::setw(12) << "build us" << std::setw(12) << "price us" << "\n";
+    for (int stepsPerYear : { 4, 12, 26, 52, 104 })
+    {
+        int numberOfSteps = static_cast<int>(maturity) * stepsPerYear;
+        TrinomialLattice lattice = buildTrinomialLattice(model, zeroRates, maturity, numberOfSteps);
+        double price = 0.0;
+        double buildTime = microsecondsPerCall([&]() { lattice = buildTrinomialLattice(model, zeroRates, maturity, numberOfSteps); });
+        double priceTime = microsecondsPerCall([&]() { price = priceBermudanSwaption(lattice, swaption); });
+        std::cout << std::setw(12) << stepsPerYear << std::setw(10) << lattice.width() << std::fixed << std::setprecision(6)
+            << std::setw(14) << price << std::scientific << std::setprecision(1) << std::setw(14) << latticeBondPrice(lattice, maturity) - exactBondPrice
+            << std::fixed << std::setprecision(1) << std::setw(12) << buildTime << std::setw(12) << priceTime << std::defaultfloat << "\n";
+    }
+
+    // theta(t) = a f + sigma^2 (1 - exp(-2 a t)) / (2 a) fits the flat forward curve f
+    std::vector<double> thetaTimes;
+    std::vector<double> thetaValues;
+    for (int knot = 0; knot <= 30 * 52; ++knot)
+    {
+        double time = knot / 52.0;
+        thetaTimes.push_back(time);
+        thetaValues.push_back(meanReversion * zeroRate + volatility * volatility * -std::expm1(-2.0 * meanReversion * time) / (2.0 * meanReversion));
+    }
+    model.theta = TimeCurve{ thetaTimes, thetaValues, CurveInterpolation::Linear };
+
+    std::cout << "\nMonte Carlo, weekly steps\n\n";
+    std::cout << std::setw(12) << "paths" << std::setw(14) << "bond price" << std::setw(14) << "std error" << std::setw(14) << "exact" << std::setw(12) << "ms" << "\n";
+    for (int numberOfPaths : { 1024, 16384 })
+    {
+        auto start = std::chrono::steady_clock::now();
+        BondPriceEstimate estimate = priceZeroCouponBonds(model, { maturity }, 1.0 / 52.0, numberOfPaths, seed).front();
+        double milliseconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e3;
+        std::cout << std::setw(12) << numberOfPaths << std::fixed << std::setprecision(6) << std::setw(14) << estimate.price
+            << std::setw(14) << estimate.standardError << std::setw(14) << exactBondPrice << std::setprecision(1) << std::setw(12) << milliseconds << std::defaultfloat << "\n";
+    }
+
+    return 0;
+}
\ No newline at end of file
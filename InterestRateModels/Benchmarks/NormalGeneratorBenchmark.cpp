@@ -0,0 +1,87 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "../InterestRateModels/CounterRandom.h"
+
+/*
+ Microbenchmark of standard normal generation.
+
+ Compares the one-sample-at-a-time std::normal_distribution over mt19937
+ that the simulators used to call with the block generators in
+ CounterRandom.h and NormalGenerator.h.
+ */
+
+/*
+ Runs a generator repeatedly and returns the best time per normal in nanoseconds.
+
+ @param generate Fills the benchmark buffer once.
+ @param numberOfNormals The number of normals one call produces.
+ @param numberOfRepetitions The number of timed calls.
+ */
+template <typename Generator>
+double measureNanosecondsPerNormal(Generator generate, const std::size_t& numberOfNormals, const int& numberOfRepetitions)
+{
+    double bestSeconds = 1e300;
+    for (int repetition = 0; repetition < numberOfRepetitions; ++repetition)
+    {
+        auto start = std::chrono::steady_clock::now();
+        generate();
+        auto stop = std::chrono::steady_clock::now();
+        bestSeconds = std::min(bestSeconds, std::chrono::duration<double>(stop - start).count());
+    }
+    return bestSeconds * 1e9 / static_cast<double>(numberOfNormals);
+}
+
+int main()
+{
+    // Benchmark parameters
+    const std::size_t numberOfNormals = 1 << 22;
+    const int numberOfRepetitions = 5;
+    const std::uint64_t seed = 42;
+    std::vector<double> normals(numberOfNormals);
+    double checksum = 0.0;
+
+    // One std::normal_distribution sample per call
+    std::mt19937 randomGenerator(static_cast<unsigned int>(seed));
+    std::normal_distribution<double> standardNormalDistribution(0.0, 1.0);
+    double standardTime = measureNanosecondsPerNormal([&]()
+    {
+        for (std::size_t i = 0; i < numberOfNormals; ++i)
+        {
+            normals[i] = standardNormalDistribution(randomGenerator);
+        }
+    }, numberOfNormals, numberOfRepetitions);
+    checksum += normals[numberOfNormals - 1];
+
+    // Block fill from one counter-based stream
+    double streamTime = measureNanosecondsPerNormal([&]()
+    {
+        CounterRandomStream randomStream(seed, 0, 0);
+        fillStandardNormals(randomStream, normals.data(), numberOfNormals);
+    }, numberOfNormals, numberOfRepetitions);
+    checksum += normals[numberOfNormals - 1];
+
+    // Rows of increments across paths, as the path engine draws them
+    const int numberOfPaths = 1024;
+    double rowTime = measureNanosecondsPerNormal([&]()
+    {
+        std::size_t numberOfBlocks = numberOfNormals / (2 * numberOfPaths);
+        for (std::size_t block = 0; block < numberOfBlocks; ++block)
+        {
+            fillIncrementPair(seed, static_cast<std::uint32_t>(block), 0, numberOfPaths, normals.data(), normals.data() + numberOfPaths);
+        }
+    }, numberOfNormals, numberOfRepetitions);
+    checksum += normals[0];
+
+    std::cout << "Normals per run: " << numberOfNormals << "\n";
+    std::cout << "std::normal_distribution + mt19937: " << standardTime << " ns/normal\n";
+    std::cout << "CounterRandomStream block fill:     " << streamTime << " ns/normal ("
+        << standardTime / streamTime << "x)\n";
+    std::cout << "fillIncrementPair path rows:        " << rowTime << " ns/normal ("
+        << standardTime / rowTime << "x)\n";
+    std::cout << "Checksum: " << checksum << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include "../InterestRateModels/ResultFile.h"
+#include "../InterestRateModels/ShortRateModels.h"
+
+/*
+ Benchmark of sparse observation dates and checkpointed resumption.
+
+ Simulates daily Vasicek paths over 30 years and compares keeping every
+ step in a PathStore with keeping month ends in an ObservedPathStore: the
+ time, the memory held and the size of the binary result file. Then
+ extends a 10-year run to 30 years, once by simulating the 30 years again
+ and once by resuming from the checkpoint at 10 years, and checks that both
+ give the same month-end rates.
+ */
+
+const double timeStep = 1.0 / 252.0;
+const double timeHorizon = 30.0;
+const int numberOfPaths = 4096;
+const std::uint64_t seed = 21;
+
+/*
+ Returns the time of a call in milliseconds.
+
+ @param call The call to time.
+ */
+template <typename Call>
+double millisecondsFor(const Call& call)
+{
+    auto start = std::chrono::steady_clock::now();
+    call();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e3;
+}
+
+/*
+ Returns the size of a file in megabytes and removes it.
+ */
+double takeFileSize(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    double megabytes = static_cast<double>(file.tellg()) / (1 << 20);
+    file.close();
+    std::remove(path.c_str());
+    return megabytes;
+}
+
+int main()
+{
+    VasicekModel model{ 0.1, 0.05, 0.01, 0.03 };
+    std::vector<ResultParameter> parameters = { { "meanReversionSpeed", model.meanReversionSpeed }, { "longTermInterestRate", model.longTermInterestRate },
+        { "volatility", model.volatility }, { "initialInterestRate", model.initialInterestRate } };
+    SimulationContext context;
+
+    std::cout << numberOfPaths << " Vasicek paths, daily steps over " << timeHorizon << " years\n\n";
+    std::cout << std::setw(12) << "storage" << std::setw(10) << "rows" << std::setw(12) << "sim ms" << std::setw(12) << "memory MB"
+        << std::setw(12) << "write ms" << std::setw(12) << "file MB" << "\n";
+
+    // Every step
+    PathStore pathStore;
+    simulatePathBatch(model, timeHorizon, timeStep, numberOfPaths, seed, pathStore, context);
+    double simulationTime = millisecondsFor([&]() { simulatePathBatch(model, timeHorizon, timeStep, numberOfPaths, seed, pathStore, context); });
+    double writeTime = millisecondsFor([&]() { writeResultFile("observation_benchmark_full.irm", "Vasicek", parameters, seed, pathStore); });
+    std::cout << std::setw(12) << "every step" << std::setw(10) << pathStore.numberOfTimeSteps + 1 << std::fixed << std::setprecision(1)
+        << std::setw(12) << simulationTime << std::setw(12) << pathStore.rateValues.size() * sizeof(double) / double(1 << 20)
+        << std::setw(12) << writeTime << std::setw(12) << takeFileSize("observation_benchmark_full.irm") << std::defaultfloat << "\n";
+    pathStore = PathStore();
+
+    // Month ends only
+    ObservedPathStore observedPathStore(ObservationSchedule::every(1.0 / 12.0, timeHorizon));
+    simulateObservedPaths(model, timeStep, numberOfPaths, seed, observedPathStore, context);
+    simulationTime = millisecondsFor([&]() { simulateObservedPaths(model, timeStep, numberOfPaths, seed, observedPathStore, context); });
+    writeTime = millisecondsFor([&]() { writeResultFile("observation_benchmark_monthly.irm", "Vasicek", parameters, seed, observedPathStore); });
+    std::cout << std::setw(12) << "month ends" << std::setw(10) << observedPathStore.numberOfObservations() << std::fixed << std::setprecision(1)
+        << std::setw(12) << simulationTime << std::setw(12) << observedPathStore.rateValues.size() * sizeof(double) / double(1 << 20)
+        << std::setw(12) << writeTime << std::setw(12) << takeFileSize("observation_benchmark_monthly.irm") << std::defaultfloat << "\n";
+
+    // A 10-year run with a checkpoint at its horizon, extended to 30 years
+    ObservationSchedule firstSchedule = ObservationSchedule::every(1.0 / 12.0, 10.0);
+    firstSchedule.checkpointTimes = { 10.0 };
+    ObservedPathStore extended(firstSchedule);
+    double firstTime = millisecondsFor([&]() { simulateObservedPaths(model, timeStep, numberOfPaths, seed, extended, context); });
+    ObservedPathStore remainder(ObservationSchedule::every(1.0 / 12.0, timeHorizon));
+    double resumeTime = millisecondsFor([&]()
+    {
+        resumeObservedPaths(model, extended.checkpointAt(10.0), remainder, context);
+        extended.append(remainder);
+    });
+
+    double largestDifference = 0.0;
+    for (int observation = 0; observation < observedPathStore.numberOfObservations(); ++observation)
+    {
+        for (int path = 0; path < numberOfPaths; ++path)
+        {
+            largestDifference = std::max(largestDifference, std::abs(extended.rate(observation, path) - observedPathStore.rate(observation, path)));
+        }
+    }
+    std::cout << "\nExtending a 10-year run (" << std::fixed << std::setprecision(1) << firstTime << " ms) to 30 years: "
+        << resumeTime << " ms from its checkpoint, against " << simulationTime << " ms from the start; largest difference "
+        << std::defaultfloat << largestDifference << " over " << extended.numberOfObservations() << " month ends\n";
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <vector>
+
+#include "../InterestRateModels/BondPricing.h"
+#include "../InterestRateModels/IncrementSource.h"
+#include "../InterestRateModels/ShortRateModels.h"
+
+/*
+ Convergence benchmark of quasi-Monte Carlo against pseudo-random sampling.
+
+ Prices a five-year zero-coupon bond with monthly steps (60 dimensions) as
+ the plain average of exp(-int r), without the control variate, so the only
+ difference between the runs is where the increments come from. For every
+ path count the error is the root mean square over independent replicates
+ (seeds for the counter-based streams, scrambles for Sobol) against a
+ reference from a large scrambled Sobol run, which removes the
+ discretization bias the two samplers share. Since pseudo-random error falls
+ like 1/sqrt(N), the squared error ratio is how many times more paths it
+ needs for the error of the Sobol run.
+ */
+
+/*
+ Returns the plain Monte Carlo price of the bond for one replicate.
+
+ @param model The short-rate model to simulate.
+ @param maturity The maturity of the bond, on the time grid.
+ @param timeStep The time step of the simulation.
+ @param numberOfPaths The number of paths to simulate.
+ @param incrementSource The source of the increments.
+ */
+template <typename Model, typename IncrementSource>
+double plainBondPrice(const Model& model, const double& maturity, const double& timeStep, const int& numberOfPaths, IncrementSource& incrementSource)
+{
+    BondPricingSink sink({ maturity });
+    simulatePaths(model, maturity + 0.5 * timeStep, timeStep, numberOfPaths, 1, incrementSource, sink, defaultThreadPool());
+    return sink.payoffs[0].meanY;
+}
+
+/*
+ Prints the error of both samplers against the path count for one model.
+
+ @param modelName The name of the model.
+ @param model The short-rate model to simulate.
+ */
+template <typename Model>
+void runConvergence(const char* modelName, const Model& model)
+{
+    const double maturity = 5.0;
+    const double timeStep = 1.0 / 12.0;
+    const int numberOfReplicates = 16;
+
+    // Reference: the average of eight scrambled Sobol runs of 2^20 paths
+    double referencePrice = 0.0;
+    for (int replicate = 0; replicate < 8; ++replicate)
+    {
+        SobolIncrementSource sobolSource(1000 + replicate);
+        referencePrice += plainBondPrice(model, maturity, timeStep, 1 << 20, sobolSource) / 8.0;
+    }
+
+    std::cout << modelName << ": five-year bond, reference price " << std::setprecision(10) << referencePrice << "\n";
+    std::cout << std::setw(9) << "Paths" << std::setw(16) << "Pseudo-random" << std::setw(16) << "Sobol" << std::setw(14) << "Paths saved"
+        << std::setw(14) << "Random ms" << std::setw(12) << "Sobol ms" << "\n";
+    for (int exponent = 10; exponent <= 18; exponent += 2)
+    {
+        int numberOfPaths = 1 << exponent;
+        double pseudoRandomSquaredError = 0.0;
+        double sobolSquaredError = 0.0;
+        double pseudoRandomSeconds = 0.0;
+        double sobolSeconds = 0.0;
+        for (int replicate = 0; replicate < numberOfReplicates; ++replicate)
+        {
+            auto start = std::chrono::steady_clock::now();
+            CounterIncrementSource counterSource(static_cast<std::uint64_t>(replicate) + 1);
+            double pseudoRandomError = plainBondPrice(model, maturity, timeStep, numberOfPaths, counterSource) - referencePrice;
+            auto middle = std::chrono::steady_clock::now();
+            SobolIncrementSource sobolSource(static_cast<std::uint64_t>(replicate) + 1);
+            double sobolError = plainBondPrice(model, maturity, timeStep, numberOfPaths, sobolSource) - referencePrice;
+            auto stop = std::chrono::steady_clock::now();
+
+            pseudoRandomSquaredError += pseudoRandomError * pseudoRandomError / numberOfReplicates;
+            pseudoRandomSeconds += std::chrono::duration<double>(middle - start).count() / numberOfReplicates;
+            sobolSquaredError += sobolError * sobolError / numberOfReplicates;
+            sobolSeconds += std::chrono::duration<double>(stop - middle).count() / numberOfReplicates;
+        }
+
+        std::cout << std::setw(9) << numberOfPaths << std::scientific << std::setprecision(3)
+            << std::setw(16) << std::sqrt(pseudoRandomSquaredError) << std::setw(16) << std::sqrt(sobolSquaredError)
+            << std::fixed << std::setprecision(0) << std::setw(13) << pseudoRandomSquaredError / sobolSquaredError << "x"
+            << std::setprecision(2) << std::setw(14) << pseudoRandomSeconds * 1e3 << std::setw(12) << sobolSeconds * 1e3
+            << std::defaultfloat << "\n";
+    }
+    std::cout << "\n";
+}
+
+int main()
+{
+    runConvergence("Vasicek", VasicekModel{ 0.3, 0.05, 0.02, 0.03 });
+    runConvergence("Cox-Ingersoll-Ross", CoxIngersollRossModel{ 0.05, 0.3, 0.1, 0.03 });
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../InterestRateModels/SimulationServer.h"
+
+/*
+ Latency benchmark of the simulation server.
+
+ Starts a server on a thread of this process and sends it Vasicek requests
+ over the socket from 1 and from 8 client threads, each client waiting for
+ every reply before sending its next request. Reports the round-trip
+ latency percentiles, the throughput and the average batch the server
+ formed from concurrent requests. For comparison, the same requests are
+ also run in-process through runServerBatch(), which is the floor the
+ socket adds to.
+ */
+
+const char* socketPath = "irm_server_benchmark.sock";
+const int smallRequestsPerClient = 400;
+const int largeRequestsPerClient = 25;
+
+ServerRequest makeRequest(const int& numberOfPaths, const double& timeStep)
+{
+    ServerRequest request;
+    request.model = 0;
+    request.scheme = SweepScheme::Exact;
+    request.numberOfPaths = numberOfPaths;
+    request.timeHorizon = 1.0;
+    request.timeStep = timeStep;
+    request.seed = 7;
+    request.parameters = { 0.3, 0.04, 0.01, 0.03 };
+    return request;
+}
+
+double percentile(std::vector<double> values, const double& fraction)
+{
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<std::size_t>(fraction * values.size()))];
+}
+
+/*
+ Runs clients against the server and prints a row of latencies in microseconds.
+
+ @param server The server, to read its batch count.
+ @param name The name of the row.
+ @param request The request every client sends.
+ @param numberOfClients The number of concurrent clients.
+ @param requestsPerClient The number of requests each client sends.
+ */
+void measureLatency(const SimulationServer& server, const std::string& name, const ServerRequest& request, const int& numberOfClients,
+    const int& requestsPerClient)
+{
+    std::vector<std::vector<double>> clientLatencies(static_cast<std::size_t>(numberOfClients));
+    std::uint64_t firstBatches = server.numberOfBatches();
+    std::uint64_t firstRequests = server.numberOfRequests();
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> clients;
+    for (int clientIndex = 0; clientIndex < numberOfClients; ++clientIndex)
+    {
+        clients.emplace_back([&, clientIndex]()
+        {
+            SimulationClient client(socketPath);
+            ServerRequest clientRequest = request;
+            for (int i = 0; i < requestsPerClient; ++i)
+            {
+                clientRequest.requestId = static_cast<std::uint32_t>(i);
+                auto sent = std::chrono::steady_clock::now();
+                ServerReply reply = client.simulate(clientRequest);
+                clientLatencies[clientIndex].push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - sent).count() * 1e6);
+                if (reply.status != serverStatusOk || reply.requestId != clientRequest.requestId)
+                {
+                    throw std::runtime_error("Unexpected reply: " + reply.message);
+                }
+            }
+        });
+    }
+    for (std::thread& client : clients)
+    {
+        client.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> latencies;
+    for (const std::vector<double>& values : clientLatencies)
+    {
+        latencies.insert(latencies.end(), values.begin(), values.end());
+    }
+    double batchSize = static_cast<double>(server.numberOfRequests() - firstRequests) / static_cast<double>(server.numberOfBatches() - firstBatches);
+    std::cout << std::setw(26) << name << std::fixed << std::setprecision(0) << std::setw(10) << percentile(latencies, 0.5)
+        << std::setw(10) << percentile(latencies, 0.9) << std::setw(10) << percentile(latencies, 0.99) << std::setw(12)
+        << latencies.size() / seconds << std::setprecision(1) << std::setw(10) << batchSize << std::defaultfloat << "\n";
+}
+
+/*
+ Runs the request in-process and prints its time in microseconds.
+ */
+void measureInProcess(const std::string& name, const ServerRequest& request, const int& numberOfRequests)
+{
+    std::vector<double> latencies;
+    std::vector<ServerRequest> batch = { request };
+    for (int i = 0; i < numberOfRequests; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        runServerBatch(batch);
+        latencies.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e6);
+    }
+    std::cout << std::setw(26) << name << std::fixed << std::setprecision(0) << std::setw(10) << percentile(latencies, 0.5)
+        << std::setw(10) << percentile(latencies, 0.9) << std::setw(10) << percentile(latencies, 0.99) << std::defaultfloat << "\n";
+}
+
+int main()
+{
+    SimulationServer server(socketPath);
+    std::thread serverThread([&]() { server.run(); });
+    std::cout << smallRequestsPerClient << " small and " << largeRequestsPerClient << " large requests per client, " << defaultThreadPool().numberOfThreads() << " threads\n\n";
+
+    ServerRequest smallRequest = makeRequest(1024, 1.0 / 52.0);
+    ServerRequest largeRequest = makeRequest(16384, 1.0 / 252.0);
+    std::cout << std::setw(26) << "us" << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99" << std::setw(12)
+        << "requests/s" << std::setw(10) << "batch" << "\n";
+    measureInProcess("1024 x 52, in-process", smallRequest, smallRequestsPerClient);
+    measureLatency(server, "1024 x 52, 1 client", smallRequest, 1, smallRequestsPerClient);
+    measureLatency(server, "1024 x 52, 8 clients", smallRequest, 8, smallRequestsPerClient);
+    measureInProcess("16384 x 252, in-process", largeRequest, largeRequestsPerClient);
+    measureLatency(server, "16384 x 252, 1 client", largeRequest, 1, largeRequestsPerClient);
+    measureLatency(server, "16384 x 252, 8 clients", largeRequest, 8, largeRequestsPerClient);
+
+    server.stop();
+    serverThread.join();
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "../InterestRateModels/HeathJarrowMortonEngine.h"
+#include "../InterestRateModels/PathEngine.h"
+#include "../InterestRateModels/ShortRateModels.h"
+
+/*
+ Benchmark of the allocations made by repeated small simulations.
+
+ Counts the calls to the global operator new made by each simulation call,
+ after a few warm-up calls, three ways: with a fresh result returned by
+ value, into a reused store without a context, and into a reused store with
+ a reused SimulationContext. The last should make no allocations at all.
+ */
+
+const int numberOfCalls = 2000;
+const int numberOfWarmUpCalls = 10;
+const std::uint64_t seed = 3;
+
+std::atomic<long long> allocationCount{ 0 };
+
+void* operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* data = std::malloc(size == 0 ? 1 : size))
+    {
+        return data;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* data) noexcept
+{
+    std::free(data);
+}
+
+void operator delete(void* data, std::size_t) noexcept
+{
+    std::free(data);
+}
+
+/*
+ Runs a simulation call repeatedly and prints its allocations and time per call.
+
+ @param name The name of the row.
+ @param simulate The call to repeat.
+ */
+template <typename Simulate>
+void measureCalls(const std::string& name, const Simulate& simulate)
+{
+    for (int call = 0; call < numberOfWarmUpCalls; ++call)
+    {
+        simulate();
+    }
+    long long firstCount = allocationCount.load();
+    auto start = std::chrono::steady_clock::now();
+    for (int call = 0; call < numberOfCalls; ++call)
+    {
+        simulate();
+    }
+    double microseconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e6 / numberOfCalls;
+    double allocations = static_cast<double>(allocationCount.load() - firstCount) / numberOfCalls;
+    std::cout << std::setw(34) << name << std::fixed << std::setprecision(1) << std::setw(14) << allocations
+        << std::setw(14) << microseconds << std::defaultfloat << "\n";
+}
+
+int main()
+{
+    std::cout << numberOfCalls << " calls each, " << defaultThreadPool().numberOfThreads() << " threads\n\n";
+    std::cout << std::setw(34) << "call" << std::setw(14) << "allocations" << std::setw(14) << "us per call" << "\n";
+
+    // Vasicek, 256 paths of 64 Euler steps
+    VasicekModel vasicekModel{ 0.3, 0.04, 0.01, 0.03 };
+    double timeHorizon = 1.0;
+    double timeStep = 1.0 / 64.0;
+    int numberOfPaths = 256;
+    double checksum = 0.0;
+    measureCalls("Vasicek, fresh PathStore", [&]()
+    {
+        PathStore pathStore = simulatePathBatch(vasicekModel, timeHorizon, timeStep, numberOfPaths, seed);
+        checksum += pathStore.rate(pathStore.numberOfTimeSteps, 0);
+    });
+    PathStore pathStore;
+    measureCalls("Vasicek, reused PathStore", [&]()
+    {
+        simulatePathBatch(vasicekModel, timeHorizon, timeStep, numberOfPaths, seed, pathStore);
+        checksum += pathStore.rate(pathStore.numberOfTimeSteps, 0);
+    });
+    SimulationContext context;
+    measureCalls("Vasicek, reused PathStore, context", [&]()
+    {
+        simulatePathBatch(vasicekModel, timeHorizon, timeStep, numberOfPaths, seed, pathStore, context);
+        checksum += pathStore.rate(pathStore.numberOfTimeSteps, 0);
+    });
+
+    // Two-factor HJM, 64 paths of 100 steps on 8 maturities
+    HeathJarrowMortonModel model;
+    model.initialForwardCurve = TimeCurve::constant(0.03);
+    model.maturities = { 0.25, 0.5, 1.0, 2.0, 3.0, 5.0, 7.0, 10.0 };
+    model.factors = { { 0.01, 0.0 }, { 0.015, 0.5 } };
+    int numberOfCurves = 64;
+    measureCalls("HJM, fresh ForwardCurveStore", [&]()
+    {
+        ForwardCurveStore forwardCurveStore;
+        simulateForwardCurves(model, timeHorizon, 0.01, numberOfCurves, seed, 10, forwardCurveStore);
+        checksum += forwardCurveStore.forwardRate(0, 0, 0);
+    });
+    ForwardCurveStore forwardCurveStore;
+    measureCalls("HJM, reused ForwardCurveStore", [&]()
+    {
+        simulateForwardCurves(model, timeHorizon, 0.01, numberOfCurves, seed, 10, forwardCurveStore);
+        checksum += forwardCurveStore.forwardRate(0, 0, 0);
+    });
+    measureCalls("HJM, reused store, context", [&]()
+    {
+        simulateForwardCurves(model, timeHorizon, 0.01, numberOfCurves, seed, 10, forwardCurveStore, context);
+        checksum += forwardCurveStore.forwardRate(0, 0, 0);
+    });
+
+    std::cout << "\nArena capacity " << context.arena.capacity() << " bytes, checksum " << checksum << "\n";
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "../InterestRateModels/AdjointGreeks.h"
+#include "../InterestRateModels/BondPricing.h"
+#include "CheckReport.h"
+
+/*
+ Check that the adjoint bond sensitivities are the derivatives of the price.
+
+ For every model prices a 5-year bond on weekly steps with all its
+ sensitivities, and compares each with the central difference of two
+ plain pricing runs on the same seed, relative to the larger of one and
+ the sensitivity. With the same paths the two agree to the size of the
+ bump. Then checks that the checkpoint interval of the reverse pass does
+ not change the result. Exits with status 1 if any differs by more than
+ the tolerance.
+ */
+
+const double maturity = 5.0;
+const double timeStep = 1.0 / 52.0;
+const int numberOfPaths = 4096;
+const std::uint64_t seed = 17;
+const double bumpSize = 1e-6;
+const double tolerance = 1e-6;
+
+/*
+ Returns the plain Monte Carlo price of the bond, on the paths the adjoint run uses.
+ */
+template <typename Model>
+double plainBondPrice(const Model& model)
+{
+    return priceZeroCouponBonds(model, { maturity }, timeStep, numberOfPaths, seed).front().plainPrice;
+}
+
+/*
+ Returns one bump per field, in the order given.
+ */
+template <typename Model>
+std::vector<std::function<void(Model&, double)>> fieldBumps(const std::vector<double Model::*>& fields)
+{
+    std::vector<std::function<void(Model&, double)>> bumps;
+    for (double Model::*field : fields)
+    {
+        bumps.push_back([field](Model& model, double shift) { model.*field += shift; });
+    }
+    return bumps;
+}
+
+/*
+ Returns the largest relative difference between the adjoint and bumped sensitivities of a model.
+
+ @param model The model.
+ @param bumps One function per sensitivity, in the order of priceZeroCouponBondGreeks(), that shifts the parameter by an amount.
+ */
+template <typename Model>
+double largestSensitivityError(const Model& model, const std::vector<std::function<void(Model&, double)>>& bumps)
+{
+    BondGreeks greeks = priceZeroCouponBondGreeks(model, maturity, timeStep, numberOfPaths, seed);
+    if (greeks.sensitivities.size() != bumps.size())
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+    double error = std::abs(greeks.price - plainBondPrice(model));
+    for (std::size_t parameter = 0; parameter < bumps.size(); ++parameter)
+    {
+        Model up = model;
+        Model down = model;
+        bumps[parameter](up, bumpSize);
+        bumps[parameter](down, -bumpSize);
+        double bumped = (plainBondPrice(up) - plainBondPrice(down)) / (2.0 * bumpSize);
+        error = std::max(error, std::abs(greeks.sensitivities[parameter].value - bumped) / std::max(1.0, std::abs(bumped)));
+    }
+    return error;
+}
+
+int main()
+{
+    VasicekModel vasicek{ 0.1, 0.05, 0.01, 0.03 };
+    CoxIngersollRossModel coxIngersollRoss{ 0.06, 0.2, 0.08, 0.04 };
+    ChanKarolyiLongstaffSandersModel chanKarolyiLongstaffSanders{ 0.01, 0.2, 0.75, 0.05, 0.04 };
+    ConstantElasticityVarianceModel constantElasticityVariance{ 0.2, 0.01, 0.75, 0.05, 0.04 };
+    HoAndLeeModel hoAndLee{ 0.002, 0.008, 0.03 };
+    HullWhiteModel hullWhite{ TimeCurve{ { 0.0, 1.0, 2.0, 3.0, 4.0 }, { 0.004, 0.0045, 0.005, 0.0055, 0.006 }, CurveInterpolation::Linear },
+        TimeCurve{ { 0.0, 5.0 }, { 0.1, 0.12 }, CurveInterpolation::Linear },
+        TimeCurve{ { 0.0, 5.0 }, { 0.01, 0.012 }, CurveInterpolation::Linear }, 0.03 };
+
+    bool passed = true;
+    passed &= reportCheck("Vasicek against bumps", largestSensitivityError(vasicek, fieldBumps<VasicekModel>({ &VasicekModel::initialInterestRate,
+        &VasicekModel::meanReversionSpeed, &VasicekModel::longTermInterestRate, &VasicekModel::volatility })), tolerance);
+    passed &= reportCheck("CIR against bumps", largestSensitivityError(coxIngersollRoss, fieldBumps<CoxIngersollRossModel>({ &CoxIngersollRossModel::initialInterestRate,
+        &CoxIngersollRossModel::meanReversionLevel, &CoxIngersollRossModel::meanReversionRate, &CoxIngersollRossModel::volatility })), tolerance);
+    passed &= reportCheck("CKLS against bumps", largestSensitivityError(chanKarolyiLongstaffSanders, fieldBumps<ChanKarolyiLongstaffSandersModel>({
+        &ChanKarolyiLongstaffSandersModel::initialInterestRate, &ChanKarolyiLongstaffSandersModel::driftTerm, &ChanKarolyiLongstaffSandersModel::meanReversionRate,
+        &ChanKarolyiLongstaffSandersModel::elasticity, &ChanKarolyiLongstaffSandersModel::volatility })), tolerance);
+    passed &= reportCheck("CEV against bumps", largestSensitivityError(constantElasticityVariance, fieldBumps<ConstantElasticityVarianceModel>({
+        &ConstantElasticityVarianceModel::initialInterestRate, &ConstantElasticityVarianceModel::meanReversionRate, &ConstantElasticityVarianceModel::driftTerm,
+        &ConstantElasticityVarianceModel::elasticity, &ConstantElasticityVarianceModel::volatility })), tolerance);
+    passed &= reportCheck("Ho-Lee against bumps", largestSensitivityError(hoAndLee, fieldBumps<HoAndLeeModel>({ &HoAndLeeModel::initialInterestRate,
+        &HoAndLeeModel::driftTerm, &HoAndLeeModel::volatility })), tolerance);
+
+    std::vector<std::function<void(HullWhiteModel&, double)>> hullWhiteBumps = fieldBumps<HullWhiteModel>({ &HullWhiteModel::initialInterestRate });
+    for (TimeCurve HullWhiteModel::*curve : { &HullWhiteModel::theta, &HullWhiteModel::alpha, &HullWhiteModel::sigma })
+    {
+        for (std::size_t knot = 0; knot < (hullWhite.*curve).values.size(); ++knot)
+        {
+            hullWhiteBumps.push_back([curve, knot](HullWhiteModel& model, double shift) { (model.*curve).values[knot] += shift; });
+        }
+    }
+    passed &= reportCheck("Hull-White against bumps, every knot", largestSensitivityError(hullWhite, hullWhiteBumps), tolerance);
+
+    // The reverse pass of CIR with a checkpoint every step pair, every 7 steps and at the default interval
+    std::vector<double> referenceValues;
+    double intervalError = 0.0;
+    for (int checkpointInterval : { 2, 7, 0 })
+    {
+        AdjointSettings settings;
+        settings.checkpointInterval = checkpointInterval;
+        BondGreeks greeks = priceZeroCouponBondGreeks(coxIngersollRoss, maturity, timeStep, numberOfPaths, seed, settings);
+        for (std::size_t parameter = 0; parameter < greeks.sensitivities.size(); ++parameter)
+        {
+            if (referenceValues.size() < greeks.sensitivities.size())
+            {
+                referenceValues.push_back(greeks.sensitivities[parameter].value);
+            }
+            intervalError = std::max(intervalError, std::abs(greeks.sensitivities[parameter].value - referenceValues[parameter]));
+        }
+    }
+    passed &= reportCheck("CIR across checkpoint intervals", intervalError, tolerance);
+
+    return passed ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "../InterestRateModels/BondPricing.h"
+#include "CheckReport.h"
+
+/*
+ Check that the closed-form bond prices agree with Monte Carlo.
+
+ Prices bonds maturing at 1, 5 and 10 years for Vasicek, CIR and Ho-Lee by
+ simulation with the control variate, on daily steps so the discretization
+ bias stays below the standard error, and measures the distance of each
+ estimate from analyticBondPrice() in standard errors. The plain estimate
+ is measured the same way against its own standard error. Exits with
+ status 1 if any is further than the tolerance.
+ */
+
+const std::vector<double> maturities = { 1.0, 5.0, 10.0 };
+const double timeStep = 1.0 / 252.0;
+const int numberOfPaths = 50000;
+const std::uint64_t seed = 3;
+const double maximumStandardErrors = 4.0;
+
+/*
+ Returns the largest distance of the estimates from the closed form, in standard errors.
+
+ @param model The model to simulate, possibly wrapped in a scheme.
+ @param controlled Whether to measure the estimate with the control variate rather than the plain one.
+ */
+template <typename Model>
+double largestStandardErrors(const Model& model, const bool& controlled)
+{
+    double largest = 0.0;
+    for (const BondPriceEstimate& estimate : priceZeroCouponBonds(model, maturities, timeStep, numberOfPaths, seed))
+    {
+        double error = controlled ? std::abs(estimate.price - estimate.analyticPrice) / estimate.standardError
+                                  : std::abs(estimate.plainPrice - estimate.analyticPrice) / estimate.plainStandardError;
+        largest = std::max(largest, std::isnan(error) ? std::numeric_limits<double>::infinity() : error);
+    }
+    return largest;
+}
+
+int main()
+{
+    VasicekModel vasicek{ 0.1, 0.05, 0.01, 0.03 };
+    CoxIngersollRossModel coxIngersollRoss{ 0.06, 0.2, 0.08, 0.04 };
+    HoAndLeeModel hoAndLee{ 0.002, 0.008, 0.03 };
+
+    std::cout << "Distance from the closed form in standard errors, " << numberOfPaths << " paths\n\n";
+    bool passed = true;
+    passed &= reportCheck("Vasicek with the control variate", largestStandardErrors(vasicek, true), maximumStandardErrors);
+    passed &= reportCheck("Vasicek, plain", largestStandardErrors(vasicek, false), maximumStandardErrors);
+    passed &= reportCheck("Vasicek, exact, with the control variate", largestStandardErrors(ExactScheme<VasicekModel>{ vasicek }, true), maximumStandardErrors);
+    passed &= reportCheck("CIR with the control variate", largestStandardErrors(coxIngersollRoss, true), maximumStandardErrors);
+    passed &= reportCheck("CIR, plain", largestStandardErrors(coxIngersollRoss, false), maximumStandardErrors);
+    passed &= reportCheck("CIR, exact, with the control variate", largestStandardErrors(ExactScheme<CoxIngersollRossModel>{ coxIngersollRoss }, true), maximumStandardErrors);
+    passed &= reportCheck("Ho-Lee with the control variate", largestStandardErrors(hoAndLee, true), maximumStandardErrors);
+    passed &= reportCheck("Ho-Lee, plain", largestStandardErrors(hoAndLee, false), maximumStandardErrors);
+
+    return passed ? 0 : 1;
+}
\ No newline at end of file
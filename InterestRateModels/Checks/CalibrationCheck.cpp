@@ -0,0 +1,93 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "../InterestRateModels/Calibration.h"
+#include "../InterestRateModels/PathEngine.h"
+#include "CheckReport.h"
+
+/*
+ Check that calibration recovers the parameters a series was simulated with.
+
+ Simulates 2 * 10^6 daily observations of Vasicek and CIR with their exact
+ transitions, and of CKLS with elasticity 3/2 with Euler steps, fits each
+ model to its series, and compares the fitted parameters with the
+ simulated ones. The drift parameters are known only to the sampling error
+ of the series, a few percent; the volatility and the elasticity, which
+ come from the size of the increments, are known far better. Exits with
+ status 1 if any relative error is larger than its tolerance.
+ */
+
+const int numberOfObservations = 2000000;
+const double observationInterval = 1.0 / 252.0;
+const std::uint64_t seed = 17;
+const double driftTolerance = 0.1;
+const double diffusionTolerance = 0.01;
+
+/*
+ Returns one long path of a model, oldest rate first.
+
+ @param model The model to simulate, possibly wrapped in a scheme.
+ */
+template <typename Model>
+std::vector<double> simulateSeries(const Model& model)
+{
+    PathStore pathStore = simulatePathBatch(model, (numberOfObservations - 0.5) * observationInterval, observationInterval, 1, seed);
+    std::vector<double> rates(static_cast<std::size_t>(pathStore.numberOfTimeSteps) + 1);
+    for (int i = 0; i <= pathStore.numberOfTimeSteps; ++i)
+    {
+        rates[i] = pathStore.rate(i, 0);
+    }
+    return rates;
+}
+
+/*
+ Returns the largest relative error of fitted parameters.
+
+ @param simulated The parameters the series was simulated with.
+ @param fitted The fitted parameters, in the same order.
+ */
+double largestRelativeError(const std::vector<double>& simulated, const std::vector<double>& fitted)
+{
+    double error = 0.0;
+    for (std::size_t index = 0; index < simulated.size(); ++index)
+    {
+        double relativeError = std::abs(fitted[index] / simulated[index] - 1.0);
+        error = std::max(error, std::isnan(relativeError) ? std::numeric_limits<double>::infinity() : relativeError);
+    }
+    return error;
+}
+
+int main()
+{
+    VasicekModel vasicek{ 0.3, 0.04, 0.01, 0.03 };
+    CoxIngersollRossModel coxIngersollRoss{ 0.05, 0.5, 0.08, 0.03 };
+    ChanKarolyiLongstaffSandersModel chanKarolyiLongstaffSanders{ 0.01, 0.2, 1.5, 1.0, 0.05 };
+
+    VasicekModel vasicekFit = calibrateVasicekModel(simulateSeries(ExactScheme<VasicekModel>{ vasicek }), observationInterval).model;
+    CoxIngersollRossModel coxIngersollRossFit =
+        calibrateCoxIngersollRossModel(simulateSeries(ExactScheme<CoxIngersollRossModel>{ coxIngersollRoss }), observationInterval).model;
+    ChanKarolyiLongstaffSandersModel chanKarolyiLongstaffSandersFit = calibrateChanKarolyiLongstaffSandersModel(
+        withSpecializedElasticity(chanKarolyiLongstaffSanders, [](const auto& model) { return simulateSeries(model); }), observationInterval).model;
+
+    std::cout << "Largest relative error of the fitted parameters, " << numberOfObservations << " daily observations\n\n";
+    bool passed = true;
+    passed &= reportCheck("Vasicek speed and long-term rate", largestRelativeError({ vasicek.meanReversionSpeed, vasicek.longTermInterestRate },
+        { vasicekFit.meanReversionSpeed, vasicekFit.longTermInterestRate }), driftTolerance);
+    passed &= reportCheck("Vasicek volatility", largestRelativeError({ vasicek.volatility }, { vasicekFit.volatility }), diffusionTolerance);
+    passed &= reportCheck("CIR level and rate", largestRelativeError({ coxIngersollRoss.meanReversionLevel, coxIngersollRoss.meanReversionRate },
+        { coxIngersollRossFit.meanReversionLevel, coxIngersollRossFit.meanReversionRate }), driftTolerance);
+    passed &= reportCheck("CIR volatility", largestRelativeError({ coxIngersollRoss.volatility }, { coxIngersollRossFit.volatility }), diffusionTolerance);
+    passed &= reportCheck("CKLS drift term and reversion rate",
+        largestRelativeError({ chanKarolyiLongstaffSanders.driftTerm, chanKarolyiLongstaffSanders.meanReversionRate },
+            { chanKarolyiLongstaffSandersFit.driftTerm, chanKarolyiLongstaffSandersFit.meanReversionRate }), driftTolerance);
+    passed &= reportCheck("CKLS elasticity and volatility",
+        largestRelativeError({ chanKarolyiLongstaffSanders.elasticity, chanKarolyiLongstaffSanders.volatility },
+            { chanKarolyiLongstaffSandersFit.elasticity, chanKarolyiLongstaffSandersFit.volatility }), diffusionTolerance);
+
+    return passed ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+/*
+ Reporting shared by the check programs. Each check prints one line per
+ comparison, ending in "ok" or "FAILED", and exits with status 1 if any
+ failed.
+ */
+
+const int checkNameWidth = 52;
+
+/*
+ Prints the result of one comparison and returns whether it passed.
+
+ @param name What was compared.
+ @param error The largest error found.
+ @param tolerance The largest error allowed.
+ */
+inline bool reportCheck(const std::string& name, const double& error, const double& tolerance)
+{
+    bool passed = error <= tolerance;
+    std::cout << std::setw(checkNameWidth) << std::left << name << std::right << std::scientific << std::setprecision(2) << std::setw(12) << error
+        << std::defaultfloat << (passed ? "   ok" : "   FAILED") << "\n";
+    return passed;
+}
+
+/*
+ Prints whether a condition held and returns it.
+
+ @param name The condition.
+ @param held Whether it held.
+ */
+inline bool reportCondition(const std::string& name, const bool& held)
+{
+    std::cout << std::setw(checkNameWidth) << std::left << name << std::right << std::setw(12) << "" << (held ? "   ok" : "   FAILED") << "\n";
+    return held;
+}
@@ -0,0 +1,115 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "../InterestRateModels/PathEngine.h"
+#include "../InterestRateModels/ShortRateModels.h"
+#include "CheckReport.h"
+
+/*
+ Check that the exact transitions have the analytic moments.
+
+ Simulates Vasicek, Ho-Lee and CIR, with many and with few degrees of
+ freedom, to a 5-year horizon with ExactScheme<> in one step and in ten,
+ and measures the distance of the sample mean and variance of the rate at
+ the horizon from the analytic mean and variance, in standard errors of
+ the sample moments. Exits with status 1 if either is further than the
+ tolerance.
+ */
+
+const double timeHorizon = 5.0;
+const int numberOfPaths = 200000;
+const std::uint64_t seed = 5;
+const double maximumStandardErrors = 4.0;
+
+/*
+ Analytic mean and variance of the rate at the horizon.
+ */
+struct Moments
+{
+    double mean = 0.0;
+    double variance = 0.0;
+};
+
+Moments vasicekMoments(const VasicekModel& model)
+{
+    double decay = std::exp(-model.meanReversionSpeed * timeHorizon);
+    return { model.longTermInterestRate + (model.initialInterestRate - model.longTermInterestRate) * decay,
+        model.volatility * model.volatility * (1.0 - decay * decay) / (2.0 * model.meanReversionSpeed) };
+}
+
+Moments hoAndLeeMoments(const HoAndLeeModel& model)
+{
+    return { model.initialInterestRate + 0.5 * model.driftTerm * timeHorizon * timeHorizon, model.volatility * model.volatility * timeHorizon };
+}
+
+Moments coxIngersollRossMoments(const CoxIngersollRossModel& model)
+{
+    double decay = std::exp(-model.meanReversionRate * timeHorizon);
+    double variance = model.volatility * model.volatility / model.meanReversionRate;
+    return { model.meanReversionLevel + (model.initialInterestRate - model.meanReversionLevel) * decay,
+        model.initialInterestRate * variance * (decay - decay * decay) + 0.5 * model.meanReversionLevel * variance * (1.0 - decay) * (1.0 - decay) };
+}
+
+/*
+ Returns the larger distance of the sample mean and variance at the horizon
+ from the analytic ones, in standard errors.
+
+ @param model The model, wrapped in ExactScheme<>.
+ @param moments The analytic moments of the rate at the horizon.
+ @param numberOfSteps The number of steps to the horizon.
+ */
+template <typename Model>
+double largestStandardErrors(const Model& model, const Moments& moments, const int& numberOfSteps)
+{
+    PathStore pathStore = simulatePathBatch(model, timeHorizon, timeHorizon / numberOfSteps, numberOfPaths, seed);
+
+    // Central moments about the analytic mean, so the variance estimate has no mean correction
+    double sum = 0.0;
+    double squareSum = 0.0;
+    double fourthPowerSum = 0.0;
+    for (int path = 0; path < numberOfPaths; ++path)
+    {
+        double deviation = pathStore.rate(pathStore.numberOfTimeSteps, path) - moments.mean;
+        sum += deviation;
+        squareSum += deviation * deviation;
+        fourthPowerSum += deviation * deviation * deviation * deviation;
+    }
+    double meanError = std::abs(sum / numberOfPaths) / std::sqrt(moments.variance / numberOfPaths);
+    double varianceSpread = fourthPowerSum / numberOfPaths - moments.variance * moments.variance;
+    double varianceError = std::abs(squareSum / numberOfPaths - moments.variance) / std::sqrt(varianceSpread / numberOfPaths);
+    double error = std::max(meanError, varianceError);
+    return std::isnan(error) ? std::numeric_limits<double>::infinity() : error;
+}
+
+int main()
+{
+    VasicekModel vasicek{ 0.3, 0.04, 0.02, 0.08 };
+    HoAndLeeModel hoAndLee{ 0.002, 0.008, 0.03 };
+    // 4 meanReversionRate meanReversionLevel / volatility^2 degrees of freedom: 9.6 and 0.4
+    CoxIngersollRossModel manyDegrees{ 0.04, 0.6, 0.1, 0.02 };
+    CoxIngersollRossModel fewDegrees{ 0.05, 0.2, std::sqrt(0.1), 0.02 };
+
+    std::cout << "Distance of the moments at " << timeHorizon << " years from the analytic ones in standard errors, " << numberOfPaths
+              << " paths\n\n";
+    bool passed = true;
+    for (int numberOfSteps : { 1, 10 })
+    {
+        std::string steps = numberOfSteps == 1 ? ", one step" : ", " + std::to_string(numberOfSteps) + " steps";
+        passed &= reportCheck("Vasicek" + steps, largestStandardErrors(ExactScheme<VasicekModel>{ vasicek }, vasicekMoments(vasicek), numberOfSteps),
+            maximumStandardErrors);
+        passed &= reportCheck("Ho-Lee" + steps, largestStandardErrors(ExactScheme<HoAndLeeModel>{ hoAndLee }, hoAndLeeMoments(hoAndLee), numberOfSteps),
+            maximumStandardErrors);
+        passed &= reportCheck("CIR with 9.6 degrees of freedom" + steps,
+            largestStandardErrors(ExactScheme<CoxIngersollRossModel>{ manyDegrees }, coxIngersollRossMoments(manyDegrees), numberOfSteps),
+            maximumStandardErrors);
+        passed &= reportCheck("CIR with 0.4 degrees of freedom" + steps,
+            largestStandardErrors(ExactScheme<CoxIngersollRossModel>{ fewDegrees }, coxIngersollRossMoments(fewDegrees), numberOfSteps),
+            maximumStandardErrors);
+    }
+
+    return passed ? 0 : 1;
+}
\ No newline at end of file
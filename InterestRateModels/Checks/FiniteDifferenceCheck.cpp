@@ -0,0 +1,83 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "../InterestRateModels/BondPricing.h"
+#include "../InterestRateModels/FiniteDifferenceEngine.h"
+#include "CheckReport.h"
+
+/*
+ Check that the finite-difference engine matches the closed forms.
+
+ Prices bonds maturing from 1 to 30 years for Vasicek and CIR with the
+ default settings and compares them with the closed-form prices, then
+ prices European calls and puts on a Vasicek bond and compares them with
+ Jamshidian's formula. Exits with status 1 if any differs by more than the
+ tolerance.
+ */
+
+const std::vector<double> maturities = { 1.0, 2.0, 5.0, 10.0, 30.0 };
+const double tolerance = 1e-8;
+
+/*
+ Returns the largest difference between the finite-difference and closed-form bond prices of a model.
+ */
+template <typename Model>
+double largestBondError(const Model& model)
+{
+    std::vector<double> prices = FiniteDifferenceEngine(model, maturities.back()).bondPrices(maturities);
+    double error = 0.0;
+    for (std::size_t index = 0; index < maturities.size(); ++index)
+    {
+        error = std::max(error, std::abs(prices[index] - analyticBondPrice(model, maturities[index])));
+    }
+    return error;
+}
+
+/*
+ Returns the closed-form price of a European option on a Vasicek zero-coupon bond (Jamshidian).
+ */
+double analyticBondOptionPrice(const VasicekModel& model, const BondOption& option)
+{
+    double speed = model.meanReversionSpeed;
+    double bondVolatility = model.volatility / speed * (1.0 - std::exp(-speed * (option.bondMaturity - option.expiry)))
+        * std::sqrt((1.0 - std::exp(-2.0 * speed * option.expiry)) / (2.0 * speed));
+    double bondPrice = analyticBondPrice(model, option.bondMaturity);
+    double expiryBondPrice = analyticBondPrice(model, option.expiry);
+    double h = std::log(bondPrice / (expiryBondPrice * option.strike)) / bondVolatility + 0.5 * bondVolatility;
+    auto normalCdf = [](const double& x) { return 0.5 * std::erfc(-x / std::sqrt(2.0)); };
+    if (option.call)
+    {
+        return bondPrice * normalCdf(h) - option.strike * expiryBondPrice * normalCdf(h - bondVolatility);
+    }
+    return option.strike * expiryBondPrice * normalCdf(bondVolatility - h) - bondPrice * normalCdf(-h);
+}
+
+int main()
+{
+    VasicekModel vasicek{ 0.1, 0.05, 0.01, 0.03 };
+    CoxIngersollRossModel coxIngersollRoss{ 0.06, 0.2, 0.08, 0.04 };
+
+    bool passed = true;
+    passed &= reportCheck("Vasicek bonds against the closed form", largestBondError(vasicek), tolerance);
+    passed &= reportCheck("CIR bonds against the closed form", largestBondError(coxIngersollRoss), tolerance);
+
+    // Calls and puts on the 10-year bond expiring at 5 years, around the forward price
+    std::vector<BondOption> options;
+    for (double strike : { 0.76, 0.80, 0.84, 0.88 })
+    {
+        options.push_back({ 5.0, 10.0, strike, true, false });
+        options.push_back({ 5.0, 10.0, strike, false, false });
+    }
+    std::vector<double> prices = FiniteDifferenceEngine(vasicek, 10.0).bondOptionPrices(options);
+    double optionError = 0.0;
+    for (std::size_t index = 0; index < options.size(); ++index)
+    {
+        optionError = std::max(optionError, std::abs(prices[index] - analyticBondOptionPrice(vasicek, options[index])));
+    }
+    passed &= reportCheck("Vasicek bond options against Jamshidian", optionError, tolerance);
+
+    return passed ? 0 : 1;
+}
\ No newline at end of file
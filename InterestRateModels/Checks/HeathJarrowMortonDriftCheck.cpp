@@ -0,0 +1,136 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "../InterestRateModels/HeathJarrowMortonEngine.h"
+#include "CheckReport.h"
+
+/*
+ Check that the HJM drift is the no-arbitrage drift.
+
+ Simulates a Ho-Lee and a Hull-White factor on an upward-sloping initial
+ curve to 5 years and measures two consequences of the drift in standard
+ errors. Every live forward must have the mean
+   f(0, T) + int_0^t alpha(s, T) ds,
+ which is known in closed form for these factors. And every bond,
+ discounted to time zero, must have the initial bond price as its mean:
+ with maturities on the step grid, a matured forward holds the short rate
+ at its maturity, so the recorded curve gives the discounted bond
+ exp(-sum_j f(min(t, T_j), T_j) h) on its own. Exits with status 1 if any
+ is further than the tolerance.
+ */
+
+const double maturitySpacing = 0.1;
+const int numberOfMaturities = 201;
+const double timeStep = 0.05;
+const double timeHorizon = 5.0;
+const int numberOfPaths = 50000;
+const std::uint64_t seed = 7;
+const double maximumStandardErrors = 4.0;
+
+/*
+ Returns int_0^t alpha_k(s, T) ds for one factor.
+
+ @param factor The volatility factor.
+ @param time The time t, at most the maturity.
+ @param maturity The maturity T.
+ */
+double integratedDrift(const HeathJarrowMortonFactor& factor, const double& time, const double& maturity)
+{
+    double variance = factor.volatility * factor.volatility;
+    if (factor.decayRate == 0.0)
+    {
+        return variance * time * (maturity - 0.5 * time);
+    }
+    double decayRate = factor.decayRate;
+    double single = (std::exp(-decayRate * (maturity - time)) - std::exp(-decayRate * maturity)) / decayRate;
+    double twice = (std::exp(-2.0 * decayRate * (maturity - time)) - std::exp(-2.0 * decayRate * maturity)) / (2.0 * decayRate);
+    return variance / decayRate * (single - twice);
+}
+
+/*
+ Returns the distance of a sample mean from a value, in standard errors.
+ */
+double standardErrors(const double& sum, const double& squareSum, const double& value)
+{
+    double mean = sum / numberOfPaths;
+    double variance = squareSum / numberOfPaths - mean * mean;
+    double error = std::abs(mean - value) / std::sqrt(variance / numberOfPaths);
+    return std::isnan(error) ? std::numeric_limits<double>::infinity() : error;
+}
+
+int main()
+{
+    HeathJarrowMortonModel model;
+    model.initialForwardCurve.times = { 0.0, 2.0, 5.0, 10.0 };
+    model.initialForwardCurve.values = { 0.02, 0.03, 0.035, 0.04 };
+    model.initialForwardCurve.interpolation = CurveInterpolation::Linear;
+    for (int maturity = 0; maturity < numberOfMaturities; ++maturity)
+    {
+        model.maturities.push_back(maturity * maturitySpacing);
+    }
+    model.factors = { { 0.015, 0.0 }, { 0.02, 0.5 } };
+
+    ForwardCurveStore forwardCurveStore;
+    simulateForwardCurves(model, timeHorizon, timeStep, numberOfPaths, seed, 1000, forwardCurveStore);
+    int horizonRecord = forwardCurveStore.numberOfRecords() - 1;
+
+    // Forwards that are still live at the horizon
+    double forwardErrors = 0.0;
+    for (int maturity = 0; maturity < numberOfMaturities; ++maturity)
+    {
+        if (model.maturities[maturity] <= timeHorizon)
+        {
+            continue;
+        }
+        double mean = model.initialForwardCurve.valueAt(model.maturities[maturity]);
+        for (const HeathJarrowMortonFactor& factor : model.factors)
+        {
+            mean += integratedDrift(factor, timeHorizon, model.maturities[maturity]);
+        }
+        double sum = 0.0;
+        double squareSum = 0.0;
+        for (int path = 0; path < numberOfPaths; ++path)
+        {
+            double forwardRate = forwardCurveStore.forwardRate(horizonRecord, path, maturity);
+            sum += forwardRate;
+            squareSum += forwardRate * forwardRate;
+        }
+        forwardErrors = std::max(forwardErrors, standardErrors(sum, squareSum, mean));
+    }
+
+    // Discounted bonds maturing after the horizon, relative to their initial prices
+    double bondErrors = 0.0;
+    for (int bondMaturity = 51; bondMaturity < numberOfMaturities; bondMaturity += 10)
+    {
+        double initialYield = 0.0;
+        for (int maturity = 0; maturity < bondMaturity; ++maturity)
+        {
+            initialYield += model.initialForwardCurve.valueAt(model.maturities[maturity]) * maturitySpacing;
+        }
+        double sum = 0.0;
+        double squareSum = 0.0;
+        for (int path = 0; path < numberOfPaths; ++path)
+        {
+            const double* curve = forwardCurveStore.curve(horizonRecord, path);
+            double yield = 0.0;
+            for (int maturity = 0; maturity < bondMaturity; ++maturity)
+            {
+                yield += curve[maturity] * maturitySpacing;
+            }
+            double relativePrice = std::exp(initialYield - yield);
+            sum += relativePrice;
+            squareSum += relativePrice * relativePrice;
+        }
+        bondErrors = std::max(bondErrors, standardErrors(sum, squareSum, 1.0));
+    }
+
+    std::cout << "Distance from the no-arbitrage values at " << timeHorizon << " years in standard errors, " << numberOfPaths << " paths\n\n";
+    bool passed = true;
+    passed &= reportCheck("Mean of every live forward", forwardErrors, maximumStandardErrors);
+    passed &= reportCheck("Mean of every discounted bond", bondErrors, maximumStandardErrors);
+
+    return passed ? 0 : 1;
+}
\ No newline at end of file
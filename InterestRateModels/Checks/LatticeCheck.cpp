@@ -0,0 +1,55 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "../InterestRateModels/BondPricing.h"
+#include "../InterestRateModels/TrinomialLattice.h"
+#include "CheckReport.h"
+
+/*
+ Check that the trinomial lattices reprice the curve they are fitted to.
+
+ Builds monthly 30-year Hull-White and Ho-Lee lattices on an upward-sloping
+ zero curve, and a Ho-Lee lattice on the model's own bond prices, and
+ compares the lattice price of the bond maturing at every slice with the
+ discount factor of the curve. Exits with status 1 if any differs by more
+ than the tolerance.
+ */
+
+const double timeHorizon = 30.0;
+const int numberOfSteps = 360;
+const double tolerance = 1e-10;
+
+/*
+ Returns the largest difference between the lattice bond prices and a discount function over every slice.
+ */
+template <typename DiscountFunction>
+double largestRepricingError(const TrinomialLattice& lattice, const DiscountFunction& discountFactor)
+{
+    double error = 0.0;
+    for (int step = 1; step <= lattice.numberOfSteps; ++step)
+    {
+        double maturity = step * lattice.timeStep;
+        error = std::max(error, std::abs(latticeBondPrice(lattice, maturity) - discountFactor(maturity)));
+    }
+    return error;
+}
+
+int main()
+{
+    TimeCurve zeroRates{ { 0.0, 5.0, 10.0, 30.0 }, { 0.02, 0.03, 0.035, 0.04 }, CurveInterpolation::Linear };
+    auto curveDiscountFactor = [&](const double& maturity) { return std::exp(-zeroRates.valueAt(maturity) * maturity); };
+
+    HullWhiteModel hullWhite{ TimeCurve::constant(0.0), TimeCurve::constant(0.1), TimeCurve::constant(0.01), 0.02 };
+    HoAndLeeModel hoAndLee{ 0.002, 0.008, 0.02 };
+
+    bool passed = true;
+    passed &= reportCheck("Hull-White lattice on the zero curve", largestRepricingError(buildTrinomialLattice(hullWhite, zeroRates, timeHorizon, numberOfSteps), curveDiscountFactor), tolerance);
+    passed &= reportCheck("Ho-Lee lattice on the zero curve", largestRepricingError(buildTrinomialLattice(hoAndLee, zeroRates, timeHorizon, numberOfSteps), curveDiscountFactor), tolerance);
+    passed &= reportCheck("Ho-Lee lattice on its own bond prices", largestRepricingError(buildTrinomialLattice(hoAndLee, timeHorizon, numberOfSteps),
+        [&](const double& maturity) { return analyticBondPrice(hoAndLee, maturity); }), tolerance);
+
+    return passed ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "../InterestRateModels/ResultFile.h"
+#include "../InterestRateModels/ShortRateModels.h"
+#include "../InterestRateModels/StreamingStatistics.h"
+#include "CheckReport.h"
+
+/*
+ Check that paths resumed from a checkpoint are those of an uninterrupted run.
+
+ Simulates month ends over 4 years on daily steps in one run, and again as
+ a run up to a checkpoint that is resumed to 4 years and appended. The
+ checkpoints fall on an even step and on an odd one, which splits a pair of
+ increments, and one is resumed through a checkpoint file. The month-end
+ rates of the two must be bit-identical: the check exits with status 1 on
+ any difference. A resumed run discounts from its checkpoint, so the
+ statistics of one must have discount factors of 1 at the checkpoint and,
+ at the horizon, the mean discount factor integrated over every resumed
+ step, to rounding.
+ */
+
+const double timeStep = 1.0 / 252.0;
+const double timeHorizon = 4.0;
+const double observationInterval = 1.0 / 12.0;
+const int numberOfPaths = 3000;
+const std::uint64_t seed = 21;
+const std::string checkpointPath = "observation_check_checkpoint.irm";
+const double discountTolerance = 1e-13;
+
+/*
+ Returns the largest difference between an uninterrupted run and one resumed from a checkpoint.
+
+ @param model The model to simulate, possibly wrapped in a scheme.
+ @param checkpointTime The date of the checkpoint.
+ @param throughFile Whether to resume from the checkpoint written to a file and read back.
+ */
+template <typename Model>
+double largestResumeDifference(const Model& model, const double& checkpointTime, const bool& throughFile)
+{
+    ObservationSchedule schedule = ObservationSchedule::every(observationInterval, timeHorizon);
+    ObservedPathStore whole(schedule);
+    simulateObservedPaths(model, timeStep, numberOfPaths, seed, whole);
+
+    // The month ends up to the checkpoint, then the rest from it
+    ObservationSchedule firstSchedule;
+    std::copy_if(schedule.observationTimes.begin(), schedule.observationTimes.end(), std::back_inserter(firstSchedule.observationTimes),
+        [&](const double& time) { return time <= checkpointTime; });
+    firstSchedule.checkpointTimes = { checkpointTime };
+    ObservedPathStore resumed(firstSchedule);
+    simulateObservedPaths(model, timeStep, numberOfPaths, seed, resumed);
+
+    PathCheckpoint checkpoint = resumed.checkpointAt(checkpointTime);
+    if (throughFile)
+    {
+        writeCheckpointFile(checkpointPath, "check", {}, checkpoint);
+        checkpoint = readCheckpointFile(checkpointPath);
+        std::remove(checkpointPath.c_str());
+    }
+    ObservedPathStore remainder(schedule);
+    resumeObservedPaths(model, checkpoint, remainder);
+    resumed.append(remainder);
+
+    if (resumed.stepIndices != whole.stepIndices)
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+    double difference = 0.0;
+    for (std::size_t index = 0; index < whole.rateValues.size(); ++index)
+    {
+        difference = std::max(difference, std::abs(resumed.rateValues[index] - whole.rateValues[index]));
+    }
+    return difference;
+}
+
+/*
+ Returns the relative difference between the mean discount factor at the horizon of a resumed
+ PathStatisticsSink and the one integrated from the checkpoint over every resumed step, infinite
+ if the sink's discount factors at the checkpoint are not all 1.
+
+ @param model The model to simulate, possibly wrapped in a scheme.
+ @param checkpointTime The date of the checkpoint.
+ */
+template <typename Model>
+double resumedDiscountDifference(const Model& model, const double& checkpointTime)
+{
+    ObservationSchedule firstSchedule;
+    firstSchedule.observationTimes = { checkpointTime };
+    firstSchedule.checkpointTimes = { checkpointTime };
+    ObservedPathStore first(firstSchedule);
+    simulateObservedPaths(model, timeStep, numberOfPaths, seed, first);
+    const PathCheckpoint& checkpoint = first.checkpointAt(checkpointTime);
+
+    // One thread takes every block in turn, so a block must not inherit the integral of the one before
+    ThreadPool threadPool(1);
+    SimulationContext context(threadPool);
+    PathStatisticsSink sink;
+    resumePaths(model, checkpoint, timeHorizon + 0.5 * timeStep, sink, context);
+    const RunningMoments& atCheckpoint = sink.statistics.discountFactorMoments[checkpoint.stepIndex];
+    if (atCheckpoint.count != numberOfPaths || atCheckpoint.mean != 1.0 || atCheckpoint.sumOfSquaredDeviations != 0.0)
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    // The trapezoidal integral over every step after the checkpoint
+    ObservedPathStore everyStep(ObservationSchedule::every(timeStep, timeHorizon));
+    resumeObservedPaths(model, checkpoint, everyStep);
+    std::vector<double> previousRates = checkpoint.rates;
+    std::vector<double> integrals(numberOfPaths, 0.0);
+    int previousStep = checkpoint.stepIndex;
+    for (int observation = 0; observation < everyStep.numberOfObservations(); ++observation)
+    {
+        int step = everyStep.stepIndices[observation];
+        if (step <= previousStep)
+        {
+            continue;
+        }
+        double halfStep = 0.5 * (step - previousStep) * timeStep;
+        for (int path = 0; path < numberOfPaths; ++path)
+        {
+            integrals[path] += halfStep * (previousRates[path] + everyStep.rate(observation, path));
+            previousRates[path] = everyStep.rate(observation, path);
+        }
+        previousStep = step;
+    }
+    double meanDiscountFactor = 0.0;
+    for (const double& integral : integrals)
+    {
+        meanDiscountFactor += std::exp(-integral) / numberOfPaths;
+    }
+    return std::abs(sink.statistics.discountFactorMoments.back().mean / meanDiscountFactor - 1.0);
+}
+
+int main()
+{
+    VasicekModel vasicek{ 0.1, 0.05, 0.01, 0.03 };
+    CoxIngersollRossModel coxIngersollRoss{ 0.06, 0.2, 0.08, 0.04 };
+    ChanKarolyiLongstaffSandersModel chanKarolyiLongstaffSanders{ 0.01, 0.2, 0.75, 0.05, 0.04 };
+    const double evenCheckpoint = 2.0;               // step 504
+    const double oddCheckpoint = 1.0 + 1.0 / 252.0;  // step 253
+
+    bool passed = true;
+    passed &= reportCheck("Vasicek from an even step", largestResumeDifference(vasicek, evenCheckpoint, false), 0.0);
+    passed &= reportCheck("Vasicek from an odd step", largestResumeDifference(vasicek, oddCheckpoint, false), 0.0);
+    passed &= reportCheck("Vasicek from a checkpoint file", largestResumeDifference(vasicek, oddCheckpoint, true), 0.0);
+    passed &= reportCheck("CIR, Milstein, from an odd step", largestResumeDifference(MilsteinScheme<CoxIngersollRossModel>{ coxIngersollRoss }, oddCheckpoint, false), 0.0);
+    passed &= reportCheck("CKLS from an odd step", largestResumeDifference(chanKarolyiLongstaffSanders, oddCheckpoint, false), 0.0);
+    passed &= reportCheck("Vasicek discounting from a checkpoint", resumedDiscountDifference(vasicek, oddCheckpoint), discountTolerance);
+
+    return passed ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include <iostream>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../InterestRateModels/HeathJarrowMortonEngine.h"
+#include "../InterestRateModels/ResultFile.h"
+#include "../InterestRateModels/ShortRateModels.h"
+#include "CheckReport.h"
+
+/*
+ Check that result files read back what was written, and that the reader
+ rejects files it cannot use.
+
+ Writes short-rate paths in float64 and float32, HJM curves and a
+ checkpoint to .irm files and compares everything read back with what was
+ written. Then writes copies of a valid file that are truncated or whose
+ header has a bad value type, sizes that overflow or a section past the end
+ of the file, and requires ResultFileReader to throw std::runtime_error for
+ each. Exits with status 1 if anything differs or a malformed file is
+ accepted.
+ */
+
+const std::uint64_t seed = 13;
+const std::string shortRateFile = "result_file_check_short_rate.irm";
+const std::string forwardCurveFile = "result_file_check_forward_curve.irm";
+const std::string checkpointFile = "result_file_check_checkpoint.irm";
+const std::string malformedFile = "result_file_check_malformed.irm";
+
+/*
+ Returns whether a reader of the file has the header and data written for a batch of paths.
+
+ @param reader The reader of the file.
+ @param pathStore The paths that were written.
+ @param parameters The parameters that were written.
+ @param valueType The type the rates were stored as.
+ */
+bool sameShortRateFile(const ResultFileReader& reader, const PathStore& pathStore, const std::vector<ResultParameter>& parameters, const ResultValueType& valueType)
+{
+    std::vector<ResultParameter> readParameters = reader.parameters();
+    bool same = reader.model() == "Vasicek" && reader.seed() == seed && reader.valueType() == valueType && readParameters.size() == parameters.size()
+        && reader.numberOfDates() == pathStore.timeValues.size() && reader.numberOfPaths() == static_cast<std::uint64_t>(pathStore.numberOfPaths)
+        && reader.valuesPerPath() == 1 && reader.numberOfMaturities() == 0;
+    for (std::size_t parameter = 0; same && parameter < parameters.size(); ++parameter)
+    {
+        same = readParameters[parameter].name == parameters[parameter].name && readParameters[parameter].value == parameters[parameter].value;
+    }
+    for (int i = 0; same && i <= pathStore.numberOfTimeSteps; ++i)
+    {
+        same = reader.timeValues()[i] == pathStore.timeValues[i];
+        for (int path = 0; same && path < pathStore.numberOfPaths; ++path)
+        {
+            double rate = pathStore.rate(i, path);
+            same = reader.value(i, path) == (valueType == ResultValueType::Float64 ? rate : static_cast<double>(static_cast<float>(rate)));
+        }
+    }
+    return same;
+}
+
+/*
+ Writes a copy of a file with its header changed, or its end cut off.
+
+ @param source The file to copy.
+ @param modify Called with the header to change it.
+ @param bytesRemoved The number of bytes to cut off the end.
+ */
+template <typename Modify>
+void writeMalformedCopy(const std::string& source, const Modify& modify, const std::size_t& bytesRemoved = 0)
+{
+    std::ifstream input(source, std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    ResultFileHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    modify(header);
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    bytes.resize(bytes.size() - bytesRemoved);
+    std::ofstream output(malformedFile, std::ios::binary | std::ios::trunc);
+    output.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+/*
+ Returns whether opening the malformed file throws std::runtime_error.
+ */
+bool rejectsMalformedFile()
+{
+    try
+    {
+        ResultFileReader reader(malformedFile);
+    }
+    catch (const std::runtime_error&)
+    {
+        return true;
+    }
+    return false;
+}
+
+int main()
+{
+    // Short-rate paths in both value types
+    VasicekModel vasicek{ 0.3, 0.04, 0.01, 0.03 };
+    std::vector<ResultParameter> parameters = {
+        { "meanReversionSpeed", vasicek.meanReversionSpeed },
+        { "longTermInterestRate", vasicek.longTermInterestRate },
+        { "volatility", vasicek.volatility },
+        { "initialInterestRate", vasicek.initialInterestRate }
+    };
+    PathStore pathStore = simulatePathBatch(vasicek, 1.0, 0.01, 1000, seed);
+    writeResultFile(shortRateFile, "Vasicek", parameters, seed, pathStore, ResultValueType::Float32);
+    bool float32RoundTrip = sameShortRateFile(ResultFileReader(shortRateFile), pathStore, parameters, ResultValueType::Float32);
+    writeResultFile(shortRateFile, "Vasicek", parameters, seed, pathStore);
+    bool float64RoundTrip = sameShortRateFile(ResultFileReader(shortRateFile), pathStore, parameters, ResultValueType::Float64);
+
+    // HJM curves
+    HeathJarrowMortonModel heathJarrowMorton;
+    heathJarrowMorton.initialForwardCurve = TimeCurve::constant(0.03);
+    heathJarrowMorton.maturities = { 0.5, 1.0, 2.0, 5.0, 10.0 };
+    heathJarrowMorton.factors = { { 0.01, 0.0 }, { 0.015, 0.5 } };
+    ForwardCurveStore forwardCurveStore = simulateForwardCurves(heathJarrowMorton, 1.0, 0.05, 100, seed);
+    writeResultFile(forwardCurveFile, "HeathJarrowMorton", {}, seed, forwardCurveStore);
+    bool forwardCurveRoundTrip = false;
+    {
+        ResultFileReader reader(forwardCurveFile);
+        forwardCurveRoundTrip = reader.numberOfMaturities() == heathJarrowMorton.maturities.size()
+            && reader.numberOfDates() == static_cast<std::uint64_t>(forwardCurveStore.numberOfRecords())
+            && std::memcmp(reader.maturities(), heathJarrowMorton.maturities.data(), heathJarrowMorton.maturities.size() * sizeof(double)) == 0;
+        for (int record = 0; forwardCurveRoundTrip && record < forwardCurveStore.numberOfRecords(); ++record)
+        {
+            forwardCurveRoundTrip = std::memcmp(reader.float64Column(record), forwardCurveStore.curve(record, 0),
+                reader.columnLength() * sizeof(double)) == 0;
+        }
+    }
+
+    // A checkpoint
+    PathCheckpoint checkpoint;
+    checkpoint.seed = seed;
+    checkpoint.timeStep = 0.01;
+    checkpoint.stepIndex = 50;
+    checkpoint.time = 0.5;
+    checkpoint.rates.assign(pathStore.ratesAtStep(50), pathStore.ratesAtStep(50) + pathStore.numberOfPaths);
+    writeCheckpointFile(checkpointFile, "Vasicek", parameters, checkpoint);
+    PathCheckpoint readCheckpoint = readCheckpointFile(checkpointFile);
+    bool checkpointRoundTrip = readCheckpoint.seed == checkpoint.seed && readCheckpoint.timeStep == checkpoint.timeStep
+        && readCheckpoint.stepIndex == checkpoint.stepIndex && readCheckpoint.time == checkpoint.time && readCheckpoint.rates == checkpoint.rates;
+
+    std::cout << "Result files read back\n\n";
+    bool passed = true;
+    passed &= reportCondition("Short-rate paths, float64", float64RoundTrip);
+    passed &= reportCondition("Short-rate paths, float32", float32RoundTrip);
+    passed &= reportCondition("HJM curves", forwardCurveRoundTrip);
+    passed &= reportCondition("Checkpoint", checkpointRoundTrip);
+
+    std::cout << "\nMalformed files rejected\n\n";
+    writeMalformedCopy(shortRateFile, [](ResultFileHeader&) {}, 1);
+    passed &= reportCondition("Data cut short by one byte", rejectsMalformedFile());
+    writeMalformedCopy(shortRateFile, [](ResultFileHeader& header) { header.valueType = 7; });
+    passed &= reportCondition("Unknown value type", rejectsMalformedFile());
+    writeMalformedCopy(shortRateFile, [](ResultFileHeader& header) { header.numberOfPaths = std::uint64_t(1) << 62; });
+    passed &= reportCondition("Column size that overflows", rejectsMalformedFile());
+    writeMalformedCopy(shortRateFile, [](ResultFileHeader& header) { header.numberOfPaths = 1; header.numberOfDates = std::uint64_t(1) << 61; });
+    passed &= reportCondition("Time grid size that overflows", rejectsMalformedFile());
+    writeMalformedCopy(shortRateFile, [](ResultFileHeader& header) { header.parameterOffset = ~std::uint64_t(0) - 8; });
+    passed &= reportCondition("Parameters past the end of the file", rejectsMalformedFile());
+    writeMalformedCopy(shortRateFile, [](ResultFileHeader& header) { header.timeGridOffset = header.dataOffset + 8 * header.numberOfPaths * header.numberOfDates; });
+    passed &= reportCondition("Time grid past the end of the file", rejectsMalformedFile());
+    writeMalformedCopy(forwardCurveFile, [](ResultFileHeader& header) { header.maturityGridOffset = ~std::uint64_t(0) - 7; });
+    passed &= reportCondition("Maturity grid past the end of the file", rejectsMalformedFile());
+    writeMalformedCopy(shortRateFile, [](ResultFileHeader& header) { header.dataOffset = ~std::uint64_t(0) - 7; });
+    passed &= reportCondition("Data past the end of the file", rejectsMalformedFile());
+
+    std::remove(shortRateFile.c_str());
+    std::remove(forwardCurveFile.c_str());
+    std::remove(checkpointFile.c_str());
+    std::remove(malformedFile.c_str());
+    return passed ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../InterestRateModels/ShortRateModels.h"
+#include "../InterestRateModels/SimdKernels.h"
+#include "CheckReport.h"
+
+/*
+ Check of the vectorized CKLS and CEV step kernels against the scalar steps.
+
+ Advances a row of rates, from 1e-6 to 0.5 with zero, negative, infinite
+ and NaN rates mixed in, by one Euler and one Milstein step at every SIMD
+ level the machine supports, for several elasticities, and compares every
+ path with the scalar eulerStep() or milsteinStep(). The error of a path is
+ counted in units in the last place of the largest term the step adds up:
+ the start and end rates, the rate without the noise, and the noise term.
+ Where the noise term is much larger than the rate they cancel, and the few
+ ulps of the power function are many ulps of the small result. Special
+ values must match exactly. Rates of extreme size, such as 1e-300 or
+ 1e200, are left out: there the error of exp(a * log(x)) grows to about
+ |a * log(x)| ulps, some hundreds. Exits with
+ status 1 if any path is off by more than the tolerance.
+ */
+
+const int numberOfPaths = 4099;  // not a multiple of the vector width, so the scalar tail runs too
+const double maximumUlps = 32.0;  // a few for the polynomials, and up to about 20 for the rounding of a * log(x) at 1e-6
+const std::vector<double> elasticities = { 0.25, 0.5, 0.75, 1.0, 1.5 };
+
+/*
+ Returns the difference of a kernel rate from the scalar rate in units in the last place, infinite if special values differ.
+
+ @param rate The kernel's rate.
+ @param scalarRate The scalar step's rate.
+ @param noiselessRate The scalar step's rate with a zero increment.
+ @param previousRate The rate at the start of the step.
+ */
+double ulpError(const double& rate, const double& scalarRate, const double& noiselessRate, const double& previousRate)
+{
+    if (!std::isfinite(scalarRate) || !std::isfinite(rate))
+    {
+        bool same = (std::isnan(rate) && std::isnan(scalarRate)) || rate == scalarRate;
+        return same ? 0.0 : std::numeric_limits<double>::infinity();
+    }
+    double scale = std::max({ std::abs(scalarRate), std::abs(previousRate), std::abs(noiselessRate), std::abs(scalarRate - noiselessRate),
+        std::numeric_limits<double>::min() });
+    double ulp = std::nextafter(scale, std::numeric_limits<double>::infinity()) - scale;
+    return std::abs(rate - scalarRate) / ulp;
+}
+
+/*
+ Returns the largest error of a kernel over the row, in ulps.
+
+ @param advance Calls the kernel on (previousRates, increments, currentRates).
+ @param scalar Returns the scalar step of a rate and an increment.
+ */
+template <typename Advance, typename Scalar>
+double largestUlpError(const Advance& advance, const Scalar& scalar, const std::vector<double>& previousRates, const std::vector<double>& increments)
+{
+    std::vector<double> currentRates(previousRates.size());
+    advance(previousRates.data(), increments.data(), currentRates.data());
+    double error = 0.0;
+    for (std::size_t path = 0; path < previousRates.size(); ++path)
+    {
+        error = std::max(error, ulpError(currentRates[path], scalar(previousRates[path], increments[path]), scalar(previousRates[path], 0.0), previousRates[path]));
+    }
+    return error;
+}
+
+const char* simdLevelName(const SimdLevel& simdLevel)
+{
+    switch (simdLevel)
+    {
+    case SimdLevel::Avx512:
+        return "AVX-512";
+    case SimdLevel::Avx2:
+        return "AVX2";
+    default:
+        return "scalar";
+    }
+}
+
+int main()
+{
+    // Rates spread log-uniformly over the range the models visit, with special values among them
+    std::mt19937_64 generator(3);
+    std::normal_distribution<double> normal;
+    std::vector<double> previousRates(numberOfPaths);
+    std::vector<double> increments(numberOfPaths);
+    for (int path = 0; path < numberOfPaths; ++path)
+    {
+        previousRates[path] = 1e-6 * std::pow(5e5, static_cast<double>(path) / numberOfPaths);
+        increments[path] = normal(generator);
+    }
+    std::shuffle(previousRates.begin(), previousRates.end(), generator);
+    const double specialRates[] = { 0.0, -0.01, std::numeric_limits<double>::infinity(), std::numeric_limits<double>::quiet_NaN() };
+    for (std::size_t index = 0; index < std::size(specialRates); ++index)
+    {
+        previousRates[index * 37] = specialRates[index];
+    }
+
+    TimeStep step;
+    step.stepIndex = 1;
+    step.endTime = step.length = 1.0 / 52.0;
+    step.squareRootLength = std::sqrt(step.length);
+
+    std::cout << "Largest error of " << numberOfPaths << " paths against the scalar step, tolerance " << maximumUlps << " ulp\n\n";
+    bool passed = true;
+    for (int level = static_cast<int>(SimdLevel::Scalar); level <= static_cast<int>(detectSimdLevel()); ++level)
+    {
+        SimdLevel simdLevel = static_cast<SimdLevel>(level);
+        double chanKarolyiLongstaffSandersEuler = 0.0;
+        double chanKarolyiLongstaffSandersMilstein = 0.0;
+        double constantElasticityVarianceEuler = 0.0;
+        double constantElasticityVarianceMilstein = 0.0;
+        for (const double& elasticity : elasticities)
+        {
+            ChanKarolyiLongstaffSandersModel chanKarolyiLongstaffSanders{ 0.01, 0.2, elasticity, 0.1, 0.04 };
+            ConstantElasticityVarianceModel constantElasticityVariance{ 0.2, 0.01, elasticity, 0.1, 0.04 };
+            chanKarolyiLongstaffSandersEuler = std::max(chanKarolyiLongstaffSandersEuler, largestUlpError(
+                [&](const double* rates, const double* randomIncrements, double* currentRates)
+                { advanceChanKarolyiLongstaffSandersPaths<false>(simdLevel, chanKarolyiLongstaffSanders, step, rates, randomIncrements, currentRates, numberOfPaths); },
+                [&](const double& rate, const double& increment) { return eulerStep(chanKarolyiLongstaffSanders, step, rate, increment); },
+                previousRates, increments));
+            chanKarolyiLongstaffSandersMilstein = std::max(chanKarolyiLongstaffSandersMilstein, largestUlpError(
+                [&](const double* rates, const double* randomIncrements, double* currentRates)
+                { advanceChanKarolyiLongstaffSandersPaths<true>(simdLevel, chanKarolyiLongstaffSanders, step, rates, randomIncrements, currentRates, numberOfPaths); },
+                [&](const double& rate, const double& increment) { return milsteinStep(chanKarolyiLongstaffSanders, step, rate, increment); },
+                previousRates, increments));
+            constantElasticityVarianceEuler = std::max(constantElasticityVarianceEuler, largestUlpError(
+                [&](const double* rates, const double* randomIncrements, double* currentRates)
+                { advanceConstantElasticityVariancePaths<false>(simdLevel, constantElasticityVariance, step, rates, randomIncrements, currentRates, numberOfPaths); },
+                [&](const double& rate, const double& increment) { return eulerStep(constantElasticityVariance, step, rate, increment); },
+                previousRates, increments));
+            constantElasticityVarianceMilstein = std::max(constantElasticityVarianceMilstein, largestUlpError(
+                [&](const double* rates, const double* randomIncrements, double* currentRates)
+                { advanceConstantElasticityVariancePaths<true>(simdLevel, constantElasticityVariance, step, rates, randomIncrements, currentRates, numberOfPaths); },
+                [&](const double& rate, const double& increment) { return milsteinStep(constantElasticityVariance, step, rate, increment); },
+                previousRates, increments));
+        }
+        std::string name = simdLevelName(simdLevel);
+        passed &= reportCheck(name + " CKLS Euler", chanKarolyiLongstaffSandersEuler, maximumUlps);
+        passed &= reportCheck(name + " CKLS Milstein", chanKarolyiLongstaffSandersMilstein, maximumUlps);
+        passed &= reportCheck(name + " CEV Euler", constantElasticityVarianceEuler, maximumUlps);
+        passed &= reportCheck(name + " CEV Milstein", constantElasticityVarianceMilstein, maximumUlps);
+    }
+
+    return passed ? 0 : 1;
+}
\ No newline at end of file
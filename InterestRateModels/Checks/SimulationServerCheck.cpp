@@ -0,0 +1,115 @@
+#include <iostream>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../InterestRateModels/SimulationServer.h"
+#include "CheckReport.h"
+
+/*
+ Check that the simulation server rejects bad requests and keeps serving.
+
+ Runs a batch of requests in-process where a valid request shares its seed
+ with requests whose grid is too large, infinite or not a number, and
+ checks that only the bad ones get an error reply. Then starts a server on
+ a thread of this process, sends it the same bad requests over the socket,
+ and checks that it still answers a valid one; and has one client pipeline
+ thousands of requests without reading its replies while a second client
+ checks that its own request is still answered, and that those requests
+ were split into batches no larger than the cap. Exits with status 1 if any
+ reply is wrong.
+ */
+
+const char* socketPath = "irm_server_check.sock";
+const int unreadRequests = 5000;
+
+ServerRequest makeRequest(const std::uint32_t& requestId, const double& timeHorizon, const double& timeStep, const int& numberOfPaths)
+{
+    ServerRequest request;
+    request.requestId = requestId;
+    request.model = 0;
+    request.numberOfPaths = numberOfPaths;
+    request.timeHorizon = timeHorizon;
+    request.timeStep = timeStep;
+    request.seed = 7;
+    request.parameters = { 0.3, 0.04, 0.01, 0.03 };
+    return request;
+}
+
+/*
+ Returns the valid request first, then requests that are too large or not finite.
+ */
+std::vector<ServerRequest> mixedRequests()
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+    return { makeRequest(1, 1.0, 0.01, 1000), makeRequest(2, 1e9, 1e-3, 1000), makeRequest(3, infinity, 0.01, 1000),
+        makeRequest(4, 1.0, std::numeric_limits<double>::quiet_NaN(), 1000), makeRequest(5, 100.0, 1e-5, 1 << 30) };
+}
+
+/*
+ Returns whether the valid request of mixedRequests() got values and every other one an error.
+ */
+bool onlyValidAnswered(const std::vector<ServerReply>& replies)
+{
+    bool valid = replies.size() == 5 && replies[0].status == serverStatusOk && replies[0].values.size() == 6;
+    for (std::size_t index = 1; index < replies.size(); ++index)
+    {
+        valid = valid && replies[index].status == serverStatusInvalidRequest && !replies[index].message.empty();
+    }
+    return valid;
+}
+
+int main()
+{
+    bool passed = true;
+    passed &= reportCondition("In-process batch rejects only the bad requests", onlyValidAnswered(runServerBatch(mixedRequests())));
+
+    SimulationServer server(socketPath);
+    std::thread serverThread([&]() { server.run(); });
+    try
+    {
+        SimulationClient client(socketPath);
+        std::vector<ServerRequest> requests = mixedRequests();
+        for (const ServerRequest& request : requests)
+        {
+            client.send(request);
+        }
+        std::vector<ServerReply> replies;
+        for (std::size_t index = 0; index < requests.size(); ++index)
+        {
+            replies.push_back(client.receive());
+        }
+        passed &= reportCondition("Server rejects only the bad requests", onlyValidAnswered(replies));
+        passed &= reportCondition("Server answers after the bad requests", client.simulate(makeRequest(6, 1.0, 0.01, 1000)).status == serverStatusOk);
+
+        // One client fills its socket with replies it does not read
+        SimulationClient slowReader(socketPath);
+        ServerRequest smallRequest = makeRequest(0, 0.01, 0.01, 1);
+        for (int index = 0; index < unreadRequests; ++index)
+        {
+            smallRequest.requestId = static_cast<std::uint32_t>(index);
+            slowReader.send(smallRequest);
+        }
+        SimulationClient otherClient(socketPath);
+        passed &= reportCondition("Server answers while a client does not read", otherClient.simulate(makeRequest(7, 1.0, 0.01, 1000)).status == serverStatusOk);
+        bool inOrder = true;
+        for (int index = 0; index < unreadRequests; ++index)
+        {
+            inOrder = inOrder && slowReader.receive().requestId == static_cast<std::uint32_t>(index);
+        }
+        passed &= reportCondition("The slow reader gets every reply in order", inOrder);
+        passed &= reportCondition("Batches hold at most " + std::to_string(serverMaximumBatchRequests) + " requests",
+            server.largestBatch() <= serverMaximumBatchRequests);
+    }
+    catch (const std::exception& error)
+    {
+        std::cout << error.what() << "\n";
+        passed = false;
+    }
+    server.stop();
+    serverThread.join();
+
+    return passed ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "../InterestRateModels/ShortRateModels.h"
+#include "../InterestRateModels/StreamingStatistics.h"
+#include "CheckReport.h"
+
+/*
+ Check that the streaming statistics keep NaN rates out of the quantiles,
+ and that the HJM forward quantiles are those of the simulated forwards.
+
+ Simulates CEV paths that go negative, where the rate becomes NaN, with a
+ PathStatisticsSink and with a PathStore from the same seed. The sink must
+ count as many non-finite rates at every date as the store holds, and the
+ quantiles at the horizon must be those of the finite rates: the fraction
+ of finite rates below each estimate must be within the tolerance of its
+ probability. A QuantileSketch is also fed a batch with NaN and infinite
+ values mixed in. Finally HJM curves are simulated with the quantiles of a
+ ForwardCurveStatisticsSink switched on and into a ForwardCurveStore, and
+ the quantiles of every maturity at the horizon are compared the same way.
+ Exits with status 1 if a count differs or a quantile is off.
+ */
+
+const double timeHorizon = 1.0;
+const double timeStep = 0.01;
+const int numberOfPaths = 4000;
+const std::uint64_t seed = 11;
+const double rankTolerance = 0.005;
+const std::vector<double> probabilities = { 0.01, 0.1, 0.5, 0.9, 0.99 };
+const int numberOfCurvePaths = 3000;
+
+/*
+ Returns the largest distance between a probability and the fraction of sorted values below its estimated quantile.
+
+ @param sketch The sketch of the values.
+ @param sortedValues The values, sorted.
+ */
+double largestRankError(const QuantileSketch& sketch, const std::vector<double>& sortedValues)
+{
+    double error = 0.0;
+    for (double probability : probabilities)
+    {
+        double estimate = sketch.quantile(probability);
+        double rank = static_cast<double>(std::upper_bound(sortedValues.begin(), sortedValues.end(), estimate) - sortedValues.begin()) / sortedValues.size();
+        error = std::max(error, std::isfinite(estimate) ? std::abs(rank - probability) : std::numeric_limits<double>::infinity());
+    }
+    return error;
+}
+
+int main()
+{
+    // Euler steps take some rates below zero, where r^(elasticity / 2) is NaN
+    ConstantElasticityVarianceModel model{ -0.5, 0.0, 1.5, 0.3, 0.01 };
+    PathStatisticsSink sink;
+    simulatePaths(model, timeHorizon, timeStep, numberOfPaths, seed, sink);
+    PathStore pathStore = simulatePathBatch(model, timeHorizon, timeStep, numberOfPaths, seed);
+
+    bool countsMatch = true;
+    std::vector<double> finiteRates;
+    for (int i = 0; i <= pathStore.numberOfTimeSteps; ++i)
+    {
+        finiteRates.clear();
+        for (int path = 0; path < numberOfPaths; ++path)
+        {
+            if (std::isfinite(pathStore.rate(i, path)))
+            {
+                finiteRates.push_back(pathStore.rate(i, path));
+            }
+        }
+        countsMatch &= sink.statistics.nonFiniteRateCounts[i] == static_cast<double>(numberOfPaths - finiteRates.size())
+            && sink.statistics.rateQuantiles[i].count() == static_cast<double>(finiteRates.size());
+    }
+    std::sort(finiteRates.begin(), finiteRates.end());
+    double nonFiniteRates = sink.statistics.nonFiniteRateCounts[pathStore.numberOfTimeSteps];
+
+    // A batch of 0, 1, ..., 999 with NaN and infinite values among them
+    std::vector<double> values;
+    std::vector<double> sortedFiniteValues;
+    for (int value = 0; value < 1000; ++value)
+    {
+        values.push_back(value);
+        sortedFiniteValues.push_back(value);
+        if (value % 100 == 0)
+        {
+            values.push_back(value % 200 == 0 ? std::numeric_limits<double>::quiet_NaN() : -std::numeric_limits<double>::infinity());
+        }
+    }
+    values.push_back(std::numeric_limits<double>::infinity());
+    QuantileSketch sketch;
+    std::size_t skipped = sketch.add(values.data(), values.size());
+
+    // HJM forwards of every maturity at the horizon
+    HeathJarrowMortonModel heathJarrowMorton;
+    heathJarrowMorton.initialForwardCurve = TimeCurve::constant(0.03);
+    heathJarrowMorton.maturities = { 0.5, 1.0, 2.0, 5.0, 10.0 };
+    heathJarrowMorton.factors = { { 0.01, 0.0 }, { 0.015, 0.5 } };
+    ForwardCurveStatisticsSink curveSink(200.0);
+    simulateForwardCurves(heathJarrowMorton, timeHorizon, 0.05, numberOfCurvePaths, seed, 5, curveSink);
+    ForwardCurveStore forwardCurveStore;
+    simulateForwardCurves(heathJarrowMorton, timeHorizon, 0.05, numberOfCurvePaths, seed, 5, forwardCurveStore);
+    int horizonRecord = forwardCurveStore.numberOfRecords() - 1;
+    double forwardRankError = 0.0;
+    std::vector<double> forwardRates;
+    for (int maturity = 0; maturity < forwardCurveStore.numberOfMaturities; ++maturity)
+    {
+        forwardRates.clear();
+        for (int path = 0; path < numberOfCurvePaths; ++path)
+        {
+            forwardRates.push_back(forwardCurveStore.forwardRate(horizonRecord, path, maturity));
+        }
+        std::sort(forwardRates.begin(), forwardRates.end());
+        forwardRankError = std::max(forwardRankError, largestRankError(curveSink.statistics.quantiles(horizonRecord, maturity), forwardRates));
+    }
+    ForwardCurveStatisticsSink momentsOnlySink;
+    simulateForwardCurves(heathJarrowMorton, timeHorizon, 0.05, numberOfCurvePaths, seed, 5, momentsOnlySink);
+
+    std::cout << "CEV paths with " << nonFiniteRates << " NaN rates out of " << numberOfPaths << " at the horizon\n\n";
+    bool passed = true;
+    passed &= reportCondition("The rates go NaN", nonFiniteRates > 0.0);
+    passed &= reportCondition("Non-finite rates counted at every date", countsMatch);
+    passed &= reportCheck("Rank error of the quantiles at the horizon", largestRankError(sink.statistics.rateQuantiles[pathStore.numberOfTimeSteps], finiteRates),
+        rankTolerance);
+    passed &= reportCondition("Sketch skips 11 NaN and infinite values", skipped == 11 && sketch.count() == 1000.0);
+    passed &= reportCondition("Sketch extremes are the finite ones", sketch.quantile(0.0) == 0.0 && sketch.quantile(1.0) == 999.0);
+    passed &= reportCheck("Rank error of the sketch", largestRankError(sketch, sortedFiniteValues), rankTolerance);
+    passed &= reportCheck("Rank error of the HJM forwards at the horizon", forwardRankError, rankTolerance);
+    passed &= reportCondition("No HJM sketches by default", momentsOnlySink.statistics.forwardRateQuantiles.empty());
+
+    return passed ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../InterestRateModels/HeathJarrowMortonEngine.h"
+#include "../InterestRateModels/ShortRateModels.h"
+#include "CheckReport.h"
+
+/*
+ Check that the results do not depend on the number of threads.
+
+ Simulates the short-rate models with the path engine, and HJM forward
+ curves, on one thread and on four, and compares the stored rates byte for
+ byte. The path counts are not multiples of the block sizes, so the last
+ block of a run is a partial one. Exits with status 1 if any byte differs.
+ */
+
+const double timeHorizon = 2.0;
+const double timeStep = 1.0 / 52.0;
+const int numberOfPaths = 2 * pathBlockSize + 300;
+const int numberOfForwardCurvePaths = 7 * forwardCurvePathBlockSize + 13;
+const std::uint64_t seed = 11;
+
+/*
+ Returns whether two vectors hold the same bytes.
+ */
+bool sameBytes(const std::vector<double>& first, const std::vector<double>& second)
+{
+    return first.size() == second.size() && std::memcmp(first.data(), second.data(), first.size() * sizeof(double)) == 0;
+}
+
+/*
+ Returns whether a model's paths on one thread and on four are bit-identical.
+
+ @param model The model to simulate, possibly wrapped in a scheme.
+ */
+template <typename Model>
+bool sameOnAnyThreadCount(const Model& model)
+{
+    ThreadPool oneThread(1);
+    ThreadPool fourThreads(4);
+    PathStore onOneThread;
+    PathStore onFourThreads;
+    simulatePathBatch(model, timeHorizon, timeStep, numberOfPaths, seed, onOneThread, oneThread);
+    simulatePathBatch(model, timeHorizon, timeStep, numberOfPaths, seed, onFourThreads, fourThreads);
+    return sameBytes(onOneThread.rateValues, onFourThreads.rateValues);
+}
+
+int main()
+{
+    VasicekModel vasicek{ 0.1, 0.05, 0.01, 0.03 };
+    CoxIngersollRossModel coxIngersollRoss{ 0.06, 0.2, 0.08, 0.04 };
+    ChanKarolyiLongstaffSandersModel chanKarolyiLongstaffSanders{ 0.01, 0.2, 0.5, 0.05, 0.04 };
+    ChanKarolyiLongstaffSandersModel generalElasticity{ 0.01, 0.2, 0.75, 0.05, 0.04 };
+    ConstantElasticityVarianceModel constantElasticityVariance{ 0.2, 0.01, 0.75, 0.1, 0.04 };
+    std::string paths = ", " + std::to_string(numberOfPaths) + " paths";
+
+    bool passed = true;
+    passed &= reportCondition("Vasicek" + paths, sameOnAnyThreadCount(vasicek));
+    passed &= reportCondition("CIR, exact transition" + paths, sameOnAnyThreadCount(ExactScheme<CoxIngersollRossModel>{ coxIngersollRoss }));
+    passed &= reportCondition("CKLS, specialized elasticity" + paths,
+        withSpecializedElasticity(chanKarolyiLongstaffSanders, [](const auto& model) { return sameOnAnyThreadCount(model); }));
+    passed &= reportCondition("CKLS, vectorized general elasticity" + paths, sameOnAnyThreadCount(generalElasticity));
+    passed &= reportCondition("CEV, adaptive Milstein" + paths, sameOnAnyThreadCount(AdaptiveScheme<ConstantElasticityVarianceModel>{ constantElasticityVariance }));
+
+    HeathJarrowMortonModel heathJarrowMorton;
+    heathJarrowMorton.initialForwardCurve = TimeCurve::constant(0.03);
+    heathJarrowMorton.maturities = { 0.25, 0.5, 1.0, 2.0, 5.0, 10.0 };
+    heathJarrowMorton.factors = { { 0.01, 0.0 }, { 0.015, 0.5 } };
+    ThreadPool oneThread(1);
+    ThreadPool fourThreads(4);
+    ForwardCurveStore onOneThread;
+    ForwardCurveStore onFourThreads;
+    simulateForwardCurves(heathJarrowMorton, timeHorizon, timeStep, numberOfForwardCurvePaths, seed, 1, onOneThread, oneThread);
+    simulateForwardCurves(heathJarrowMorton, timeHorizon, timeStep, numberOfForwardCurvePaths, seed, 1, onFourThreads, fourThreads);
+    passed &= reportCondition("HJM, " + std::to_string(numberOfForwardCurvePaths) + " paths", sameBytes(onOneThread.forwardRates, onFourThreads.forwardRates));
+
+    return passed ? 0 : 1;
+}
\ No newline at end of file
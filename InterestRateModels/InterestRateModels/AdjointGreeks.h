@@ -0,0 +1,673 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "CounterRandom.h"
+#include "PathEngine.h"
+#include "Profiling.h"
+#include "ShortRateModels.h"
+#include "StreamingStatistics.h"
+#include "ThreadPool.h"
+
+/*
+ Pathwise sensitivities of Monte Carlo bond prices to every model parameter, by adjoints.
+
+ A path is the recursion r(i + 1) = step(r(i), Z(i), parameters) and pays
+ Y = exp(-X), X the trapezoidal integral of r up to the maturity, as in
+ priceZeroCouponBonds(). Differentiating along the path, the adjoint
+ rbar(i) = dY / dr(i) satisfies
+
+   rbar(i) = -Y w(i) + rbar(i + 1) d r(i + 1) / d r(i),
+
+ with w(i) the trapezoidal weight of r(i), and each parameter collects
+ sum over i of rbar(i + 1) d r(i + 1) / d parameter. One backward sweep
+ thus gives every sensitivity of a path, however many parameters there are.
+ The sensitivity to initialInterestRate is rbar(0).
+
+ How the sweep is run depends on the model:
+
+ - Vasicek, Ho-Lee and Hull-White step linearly with additive noise, so
+   d r(i + 1) / d r(i) does not depend on the path and rbar(i) = Y a(i) with
+   weights a(i) that are computed once per run. The parameter sums are then
+   accumulated during the forward simulation, and no path is stored: the
+   cost is that of the pricing run plus a few multiply-adds per step and
+   parameter.
+ - CIR, CKLS and CEV have state-dependent Jacobians, so the sweep runs
+   backwards over the path. Instead of a tape of every step, a block of
+   paths keeps its rates every checkpointInterval steps; the reverse pass
+   recomputes one interval at a time from its checkpoint and walks back
+   through it. The increments are regenerated from the counter-based
+   streams rather than stored. With the default interval of about
+   sqrt(steps), a block holds O(sqrt(steps)) rows instead of O(steps), for
+   one extra forward pass.
+
+ The paths and increments are those of priceZeroCouponBonds() with the same
+ seed and time step, so the price matches its plain Monte Carlo estimate.
+ */
+
+/*
+ Settings of the adjoint pass.
+ */
+struct AdjointSettings
+{
+    int checkpointInterval = 0;  // steps between stored rows in the reverse pass; 0 picks about sqrt(steps)
+};
+
+/*
+ The derivative of a price with respect to one parameter.
+ */
+struct ParameterSensitivity
+{
+    std::string parameter;
+    double value = 0.0;
+    double standardError = 0.0;
+};
+
+/*
+ A Monte Carlo bond price with its parameter sensitivities.
+ */
+struct BondGreeks
+{
+    double maturity = 0.0;          // the maturity, rounded to the time grid
+    double price = 0.0;             // the plain Monte Carlo estimate
+    double standardError = 0.0;
+    std::vector<ParameterSensitivity> sensitivities;  // initialInterestRate first, then the model's parameters
+    bool tapeFree = false;          // whether the sensitivities were accumulated in the forward pass
+    std::size_t storedRows = 0;     // rows of pathBlockSize rates and increments held per thread
+    std::size_t fullTapeRows = 0;   // rows a tape of every rate and increment would hold
+};
+
+/*
+ Derivatives of the Euler coefficients at one time and rate: with respect to
+ the rate, and with respect to each parameter of the model in order.
+ */
+struct EulerPartials
+{
+    static constexpr int maximumParameters = 4;
+
+    double driftRate = 0.0;
+    double diffusionRate = 0.0;
+    double drift[maximumParameters] = {};
+    double diffusion[maximumParameters] = {};
+};
+
+/*
+ Adjoint of a row of Euler steps r' = constrain(r + drift h + diffusion sqrt(h) Z).
+
+ @param model The model.
+ @param step The step.
+ @param rates The rates at the start of the step.
+ @param increments The increments of the step.
+ @param nextRates The rates at the end of the step.
+ @param nextAdjoints The adjoints of nextRates.
+ @param rateAdjoints Receives nextAdjoints times d r' / d r.
+ @param parameterAdjoints Collects nextAdjoints times d r' / d parameter, pathBlockSize values per parameter.
+ @param numberOfPaths The number of paths in the row.
+ @param numberOfParameters The number of parameters of the model.
+ @param partials Fills the EulerPartials of the model at a time and rate.
+ */
+template <typename Model, typename Partials>
+void eulerAdjointRow(
+    const Model& model,
+    const TimeStep& step,
+    const double* rates,
+    const double* increments,
+    const double* nextRates,
+    const double* nextAdjoints,
+    double* rateAdjoints,
+    double* parameterAdjoints,
+    const int& numberOfPaths,
+    const int& numberOfParameters,
+    const Partials& partials)
+{
+    EulerPartials point;
+    for (int path = 0; path < numberOfPaths; ++path)
+    {
+        // A step floored at zero does not depend on anything
+        if (HasNonNegativeRates<Model>::value && nextRates[path] <= 0.0)
+        {
+            rateAdjoints[path] = 0.0;
+            continue;
+        }
+        partials(model, step.startTime, rates[path], point);
+        double noise = step.squareRootLength * increments[path];
+        rateAdjoints[path] = nextAdjoints[path] * (1.0 + point.driftRate * step.length + point.diffusionRate * noise);
+        for (int parameter = 0; parameter < numberOfParameters; ++parameter)
+        {
+            parameterAdjoints[parameter * pathBlockSize + path] += nextAdjoints[path] * (point.drift[parameter] * step.length + point.diffusion[parameter] * noise);
+        }
+    }
+}
+
+/*
+ The adjoint of each model's step. A specialization provides
+   static constexpr bool tapeFree                  d r' / d r is the same on every path
+   parameterNames(model)                           the parameters, in the order of the adjoints
+   adjointRow(model, step, rates, increments, nextRates, nextAdjoints, rateAdjoints, parameterAdjoints, numberOfPaths)
+ and, when tapeFree,
+   stepJacobian(model, step)                       d r' / d r
+ */
+template <typename Model>
+struct ModelAdjoint;
+
+template <>
+struct ModelAdjoint<VasicekModel>
+{
+    static constexpr bool tapeFree = true;
+
+    static std::vector<std::string> parameterNames(const VasicekModel&)
+    {
+        return { "meanReversionSpeed", "longTermInterestRate", "volatility" };
+    }
+
+    static double stepJacobian(const VasicekModel& model, const TimeStep& step)
+    {
+        return 1.0 - model.meanReversionSpeed * step.length;
+    }
+
+    static void adjointRow(const VasicekModel& model, const TimeStep& step, const double* rates, const double* increments, const double* nextRates,
+        const double* nextAdjoints, double* rateAdjoints, double* parameterAdjoints, const int& numberOfPaths)
+    {
+        eulerAdjointRow(model, step, rates, increments, nextRates, nextAdjoints, rateAdjoints, parameterAdjoints, numberOfPaths, 3,
+            [](const VasicekModel& vasicek, const double&, const double& rate, EulerPartials& point)
+            {
+                // drift = a (b - r), diffusion = sigma
+                point.driftRate = -vasicek.meanReversionSpeed;
+                point.drift[0] = vasicek.longTermInterestRate - rate;
+                point.drift[1] = vasicek.meanReversionSpeed;
+                point.diffusion[2] = 1.0;
+            });
+    }
+};
+
+template <>
+struct ModelAdjoint<CoxIngersollRossModel>
+{
+    static constexpr bool tapeFree = false;
+
+    static std::vector<std::string> parameterNames(const CoxIngersollRossModel&)
+    {
+        return { "meanReversionLevel", "meanReversionRate", "volatility" };
+    }
+
+    static void adjointRow(const CoxIngersollRossModel& model, const TimeStep& step, const double* rates, const double* increments, const double* nextRates,
+        const double* nextAdjoints, double* rateAdjoints, double* parameterAdjoints, const int& numberOfPaths)
+    {
+        eulerAdjointRow(model, step, rates, increments, nextRates, nextAdjoints, rateAdjoints, parameterAdjoints, numberOfPaths, 3,
+            [](const CoxIngersollRossModel& coxIngersollRoss, const double& time, const double& rate, EulerPartials& point)
+            {
+                // drift = k (theta - r), diffusion = sigma sqrt(r)
+                double diffusion = coxIngersollRoss.diffusion(time, rate);
+                point.driftRate = -coxIngersollRoss.meanReversionRate;
+                point.diffusionRate = coxIngersollRoss.diffusionDerivative(time, rate, diffusion);
+                point.drift[0] = coxIngersollRoss.meanReversionRate;
+                point.drift[1] = coxIngersollRoss.meanReversionLevel - rate;
+                point.diffusion[2] = std::sqrt(std::max(0.0, rate));
+            });
+    }
+};
+
+template <typename Elasticity>
+struct ModelAdjoint<BasicChanKarolyiLongstaffSandersModel<Elasticity>>
+{
+    using Model = BasicChanKarolyiLongstaffSandersModel<Elasticity>;
+
+    static constexpr bool tapeFree = false;
+
+    static std::vector<std::string> parameterNames(const Model&)
+    {
+        return { "driftTerm", "meanReversionRate", "elasticity", "volatility" };
+    }
+
+    static void adjointRow(const Model& model, const TimeStep& step, const double* rates, const double* increments, const double* nextRates,
+        const double* nextAdjoints, double* rateAdjoints, double* parameterAdjoints, const int& numberOfPaths)
+    {
+        eulerAdjointRow(model, step, rates, increments, nextRates, nextAdjoints, rateAdjoints, parameterAdjoints, numberOfPaths, 4,
+            [](const Model& chanKarolyiLongstaffSanders, const double& time, const double& rate, EulerPartials& point)
+            {
+                // drift = alpha - beta r, diffusion = sigma |r|^gamma
+                double diffusion = chanKarolyiLongstaffSanders.diffusion(time, rate);
+                double absoluteRate = std::abs(rate);
+                point.driftRate = -chanKarolyiLongstaffSanders.meanReversionRate;
+                point.diffusionRate = chanKarolyiLongstaffSanders.diffusionDerivative(time, rate, diffusion);
+                point.drift[0] = 1.0;
+                point.drift[1] = -rate;
+                point.diffusion[2] = absoluteRate > 0.0 ? diffusion * std::log(absoluteRate) : 0.0;
+                point.diffusion[3] = chanKarolyiLongstaffSanders.volatility != 0.0 ? diffusion / chanKarolyiLongstaffSanders.volatility : Elasticity::power(absoluteRate, chanKarolyiLongstaffSanders.elasticity);
+            });
+    }
+};
+
+template <typename Elasticity>
+struct ModelAdjoint<BasicConstantElasticityVarianceModel<Elasticity>>
+{
+    using Model = BasicConstantElasticityVarianceModel<Elasticity>;
+
+    static constexpr bool tapeFree = false;
+
+    static std::vector<std::string> parameterNames(const Model&)
+    {
+        return { "meanReversionRate", "driftTerm", "elasticity", "volatility" };
+    }
+
+    static void adjointRow(const Model& model, const TimeStep& step, const double* rates, const double* increments, const double* nextRates,
+        const double* nextAdjoints, double* rateAdjoints, double* parameterAdjoints, const int& numberOfPaths)
+    {
+        eulerAdjointRow(model, step, rates, increments, nextRates, nextAdjoints, rateAdjoints, parameterAdjoints, numberOfPaths, 4,
+            [](const Model& constantElasticityVariance, const double& time, const double& rate, EulerPartials& point)
+            {
+                // drift = c r^(gamma - 1) + a r, diffusion = sigma r^(gamma / 2)
+                double elasticity = constantElasticityVariance.elasticity;
+                double power = Elasticity::powerMinusOne(rate, elasticity);
+                double diffusion = constantElasticityVariance.diffusion(time, rate);
+                double logRate = rate > 0.0 ? std::log(rate) : 0.0;
+                point.driftRate = (rate != 0.0 ? constantElasticityVariance.driftTerm * (elasticity - 1.0) * power / rate : 0.0) + constantElasticityVariance.meanReversionRate;
+                point.diffusionRate = constantElasticityVariance.diffusionDerivative(time, rate, diffusion);
+                point.drift[0] = rate;
+                point.drift[1] = power;
+                point.drift[2] = constantElasticityVariance.driftTerm * power * logRate;
+                point.diffusion[2] = 0.5 * diffusion * logRate;
+                point.diffusion[3] = constantElasticityVariance.volatility != 0.0 ? diffusion / constantElasticityVariance.volatility : Elasticity::halfPower(rate, elasticity);
+            });
+    }
+};
+
+template <>
+struct ModelAdjoint<HoAndLeeModel>
+{
+    static constexpr bool tapeFree = true;
+
+    static std::vector<std::string> parameterNames(const HoAndLeeModel&)
+    {
+        return { "driftTerm", "volatility" };
+    }
+
+    static double stepJacobian(const HoAndLeeModel&, const TimeStep&)
+    {
+        return 1.0;
+    }
+
+    static void adjointRow(const HoAndLeeModel& model, const TimeStep& step, const double* rates, const double* increments, const double* nextRates,
+        const double* nextAdjoints, double* rateAdjoints, double* parameterAdjoints, const int& numberOfPaths)
+    {
+        eulerAdjointRow(model, step, rates, increments, nextRates, nextAdjoints, rateAdjoints, parameterAdjoints, numberOfPaths, 2,
+            [](const HoAndLeeModel&, const double& time, const double&, EulerPartials& point)
+            {
+                // drift = c t, diffusion = sigma
+                point.drift[0] = time;
+                point.diffusion[1] = 1.0;
+            });
+    }
+};
+
+/*
+ Hull-White steps with its exact transition at the midpoint of each step,
+ r' = exp(-a h) r + theta G(a) + sigma sqrt(V(a)) Z, and its parameters are
+ the knot values of the theta, alpha and sigma curves in that order. The
+ derivative with respect to a curve's value at the midpoint goes to the knots
+ that valueAt() interpolates between.
+ */
+template <>
+struct ModelAdjoint<HullWhiteModel>
+{
+    static constexpr bool tapeFree = true;
+
+    static std::vector<std::string> parameterNames(const HullWhiteModel& model)
+    {
+        std::vector<std::string> names;
+        for (std::size_t knot = 0; knot < model.theta.values.size(); ++knot)
+        {
+            names.push_back("theta" + std::to_string(knot));
+        }
+        for (std::size_t knot = 0; knot < model.alpha.values.size(); ++knot)
+        {
+            names.push_back("alpha" + std::to_string(knot));
+        }
+        for (std::size_t knot = 0; knot < model.sigma.values.size(); ++knot)
+        {
+            names.push_back("sigma" + std::to_string(knot));
+        }
+        return names;
+    }
+
+    static double stepJacobian(const HullWhiteModel& model, const TimeStep& step)
+    {
+        return model.exactTransition(step.startTime, step.length).decay;
+    }
+
+    static void adjointRow(const HullWhiteModel& model, const TimeStep& step, const double* rates, const double* increments, const double*,
+        const double* nextAdjoints, double* rateAdjoints, double* parameterAdjoints, const int& numberOfPaths)
+    {
+        double midpoint = step.startTime + 0.5 * step.length;
+        double length = step.length;
+        double meanReversion = model.alpha.valueAt(midpoint);
+        double volatility = model.sigma.valueAt(midpoint);
+        double theta = model.theta.valueAt(midpoint);
+        GaussianTransition transition = model.exactTransition(step.startTime, length);
+
+        // G = (1 - exp(-a h)) / a and V = (1 - exp(-2 a h)) / (2 a) with their derivatives in a
+        double growthFactor = length;
+        double varianceFactor = length;
+        double growthDerivative = -0.5 * length * length;
+        double varianceDerivative = -length * length;
+        if (meanReversion != 0.0)
+        {
+            growthFactor = -std::expm1(-meanReversion * length) / meanReversion;
+            varianceFactor = -std::expm1(-2.0 * meanReversion * length) / (2.0 * meanReversion);
+            growthDerivative = (length * transition.decay - growthFactor) / meanReversion;
+            varianceDerivative = (length * transition.decay * transition.decay - varianceFactor) / meanReversion;
+        }
+        double squareRootVariance = std::sqrt(varianceFactor);
+
+        // The knots each curve interpolates between at the midpoint
+        const TimeCurve* curves[3] = { &model.theta, &model.alpha, &model.sigma };
+        std::size_t firstKnots[3];
+        double secondWeights[3];
+        std::size_t offsets[3];
+        std::size_t offset = 0;
+        for (int curve = 0; curve < 3; ++curve)
+        {
+            curves[curve]->knotWeights(midpoint, firstKnots[curve], secondWeights[curve]);
+            offsets[curve] = offset + firstKnots[curve];
+            offset += curves[curve]->values.size();
+        }
+
+        for (int path = 0; path < numberOfPaths; ++path)
+        {
+            double adjoint = nextAdjoints[path];
+            rateAdjoints[path] = adjoint * transition.decay;
+            double derivatives[3] = {
+                growthFactor,
+                -length * transition.decay * rates[path] + theta * growthDerivative + volatility * increments[path] * 0.5 * varianceDerivative / squareRootVariance,
+                squareRootVariance * increments[path]
+            };
+            for (int curve = 0; curve < 3; ++curve)
+            {
+                double contribution = adjoint * derivatives[curve];
+                parameterAdjoints[offsets[curve] * pathBlockSize + path] += (1.0 - secondWeights[curve]) * contribution;
+                if (secondWeights[curve] != 0.0)
+                {
+                    parameterAdjoints[(offsets[curve] + 1) * pathBlockSize + path] += secondWeights[curve] * contribution;
+                }
+            }
+        }
+    }
+};
+
+/*
+ Prices a zero-coupon bond by Monte Carlo with its sensitivities to the
+ initial rate and every model parameter, from one adjoint pass per path.
+
+ @param model The short-rate model, stepped as the path engine steps it bare.
+ @param maturity The maturity of the bond, rounded to the nearest step.
+ @param timeStep The time step of the simulation.
+ @param numberOfPaths The number of paths to simulate.
+ @param seed The seed of the random number streams.
+ @param settings The checkpointing of the reverse pass.
+ @param threadPool The threads that simulate the path blocks.
+ */
+template <typename Model>
+BondGreeks priceZeroCouponBondGreeks(
+    const Model& model,
+    const double& maturity,
+    const double& timeStep,
+    const int& numberOfPaths,
+    const std::uint64_t& seed,
+    const AdjointSettings& settings = AdjointSettings(),
+    ThreadPool& threadPool = defaultThreadPool())
+{
+    INTEREST_RATE_MODELS_PROFILE_SCOPE("adjointGreeks");
+    using Adjoint = ModelAdjoint<Model>;
+    std::vector<std::string> parameterNames = Adjoint::parameterNames(model);
+    int numberOfParameters = static_cast<int>(parameterNames.size());
+    int numberOfSteps = static_cast<int>(std::lround(maturity / timeStep));
+    if (numberOfSteps < 1 || numberOfPaths < 1)
+    {
+        throw std::runtime_error("Bond sensitivities need at least one step and one path");
+    }
+
+    // An even interval keeps each interval's increments in whole pairs of the streams.
+    // Tape-free models only step forward, two rows at a time
+    int checkpointInterval = settings.checkpointInterval > 0 ? settings.checkpointInterval : static_cast<int>(std::ceil(std::sqrt(static_cast<double>(numberOfSteps))));
+    checkpointInterval = Adjoint::tapeFree ? 2 : std::min(checkpointInterval + checkpointInterval % 2, numberOfSteps + numberOfSteps % 2);
+    int numberOfCheckpoints = Adjoint::tapeFree ? 0 : (numberOfSteps + checkpointInterval - 1) / checkpointInterval;
+
+    auto makeStep = [&](const int& stepIndex, const int& firstPath)
+    {
+        TimeStep step;
+        step.stepIndex = stepIndex;
+        step.startTime = (stepIndex - 1) * timeStep;
+        step.endTime = stepIndex * timeStep;
+        step.length = timeStep;
+        step.squareRootLength = std::sqrt(timeStep);
+        step.seed = seed;
+        step.firstPath = static_cast<std::uint64_t>(firstPath);
+        return step;
+    };
+
+    // Trapezoidal weights of the rates in the discount integral
+    auto discountWeight = [&](const int& stepIndex)
+    {
+        return stepIndex == 0 || stepIndex == numberOfSteps ? 0.5 * timeStep : timeStep;
+    };
+
+    // Tape-free models: the adjoint of r(i) is Y a(i) on every path
+    std::vector<double> pathIndependentAdjoints;
+    if constexpr (Adjoint::tapeFree)
+    {
+        pathIndependentAdjoints.resize(static_cast<std::size_t>(numberOfSteps) + 1);
+        pathIndependentAdjoints[numberOfSteps] = -discountWeight(numberOfSteps);
+        for (int i = numberOfSteps - 1; i >= 0; --i)
+        {
+            pathIndependentAdjoints[i] = -discountWeight(i) + pathIndependentAdjoints[i + 1] * Adjoint::stepJacobian(model, makeStep(i + 1, 0));
+        }
+    }
+
+    struct ThreadState
+    {
+        RunningMoments price;
+        std::vector<RunningMoments> sensitivities;
+        std::vector<double> rows;           // checkpoints, then the rows of one interval
+        std::vector<double> increments;     // the increments of one interval
+        std::vector<double> adjoints;       // two rows
+        std::vector<double> parameterAdjoints;
+        std::vector<double> integrals;
+        std::vector<double> payoffs;
+    };
+    std::vector<ThreadState> threadStates(static_cast<std::size_t>(threadPool.numberOfThreads()));
+    // Rows of rates: the checkpoints, then one interval; and one interval of increments
+    std::size_t rateRows = static_cast<std::size_t>(numberOfCheckpoints) + checkpointInterval + 1;
+    for (ThreadState& threadState : threadStates)
+    {
+        threadState.sensitivities.assign(static_cast<std::size_t>(numberOfParameters) + 1, RunningMoments());
+        threadState.rows.resize(rateRows * pathBlockSize);
+        threadState.increments.resize(static_cast<std::size_t>(checkpointInterval) * pathBlockSize);
+        threadState.adjoints.resize(2 * static_cast<std::size_t>(pathBlockSize));
+        threadState.parameterAdjoints.resize(static_cast<std::size_t>(numberOfParameters) * pathBlockSize);
+        threadState.integrals.resize(pathBlockSize);
+        threadState.payoffs.resize(pathBlockSize);
+    }
+
+    auto simulateBlock = [&](int blockIndex, int threadIndex)
+    {
+        ThreadState& state = threadStates[threadIndex];
+        int firstPath = blockIndex * pathBlockSize;
+        int blockPaths = std::min(pathBlockSize, numberOfPaths - firstPath);
+        INTEREST_RATE_MODELS_PROFILE_COUNT(Paths, blockPaths);
+        INTEREST_RATE_MODELS_PROFILE_COUNT(Steps, static_cast<std::uint64_t>(blockPaths) * numberOfSteps * (Adjoint::tapeFree ? 1 : 2));
+        double* increments = state.increments.data();
+        double* parameterAdjoints = state.parameterAdjoints.data();
+        double* integrals = state.integrals.data();
+        std::fill(state.parameterAdjoints.begin(), state.parameterAdjoints.end(), 0.0);
+
+        // The increments of steps first + 1 .. last, one row per step from row zero, in whole pairs
+        auto fillIncrements = [&](const int& first, const int& last)
+        {
+            for (int increment = first; increment < last; increment += 2)
+            {
+                double* row = increments + static_cast<std::size_t>(increment - first) * pathBlockSize;
+                fillIncrementPair(seed, static_cast<std::uint32_t>(increment / 2), static_cast<std::uint64_t>(firstPath), blockPaths, row, row + pathBlockSize);
+            }
+        };
+
+        // Forward pass: the payoff, and the checkpoints or the tape-free parameter sums
+        double* checkpoints = state.rows.data();
+        double* intervalRows = checkpoints + static_cast<std::size_t>(numberOfCheckpoints) * pathBlockSize;
+        double* previousRates = intervalRows;
+        double* currentRates = intervalRows + pathBlockSize;
+        std::fill(previousRates, previousRates + blockPaths, model.initialInterestRate);
+        for (int path = 0; path < blockPaths; ++path)
+        {
+            integrals[path] = discountWeight(0) * previousRates[path];
+        }
+        double* adjointRow = state.adjoints.data();
+        double* scratchRow = adjointRow + pathBlockSize;
+        for (int i = 1; i <= numberOfSteps; ++i)
+        {
+            int stepInInterval = (i - 1) % checkpointInterval;
+            if (stepInInterval == 0)
+            {
+                fillIncrements(i - 1, std::min(i - 1 + checkpointInterval, numberOfSteps));
+                if constexpr (!Adjoint::tapeFree)
+                {
+                    std::copy(previousRates, previousRates + blockPaths, checkpoints + static_cast<std::size_t>((i - 1) / checkpointInterval) * pathBlockSize);
+                }
+            }
+            const double* stepIncrements = increments + static_cast<std::size_t>(stepInInterval) * pathBlockSize;
+            TimeStep step = makeStep(i, firstPath);
+            advancePaths(model, step, previousRates, stepIncrements, currentRates, blockPaths);
+            if constexpr (Adjoint::tapeFree)
+            {
+                std::fill(adjointRow, adjointRow + blockPaths, pathIndependentAdjoints[i]);
+                Adjoint::adjointRow(model, step, previousRates, stepIncrements, currentRates, adjointRow, scratchRow, parameterAdjoints, blockPaths);
+            }
+            std::swap(previousRates, currentRates);
+            for (int path = 0; path < blockPaths; ++path)
+            {
+                integrals[path] += discountWeight(i) * previousRates[path];
+            }
+        }
+        double* payoffs = state.payoffs.data();
+        for (int path = 0; path < blockPaths; ++path)
+        {
+            payoffs[path] = std::exp(-integrals[path]);
+        }
+        state.price.add(payoffs, static_cast<std::size_t>(blockPaths));
+
+        if constexpr (Adjoint::tapeFree)
+        {
+            for (int path = 0; path < blockPaths; ++path)
+            {
+                adjointRow[path] = payoffs[path] * pathIndependentAdjoints[0];
+            }
+            for (int parameter = 0; parameter < numberOfParameters; ++parameter)
+            {
+                double* sums = parameterAdjoints + static_cast<std::size_t>(parameter) * pathBlockSize;
+                for (int path = 0; path < blockPaths; ++path)
+                {
+                    sums[path] *= payoffs[path];
+                }
+            }
+        }
+        else
+        {
+            // Reverse pass, one interval at a time, each recomputed from its checkpoint
+            for (int path = 0; path < blockPaths; ++path)
+            {
+                adjointRow[path] = -discountWeight(numberOfSteps) * payoffs[path];
+            }
+            for (int checkpoint = numberOfCheckpoints - 1; checkpoint >= 0; --checkpoint)
+            {
+                int first = checkpoint * checkpointInterval;
+                int last = std::min(first + checkpointInterval, numberOfSteps);
+                fillIncrements(first, last);
+                std::copy(checkpoints + static_cast<std::size_t>(checkpoint) * pathBlockSize, checkpoints + static_cast<std::size_t>(checkpoint + 1) * pathBlockSize, intervalRows);
+                for (int i = first + 1; i <= last; ++i)
+                {
+                    advancePaths(model, makeStep(i, firstPath), intervalRows + static_cast<std::size_t>(i - 1 - first) * pathBlockSize,
+                        increments + static_cast<std::size_t>(i - 1 - first) * pathBlockSize, intervalRows + static_cast<std::size_t>(i - first) * pathBlockSize, blockPaths);
+                }
+                for (int i = last; i > first; --i)
+                {
+                    const double* rates = intervalRows + static_cast<std::size_t>(i - 1 - first) * pathBlockSize;
+                    Adjoint::adjointRow(model, makeStep(i, firstPath), rates, increments + static_cast<std::size_t>(i - 1 - first) * pathBlockSize,
+                        intervalRows + static_cast<std::size_t>(i - first) * pathBlockSize, adjointRow, scratchRow, parameterAdjoints, blockPaths);
+                    for (int path = 0; path < blockPaths; ++path)
+                    {
+                        scratchRow[path] -= discountWeight(i - 1) * payoffs[path];
+                    }
+                    std::swap(adjointRow, scratchRow);
+                }
+            }
+        }
+
+        state.sensitivities[0].add(adjointRow, static_cast<std::size_t>(blockPaths));
+        for (int parameter = 0; parameter < numberOfParameters; ++parameter)
+        {
+            state.sensitivities[parameter + 1].add(parameterAdjoints + static_cast<std::size_t>(parameter) * pathBlockSize, static_cast<std::size_t>(blockPaths));
+        }
+    };
+
+    int numberOfBlocks = (numberOfPaths + pathBlockSize - 1) / pathBlockSize;
+    threadPool.parallelFor(numberOfBlocks, simulateBlock);
+
+    RunningMoments price;
+    std::vector<RunningMoments> sensitivities(static_cast<std::size_t>(numberOfParameters) + 1);
+    for (const ThreadState& threadState : threadStates)
+    {
+        price.merge(threadState.price);
+        for (std::size_t parameter = 0; parameter < sensitivities.size(); ++parameter)
+        {
+            sensitivities[parameter].merge(threadState.sensitivities[parameter]);
+        }
+    }
+
+    BondGreeks greeks;
+    greeks.maturity = numberOfSteps * timeStep;
+    greeks.price = price.mean;
+    greeks.standardError = price.standardError();
+    greeks.tapeFree = Adjoint::tapeFree;
+    greeks.storedRows = rateRows + checkpointInterval;
+    greeks.fullTapeRows = 2 * static_cast<std::size_t>(numberOfSteps) + 1;
+    parameterNames.insert(parameterNames.begin(), "initialInterestRate");
+    for (std::size_t parameter = 0; parameter < sensitivities.size(); ++parameter)
+    {
+        greeks.sensitivities.push_back({ parameterNames[parameter], sensitivities[parameter].mean, sensitivities[parameter].standardError() });
+    }
+    return greeks;
+}
+
+/*
+ Prints a bond price with its parameter sensitivities.
+
+ @param output The stream to print to.
+ @param title The title of the table, naming the model and the bond.
+ @param greeks The result of priceZeroCouponBondGreeks().
+ */
+inline void printBondGreeks(std::ostream& output, const std::string& title, const BondGreeks& greeks)
+{
+    std::ios_base::fmtflags flags = output.flags();
+    std::streamsize precision = output.precision();
+
+    output << "Sensitivities: " << title << "\n";
+    output << std::left << std::setw(30) << "  Parameter" << std::right << std::setw(14) << "dPrice" << std::setw(14) << "Std error" << "\n";
+    output << "  " << std::left << std::setw(28) << "(price)" << std::right << std::fixed << std::setprecision(6) << std::setw(14) << greeks.price
+        << std::scientific << std::setprecision(2) << std::setw(14) << greeks.standardError << "\n";
+    for (const ParameterSensitivity& sensitivity : greeks.sensitivities)
+    {
+        output << "  " << std::left << std::setw(28) << sensitivity.parameter << std::right << std::fixed << std::setprecision(6) << std::setw(14) << sensitivity.value
+            << std::scientific << std::setprecision(2) << std::setw(14) << sensitivity.standardError << "\n";
+    }
+    output << "  " << (greeks.tapeFree ? "Tape-free" : "Checkpointed") << ", " << greeks.storedRows << " of " << greeks.fullTapeRows << " rows stored per path block\n";
+
+    output.flags(flags);
+    output.precision(precision);
+}
@@ -0,0 +1,335 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "PathEngine.h"
+#include "ShortRateModels.h"
+#include "StreamingStatistics.h"
+
+/*
+ Monte Carlo zero-coupon bond prices and discount curves.
+
+ Each path's rate is integrated along the way with the trapezoidal rule, and
+ the bond maturing at T pays exp(-int_0^T r(s) ds). All maturities come out
+ of one pass over the paths, without storing them.
+
+ Vasicek, CIR and Ho-Lee have closed-form bond prices and rate means. For
+ them the integral X = int_0^T r ds is used as a control variate for the
+ payoff Y = exp(-X): its expectation is known exactly, it is strongly
+ correlated with Y, and the estimate becomes mean(Y) - beta * (mean(X) - E[X])
+ with beta = cov(X, Y) / var(X). With Euler steps both the payoff and its
+ control keep the scheme's O(timeStep) bias; ExactScheme<> removes it.
+ */
+
+/*
+ Bond price and rate mean of the Vasicek model.
+ */
+inline double analyticBondPrice(const VasicekModel& model, const double& maturity)
+{
+    double a = model.meanReversionSpeed;
+    double variance = model.volatility * model.volatility;
+    if (a == 0.0)
+    {
+        return std::exp(-model.initialInterestRate * maturity + variance * maturity * maturity * maturity / 6.0);
+    }
+    double b = (1.0 - std::exp(-a * maturity)) / a;
+    double logA = (model.longTermInterestRate - variance / (2.0 * a * a)) * (b - maturity) - variance * b * b / (4.0 * a);
+    return std::exp(logA - b * model.initialInterestRate);
+}
+
+inline double analyticShortRateMean(const VasicekModel& model, const double& time)
+{
+    return model.longTermInterestRate + (model.initialInterestRate - model.longTermInterestRate) * std::exp(-model.meanReversionSpeed * time);
+}
+
+/*
+ Bond price and rate mean of the CIR model.
+ */
+inline double analyticBondPrice(const CoxIngersollRossModel& model, const double& maturity)
+{
+    double kappa = model.meanReversionRate;
+    double variance = model.volatility * model.volatility;
+    double gamma = std::sqrt(kappa * kappa + 2.0 * variance);
+    double growth = std::expm1(gamma * maturity);
+    double denominator = (gamma + kappa) * growth + 2.0 * gamma;
+    double b = 2.0 * growth / denominator;
+    double logA = variance > 0.0
+        ? 2.0 * kappa * model.meanReversionLevel / variance * std::log(2.0 * gamma * std::exp(0.5 * (kappa + gamma) * maturity) / denominator)
+        : -model.meanReversionLevel * (maturity - b);
+    return std::exp(logA - b * model.initialInterestRate);
+}
+
+inline double analyticShortRateMean(const CoxIngersollRossModel& model, const double& time)
+{
+    return model.meanReversionLevel + (model.initialInterestRate - model.meanReversionLevel) * std::exp(-model.meanReversionRate * time);
+}
+
+/*
+ Bond price and rate mean of the Ho-Lee model as simulated here, dr = driftTerm * t dt + volatility dW.
+ */
+inline double analyticBondPrice(const HoAndLeeModel& model, const double& maturity)
+{
+    double cube = maturity * maturity * maturity;
+    return std::exp(-model.initialInterestRate * maturity - model.driftTerm * cube / 6.0 + model.volatility * model.volatility * cube / 6.0);
+}
+
+inline double analyticShortRateMean(const HoAndLeeModel& model, const double& time)
+{
+    return model.initialInterestRate + 0.5 * model.driftTerm * time * time;
+}
+
+/*
+ True for models with analyticBondPrice() and analyticShortRateMean(), including their ExactScheme<>.
+ */
+template <typename Model, typename = void>
+struct HasAnalyticBondPrice : std::false_type
+{
+};
+
+template <typename Model>
+struct HasAnalyticBondPrice<Model, decltype(void(analyticBondPrice(std::declval<const Model&>(), 0.0)), void(analyticShortRateMean(std::declval<const Model&>(), 0.0)))> : std::true_type
+{
+};
+
+/*
+ The Monte Carlo price of one zero-coupon bond.
+ */
+struct BondPriceEstimate
+{
+    double maturity = 0.0;              // the maturity, rounded to the time grid
+    double price = 0.0;                 // the estimate, with the control variate where available
+    double standardError = 0.0;         // the standard error of price
+    double plainPrice = 0.0;            // the plain Monte Carlo estimate
+    double plainStandardError = 0.0;    // the standard error of plainPrice
+    double analyticPrice = std::numeric_limits<double>::quiet_NaN();  // the closed form, NaN if the model has none
+    double controlCoefficient = 0.0;    // beta, zero without a control variate
+
+    /*
+     Returns the continuously compounded zero rate, -log(price) / maturity.
+     */
+    double zeroRate() const
+    {
+        return maturity > 0.0 ? -std::log(price) / maturity : 0.0;
+    }
+
+    /*
+     Returns how many times fewer paths the control variate needs for the same error.
+     */
+    double varianceReduction() const
+    {
+        return standardError > 0.0 ? (plainStandardError * plainStandardError) / (standardError * standardError) : 1.0;
+    }
+};
+
+/*
+ A path sink for simulatePaths() that accumulates, for every bond, the pairs
+ (int_0^T r ds, exp(-int_0^T r ds)).
+
+ The integral starts at the first step a block is given, so with
+ resumePaths() it runs from the checkpoint and prices the bonds forward from
+ the checkpoint's date; bonds maturing before it get no payoffs.
+ */
+class BondPricingSink
+{
+public:
+    /*
+     @param bondMaturities The maturities of the bonds to price.
+     */
+    explicit BondPricingSink(const std::vector<double>& bondMaturities)
+        : maturities(bondMaturities)
+    {
+    }
+
+    void beginSimulation(const std::vector<double>& simulationTimeValues, const int&, const int& numberOfThreads)
+    {
+        timeValues = simulationTimeValues;
+        int numberOfTimeSteps = static_cast<int>(timeValues.size()) - 1;
+        double timeStep = numberOfTimeSteps > 0 ? timeValues[1] - timeValues[0] : 0.0;
+
+        // Price each bond at the grid date nearest its maturity
+        bondOfStep.assign(timeValues.size(), std::vector<int>());
+        maturitySteps.resize(maturities.size());
+        for (std::size_t bond = 0; bond < maturities.size(); ++bond)
+        {
+            int step = timeStep > 0.0 ? static_cast<int>(std::lround(maturities[bond] / timeStep)) : 0;
+            maturitySteps[bond] = std::min(std::max(step, 0), numberOfTimeSteps);
+            bondOfStep[maturitySteps[bond]].push_back(static_cast<int>(bond));
+        }
+
+        threadStates.resize(static_cast<std::size_t>(numberOfThreads));
+        for (ThreadState& threadState : threadStates)
+        {
+            threadState.payoffs.assign(maturities.size(), RunningCovariance());
+            threadState.previousRates.resize(pathBlockSize);
+            threadState.discountIntegrals.resize(pathBlockSize);
+            threadState.lastStep = -1;
+        }
+    }
+
+    void observeStep(const int& threadIndex, const int& stepIndex, const int&, const double* rates, const int& numberOfPaths)
+    {
+        ThreadState& threadState = threadStates[threadIndex];
+        bool blockStart = stepIndex == 0 || stepIndex != threadState.lastStep + 1;
+        threadState.lastStep = stepIndex;
+        if (blockStart)
+        {
+            std::fill(threadState.discountIntegrals.begin(), threadState.discountIntegrals.end(), 0.0);
+        }
+        else
+        {
+            double halfStep = 0.5 * (timeValues[stepIndex] - timeValues[stepIndex - 1]);
+            for (int path = 0; path < numberOfPaths; ++path)
+            {
+                threadState.discountIntegrals[path] += halfStep * (threadState.previousRates[path] + rates[path]);
+            }
+        }
+        std::copy(rates, rates + numberOfPaths, threadState.previousRates.begin());
+
+        for (int bond : bondOfStep[stepIndex])
+        {
+            RunningCovariance& payoff = threadState.payoffs[bond];
+            for (int path = 0; path < numberOfPaths; ++path)
+            {
+                double integral = threadState.discountIntegrals[path];
+                payoff.add(integral, std::exp(-integral));
+            }
+        }
+    }
+
+    void endSimulation()
+    {
+        payoffs.assign(maturities.size(), RunningCovariance());
+        for (const ThreadState& threadState : threadStates)
+        {
+            for (std::size_t bond = 0; bond < maturities.size(); ++bond)
+            {
+                payoffs[bond].merge(threadState.payoffs[bond]);
+            }
+        }
+    }
+
+    std::vector<double> maturities;
+    std::vector<double> timeValues;
+    std::vector<int> maturitySteps;
+    std::vector<RunningCovariance> payoffs;  // x = int_0^T r ds, y = exp(-x), one per bond
+
+private:
+    struct ThreadState
+    {
+        std::vector<RunningCovariance> payoffs;
+        std::vector<double> previousRates;
+        std::vector<double> discountIntegrals;
+        int lastStep = -1;  // the step last observed, to tell where a block starts
+    };
+
+    std::vector<std::vector<int>> bondOfStep;
+    std::vector<ThreadState> threadStates;
+};
+
+/*
+ Returns E[int_0^T r ds] under the same trapezoidal rule the sink uses, from the analytic rate means.
+
+ @param model The model.
+ @param timeValues The time grid.
+ @param maturityStep The grid index of the maturity.
+ */
+template <typename Model>
+double expectedDiscountIntegral(const Model& model, const std::vector<double>& timeValues, const int& maturityStep)
+{
+    double integral = 0.0;
+    for (int i = 1; i <= maturityStep; ++i)
+    {
+        integral += 0.5 * (timeValues[i] - timeValues[i - 1]) * (analyticShortRateMean(model, timeValues[i - 1]) + analyticShortRateMean(model, timeValues[i]));
+    }
+    return integral;
+}
+
+/*
+ Turns the accumulated payoffs of one bond into an estimate.
+
+ @param payoff The accumulated pairs (int r, exp(-int r)).
+ @param maturity The maturity of the bond.
+ @param hasControl Whether the control variate is available.
+ @param controlMean The expectation of int r, when available.
+ @param analyticPrice The closed-form price, or NaN.
+ */
+inline BondPriceEstimate estimateBondPrice(
+    const RunningCovariance& payoff,
+    const double& maturity,
+    const bool& hasControl,
+    const double& controlMean,
+    const double& analyticPrice)
+{
+    BondPriceEstimate estimate;
+    estimate.maturity = maturity;
+    estimate.analyticPrice = analyticPrice;
+    estimate.plainPrice = payoff.meanY;
+    estimate.plainStandardError = payoff.count > 0.0 ? std::sqrt(payoff.varianceY() / payoff.count) : 0.0;
+    estimate.price = estimate.plainPrice;
+    estimate.standardError = estimate.plainStandardError;
+
+    double controlVariance = payoff.varianceX();
+    if (hasControl && controlVariance > 0.0)
+    {
+        estimate.controlCoefficient = payoff.covariance() / controlVariance;
+        estimate.price = payoff.meanY - estimate.controlCoefficient * (payoff.meanX - controlMean);
+        double residualVariance = std::max(0.0, payoff.varianceY() - estimate.controlCoefficient * payoff.covariance());
+        estimate.standardError = std::sqrt(residualVariance / payoff.count);
+    }
+    return estimate;
+}
+
+/*
+ Prices zero-coupon bonds for a set of maturities in one pass over the paths.
+
+ For models with closed forms the estimates use the control variate and
+ report the analytic price; for the others they are plain Monte Carlo.
+ Maturities are rounded to the nearest step of the grid.
+
+ @param model The short-rate model to simulate.
+ @param maturities The maturities of the bonds.
+ @param timeStep The time step of the simulation.
+ @param numberOfPaths The number of paths to simulate.
+ @param seed The seed of the random number streams.
+ @param threadPool The threads that simulate the path blocks.
+ @return One estimate per maturity, in the order given.
+ */
+template <typename Model>
+std::vector<BondPriceEstimate> priceZeroCouponBonds(
+    const Model& model,
+    const std::vector<double>& maturities,
+    const double& timeStep,
+    const int& numberOfPaths,
+    const std::uint64_t& seed,
+    ThreadPool& threadPool = defaultThreadPool())
+{
+    double timeHorizon = maturities.empty() ? 0.0 : *std::max_element(maturities.begin(), maturities.end());
+    BondPricingSink sink(maturities);
+
+    // Extend the horizon by half a step so that the last maturity is on the grid
+    simulatePaths(model, timeHorizon + 0.5 * timeStep, timeStep, numberOfPaths, seed, sink, threadPool);
+
+    std::vector<BondPriceEstimate> estimates;
+    for (std::size_t bond = 0; bond < maturities.size(); ++bond)
+    {
+        int maturityStep = sink.maturitySteps[bond];
+        double maturity = sink.timeValues[maturityStep];
+        double controlMean = 0.0;
+        double analyticPrice = std::numeric_limits<double>::quiet_NaN();
+        bool hasControl = false;
+        if constexpr (HasAnalyticBondPrice<Model>::value)
+        {
+            controlMean = expectedDiscountIntegral(model, sink.timeValues, maturityStep);
+            analyticPrice = analyticBondPrice(model, maturity);
+            hasControl = true;
+        }
+        estimates.push_back(estimateBondPrice(sink.payoffs[bond], maturity, hasControl, controlMean, analyticPrice));
+    }
+    return estimates;
+}
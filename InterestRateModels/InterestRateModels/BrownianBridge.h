@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/*
+ Brownian-bridge construction of the increments of a path on an evenly spaced grid.
+
+ The first normal fixes the end point of the Brownian motion, the second the
+ midpoint given both ends, and so on, each new point bisecting the largest
+ gap left between points already built. The leading normals therefore
+ decide the large-scale shape of the path and the later ones only its fine
+ detail, which is what lets low-discrepancy points, whose leading dimensions
+ are the best distributed, pay off on long paths.
+
+ The grid is taken in units of the step length, so the increments come out
+ as standard normals just like those of an independent draw per step.
+ */
+class BrownianBridge
+{
+public:
+    BrownianBridge() = default;
+
+    /*
+     @param stepCount The number of steps of the path.
+     */
+    explicit BrownianBridge(const int& stepCount)
+        : numberOfSteps(stepCount)
+    {
+        std::size_t size = static_cast<std::size_t>(stepCount);
+        pointOfStep.assign(size, 0);
+        leftPoint.assign(size, 0);
+        rightPoint.assign(size, 0);
+        leftWeight.assign(size, 0.0);
+        rightWeight.assign(size, 0.0);
+        standardDeviation.assign(size, 0.0);
+        if (stepCount == 0)
+        {
+            return;
+        }
+
+        // Points are the times 1..numberOfSteps; built[p] marks point p + 1 as constructed
+        std::vector<bool> built(size, false);
+        pointOfStep[0] = stepCount - 1;
+        standardDeviation[0] = std::sqrt(static_cast<double>(stepCount));
+        built[size - 1] = true;
+
+        int gapStart = 0;
+        for (int step = 1; step < stepCount; ++step)
+        {
+            // Find the next gap of unbuilt points, wrapping round once a pass over the path is done
+            while (built[gapStart])
+            {
+                ++gapStart;
+            }
+            int gapEnd = gapStart;
+            while (!built[gapEnd])
+            {
+                ++gapEnd;
+            }
+
+            // Bisect the gap between the built points gapStart - 1 (or time zero) and gapEnd
+            int point = gapStart + (gapEnd - 1 - gapStart) / 2;
+            double leftTime = static_cast<double>(gapStart);
+            double pointTime = static_cast<double>(point + 1);
+            double rightTime = static_cast<double>(gapEnd + 1);
+            pointOfStep[step] = point;
+            leftPoint[step] = gapStart - 1;
+            rightPoint[step] = gapEnd;
+            leftWeight[step] = (rightTime - pointTime) / (rightTime - leftTime);
+            rightWeight[step] = (pointTime - leftTime) / (rightTime - leftTime);
+            standardDeviation[step] = std::sqrt((pointTime - leftTime) * (rightTime - pointTime) / (rightTime - leftTime));
+            built[point] = true;
+
+            gapStart = gapEnd + 1;
+            if (gapStart >= stepCount)
+            {
+                gapStart = 0;
+            }
+        }
+    }
+
+    int steps() const
+    {
+        return numberOfSteps;
+    }
+
+    /*
+     Returns the grid point fixed by the normal at the given position of the construction.
+
+     @param constructionStep The position of the normal, 0 for the most important one.
+     @return The index of the point, 0 for the end of the first step.
+     */
+    int pointOf(const int& constructionStep) const
+    {
+        return pointOfStep[constructionStep];
+    }
+
+    /*
+     Turns rows of normals into rows of increments, in place, for a block of paths.
+
+     On entry row p holds the normals of the construction step that fixes
+     point p, as given by pointOf(); on exit it holds the increments of time
+     step p + 1.
+
+     @param rows The numberOfSteps rows, one value per path.
+     @param rowStride The distance between consecutive rows.
+     @param numberOfPaths The number of paths in each row.
+     */
+    void buildIncrements(double* rows, const std::size_t& rowStride, const int& numberOfPaths) const
+    {
+        if (numberOfSteps == 0)
+        {
+            return;
+        }
+
+        // Build the Brownian motion at every point in construction order
+        double* endRow = rows + static_cast<std::size_t>(numberOfSteps - 1) * rowStride;
+        for (int path = 0; path < numberOfPaths; ++path)
+        {
+            endRow[path] *= standardDeviation[0];
+        }
+        for (int step = 1; step < numberOfSteps; ++step)
+        {
+            double* pointRow = rows + static_cast<std::size_t>(pointOfStep[step]) * rowStride;
+            const double* rightRow = rows + static_cast<std::size_t>(rightPoint[step]) * rowStride;
+            double pointWeight = rightWeight[step];
+            double pointDeviation = standardDeviation[step];
+            if (leftPoint[step] >= 0)
+            {
+                const double* leftRow = rows + static_cast<std::size_t>(leftPoint[step]) * rowStride;
+                double pointLeftWeight = leftWeight[step];
+                for (int path = 0; path < numberOfPaths; ++path)
+                {
+                    pointRow[path] = pointLeftWeight * leftRow[path] + pointWeight * rightRow[path] + pointDeviation * pointRow[path];
+                }
+            }
+            else
+            {
+                for (int path = 0; path < numberOfPaths; ++path)
+                {
+                    pointRow[path] = pointWeight * rightRow[path] + pointDeviation * pointRow[path];
+                }
+            }
+        }
+
+        // Difference the path into increments, last step first so each row still sees its predecessor
+        for (int point = numberOfSteps - 1; point > 0; --point)
+        {
+            double* pointRow = rows + static_cast<std::size_t>(point) * rowStride;
+            const double* previousRow = pointRow - rowStride;
+            for (int path = 0; path < numberOfPaths; ++path)
+            {
+                pointRow[path] -= previousRow[path];
+            }
+        }
+    }
+
+private:
+    int numberOfSteps = 0;
+    std::vector<int> pointOfStep;        // Point fixed by each construction step
+    std::vector<int> leftPoint;          // Built point to its left, -1 for time zero
+    std::vector<int> rightPoint;         // Built point to its right
+    std::vector<double> leftWeight;      // Weight of the left point in the conditional mean
+    std::vector<double> rightWeight;     // Weight of the right point in the conditional mean
+    std::vector<double> standardDeviation;  // Conditional standard deviation of the new point
+};
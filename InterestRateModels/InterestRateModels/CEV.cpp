@@ -1,8 +1,7 @@
 #include <iostream>
-#include <cmath>
 #include <vector>
-#include <random>
-#include <fstream>
+
+#include "ShortRateSimulation.h"
 
 /*
  Simulates the Constant Elasticity of Variance (CEV) model.
@@ -14,7 +13,9 @@
  @param initialInterestRate The initial interest rate of the CEV model.
  @param timeHorizon The time horizon of the CEV model.
  @param timeStep The time step of the CEV model.
- @param outputPath The path to the output CSV file.
+ @param seed The seed of the random number streams.
+ @param outputFormat The format of the output file.
+ @param outputPath The path to the output file.
  */
 
 void simulateConstantElasticityVarianceModel(
@@ -25,48 +26,25 @@ void simulateConstantElasticityVarianceModel(
     const double& initialInterestRate,
     const double& timeHorizon,
     const double& timeStep,
+    const std::uint64_t& seed,
+    const OutputFormat& outputFormat,
     const std::string& outputPath) 
 {
-    // Set up random number generation
-    std::random_device randomDevice;
-    std::mt19937 randomGenerator(randomDevice());
-    std::normal_distribution<double> standardNormalDistribution(0.0, 1.0);
-
-    // Calculate the number of time steps
-    int numberOfTimeSteps = static_cast<int>(timeHorizon / timeStep);
-
-    // Initialize vectors to store time and interest rate values
-    std::vector<double> timeValues(numberOfTimeSteps + 1);
-    std::vector<double> interestRateValues(numberOfTimeSteps + 1);
-
-    // Initialize the initial interest rate
-    interestRateValues[0] = initialInterestRate;
-
-    // Simulate the CEV model
-    for (int i = 1; i <= numberOfTimeSteps; ++i) 
-    {
-        // Update time
-        timeValues[i] = i * timeStep;
-
-        // Generate a random increment
-        double randomIncrement = standardNormalDistribution(randomGenerator);
+    // Simulate a single path of the CEV model and write it out
+    ConstantElasticityVarianceModel model{ meanReversionRate, driftTerm, elasticity, volatility, initialInterestRate };
+    std::vector<ResultParameter> parameters = {
+        { "meanReversionRate", meanReversionRate },
+        { "driftTerm", driftTerm },
+        { "elasticity", elasticity },
+        { "volatility", volatility },
+        { "initialInterestRate", initialInterestRate }
+    };
 
-        // Update the interest rate using the CEV SDE
-        interestRateValues[i] = interestRateValues[i - 1] +
-            (driftTerm * std::pow(interestRateValues[i - 1], elasticity - 1.0) +
-                meanReversionRate * interestRateValues[i - 1]) * timeStep +
-            volatility * std::pow(interestRateValues[i - 1], elasticity / 2.0) *
-            std::sqrt(timeStep) * randomIncrement;
-    }
-
-    // Output the results to a CSV file
-    std::ofstream outputFile(outputPath);
-    outputFile << "Time,InterestRate\n";
-    for (int i = 0; i <= numberOfTimeSteps; ++i) 
+    // Common elasticities such as 0.5 run a kernel with the power compiled to products and square roots
+    withSpecializedElasticity(model, [&](const auto& specializedModel)
     {
-        outputFile << timeValues[i] << "," << interestRateValues[i] << "\n";
-    }
-    outputFile.close();
+        simulateShortRatePath(specializedModel, "ConstantElasticityVariance", parameters, timeHorizon, timeStep, seed, outputFormat, outputPath);
+    });
 }
 
 int main() 
@@ -79,7 +57,9 @@ int main()
     double initialInterestRate = 0.05;
     double timeHorizon = 1.0;
     double timeStep = 0.01;
-    std::string outputPath = "cev_simulation.csv";
+    std::uint64_t seed = 42;
+    OutputFormat outputFormat = defaultOutputFormat(static_cast<std::uint64_t>(timeHorizon / timeStep) + 1);
+    std::string outputPath = outputFileName("cev_simulation", outputFormat);
 
     // Simulate the CEV model
     simulateConstantElasticityVarianceModel(
@@ -90,9 +70,14 @@ int main()
         initialInterestRate,
         timeHorizon,
         timeStep,
+        seed,
+        outputFormat,
         outputPath);
 
     std::cout << "Simulation completed. Results saved to " << outputPath << std::endl;
 
+    // Write the profiling report, if built with INTEREST_RATE_MODELS_PROFILING
+    INTEREST_RATE_MODELS_PROFILE_REPORT("cev_profile.json", true);
+
     return 0;
 }
\ No newline at end of file
@@ -1,8 +1,9 @@
 #include <iostream>
-#include <cmath>
+#include <stdexcept>
 #include <vector>
-#include <random>
-#include <fstream>
+
+#include "Calibration.h"
+#include "ShortRateSimulation.h"
 
 /*
  Simulates the Cox-Ingersoll-Ross (CIR) model.
@@ -13,7 +14,9 @@
  @param initialInterestRate The initial interest rate of the CIR model.
  @param timeHorizon The time horizon of the CIR model.
  @param timeStep The time step of the CIR model.
- @param outputPath The path to the output CSV file.
+ @param seed The seed of the random number streams.
+ @param outputFormat The format of the output file.
+ @param outputPath The path to the output file.
  */
 void simulateCoxIngersollRossModel(
     const double& meanReversionLevel,
@@ -22,50 +25,22 @@ void simulateCoxIngersollRossModel(
     const double& initialInterestRate,
     const double& timeHorizon,
     const double& timeStep,
+    const std::uint64_t& seed,
+    const OutputFormat& outputFormat,
     const std::string& outputPath) 
 {
-    // Set up random number generation
-    std::random_device randomDevice;
-    std::mt19937 randomGenerator(randomDevice());
-    std::normal_distribution<double> standardNormalDistribution(0.0, 1.0);
-
-    // Calculate the number of time steps
-    int numberOfTimeSteps = static_cast<int>(timeHorizon / timeStep);
-
-    // Initialize vectors to store time and interest rate values
-    std::vector<double> timeValues(numberOfTimeSteps + 1);
-    std::vector<double> interestRateValues(numberOfTimeSteps + 1);
-
-    // Initialize the initial interest rate
-    interestRateValues[0] = initialInterestRate;
-
-    // Simulate the CIR model
-    for (int i = 1; i <= numberOfTimeSteps; ++i) 
-    {
-        // Update time
-        timeValues[i] = i * timeStep;
-
-        // Generate a random increment
-        double randomIncrement = standardNormalDistribution(randomGenerator);
-
-        // Update the interest rate using the CIR SDE
-        interestRateValues[i] = std::max(0.0, interestRateValues[i - 1] +
-            meanReversionRate * (meanReversionLevel - interestRateValues[i - 1]) * timeStep +
-            volatility * std::sqrt(std::max(0.0, interestRateValues[i - 1])) *
-            std::sqrt(timeStep) * randomIncrement);
-    }
-
-    // Output the results to a CSV file
-    std::ofstream outputFile(outputPath);
-    outputFile << "Time,InterestRate\n";
-    for (int i = 0; i <= numberOfTimeSteps; ++i) 
-    {
-        outputFile << timeValues[i] << "," << interestRateValues[i] << "\n";
-    }
-    outputFile.close();
+    // Simulate a single path of the CIR model and write it out
+    CoxIngersollRossModel model{ meanReversionLevel, meanReversionRate, volatility, initialInterestRate };
+    std::vector<ResultParameter> parameters = {
+        { "meanReversionLevel", meanReversionLevel },
+        { "meanReversionRate", meanReversionRate },
+        { "volatility", volatility },
+        { "initialInterestRate", initialInterestRate }
+    };
+    simulateShortRatePath(model, "CoxIngersollRoss", parameters, timeHorizon, timeStep, seed, outputFormat, outputPath);
 }
 
-int main() 
+int main(int argc, char* argv[]) 
 {
     // Parameters for the CIR model
     double meanReversionLevel = 0.1;
@@ -74,7 +49,31 @@ int main()
     double initialInterestRate = 0.05;
     double timeHorizon = 1.0;
     double timeStep = 0.01;
-    std::string outputPath = "cir_simulation.csv";
+    std::uint64_t seed = 42;
+    OutputFormat outputFormat = defaultOutputFormat(static_cast<std::uint64_t>(timeHorizon / timeStep) + 1);
+    std::string outputPath = outputFileName("cir_simulation", outputFormat);
+
+    // Calibrate to a rate series instead, if one is given with its observation interval in years;
+    // a bad argument or series exits with status 1
+    if (argc > 1)
+    {
+        try
+        {
+            double observationInterval = argc > 2 ? std::stod(argv[2]) : 1.0 / 252.0;
+            CalibrationResult<CoxIngersollRossModel> calibration = calibrateCoxIngersollRossModel(readRateSeries(argv[1]), observationInterval);
+            meanReversionLevel = calibration.model.meanReversionLevel;
+            meanReversionRate = calibration.model.meanReversionRate;
+            volatility = calibration.model.volatility;
+            initialInterestRate = calibration.model.initialInterestRate;
+            std::cout << "Calibrated to " << calibration.numberOfTransitions << " transitions of " << argv[1] << ": meanReversionLevel "
+                << meanReversionLevel << ", meanReversionRate " << meanReversionRate << ", volatility " << volatility << std::endl;
+        }
+        catch (const std::exception& error)
+        {
+            std::cerr << "Calibration failed: " << error.what() << std::endl;
+            return 1;
+        }
+    }
 
     // Simulate the CIR model
     simulateCoxIngersollRossModel(
@@ -84,9 +83,14 @@ int main()
         initialInterestRate,
         timeHorizon,
         timeStep,
+        seed,
+        outputFormat,
         outputPath);
 
     std::cout << "Simulation completed. Results saved to " << outputPath << std::endl;
 
+    // Write the profiling report, if built with INTEREST_RATE_MODELS_PROFILING
+    INTEREST_RATE_MODELS_PROFILE_REPORT("cir_profile.json", true);
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,796 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ResultFile.h"
+#include "ShortRateModels.h"
+#include "SimdMath.h"
+#include "ThreadPool.h"
+
+/*
+ Maximum-likelihood calibration of the Vasicek, CIR and CKLS models to a
+ series of rates observed at a fixed interval h.
+
+ All three likelihoods are Gaussian in the rate change y = r' - r:
+
+     y ~ N(c0 + c1 r, s^2 |r|^(2 e))
+
+ Vasicek uses its exact transition, which is of this form with e = 0. CIR
+ (e = 1/2) and CKLS use the Euler transition, which is accurate for daily
+ or weekly observations. For a fixed elasticity e the score equations of
+ c0, c1 and s^2 are a weighted least-squares problem with weights |r|^(-2 e),
+ so they are solved in closed form from a handful of weighted sums of r and
+ y. Only the CKLS elasticity is searched for, by finding the root of the
+ analytic derivative of the profile log-likelihood, which the same pass over
+ the series provides.
+
+ Each pass splits the series into fixed blocks that are summed in parallel,
+ with AVX2 or AVX-512 kernels for the powers, and adds the block sums in
+ order, so the result does not depend on the number of threads.
+ */
+
+// Number of transitions summed by one task
+constexpr std::size_t transitionBlockSize = 1 << 16;
+
+/*
+ Weighted sums of the rate r and rate change y over a set of transitions.
+ */
+struct RegressionMoments
+{
+    double weight = 0.0;
+    double rate = 0.0;
+    double rateSquared = 0.0;
+    double change = 0.0;
+    double rateChange = 0.0;
+    double changeSquared = 0.0;
+
+    void add(const RegressionMoments& other)
+    {
+        weight += other.weight;
+        rate += other.rate;
+        rateSquared += other.rateSquared;
+        change += other.change;
+        rateChange += other.rateChange;
+        changeSquared += other.changeSquared;
+    }
+};
+
+/*
+ Everything one likelihood pass needs from the series.
+
+ moments holds the sums weighted by w = |r|^(-2 e), and logMoments the same
+ sums weighted by w log|r|, which give the derivative with respect to e.
+ */
+struct TransitionSums
+{
+    RegressionMoments moments;
+    RegressionMoments logMoments;
+    double logAbsoluteRate = 0.0;
+    double smallestRate = DBL_MAX;
+    double smallestAbsoluteRate = DBL_MAX;
+
+    void add(const TransitionSums& other)
+    {
+        moments.add(other.moments);
+        logMoments.add(other.logMoments);
+        logAbsoluteRate += other.logAbsoluteRate;
+        smallestRate = std::min(smallestRate, other.smallestRate);
+        smallestAbsoluteRate = std::min(smallestAbsoluteRate, other.smallestAbsoluteRate);
+    }
+};
+
+/*
+ Adds transitions to the sums one at a time.
+
+ @param rates The rates, one more than the number of transitions.
+ @param numberOfTransitions The number of transitions to add.
+ @param elasticity The elasticity e of the weights. Unused unless Weighted.
+ @param sums Receives the sums.
+ */
+template <bool Weighted>
+inline void accumulateTransitionSumsScalar(const double* rates, const std::size_t& numberOfTransitions, const double& elasticity, TransitionSums& sums)
+{
+    for (std::size_t i = 0; i < numberOfTransitions; ++i)
+    {
+        double rate = rates[i];
+        double change = rates[i + 1] - rate;
+        double weight = 1.0;
+        double logAbsoluteRate = 0.0;
+        if constexpr (Weighted)
+        {
+            double absoluteRate = std::abs(rate);
+            sums.smallestRate = std::min(sums.smallestRate, rate);
+            sums.smallestAbsoluteRate = std::min(sums.smallestAbsoluteRate, absoluteRate);
+            logAbsoluteRate = std::log(absoluteRate);
+            weight = std::exp(-2.0 * elasticity * logAbsoluteRate);
+        }
+        double weightedRate = weight * rate;
+        double weightedChange = weight * change;
+        sums.moments.weight += weight;
+        sums.moments.rate += weightedRate;
+        sums.moments.rateSquared += weightedRate * rate;
+        sums.moments.change += weightedChange;
+        sums.moments.rateChange += weightedRate * change;
+        sums.moments.changeSquared += weightedChange * change;
+        if constexpr (Weighted)
+        {
+            sums.logMoments.weight += logAbsoluteRate * weight;
+            sums.logMoments.rate += logAbsoluteRate * weightedRate;
+            sums.logMoments.rateSquared += logAbsoluteRate * weightedRate * rate;
+            sums.logMoments.change += logAbsoluteRate * weightedChange;
+            sums.logMoments.rateChange += logAbsoluteRate * weightedRate * change;
+            sums.logMoments.changeSquared += logAbsoluteRate * weightedChange * change;
+            sums.logAbsoluteRate += logAbsoluteRate;
+        }
+    }
+}
+
+#if defined(INTEREST_RATE_MODELS_X86_SIMD)
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+INTEREST_RATE_MODELS_TARGET_AVX2 inline double horizontalSumAvx2(__m256d x)
+{
+    __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(x), _mm256_extractf128_pd(x, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+}
+
+INTEREST_RATE_MODELS_TARGET_AVX2 inline double horizontalMinimumAvx2(__m256d x)
+{
+    __m128d pair = _mm_min_pd(_mm256_castpd256_pd128(x), _mm256_extractf128_pd(x, 1));
+    return _mm_cvtsd_f64(_mm_min_sd(pair, _mm_unpackhi_pd(pair, pair)));
+}
+
+/*
+ Adds transitions to the sums four at a time and returns how many it added.
+ Groups with a rate outside the range of the vector log and exp are added by
+ the scalar loop.
+ */
+template <bool Weighted>
+INTEREST_RATE_MODELS_TARGET_AVX2 inline std::size_t accumulateTransitionSumsAvx2(
+    const double* rates,
+    const std::size_t& numberOfTransitions,
+    const double& elasticity,
+    TransitionSums& sums)
+{
+    __m256d weightExponent = _mm256_set1_pd(-2.0 * elasticity);
+    __m256d signBit = _mm256_set1_pd(-0.0);
+    __m256d weight = _mm256_set1_pd(1.0);
+    __m256d logAbsoluteRate = _mm256_setzero_pd();
+    __m256d smallestRate = _mm256_set1_pd(DBL_MAX);
+    __m256d smallestAbsoluteRate = _mm256_set1_pd(DBL_MAX);
+    __m256d weightSum = _mm256_setzero_pd();
+    __m256d rateSum = _mm256_setzero_pd();
+    __m256d rateSquaredSum = _mm256_setzero_pd();
+    __m256d changeSum = _mm256_setzero_pd();
+    __m256d rateChangeSum = _mm256_setzero_pd();
+    __m256d changeSquaredSum = _mm256_setzero_pd();
+    __m256d logWeightSum = _mm256_setzero_pd();
+    __m256d logRateSum = _mm256_setzero_pd();
+    __m256d logRateSquaredSum = _mm256_setzero_pd();
+    __m256d logChangeSum = _mm256_setzero_pd();
+    __m256d logRateChangeSum = _mm256_setzero_pd();
+    __m256d logChangeSquaredSum = _mm256_setzero_pd();
+    __m256d logAbsoluteRateSum = _mm256_setzero_pd();
+
+    std::size_t i = 0;
+    for (; i + 4 <= numberOfTransitions; i += 4)
+    {
+        __m256d rate = _mm256_loadu_pd(rates + i);
+        __m256d change = _mm256_sub_pd(_mm256_loadu_pd(rates + i + 1), rate);
+        if constexpr (Weighted)
+        {
+            __m256d absoluteRate = _mm256_andnot_pd(signBit, rate);
+            logAbsoluteRate = logAvx2(absoluteRate);
+            __m256d exponent = _mm256_mul_pd(weightExponent, logAbsoluteRate);
+            if (_mm256_movemask_pd(_mm256_and_pd(inLogRangeAvx2(absoluteRate), inExpRangeAvx2(exponent))) != 0xF)
+            {
+                accumulateTransitionSumsScalar<true>(rates + i, 4, elasticity, sums);
+                continue;
+            }
+            weight = expAvx2(exponent);
+            smallestRate = _mm256_min_pd(smallestRate, rate);
+            smallestAbsoluteRate = _mm256_min_pd(smallestAbsoluteRate, absoluteRate);
+        }
+        __m256d weightedRate = _mm256_mul_pd(weight, rate);
+        __m256d weightedChange = _mm256_mul_pd(weight, change);
+        weightSum = _mm256_add_pd(weightSum, weight);
+        rateSum = _mm256_add_pd(rateSum, weightedRate);
+        rateSquaredSum = _mm256_fmadd_pd(weightedRate, rate, rateSquaredSum);
+        changeSum = _mm256_add_pd(changeSum, weightedChange);
+        rateChangeSum = _mm256_fmadd_pd(weightedRate, change, rateChangeSum);
+        changeSquaredSum = _mm256_fmadd_pd(weightedChange, change, changeSquaredSum);
+        if constexpr (Weighted)
+        {
+            __m256d logWeightedRate = _mm256_mul_pd(logAbsoluteRate, weightedRate);
+            __m256d logWeightedChange = _mm256_mul_pd(logAbsoluteRate, weightedChange);
+            logWeightSum = _mm256_fmadd_pd(logAbsoluteRate, weight, logWeightSum);
+            logRateSum = _mm256_add_pd(logRateSum, logWeightedRate);
+            logRateSquaredSum = _mm256_fmadd_pd(logWeightedRate, rate, logRateSquaredSum);
+            logChangeSum = _mm256_add_pd(logChangeSum, logWeightedChange);
+            logRateChangeSum = _mm256_fmadd_pd(logWeightedRate, change, logRateChangeSum);
+            logChangeSquaredSum = _mm256_fmadd_pd(logWeightedChange, change, logChangeSquaredSum);
+            logAbsoluteRateSum = _mm256_add_pd(logAbsoluteRateSum, logAbsoluteRate);
+        }
+    }
+
+    sums.moments.weight += horizontalSumAvx2(weightSum);
+    sums.moments.rate += horizontalSumAvx2(rateSum);
+    sums.moments.rateSquared += horizontalSumAvx2(rateSquaredSum);
+    sums.moments.change += horizontalSumAvx2(changeSum);
+    sums.moments.rateChange += horizontalSumAvx2(rateChangeSum);
+    sums.moments.changeSquared += horizontalSumAvx2(changeSquaredSum);
+    if constexpr (Weighted)
+    {
+        sums.logMoments.weight += horizontalSumAvx2(logWeightSum);
+        sums.logMoments.rate += horizontalSumAvx2(logRateSum);
+        sums.logMoments.rateSquared += horizontalSumAvx2(logRateSquaredSum);
+        sums.logMoments.change += horizontalSumAvx2(logChangeSum);
+        sums.logMoments.rateChange += horizontalSumAvx2(logRateChangeSum);
+        sums.logMoments.changeSquared += horizontalSumAvx2(logChangeSquaredSum);
+        sums.logAbsoluteRate += horizontalSumAvx2(logAbsoluteRateSum);
+        sums.smallestRate = std::min(sums.smallestRate, horizontalMinimumAvx2(smallestRate));
+        sums.smallestAbsoluteRate = std::min(sums.smallestAbsoluteRate, horizontalMinimumAvx2(smallestAbsoluteRate));
+    }
+    return i;
+}
+
+INTEREST_RATE_MODELS_TARGET_AVX512 inline double horizontalSumAvx512(__m512d x)
+{
+    alignas(64) double lanes[8];
+    _mm512_store_pd(lanes, x);
+    return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+}
+
+INTEREST_RATE_MODELS_TARGET_AVX512 inline double horizontalMinimumAvx512(__m512d x)
+{
+    alignas(64) double lanes[8];
+    _mm512_store_pd(lanes, x);
+    return *std::min_element(lanes, lanes + 8);
+}
+
+/*
+ Adds transitions to the sums eight at a time and returns how many it added.
+ */
+template <bool Weighted>
+INTEREST_RATE_MODELS_TARGET_AVX512 inline std::size_t accumulateTransitionSumsAvx512(
+    const double* rates,
+    const std::size_t& numberOfTransitions,
+    const double& elasticity,
+    TransitionSums& sums)
+{
+    __m512d weightExponent = _mm512_set1_pd(-2.0 * elasticity);
+    __m512d weight = _mm512_set1_pd(1.0);
+    __m512d logAbsoluteRate = _mm512_setzero_pd();
+    __m512d smallestRate = _mm512_set1_pd(DBL_MAX);
+    __m512d smallestAbsoluteRate = _mm512_set1_pd(DBL_MAX);
+    __m512d weightSum = _mm512_setzero_pd();
+    __m512d rateSum = _mm512_setzero_pd();
+    __m512d rateSquaredSum = _mm512_setzero_pd();
+    __m512d changeSum = _mm512_setzero_pd();
+    __m512d rateChangeSum = _mm512_setzero_pd();
+    __m512d changeSquaredSum = _mm512_setzero_pd();
+    __m512d logWeightSum = _mm512_setzero_pd();
+    __m512d logRateSum = _mm512_setzero_pd();
+    __m512d logRateSquaredSum = _mm512_setzero_pd();
+    __m512d logChangeSum = _mm512_setzero_pd();
+    __m512d logRateChangeSum = _mm512_setzero_pd();
+    __m512d logChangeSquaredSum = _mm512_setzero_pd();
+    __m512d logAbsoluteRateSum = _mm512_setzero_pd();
+
+    std::size_t i = 0;
+    for (; i + 8 <= numberOfTransitions; i += 8)
+    {
+        __m512d rate = _mm512_loadu_pd(rates + i);
+        __m512d change = _mm512_sub_pd(_mm512_loadu_pd(rates + i + 1), rate);
+        if constexpr (Weighted)
+        {
+            __m512d absoluteRate = _mm512_abs_pd(rate);
+            logAbsoluteRate = logAvx512(absoluteRate);
+            __m512d exponent = _mm512_mul_pd(weightExponent, logAbsoluteRate);
+            if ((inLogRangeAvx512(absoluteRate) & inExpRangeAvx512(exponent)) != 0xFF)
+            {
+                accumulateTransitionSumsScalar<true>(rates + i, 8, elasticity, sums);
+                continue;
+            }
+            weight = expAvx512(exponent);
+            smallestRate = _mm512_min_pd(smallestRate, rate);
+            smallestAbsoluteRate = _mm512_min_pd(smallestAbsoluteRate, absoluteRate);
+        }
+        __m512d weightedRate = _mm512_mul_pd(weight, rate);
+        __m512d weightedChange = _mm512_mul_pd(weight, change);
+        weightSum = _mm512_add_pd(weightSum, weight);
+        rateSum = _mm512_add_pd(rateSum, weightedRate);
+        rateSquaredSum = _mm512_fmadd_pd(weightedRate, rate, rateSquaredSum);
+        changeSum = _mm512_add_pd(changeSum, weightedChange);
+        rateChangeSum = _mm512_fmadd_pd(weightedRate, change, rateChangeSum);
+        changeSquaredSum = _mm512_fmadd_pd(weightedChange, change, changeSquaredSum);
+        if constexpr (Weighted)
+        {
+            __m512d logWeightedRate = _mm512_mul_pd(logAbsoluteRate, weightedRate);
+            __m512d logWeightedChange = _mm512_mul_pd(logAbsoluteRate, weightedChange);
+            logWeightSum = _mm512_fmadd_pd(logAbsoluteRate, weight, logWeightSum);
+            logRateSum = _mm512_add_pd(logRateSum, logWeightedRate);
+            logRateSquaredSum = _mm512_fmadd_pd(logWeightedRate, rate, logRateSquaredSum);
+            logChangeSum = _mm512_add_pd(logChangeSum, logWeightedChange);
+            logRateChangeSum = _mm512_fmadd_pd(logWeightedRate, change, logRateChangeSum);
+            logChangeSquaredSum = _mm512_fmadd_pd(logWeightedChange, change, logChangeSquaredSum);
+            logAbsoluteRateSum = _mm512_add_pd(logAbsoluteRateSum, logAbsoluteRate);
+        }
+    }
+
+    sums.moments.weight += horizontalSumAvx512(weightSum);
+    sums.moments.rate += horizontalSumAvx512(rateSum);
+    sums.moments.rateSquared += horizontalSumAvx512(rateSquaredSum);
+    sums.moments.change += horizontalSumAvx512(changeSum);
+    sums.moments.rateChange += horizontalSumAvx512(rateChangeSum);
+    sums.moments.changeSquared += horizontalSumAvx512(changeSquaredSum);
+    if constexpr (Weighted)
+    {
+        sums.logMoments.weight += horizontalSumAvx512(logWeightSum);
+        sums.logMoments.rate += horizontalSumAvx512(logRateSum);
+        sums.logMoments.rateSquared += horizontalSumAvx512(logRateSquaredSum);
+        sums.logMoments.change += horizontalSumAvx512(logChangeSum);
+        sums.logMoments.rateChange += horizontalSumAvx512(logRateChangeSum);
+        sums.logMoments.changeSquared += horizontalSumAvx512(logChangeSquaredSum);
+        sums.logAbsoluteRate += horizontalSumAvx512(logAbsoluteRateSum);
+        sums.smallestRate = std::min(sums.smallestRate, horizontalMinimumAvx512(smallestRate));
+        sums.smallestAbsoluteRate = std::min(sums.smallestAbsoluteRate, horizontalMinimumAvx512(smallestAbsoluteRate));
+    }
+    return i;
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+/*
+ Sums every transition of a series in one parallel pass.
+
+ @param rates The rate series.
+ @param elasticity The elasticity e of the weights |r|^(-2 e). Unused unless Weighted.
+ @param threadPool The thread pool that sums the blocks.
+ */
+template <bool Weighted>
+inline TransitionSums sumTransitions(const std::vector<double>& rates, const double& elasticity, ThreadPool& threadPool)
+{
+    INTEREST_RATE_MODELS_PROFILE_SCOPE("likelihoodPass");
+    std::size_t numberOfTransitions = rates.size() - 1;
+    int numberOfBlocks = static_cast<int>((numberOfTransitions + transitionBlockSize - 1) / transitionBlockSize);
+    std::vector<TransitionSums> blockSums(static_cast<std::size_t>(numberOfBlocks));
+    SimdLevel simdLevel = activeSimdLevel();
+
+    auto sumBlock = [&](int blockIndex, int)
+    {
+        std::size_t firstTransition = static_cast<std::size_t>(blockIndex) * transitionBlockSize;
+        std::size_t blockTransitions = std::min(transitionBlockSize, numberOfTransitions - firstTransition);
+        const double* blockRates = rates.data() + firstTransition;
+        TransitionSums& sums = blockSums[static_cast<std::size_t>(blockIndex)];
+        std::size_t transition = 0;
+
+#if defined(INTEREST_RATE_MODELS_X86_SIMD)
+        if (simdLevel == SimdLevel::Avx512)
+        {
+            transition = accumulateTransitionSumsAvx512<Weighted>(blockRates, blockTransitions, elasticity, sums);
+        }
+        else if (simdLevel == SimdLevel::Avx2)
+        {
+            transition = accumulateTransitionSumsAvx2<Weighted>(blockRates, blockTransitions, elasticity, sums);
+        }
+#else
+        (void)simdLevel;
+#endif
+
+        // Finish the block with the scalar loop
+        accumulateTransitionSumsScalar<Weighted>(blockRates + transition, blockTransitions - transition, elasticity, sums);
+    };
+    threadPool.parallelFor(numberOfBlocks, sumBlock);
+
+    // Add the blocks in order so the total does not depend on the threads
+    TransitionSums totalSums;
+    for (const TransitionSums& sums : blockSums)
+    {
+        totalSums.add(sums);
+    }
+    return totalSums;
+}
+
+/*
+ The maximum of the Gaussian likelihood y ~ N(c0 + c1 r, s^2 |r|^(2 e)) for a fixed elasticity e.
+ */
+struct WeightedRegression
+{
+    double intercept = 0.0;
+    double slope = 0.0;
+    double residualVariance = 0.0;
+    double logLikelihood = 0.0;
+
+    // Derivative of the profile log-likelihood with respect to e
+    double elasticityScore = 0.0;
+};
+
+/*
+ Solves the score equations of c0, c1 and s^2 from the sums of a pass.
+
+ @param sums The sums of the pass.
+ @param numberOfTransitions The number of transitions in the series.
+ @param elasticity The elasticity e the sums were weighted with.
+ */
+inline WeightedRegression solveWeightedRegression(const TransitionSums& sums, const std::size_t& numberOfTransitions, const double& elasticity)
+{
+    const RegressionMoments& moments = sums.moments;
+    double count = static_cast<double>(numberOfTransitions);
+    double determinant = moments.weight * moments.rateSquared - moments.rate * moments.rate;
+    if (!(determinant > 0.0))
+    {
+        throw std::runtime_error("The rate series is constant, so the drift cannot be identified");
+    }
+
+    WeightedRegression regression;
+    regression.slope = (moments.weight * moments.rateChange - moments.rate * moments.change) / determinant;
+    regression.intercept = (moments.change - regression.slope * moments.rate) / moments.weight;
+    double residualSquares = moments.changeSquared - regression.intercept * moments.change - regression.slope * moments.rateChange;
+    if (!(residualSquares > 0.0))
+    {
+        throw std::runtime_error("The rate series has no noise around its drift");
+    }
+    regression.residualVariance = residualSquares / count;
+
+    // At the maximum the weighted squared residuals add up to half the count
+    const double logTwoPi = 1.83787706640934548356;
+    regression.logLikelihood = -0.5 * count * (logTwoPi + std::log(regression.residualVariance) + 1.0) - elasticity * sums.logAbsoluteRate;
+
+    // The partial derivative in e is the profile derivative, since the other scores vanish
+    const RegressionMoments& logMoments = sums.logMoments;
+    double intercept = regression.intercept;
+    double slope = regression.slope;
+    double logResidualSquares = logMoments.changeSquared - 2.0 * intercept * logMoments.change - 2.0 * slope * logMoments.rateChange
+        + intercept * intercept * logMoments.weight + 2.0 * intercept * slope * logMoments.rate + slope * slope * logMoments.rateSquared;
+    regression.elasticityScore = logResidualSquares / regression.residualVariance - sums.logAbsoluteRate;
+    return regression;
+}
+
+/*
+ A calibrated model and the fit of its likelihood.
+
+ logLikelihood is the log density of the observed rate changes, so it can be
+ compared across models fitted to the same series.
+ */
+template <typename Model>
+struct CalibrationResult
+{
+    Model model;
+    double logLikelihood = 0.0;
+    std::size_t numberOfTransitions = 0;
+    int likelihoodPasses = 0;
+};
+
+// Rejects series and observation intervals that cannot be calibrated to
+inline void checkCalibrationInput(const std::vector<double>& rates, const double& timeStep)
+{
+    if (rates.size() < 3)
+    {
+        throw std::runtime_error("Calibration needs at least three observations");
+    }
+    if (!(timeStep > 0.0))
+    {
+        throw std::runtime_error("The observation interval must be positive");
+    }
+}
+
+// Rejects sums that contain non-finite rates
+inline void checkTransitionSums(const TransitionSums& sums)
+{
+    if (!std::isfinite(sums.moments.changeSquared) || !std::isfinite(sums.logMoments.changeSquared) || !std::isfinite(sums.logAbsoluteRate))
+    {
+        throw std::runtime_error("The rate series contains values that are not finite");
+    }
+}
+
+/*
+ Calibrates the Vasicek model with its exact transition density.
+
+ The exact transition is r' = theta + (r - theta) exp(-kappa h) plus Gaussian
+ noise, a linear regression, so the maximum is found in a single pass.
+
+ @param rates The rate series, oldest first. The last rate becomes the initial interest rate.
+ @param timeStep The interval between observations, in years.
+ @param threadPool The thread pool that sums the series.
+ */
+inline CalibrationResult<VasicekModel> calibrateVasicekModel(
+    const std::vector<double>& rates,
+    const double& timeStep,
+    ThreadPool& threadPool = defaultThreadPool())
+{
+    INTEREST_RATE_MODELS_PROFILE_SCOPE("calibration");
+    checkCalibrationInput(rates, timeStep);
+    TransitionSums sums = sumTransitions<false>(rates, 0.0, threadPool);
+    checkTransitionSums(sums);
+    WeightedRegression regression = solveWeightedRegression(sums, rates.size() - 1, 0.0);
+
+    double decay = 1.0 + regression.slope;
+    if (!(decay > 0.0 && decay < 1.0))
+    {
+        throw std::runtime_error("The rate series shows no mean reversion");
+    }
+
+    CalibrationResult<VasicekModel> result;
+    result.model.meanReversionSpeed = -std::log(decay) / timeStep;
+    result.model.longTermInterestRate = regression.intercept / (1.0 - decay);
+    result.model.volatility = std::sqrt(regression.residualVariance * 2.0 * result.model.meanReversionSpeed / (1.0 - decay * decay));
+    result.model.initialInterestRate = rates.back();
+    result.logLikelihood = regression.logLikelihood;
+    result.numberOfTransitions = rates.size() - 1;
+    result.likelihoodPasses = 1;
+    return result;
+}
+
+/*
+ Calibrates the CIR model with its Euler transition density, which makes the
+ maximum a weighted regression with weights 1 / r found in a single pass.
+
+ @param rates The rate series, oldest first, all positive. The last rate becomes the initial interest rate.
+ @param timeStep The interval between observations, in years.
+ @param threadPool The thread pool that sums the series.
+ */
+inline CalibrationResult<CoxIngersollRossModel> calibrateCoxIngersollRossModel(
+    const std::vector<double>& rates,
+    const double& timeStep,
+    ThreadPool& threadPool = defaultThreadPool())
+{
+    INTEREST_RATE_MODELS_PROFILE_SCOPE("calibration");
+    checkCalibrationInput(rates, timeStep);
+    TransitionSums sums = sumTransitions<true>(rates, 0.5, threadPool);
+    if (!(sums.smallestRate > 0.0))
+    {
+        throw std::runtime_error("CIR calibration needs positive rates");
+    }
+    checkTransitionSums(sums);
+    WeightedRegression regression = solveWeightedRegression(sums, rates.size() - 1, 0.5);
+    if (!(regression.slope < 0.0))
+    {
+        throw std::runtime_error("The rate series shows no mean reversion");
+    }
+
+    CalibrationResult<CoxIngersollRossModel> result;
+    result.model.meanReversionRate = -regression.slope / timeStep;
+    result.model.meanReversionLevel = -regression.intercept / regression.slope;
+    result.model.volatility = std::sqrt(regression.residualVariance / timeStep);
+    result.model.initialInterestRate = rates.back();
+    result.logLikelihood = regression.logLikelihood;
+    result.numberOfTransitions = rates.size() - 1;
+    result.likelihoodPasses = 1;
+    return result;
+}
+
+/*
+ Calibrates the CKLS model with its Euler transition density.
+
+ The elasticity is the root of the derivative of the profile log-likelihood
+ in [minimumElasticity, maximumElasticity], found by the Illinois variant of
+ regula falsi; each step is one pass over the series. If the derivative does
+ not change sign the nearer bound is returned.
+
+ @param rates The rate series, oldest first, none zero. The last rate becomes the initial interest rate.
+ @param timeStep The interval between observations, in years.
+ @param minimumElasticity The smallest elasticity to consider.
+ @param maximumElasticity The largest elasticity to consider.
+ @param threadPool The thread pool that sums the series.
+ */
+inline CalibrationResult<ChanKarolyiLongstaffSandersModel> calibrateChanKarolyiLongstaffSandersModel(
+    const std::vector<double>& rates,
+    const double& timeStep,
+    const double& minimumElasticity = 0.0,
+    const double& maximumElasticity = 3.0,
+    ThreadPool& threadPool = defaultThreadPool())
+{
+    INTEREST_RATE_MODELS_PROFILE_SCOPE("calibration");
+    checkCalibrationInput(rates, timeStep);
+    if (!(minimumElasticity < maximumElasticity))
+    {
+        throw std::runtime_error("The elasticity range is empty");
+    }
+
+    std::size_t numberOfTransitions = rates.size() - 1;
+    int likelihoodPasses = 0;
+    auto fitElasticity = [&](const double& elasticity)
+    {
+        ++likelihoodPasses;
+        TransitionSums sums = sumTransitions<true>(rates, elasticity, threadPool);
+        if (!(sums.smallestAbsoluteRate > 0.0))
+        {
+            throw std::runtime_error("CKLS calibration needs non-zero rates");
+        }
+        checkTransitionSums(sums);
+        return solveWeightedRegression(sums, numberOfTransitions, elasticity);
+    };
+
+    // The score decreases through the maximum, so it is positive below it
+    double lowerElasticity = minimumElasticity;
+    double upperElasticity = maximumElasticity;
+    WeightedRegression lower = fitElasticity(lowerElasticity);
+    WeightedRegression upper = fitElasticity(upperElasticity);
+    double elasticity = lowerElasticity;
+    WeightedRegression best = lower;
+    if (upper.elasticityScore >= 0.0)
+    {
+        elasticity = upperElasticity;
+        best = upper;
+    }
+    else if (lower.elasticityScore > 0.0)
+    {
+        double lowerScore = lower.elasticityScore;
+        double upperScore = upper.elasticityScore;
+        int retainedSide = 0;
+        const double elasticityTolerance = 1e-9;
+        const int maximumPasses = 100;
+        while (upperElasticity - lowerElasticity > elasticityTolerance && likelihoodPasses < maximumPasses)
+        {
+            elasticity = (lowerElasticity * upperScore - upperElasticity * lowerScore) / (upperScore - lowerScore);
+            best = fitElasticity(elasticity);
+            if (best.elasticityScore == 0.0)
+            {
+                break;
+            }
+            if (best.elasticityScore > 0.0)
+            {
+                lowerElasticity = elasticity;
+                lowerScore = best.elasticityScore;
+
+                // Halve the score of an end that stays put twice in a row
+                if (retainedSide == 1)
+                {
+                    upperScore *= 0.5;
+                }
+                retainedSide = 1;
+            }
+            else
+            {
+                upperElasticity = elasticity;
+                upperScore = best.elasticityScore;
+                if (retainedSide == -1)
+                {
+                    lowerScore *= 0.5;
+                }
+                retainedSide = -1;
+            }
+        }
+    }
+
+    CalibrationResult<ChanKarolyiLongstaffSandersModel> result;
+    result.model.driftTerm = best.intercept / timeStep;
+    result.model.meanReversionRate = -best.slope / timeStep;
+    result.model.elasticity = elasticity;
+    result.model.volatility = std::sqrt(best.residualVariance / timeStep);
+    result.model.initialInterestRate = rates.back();
+    result.logLikelihood = best.logLikelihood;
+    result.numberOfTransitions = numberOfTransitions;
+    result.likelihoodPasses = likelihoodPasses;
+    return result;
+}
+
+/*
+ Parses the rates of a text series: one observation per line, with the rate
+ in the last comma-separated field, so both a bare column of rates and the
+ Time,InterestRate CSV files the simulators write can be read. A first line
+ that is not a number is taken as a header.
+ */
+inline std::vector<double> parseRateSeries(const char* text, const std::size_t& size, ThreadPool& threadPool)
+{
+    INTEREST_RATE_MODELS_PROFILE_SCOPE("parseRates");
+    // Each chunk parses the lines that start inside it
+    const std::size_t chunkSize = 1 << 20;
+    int numberOfChunks = static_cast<int>((size + chunkSize - 1) / chunkSize);
+    std::vector<std::vector<double>> chunkRates(static_cast<std::size_t>(numberOfChunks));
+    const char* textEnd = text + size;
+
+    auto parseChunk = [&](int chunkIndex, int)
+    {
+        const char* lineStart = text + static_cast<std::size_t>(chunkIndex) * chunkSize;
+        const char* chunkEnd = text + std::min(size, static_cast<std::size_t>(chunkIndex + 1) * chunkSize);
+        if (lineStart != text && lineStart[-1] != '\n')
+        {
+            const void* newline = std::memchr(lineStart, '\n', static_cast<std::size_t>(textEnd - lineStart));
+            lineStart = newline == nullptr ? textEnd : static_cast<const char*>(newline) + 1;
+        }
+
+        std::vector<double>& rates = chunkRates[static_cast<std::size_t>(chunkIndex)];
+        rates.reserve(chunkSize / 8);
+        while (lineStart < chunkEnd)
+        {
+            const void* newline = std::memchr(lineStart, '\n', static_cast<std::size_t>(textEnd - lineStart));
+            const char* lineEnd = newline == nullptr ? textEnd : static_cast<const char*>(newline);
+            const char* nextLine = newline == nullptr ? textEnd : lineEnd + 1;
+
+            // Trim the line and take its last field
+            while (lineEnd > lineStart && (lineEnd[-1] == '\r' || lineEnd[-1] == ' ' || lineEnd[-1] == '\t'))
+            {
+                --lineEnd;
+            }
+            const char* fieldStart = lineEnd;
+            while (fieldStart > lineStart && fieldStart[-1] != ',')
+            {
+                --fieldStart;
+            }
+            while (fieldStart < lineEnd && (*fieldStart == ' ' || *fieldStart == '\t' || *fieldStart == '+'))
+            {
+                ++fieldStart;
+            }
+
+            if (lineEnd > lineStart)
+            {
+                double rate = 0.0;
+                std::from_chars_result parsed = std::from_chars(fieldStart, lineEnd, rate);
+                if (parsed.ec == std::errc() && parsed.ptr == lineEnd)
+                {
+                    rates.push_back(rate);
+                }
+                else if (lineStart != text)
+                {
+                    throw std::runtime_error("Cannot read a rate from the line \"" + std::string(lineStart, lineEnd) + "\"");
+                }
+            }
+            lineStart = nextLine;
+        }
+    };
+    threadPool.parallelFor(numberOfChunks, parseChunk);
+
+    std::size_t numberOfRates = 0;
+    for (const std::vector<double>& rates : chunkRates)
+    {
+        numberOfRates += rates.size();
+    }
+    std::vector<double> rates;
+    rates.reserve(numberOfRates);
+    for (const std::vector<double>& chunk : chunkRates)
+    {
+        rates.insert(rates.end(), chunk.begin(), chunk.end());
+    }
+    return rates;
+}
+
+/*
+ Reads a rate series through a read-only memory mapping.
+
+ The file is either text (see parseRateSeries()) or a binary result file
+ written by a short-rate program, in which case one path of it is read.
+
+ @param path The path of the file.
+ @param pathIndex The path to read from a binary result file.
+ @param threadPool The thread pool that parses a text file.
+ */
+inline std::vector<double> readRateSeries(const std::string& path, const std::uint64_t& pathIndex = 0, ThreadPool& threadPool = defaultThreadPool())
+{
+    MappedFile mappedFile;
+    mappedFile.openForReading(path);
+    if (mappedFile.size() < sizeof(resultFileMagic) || std::memcmp(mappedFile.data(), resultFileMagic, sizeof(resultFileMagic)) != 0)
+    {
+        return parseRateSeries(reinterpret_cast<const char*>(mappedFile.data()), mappedFile.size(), threadPool);
+    }
+    mappedFile.close();
+
+    ResultFileReader reader(path);
+    if (reader.valuesPerPath() != 1 || pathIndex >= reader.numberOfPaths())
+    {
+        throw std::runtime_error(path + " has no short-rate path " + std::to_string(pathIndex));
+    }
+    std::vector<double> rates(static_cast<std::size_t>(reader.numberOfDates()));
+    for (std::uint64_t date = 0; date < reader.numberOfDates(); ++date)
+    {
+        rates[static_cast<std::size_t>(date)] = reader.value(date, pathIndex);
+    }
+    return rates;
+}
@@ -0,0 +1,382 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "NormalGenerator.h"
+#include "SimdMath.h"
+
+/*
+ Counter-based random numbers for reproducible parallel simulation.
+
+ Draws come from the Philox4x32-10 generator, a pure function that maps a
+ 128-bit counter and a 64-bit key to 128 random bits. Every path has its own
+ stream identified by (seed, path index), and the position within the
+ stream is part of the counter, so any draw can be computed directly without
+ touching shared state. A path therefore sees the same numbers whichever
+ thread simulates it and however the paths are split.
+
+ Counter layout:
+   word 0     block index within the stream
+   word 1     substream (0 for the per-step increments, other values free for auxiliary draws)
+   words 2-3  path index
+ The key is the 64-bit seed. Each block yields two uniforms with 52 random bits,
+ and each uniform becomes one normal through the inverse CDF in NormalGenerator.h.
+ */
+
+constexpr std::uint32_t philoxMultiplier0 = 0xD2511F53u;
+constexpr std::uint32_t philoxMultiplier1 = 0xCD9E8D57u;
+constexpr std::uint32_t philoxWeyl0 = 0x9E3779B9u;
+constexpr std::uint32_t philoxWeyl1 = 0xBB67AE85u;
+
+// Scale that maps a 52-bit integer to [0, 1)
+constexpr double uniformScale = 1.0 / 4503599627370496.0;
+
+/*
+ Applies the ten Philox4x32 rounds.
+
+ @param counter The 128-bit counter, overwritten with the 128 output bits.
+ @param key The 64-bit key.
+ */
+inline void philox4x32(std::uint32_t counter[4], const std::uint32_t key[2])
+{
+    std::uint32_t key0 = key[0];
+    std::uint32_t key1 = key[1];
+    for (int round = 0; round < 10; ++round)
+    {
+        std::uint64_t product0 = static_cast<std::uint64_t>(philoxMultiplier0) * counter[0];
+        std::uint64_t product1 = static_cast<std::uint64_t>(philoxMultiplier1) * counter[2];
+        std::uint32_t next0 = static_cast<std::uint32_t>(product1 >> 32) ^ counter[1] ^ key0;
+        std::uint32_t next1 = static_cast<std::uint32_t>(product1);
+        std::uint32_t next2 = static_cast<std::uint32_t>(product0 >> 32) ^ counter[3] ^ key1;
+        std::uint32_t next3 = static_cast<std::uint32_t>(product0);
+        counter[0] = next0;
+        counter[1] = next1;
+        counter[2] = next2;
+        counter[3] = next3;
+        key0 += philoxWeyl0;
+        key1 += philoxWeyl1;
+    }
+}
+
+/*
+ Computes the two uniforms of one block of a path's stream.
+
+ Both uniforms lie strictly inside (0, 1), so they are safe to pass to a log
+ or an inverse CDF.
+
+ @param seed The seed of the simulation.
+ @param pathIndex The index of the path.
+ @param substream The substream within the path.
+ @param blockIndex The block within the substream.
+ @param firstUniform Receives the first uniform.
+ @param secondUniform Receives the second uniform.
+ */
+inline void counterUniformPair(
+    const std::uint64_t& seed,
+    const std::uint64_t& pathIndex,
+    const std::uint32_t& substream,
+    const std::uint32_t& blockIndex,
+    double& firstUniform,
+    double& secondUniform)
+{
+    std::uint32_t key[2] = { static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32) };
+    std::uint32_t counter[4] = { blockIndex, substream, static_cast<std::uint32_t>(pathIndex), static_cast<std::uint32_t>(pathIndex >> 32) };
+    philox4x32(counter, key);
+
+    std::uint64_t firstBits = (static_cast<std::uint64_t>(counter[0]) << 32) | counter[1];
+    std::uint64_t secondBits = (static_cast<std::uint64_t>(counter[2]) << 32) | counter[3];
+    firstUniform = (static_cast<double>(firstBits >> 12) + 0.5) * uniformScale;
+    secondUniform = (static_cast<double>(secondBits >> 12) + 0.5) * uniformScale;
+}
+
+#if defined(INTEREST_RATE_MODELS_X86_SIMD)
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+/*
+ Vectorized counterUniformPair() over consecutive paths.
+
+ Each 64-bit lane carries one path's 32-bit counter words, so the Philox
+ multiplies map onto the widening 32 x 32 -> 64 bit vector multiply. The
+ output is bit-identical to the scalar generator.
+ */
+INTEREST_RATE_MODELS_TARGET_AVX2 inline int fillUniformPairRowsAvx2(
+    const std::uint64_t& seed,
+    const std::uint32_t& substream,
+    const std::uint32_t& blockIndex,
+    const std::uint64_t& firstPath,
+    const int& numberOfPaths,
+    double* firstUniforms,
+    double* secondUniforms)
+{
+    __m256i roundKey0[10];
+    __m256i roundKey1[10];
+    std::uint32_t key0 = static_cast<std::uint32_t>(seed);
+    std::uint32_t key1 = static_cast<std::uint32_t>(seed >> 32);
+    for (int round = 0; round < 10; ++round)
+    {
+        roundKey0[round] = _mm256_set1_epi64x(key0);
+        roundKey1[round] = _mm256_set1_epi64x(key1);
+        key0 += philoxWeyl0;
+        key1 += philoxWeyl1;
+    }
+    __m256i multiplier0 = _mm256_set1_epi64x(philoxMultiplier0);
+    __m256i multiplier1 = _mm256_set1_epi64x(philoxMultiplier1);
+    __m256i lowWord = _mm256_set1_epi64x(0xFFFFFFFFLL);
+    __m256i exponentBits = _mm256_set1_epi64x(0x4330000000000000LL);
+    __m256d offset = _mm256_set1_pd(4503599627370496.0 - 0.5);
+    __m256d scale = _mm256_set1_pd(uniformScale);
+
+    int path = 0;
+    for (; path + 4 <= numberOfPaths; path += 4)
+    {
+        std::uint64_t pathIndex = firstPath + static_cast<std::uint64_t>(path);
+        __m256i pathIndices = _mm256_set_epi64x(
+            static_cast<long long>(pathIndex + 3), static_cast<long long>(pathIndex + 2),
+            static_cast<long long>(pathIndex + 1), static_cast<long long>(pathIndex));
+        __m256i counter0 = _mm256_set1_epi64x(blockIndex);
+        __m256i counter1 = _mm256_set1_epi64x(substream);
+        __m256i counter2 = _mm256_and_si256(pathIndices, lowWord);
+        __m256i counter3 = _mm256_srli_epi64(pathIndices, 32);
+        for (int round = 0; round < 10; ++round)
+        {
+            __m256i product0 = _mm256_mul_epu32(counter0, multiplier0);
+            __m256i product1 = _mm256_mul_epu32(counter2, multiplier1);
+            counter0 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(product1, 32), counter1), roundKey0[round]);
+            counter1 = _mm256_and_si256(product1, lowWord);
+            counter2 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(product0, 32), counter3), roundKey1[round]);
+            counter3 = _mm256_and_si256(product0, lowWord);
+        }
+
+        // Keep the top 52 bits of each 64-bit output and map them to (0, 1)
+        __m256i firstBits = _mm256_or_si256(_mm256_slli_epi64(counter0, 20), _mm256_srli_epi64(counter1, 12));
+        __m256i secondBits = _mm256_or_si256(_mm256_slli_epi64(counter2, 20), _mm256_srli_epi64(counter3, 12));
+        __m256d first = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(firstBits, exponentBits)), offset);
+        __m256d second = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(secondBits, exponentBits)), offset);
+        _mm256_storeu_pd(firstUniforms + path, _mm256_mul_pd(first, scale));
+        _mm256_storeu_pd(secondUniforms + path, _mm256_mul_pd(second, scale));
+    }
+    return path;
+}
+
+INTEREST_RATE_MODELS_TARGET_AVX512 inline int fillUniformPairRowsAvx512(
+    const std::uint64_t& seed,
+    const std::uint32_t& substream,
+    const std::uint32_t& blockIndex,
+    const std::uint64_t& firstPath,
+    const int& numberOfPaths,
+    double* firstUniforms,
+    double* secondUniforms)
+{
+    __m512i roundKey0[10];
+    __m512i roundKey1[10];
+    std::uint32_t key0 = static_cast<std::uint32_t>(seed);
+    std::uint32_t key1 = static_cast<std::uint32_t>(seed >> 32);
+    for (int round = 0; round < 10; ++round)
+    {
+        roundKey0[round] = _mm512_set1_epi64(key0);
+        roundKey1[round] = _mm512_set1_epi64(key1);
+        key0 += philoxWeyl0;
+        key1 += philoxWeyl1;
+    }
+    __m512i multiplier0 = _mm512_set1_epi64(philoxMultiplier0);
+    __m512i multiplier1 = _mm512_set1_epi64(philoxMultiplier1);
+    __m512i lowWord = _mm512_set1_epi64(0xFFFFFFFFLL);
+    __m512i exponentBits = _mm512_set1_epi64(0x4330000000000000LL);
+    __m512i laneOffsets = _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+    __m512d offset = _mm512_set1_pd(4503599627370496.0 - 0.5);
+    __m512d scale = _mm512_set1_pd(uniformScale);
+
+    int path = 0;
+    for (; path + 8 <= numberOfPaths; path += 8)
+    {
+        std::uint64_t pathIndex = firstPath + static_cast<std::uint64_t>(path);
+        __m512i pathIndices = _mm512_add_epi64(_mm512_set1_epi64(static_cast<long long>(pathIndex)), laneOffsets);
+        __m512i counter0 = _mm512_set1_epi64(blockIndex);
+        __m512i counter1 = _mm512_set1_epi64(substream);
+        __m512i counter2 = _mm512_and_si512(pathIndices, lowWord);
+        __m512i counter3 = _mm512_srli_epi64(pathIndices, 32);
+        for (int round = 0; round < 10; ++round)
+        {
+            __m512i product0 = _mm512_mul_epu32(counter0, multiplier0);
+            __m512i product1 = _mm512_mul_epu32(counter2, multiplier1);
+            counter0 = _mm512_xor_si512(_mm512_xor_si512(_mm512_srli_epi64(product1, 32), counter1), roundKey0[round]);
+            counter1 = _mm512_and_si512(product1, lowWord);
+            counter2 = _mm512_xor_si512(_mm512_xor_si512(_mm512_srli_epi64(product0, 32), counter3), roundKey1[round]);
+            counter3 = _mm512_and_si512(product0, lowWord);
+        }
+
+        // Keep the top 52 bits of each 64-bit output and map them to (0, 1)
+        __m512i firstBits = _mm512_or_si512(_mm512_slli_epi64(counter0, 20), _mm512_srli_epi64(counter1, 12));
+        __m512i secondBits = _mm512_or_si512(_mm512_slli_epi64(counter2, 20), _mm512_srli_epi64(counter3, 12));
+        __m512d first = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(firstBits, exponentBits)), offset);
+        __m512d second = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(secondBits, exponentBits)), offset);
+        _mm512_storeu_pd(firstUniforms + path, _mm512_mul_pd(first, scale));
+        _mm512_storeu_pd(secondUniforms + path, _mm512_mul_pd(second, scale));
+    }
+    return path;
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+/*
+ Fills the two uniforms of one block for a range of consecutive paths.
+
+ @param seed The seed of the simulation.
+ @param substream The substream within each path.
+ @param blockIndex The block within the substream.
+ @param firstPath The index of the first path in the range.
+ @param numberOfPaths The number of paths in the range.
+ @param firstUniforms Receives the first uniform of every path in the range.
+ @param secondUniforms Receives the second uniform of every path in the range.
+ */
+inline void fillUniformPairRows(
+    const std::uint64_t& seed,
+    const std::uint32_t& substream,
+    const std::uint32_t& blockIndex,
+    const std::uint64_t& firstPath,
+    const int& numberOfPaths,
+    double* firstUniforms,
+    double* secondUniforms)
+{
+    int path = 0;
+
+#if defined(INTEREST_RATE_MODELS_X86_SIMD)
+    SimdLevel simdLevel = activeSimdLevel();
+    if (simdLevel == SimdLevel::Avx512)
+    {
+        path = fillUniformPairRowsAvx512(seed, substream, blockIndex, firstPath, numberOfPaths, firstUniforms, secondUniforms);
+    }
+    else if (simdLevel == SimdLevel::Avx2)
+    {
+        path = fillUniformPairRowsAvx2(seed, substream, blockIndex, firstPath, numberOfPaths, firstUniforms, secondUniforms);
+    }
+#endif
+
+    for (; path < numberOfPaths; ++path)
+    {
+        counterUniformPair(seed, firstPath + static_cast<std::uint64_t>(path), substream, blockIndex, firstUniforms[path], secondUniforms[path]);
+    }
+}
+
+/*
+ Fills the increments of one substream for two consecutive steps.
+
+ Models driven by several Brownian motions give each factor a substream of
+ its own; substream 0 is the one used by single-factor models.
+
+ @param seed The seed of the simulation.
+ @param substream The substream of the increments.
+ @param blockIndex The block holding increments 2 * blockIndex and 2 * blockIndex + 1.
+ @param firstPath The index of the first path in the range.
+ @param numberOfPaths The number of paths in the range.
+ @param evenIncrements Receives increment 2 * blockIndex of every path in the range.
+ @param oddIncrements Receives increment 2 * blockIndex + 1 of every path in the range.
+ */
+inline void fillIncrementPair(
+    const std::uint64_t& seed,
+    const std::uint32_t& substream,
+    const std::uint32_t& blockIndex,
+    const std::uint64_t& firstPath,
+    const int& numberOfPaths,
+    double* evenIncrements,
+    double* oddIncrements)
+{
+    fillUniformPairRows(seed, substream, blockIndex, firstPath, numberOfPaths, evenIncrements, oddIncrements);
+    uniformsToStandardNormals(evenIncrements, static_cast<std::size_t>(numberOfPaths));
+    uniformsToStandardNormals(oddIncrements, static_cast<std::size_t>(numberOfPaths));
+}
+
+/*
+ Fills the per-step standard normal increments of a range of paths for two consecutive steps.
+
+ Increments are numbered from zero along each path; increment d drives time
+ step d + 1. Block k of substream 0 holds increments 2k and 2k + 1, so both
+ rows come out of one pass over the paths. The uniforms are generated first
+ and then converted to normals a row at a time.
+
+ @param seed The seed of the simulation.
+ @param blockIndex The block holding increments 2 * blockIndex and 2 * blockIndex + 1.
+ @param firstPath The index of the first path in the range.
+ @param numberOfPaths The number of paths in the range.
+ @param evenIncrements Receives increment 2 * blockIndex of every path in the range.
+ @param oddIncrements Receives increment 2 * blockIndex + 1 of every path in the range.
+ */
+inline void fillIncrementPair(
+    const std::uint64_t& seed,
+    const std::uint32_t& blockIndex,
+    const std::uint64_t& firstPath,
+    const int& numberOfPaths,
+    double* evenIncrements,
+    double* oddIncrements)
+{
+    fillIncrementPair(seed, 0, blockIndex, firstPath, numberOfPaths, evenIncrements, oddIncrements);
+}
+
+/*
+ Sequential view of one substream of a path, for draws whose count is not known in advance.
+ */
+struct CounterRandomStream
+{
+    std::uint64_t seed = 0;
+    std::uint64_t pathIndex = 0;
+    std::uint32_t substream = 0;
+    std::uint32_t nextBlock = 0;
+    double bufferedUniform = 0.0;
+    bool hasBufferedUniform = false;
+
+    CounterRandomStream() = default;
+
+    CounterRandomStream(const std::uint64_t& streamSeed, const std::uint64_t& streamPathIndex, const std::uint32_t& streamSubstream)
+        : seed(streamSeed), pathIndex(streamPathIndex), substream(streamSubstream)
+    {
+    }
+
+    /*
+     Returns the next uniform in (0, 1).
+     */
+    double nextUniform()
+    {
+        if (hasBufferedUniform)
+        {
+            hasBufferedUniform = false;
+            return bufferedUniform;
+        }
+        double firstUniform;
+        counterUniformPair(seed, pathIndex, substream, nextBlock++, firstUniform, bufferedUniform);
+        hasBufferedUniform = true;
+        return firstUniform;
+    }
+
+    /*
+     Returns the next standard normal.
+     */
+    double nextStandardNormal()
+    {
+        return inverseStandardNormal(nextUniform());
+    }
+};
+
+/*
+ Fills an array with the next standard normals of a stream.
+
+ @param stream The stream to draw from.
+ @param normals Receives the normals.
+ @param count The number of normals to draw.
+ */
+inline void fillStandardNormals(CounterRandomStream& stream, double* normals, const std::size_t& count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        normals[i] = stream.nextUniform();
+    }
+    uniformsToStandardNormals(normals, count);
+}
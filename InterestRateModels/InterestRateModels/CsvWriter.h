@@ -0,0 +1,302 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Profiling.h"
+
+/*
+ Writes CSV files with formatting on the caller's thread and file I/O on a background thread.
+
+ Values are formatted with std::to_chars (no locale, 15 significant digits
+ by default) straight into large buffers. A full buffer is handed to the I/O
+ thread and the caller carries on in the next free one, so formatting and
+ writing overlap. The buffers are allocated once and recycled, so writing
+ does not allocate.
+ */
+class CsvWriter
+{
+public:
+    /*
+     Opens the file and starts the I/O thread.
+
+     @param path The path of the file.
+     @param significantDigits The significant digits of numbers; zero writes the shortest text that reads back exactly.
+     @param bufferSize The size of each buffer in bytes.
+     @param numberOfBuffers The number of buffers, at least two.
+     */
+    explicit CsvWriter(const std::string& path, const int& significantDigits = 15, const std::size_t& bufferSize = 1 << 20, const int& numberOfBuffers = 4)
+        : digits(std::min(significantDigits, 17)), capacity(std::max<std::size_t>(bufferSize, 2 * maximumFieldLength))
+    {
+        file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr)
+        {
+            throw std::runtime_error("Cannot create " + path);
+        }
+        std::setvbuf(file, nullptr, _IONBF, 0);
+
+        buffers.resize(static_cast<std::size_t>(std::max(2, numberOfBuffers)));
+        freeBuffers.reserve(buffers.size());
+        fullBuffers.reserve(buffers.size());
+        for (Buffer& buffer : buffers)
+        {
+            buffer.data.resize(capacity);
+            freeBuffers.push_back(&buffer);
+        }
+        current = takeFirst(freeBuffers);
+
+        ioThread = std::thread([this]() { writeBuffers(); });
+    }
+
+    ~CsvWriter()
+    {
+        try
+        {
+            close();
+        }
+        catch (...)
+        {
+        }
+    }
+
+    CsvWriter(const CsvWriter&) = delete;
+    CsvWriter& operator=(const CsvWriter&) = delete;
+
+    /*
+     Appends a number field to the current row.
+
+     @param value The value to write.
+     */
+    void writeField(const double& value)
+    {
+        writeNumber(beginField(maximumFieldLength), value);
+    }
+
+    void writeField(const int& value)
+    {
+        char* position = beginField(maximumFieldLength);
+        current->length += static_cast<std::size_t>(std::to_chars(position, position + maximumFieldLength, value).ptr - position);
+    }
+
+    void writeField(const long long& value)
+    {
+        char* position = beginField(maximumFieldLength);
+        current->length += static_cast<std::size_t>(std::to_chars(position, position + maximumFieldLength, value).ptr - position);
+    }
+
+    /*
+     Appends a field made of a label followed by a number, such as a column name with a maturity.
+
+     @param label The label.
+     @param value The number.
+     */
+    void writeField(const char* label, const double& value)
+    {
+        beginField(0);
+        writeText(label, std::strlen(label));
+        writeNumber(reserve(maximumFieldLength), value);
+    }
+
+    /*
+     Appends a text field to the current row. The text is written as is, without quoting.
+
+     @param text The text to write.
+     */
+    void writeField(const std::string& text)
+    {
+        beginField(0);
+        writeText(text.data(), text.size());
+    }
+
+    void writeField(const char* text)
+    {
+        beginField(0);
+        writeText(text, std::strlen(text));
+    }
+
+    /*
+     Ends the current row.
+     */
+    void endRow()
+    {
+        reserve(1)[0] = '\n';
+        current->length += 1;
+        atRowStart = true;
+    }
+
+    /*
+     Writes a whole row.
+
+     @param fields The fields of the row.
+     */
+    template <typename... Fields>
+    void writeRow(const Fields&... fields)
+    {
+        int expand[] = { 0, (writeField(fields), 0)... };
+        (void)expand;
+        endRow();
+    }
+
+    /*
+     Writes out the remaining data, stops the I/O thread and closes the file.
+
+     Throws std::runtime_error if any write failed.
+     */
+    void close()
+    {
+        if (file == nullptr)
+        {
+            return;
+        }
+        submitCurrent();
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopping = true;
+        }
+        queueChanged.notify_all();
+        ioThread.join();
+
+        bool closeFailed = std::fclose(file) != 0;
+        file = nullptr;
+        if (writeFailed || closeFailed)
+        {
+            throw std::runtime_error("Writing the CSV file failed");
+        }
+    }
+
+private:
+    struct Buffer
+    {
+        std::vector<char> data;
+        std::size_t length = 0;
+    };
+
+    // Longest text std::to_chars produces for a double or a 64-bit integer, plus the separator
+    static constexpr std::size_t maximumFieldLength = 32;
+
+    // Adds the separator if needed and returns space for a field of up to length bytes
+    char* beginField(const std::size_t& length)
+    {
+        char* position = reserve(length + 1);
+        if (!atRowStart)
+        {
+            *position++ = ',';
+            current->length += 1;
+        }
+        atRowStart = false;
+        return position;
+    }
+
+    void writeNumber(char* position, const double& value)
+    {
+        std::to_chars_result result = digits > 0
+            ? std::to_chars(position, position + maximumFieldLength, value, std::chars_format::general, digits)
+            : std::to_chars(position, position + maximumFieldLength, value);
+        current->length += static_cast<std::size_t>(result.ptr - position);
+    }
+
+    void writeText(const char* text, std::size_t length)
+    {
+        while (length > 0)
+        {
+            std::size_t chunk = std::min(length, capacity - current->length);
+            if (chunk == 0)
+            {
+                submitCurrent();
+                continue;
+            }
+            std::memcpy(current->data.data() + current->length, text, chunk);
+            current->length += chunk;
+            text += chunk;
+            length -= chunk;
+        }
+    }
+
+    // Returns space for length bytes in the current buffer, switching buffers if it is too full
+    char* reserve(const std::size_t& length)
+    {
+        if (capacity - current->length < length)
+        {
+            submitCurrent();
+        }
+        return current->data.data() + current->length;
+    }
+
+    // Removes the oldest buffer from a queue; the queues are short and never reallocate
+    static Buffer* takeFirst(std::vector<Buffer*>& queue)
+    {
+        Buffer* buffer = queue.front();
+        queue.erase(queue.begin());
+        return buffer;
+    }
+
+    // Hands the current buffer to the I/O thread and waits for a free one
+    void submitCurrent()
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        if (current->length > 0)
+        {
+            fullBuffers.push_back(current);
+            queueChanged.notify_all();
+            queueChanged.wait(lock, [this]() { return !freeBuffers.empty(); });
+            current = takeFirst(freeBuffers);
+        }
+    }
+
+    void writeBuffers()
+    {
+        while (true)
+        {
+            Buffer* buffer;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueChanged.wait(lock, [this]() { return stopping || !fullBuffers.empty(); });
+                if (fullBuffers.empty())
+                {
+                    return;
+                }
+                buffer = takeFirst(fullBuffers);
+            }
+
+            {
+                INTEREST_RATE_MODELS_PROFILE_SCOPE("csvWrite");
+                if (std::fwrite(buffer->data.data(), 1, buffer->length, file) != buffer->length)
+                {
+                    writeFailed = true;
+                }
+                INTEREST_RATE_MODELS_PROFILE_COUNT(BytesWritten, buffer->length);
+            }
+            buffer->length = 0;
+
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                freeBuffers.push_back(buffer);
+            }
+            queueChanged.notify_all();
+        }
+    }
+
+    int digits;
+    std::size_t capacity;
+    std::FILE* file = nullptr;
+    std::vector<Buffer> buffers;
+    Buffer* current = nullptr;
+    bool atRowStart = true;
+
+    std::thread ioThread;
+    std::mutex queueMutex;
+    std::condition_variable queueChanged;
+    std::vector<Buffer*> freeBuffers;
+    std::vector<Buffer*> fullBuffers;
+    bool stopping = false;
+    bool writeFailed = false;
+};
@@ -0,0 +1,689 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#include "Profiling.h"
+
+/*
+ Crank-Nicolson finite differences for one-factor short-rate models.
+
+ The price V(tau, r) of a claim with time to expiry tau solves
+ dV/dtau = mu(r) dV/dr + sigma(r)^2 / 2 d2V/dr2 - r V, with mu and sigma the
+ drift and diffusion of the model. The coefficients are evaluated once, at
+ time zero, so the engine serves the time-homogeneous models: Vasicek, CIR,
+ CKLS and CEV. That is also what lets one sweep in tau price a whole batch:
+ the value at tau = T of a sweep started from a payoff is the price of that
+ payoff paid at T, so every maturity of a batch is read off the same sweep.
+
+ The rate grid is a sinh stretch, fine around the initial rate, which is a
+ node, and coarse towards the ends. Interior nodes use central differences,
+ falling back to upwinding where the drift would otherwise make an
+ off-diagonal negative; boundary nodes drop the diffusion and take a
+ one-sided derivative into the grid when the drift points inwards, which for
+ a square-root diffusion at zero is the exact boundary condition. Option
+ payoffs start with a few implicit Euler half steps (Rannacher smoothing),
+ which damp the oscillations Crank-Nicolson leaves at a kink. The implicit
+ half step and Crank-Nicolson solve the same tridiagonal system, so each
+ step length is factorized once.
+
+ Values are stored node-major with one column per claim of a batch, so the
+ tridiagonal solve runs its inner loops over the batch.
+ */
+
+/*
+ Thomas algorithm for tridiagonal systems with one matrix and many right-hand sides.
+
+ The matrix is factorized once and the factors are kept, so each solve is one
+ forward and one backward pass. Both passes are recurrences from row to row;
+ the factors are scaled so that each row adds a single multiply-add to the
+ chain, and a single right-hand side keeps its carried value in a register.
+ Buffers are reused between factorizations.
+ */
+class TridiagonalSolver
+{
+public:
+    /*
+     Factorizes the matrix with the given diagonals. The matrix must be diagonally dominant.
+
+     @param lower The subdiagonal; lower[0] is ignored.
+     @param diagonal The diagonal.
+     @param upper The superdiagonal; upper[size - 1] is ignored.
+     @param size The number of rows.
+     */
+    void factorize(const double* lower, const double* diagonal, const double* upper, const std::size_t& size)
+    {
+        scaledLower.resize(size);
+        modifiedUpper.resize(size);
+        inverseDiagonal.resize(size);
+        double previousUpper = 0.0;
+        for (std::size_t row = 0; row < size; ++row)
+        {
+            double sub = row > 0 ? lower[row] : 0.0;
+            inverseDiagonal[row] = 1.0 / (diagonal[row] - sub * previousUpper);
+            scaledLower[row] = sub * inverseDiagonal[row];
+            previousUpper = row + 1 < size ? upper[row] * inverseDiagonal[row] : 0.0;
+            modifiedUpper[row] = previousUpper;
+        }
+    }
+
+    /*
+     Solves in place for every column.
+
+     @param values The right-hand sides, overwritten with the solutions, stored row-major.
+     @param columns The number of right-hand sides.
+     */
+    void solve(double* values, const std::size_t& columns) const
+    {
+        std::size_t size = inverseDiagonal.size();
+        const double* inverse = inverseDiagonal.data();
+        const double* scaled = scaledLower.data();
+        const double* upper = modifiedUpper.data();
+        if (columns == 1)
+        {
+            double carried = 0.0;
+            for (std::size_t row = 0; row < size; ++row)
+            {
+                carried = values[row] * inverse[row] - scaled[row] * carried;
+                values[row] = carried;
+            }
+            for (std::size_t row = size - 1; row-- > 0;)
+            {
+                carried = values[row] - upper[row] * carried;
+                values[row] = carried;
+            }
+            return;
+        }
+
+        for (std::size_t column = 0; column < columns; ++column)
+        {
+            values[column] *= inverse[0];
+        }
+        for (std::size_t row = 1; row < size; ++row)
+        {
+            double* current = values + row * columns;
+            const double* previous = current - columns;
+            for (std::size_t column = 0; column < columns; ++column)
+            {
+                current[column] = current[column] * inverse[row] - scaled[row] * previous[column];
+            }
+        }
+        for (std::size_t row = size - 1; row-- > 0;)
+        {
+            double* current = values + row * columns;
+            const double* next = current + columns;
+            for (std::size_t column = 0; column < columns; ++column)
+            {
+                current[column] -= upper[row] * next[column];
+            }
+        }
+    }
+
+private:
+    std::vector<double> scaledLower;
+    std::vector<double> modifiedUpper;
+    std::vector<double> inverseDiagonal;
+};
+
+/*
+ Grid and time-stepping settings. The rate bounds and the width of the fine
+ region default to values derived from the model when left as NaN.
+ */
+struct FiniteDifferenceSettings
+{
+    int numberOfNodes = 201;
+    int stepsPerYear = 50;
+    int smoothingSteps = 2;      // Crank-Nicolson steps replaced by two implicit half steps after a payoff
+    bool extrapolate = true;     // Richardson extrapolation against a grid with twice the nodes and steps
+    double minimumRate = std::numeric_limits<double>::quiet_NaN();
+    double maximumRate = std::numeric_limits<double>::quiet_NaN();
+    double gridConcentration = std::numeric_limits<double>::quiet_NaN();
+};
+
+/*
+ An option on a zero-coupon bond, struck on the bond price.
+ */
+struct BondOption
+{
+    double expiry = 0.0;
+    double bondMaturity = 0.0;
+    double strike = 0.0;
+    bool call = true;
+    bool american = false;  // exercisable at any time up to the expiry
+};
+
+/*
+ Prices bonds, bond options and caps of one short-rate model by finite differences.
+
+ With extrapolation on, every price is computed on the grid of the settings
+ and on one with each rate interval and time step halved, and the two are
+ combined as (4 fine - coarse) / 3, which cancels the leading h^2 and dt^2
+ errors of both. The grids, the discretized generators and the solver
+ buffers are built once and reused by every call, so repeated batches
+ allocate only when they are larger than any before.
+ */
+class FiniteDifferenceEngine
+{
+public:
+    /*
+     @param model The model; only its drift, diffusion and initial rate are used.
+     @param timeHorizon The longest time the engine will price to, which sizes the default grid.
+     @param settings The grid and time-stepping settings.
+     */
+    template <typename Model>
+    FiniteDifferenceEngine(const Model& model, const double& timeHorizon, const FiniteDifferenceSettings& settings = FiniteDifferenceSettings())
+        : settings(settings)
+    {
+        if (settings.numberOfNodes < 5 || settings.stepsPerYear < 1 || !(timeHorizon > 0.0))
+        {
+            throw std::runtime_error("A finite-difference grid needs at least 5 nodes, a step per year and a positive horizon");
+        }
+        levels.resize(settings.extrapolate ? 2 : 1);
+        for (std::size_t level = 0; level < levels.size(); ++level)
+        {
+            int refinement = 1 << level;
+            levels[level].stepsPerYear = settings.stepsPerYear * refinement;
+            buildGrid(levels[level], model, timeHorizon, refinement);
+            buildOperator(levels[level], model);
+        }
+    }
+
+    /*
+     Returns the prices of zero-coupon bonds at the initial rate.
+
+     @param maturities The maturities.
+     */
+    std::vector<double> bondPrices(const std::vector<double>& maturities)
+    {
+        INTEREST_RATE_MODELS_PROFILE_SCOPE("finiteDifference");
+        return extrapolate([&](Level& level)
+        {
+            std::vector<double> prices(maturities.size());
+            level.values.assign(level.rates.size(), 1.0);
+            sweep(level, 1, maturities, 0, [](const double&) {}, [&](const std::size_t& index)
+            {
+                prices[index] = level.values[level.initialNode];
+            });
+            return prices;
+        });
+    }
+
+    /*
+     Returns the prices of options on zero-coupon bonds at the initial rate.
+
+     Options whose bonds have the same time to maturity at expiry share one
+     sweep, with one column per option.
+
+     @param options The options.
+     */
+    std::vector<double> bondOptionPrices(const std::vector<BondOption>& options)
+    {
+        INTEREST_RATE_MODELS_PROFILE_SCOPE("finiteDifference");
+        std::map<long long, std::vector<std::size_t>> groups;
+        for (std::size_t index = 0; index < options.size(); ++index)
+        {
+            if (!(options[index].expiry >= 0.0) || !(options[index].bondMaturity > options[index].expiry))
+            {
+                throw std::runtime_error("A bond option must expire before its bond matures");
+            }
+            groups[std::llround((options[index].bondMaturity - options[index].expiry) * 1e9)].push_back(index);
+        }
+
+        return extrapolate([&](Level& level)
+        {
+            std::vector<double> prices(options.size());
+            for (const auto& group : groups)
+            {
+                const std::vector<std::size_t>& members = group.second;
+                std::vector<double> bond = bondValues(level, options[members.front()].bondMaturity - options[members.front()].expiry);
+
+                // Column 0 carries the bond on, for the exercise values of American options
+                std::size_t columns = members.size() + 1;
+                std::size_t nodes = level.rates.size();
+                level.values.resize(nodes * columns);
+                for (std::size_t node = 0; node < nodes; ++node)
+                {
+                    level.values[node * columns] = bond[node];
+                    for (std::size_t member = 0; member < members.size(); ++member)
+                    {
+                        const BondOption& option = options[members[member]];
+                        level.values[node * columns + member + 1] = option.call ? bond[node] - option.strike : option.strike - bond[node];
+                    }
+                }
+                averagePositiveParts(level, columns, 1);
+
+                std::vector<double> expiries;
+                std::vector<std::size_t> americanMembers;
+                for (std::size_t member = 0; member < members.size(); ++member)
+                {
+                    expiries.push_back(options[members[member]].expiry);
+                    if (options[members[member]].american)
+                    {
+                        americanMembers.push_back(member);
+                    }
+                }
+                sweep(level, columns, expiries, settings.smoothingSteps, [&](const double& time)
+                {
+                    if (americanMembers.empty())
+                    {
+                        return;
+                    }
+                    for (std::size_t node = 0; node < nodes; ++node)
+                    {
+                        double* row = &level.values[node * columns];
+                        for (const std::size_t& member : americanMembers)
+                        {
+                            const BondOption& option = options[members[member]];
+                            if (time <= option.expiry + 1e-12)
+                            {
+                                row[member + 1] = std::max(row[member + 1], exerciseValue(option, row[0]));
+                            }
+                        }
+                    }
+                }, [&](const std::size_t& member)
+                {
+                    prices[members[member]] = level.values[level.initialNode * columns + member + 1];
+                });
+            }
+            return prices;
+        });
+    }
+
+    /*
+     Returns the prices of caps on the simply compounded rate over each accrual
+     period, for a notional of one.
+
+     Each caplet is a put on the bond maturing at the end of its period,
+     expiring at the start, so every caplet of every cap starts from the same
+     kind of payoff and all are priced in one sweep with one column per cap
+     rate. The first period, which fixes today, is left out.
+
+     @param capRates The cap rates.
+     @param maturity The end of the last period.
+     @param accrual The length of each period.
+     */
+    std::vector<double> capPrices(const std::vector<double>& capRates, const double& maturity, const double& accrual)
+    {
+        INTEREST_RATE_MODELS_PROFILE_SCOPE("finiteDifference");
+        int numberOfPeriods = static_cast<int>(std::lround(maturity / accrual));
+        std::vector<double> resets;
+        for (int period = 1; period < numberOfPeriods; ++period)
+        {
+            resets.push_back(period * accrual);
+        }
+
+        return extrapolate([&](Level& level)
+        {
+            // Caplet paid at the end of a period, valued at its reset: max(1 - (1 + K accrual) P(accrual), 0)
+            std::vector<double> bond = bondValues(level, accrual);
+            std::size_t columns = capRates.size();
+            std::size_t nodes = level.rates.size();
+            level.values.resize(nodes * columns);
+            for (std::size_t node = 0; node < nodes; ++node)
+            {
+                for (std::size_t column = 0; column < columns; ++column)
+                {
+                    level.values[node * columns + column] = 1.0 - (1.0 + capRates[column] * accrual) * bond[node];
+                }
+            }
+            averagePositiveParts(level, columns, 0);
+
+            std::vector<double> prices(columns, 0.0);
+            sweep(level, columns, resets, settings.smoothingSteps, [](const double&) {}, [&](const std::size_t&)
+            {
+                for (std::size_t column = 0; column < columns; ++column)
+                {
+                    prices[column] += level.values[level.initialNode * columns + column];
+                }
+            });
+            return prices;
+        });
+    }
+
+    // The rate nodes of the grid of the settings, in increasing order
+    const std::vector<double>& rateGrid() const
+    {
+        return levels.front().rates;
+    }
+
+private:
+    /*
+     One grid with its discretization and buffers.
+     */
+    struct Level
+    {
+        int stepsPerYear = 0;
+        std::vector<double> rates;
+        std::size_t initialNode = 0;
+
+        // The generator mu d/dr + sigma^2 / 2 d2/dr2 - r, as three diagonals
+        std::vector<double> generatorLower;
+        std::vector<double> generatorDiagonal;
+        std::vector<double> generatorUpper;
+
+        // I - stepLength / 2 * generator, factorized, and I + stepLength / 2 * generator, for factorizedStep
+        std::vector<double> systemLower;
+        std::vector<double> systemDiagonal;
+        std::vector<double> systemUpper;
+        std::vector<double> explicitLower;
+        std::vector<double> explicitDiagonal;
+        std::vector<double> explicitUpper;
+        TridiagonalSolver solver;
+        double factorizedStep = 0.0;
+
+        std::vector<double> values;
+        std::vector<double> rightHandSide;
+    };
+
+    /*
+     Runs a pricing on every level and combines the results.
+     */
+    template <typename Price>
+    std::vector<double> extrapolate(const Price& price)
+    {
+        std::vector<double> prices = price(levels.front());
+        if (levels.size() > 1)
+        {
+            std::vector<double> finePrices = price(levels.back());
+            for (std::size_t index = 0; index < prices.size(); ++index)
+            {
+                prices[index] = (4.0 * finePrices[index] - prices[index]) / 3.0;
+            }
+        }
+        return prices;
+    }
+
+    /*
+     Places the nodes of a level, uniform in asinh((r - r0) / c) with the spacing
+     chosen so that r0 and the lower bound are nodes. A refinement of 2 halves
+     every interval of the grid of the settings, so the two grids nest.
+     */
+    template <typename Model>
+    void buildGrid(Level& level, const Model& model, const double& timeHorizon, const int& refinement)
+    {
+        double initialRate = model.initialInterestRate;
+
+        // The scale of the rate moves over the horizon, from the diffusion a little above the initial rate
+        double rateScale = std::max(std::abs(initialRate), 0.02);
+        double spread = std::max(model.diffusion(0.0, initialRate + rateScale), 1e-4) * std::sqrt(timeHorizon);
+        double maximumRate = std::isnan(settings.maximumRate) ? initialRate + std::max(8.0 * spread, 4.0 * rateScale) : settings.maximumRate;
+        double minimumRate = settings.minimumRate;
+        if (std::isnan(minimumRate))
+        {
+            // Zero is a boundary the rate cannot cross when the diffusion vanishes there and the drift points up
+            bool zeroIsBoundary = initialRate >= 0.0 && model.diffusion(0.0, 0.0) == 0.0 && model.drift(0.0, 0.0) >= 0.0;
+            minimumRate = zeroIsBoundary ? 0.0 : 2.0 * initialRate - maximumRate;
+        }
+        double concentration = std::isnan(settings.gridConcentration) ? 0.5 * spread : settings.gridConcentration;
+        if (!(minimumRate <= initialRate && initialRate < maximumRate && concentration > 0.0))
+        {
+            throw std::runtime_error("The finite-difference grid must contain the initial rate");
+        }
+
+        int intervals = settings.numberOfNodes - 1;
+        double lowerCoordinate = std::asinh((minimumRate - initialRate) / concentration);
+        double upperCoordinate = std::asinh((maximumRate - initialRate) / concentration);
+        int lowerIntervals = static_cast<int>(std::lround(intervals * -lowerCoordinate / (upperCoordinate - lowerCoordinate)));
+        if (lowerCoordinate < 0.0)
+        {
+            lowerIntervals = std::min(std::max(lowerIntervals, 1), intervals - 1);
+        }
+        double coordinateStep = lowerIntervals > 0 ? -lowerCoordinate / lowerIntervals : upperCoordinate / intervals;
+
+        intervals *= refinement;
+        lowerIntervals *= refinement;
+        coordinateStep /= refinement;
+        level.rates.resize(static_cast<std::size_t>(intervals) + 1);
+        for (int node = 0; node <= intervals; ++node)
+        {
+            level.rates[node] = initialRate + concentration * std::sinh((node - lowerIntervals) * coordinateStep);
+        }
+        level.rates[0] = lowerIntervals > 0 ? minimumRate : initialRate;
+        level.initialNode = static_cast<std::size_t>(lowerIntervals);
+        level.rates[level.initialNode] = initialRate;
+    }
+
+    template <typename Model>
+    static void buildOperator(Level& level, const Model& model)
+    {
+        const std::vector<double>& rates = level.rates;
+        std::size_t nodes = rates.size();
+        level.generatorLower.assign(nodes, 0.0);
+        level.generatorDiagonal.assign(nodes, 0.0);
+        level.generatorUpper.assign(nodes, 0.0);
+        for (std::size_t node = 0; node < nodes; ++node)
+        {
+            double rate = rates[node];
+            double drift = model.drift(0.0, rate);
+            if (node == 0)
+            {
+                // One-sided into the grid if the drift points inwards, no diffusion
+                level.generatorUpper[node] = std::max(drift, 0.0) / (rates[1] - rate);
+            }
+            else if (node + 1 == nodes)
+            {
+                level.generatorLower[node] = std::max(-drift, 0.0) / (rate - rates[node - 1]);
+            }
+            else
+            {
+                double diffusion = model.diffusion(0.0, rate);
+                double halfVariance = 0.5 * diffusion * diffusion;
+                double below = rate - rates[node - 1];
+                double above = rates[node + 1] - rate;
+                double lower = (2.0 * halfVariance - drift * above) / (below * (below + above));
+                double upper = (2.0 * halfVariance + drift * below) / (above * (below + above));
+                if (lower < 0.0 || upper < 0.0)
+                {
+                    // Upwind the drift
+                    lower = 2.0 * halfVariance / (below * (below + above)) + std::max(-drift, 0.0) / below;
+                    upper = 2.0 * halfVariance / (above * (below + above)) + std::max(drift, 0.0) / above;
+                }
+                level.generatorLower[node] = lower;
+                level.generatorUpper[node] = upper;
+            }
+            level.generatorDiagonal[node] = -level.generatorLower[node] - level.generatorUpper[node] - rate;
+        }
+        level.factorizedStep = 0.0;
+    }
+
+    /*
+     Factorizes I - stepLength / 2 * generator and forms I + stepLength / 2 * generator, unless they already are.
+     */
+    static void factorize(Level& level, const double& stepLength)
+    {
+        if (stepLength == level.factorizedStep)
+        {
+            return;
+        }
+        std::size_t nodes = level.rates.size();
+        double halfStep = 0.5 * stepLength;
+        level.systemLower.resize(nodes);
+        level.systemDiagonal.resize(nodes);
+        level.systemUpper.resize(nodes);
+        level.explicitLower.resize(nodes);
+        level.explicitDiagonal.resize(nodes);
+        level.explicitUpper.resize(nodes);
+        for (std::size_t node = 0; node < nodes; ++node)
+        {
+            level.systemLower[node] = -halfStep * level.generatorLower[node];
+            level.systemDiagonal[node] = 1.0 - halfStep * level.generatorDiagonal[node];
+            level.systemUpper[node] = -halfStep * level.generatorUpper[node];
+            level.explicitLower[node] = halfStep * level.generatorLower[node];
+            level.explicitDiagonal[node] = 1.0 + halfStep * level.generatorDiagonal[node];
+            level.explicitUpper[node] = halfStep * level.generatorUpper[node];
+        }
+        level.solver.factorize(level.systemLower.data(), level.systemDiagonal.data(), level.systemUpper.data(), nodes);
+        level.factorizedStep = stepLength;
+    }
+
+    /*
+     Takes a Crank-Nicolson step of the factorized length, or an implicit Euler step of half of it.
+     */
+    static void step(Level& level, const std::size_t& columns, const bool& crankNicolson)
+    {
+        if (crankNicolson)
+        {
+            // The right-hand side (I + stepLength / 2 * generator) values goes to a second buffer, which becomes values
+            std::size_t nodes = level.rates.size();
+            level.rightHandSide.resize(nodes * columns);
+            const double* current = level.values.data();
+            double* result = level.rightHandSide.data();
+            for (std::size_t column = 0; column < columns; ++column)
+            {
+                result[column] = level.explicitDiagonal[0] * current[column] + level.explicitUpper[0] * current[columns + column];
+            }
+            for (std::size_t node = 1; node + 1 < nodes; ++node)
+            {
+                double lower = level.explicitLower[node];
+                double diagonal = level.explicitDiagonal[node];
+                double upper = level.explicitUpper[node];
+                const double* here = current + node * columns;
+                double* target = result + node * columns;
+                for (std::size_t column = 0; column < columns; ++column)
+                {
+                    target[column] = lower * here[column - columns] + diagonal * here[column] + upper * here[column + columns];
+                }
+            }
+            std::size_t last = (nodes - 1) * columns;
+            for (std::size_t column = 0; column < columns; ++column)
+            {
+                result[last + column] = level.explicitLower[nodes - 1] * current[last - columns + column] + level.explicitDiagonal[nodes - 1] * current[last + column];
+            }
+            level.values.swap(level.rightHandSide);
+        }
+        level.solver.solve(level.values.data(), columns);
+    }
+
+    /*
+     Advances the values of a level from tau = 0 through every record time.
+
+     @param level The level.
+     @param columns The number of columns of values.
+     @param recordTimes The times at which to record, in any order.
+     @param smoothingSteps The number of leading steps taken as two implicit half steps.
+     @param afterStep Called with the time after each step, for early exercise.
+     @param record Called with the index of each record time when the sweep reaches it.
+     */
+    template <typename AfterStep, typename Record>
+    static void sweep(Level& level, const std::size_t& columns, const std::vector<double>& recordTimes, const int& smoothingSteps, const AfterStep& afterStep, const Record& record)
+    {
+        std::vector<std::size_t> order(recordTimes.size());
+        for (std::size_t index = 0; index < order.size(); ++index)
+        {
+            order[index] = index;
+        }
+        std::sort(order.begin(), order.end(), [&](const std::size_t& first, const std::size_t& second) { return recordTimes[first] < recordTimes[second]; });
+
+        double time = 0.0;
+        int stepsTaken = 0;
+        for (const std::size_t& index : order)
+        {
+            double segment = recordTimes[index] - time;
+            if (segment < -1e-12)
+            {
+                throw std::runtime_error("Finite-difference record times must not be negative");
+            }
+            int numberOfSteps = static_cast<int>(std::ceil(segment * level.stepsPerYear - 1e-9));
+            if (numberOfSteps > 0)
+            {
+                factorize(level, segment / numberOfSteps);
+            }
+            for (int segmentStep = 0; segmentStep < numberOfSteps; ++segmentStep)
+            {
+                if (stepsTaken < smoothingSteps)
+                {
+                    step(level, columns, false);
+                    step(level, columns, false);
+                }
+                else
+                {
+                    step(level, columns, true);
+                }
+                ++stepsTaken;
+                afterStep(time + (segmentStep + 1) * level.factorizedStep);
+            }
+            time = std::max(time, recordTimes[index]);
+            record(index);
+        }
+        INTEREST_RATE_MODELS_PROFILE_COUNT(Steps, static_cast<long long>(stepsTaken) * static_cast<long long>(columns));
+    }
+
+    /*
+     Returns the price of the bond maturing after the given time at every node of a level.
+     */
+    static std::vector<double> bondValues(Level& level, const double& maturity)
+    {
+        level.values.assign(level.rates.size(), 1.0);
+        sweep(level, 1, { maturity }, 0, [](const double&) {}, [](const std::size_t&) {});
+        return std::vector<double>(level.values.begin(), level.values.begin() + level.rates.size());
+    }
+
+    /*
+     Replaces payoffs g by the average of max(g, 0) over the cell of each node,
+     with g linear between nodes, so that a kink between two nodes enters the
+     grid at its true position rather than rounded to a node. Without this the
+     error of an option price depends on where the strike falls between nodes
+     and does not fall off as h^2.
+
+     @param level The level.
+     @param columns The number of columns of values.
+     @param firstColumn The first column holding a payoff; the rest up to columns do too.
+     */
+    static void averagePositiveParts(Level& level, const std::size_t& columns, const std::size_t& firstColumn)
+    {
+        // The average of max(g, 0) over a segment on which g runs linearly from first to second
+        auto segmentAverage = [](const double& first, const double& second)
+        {
+            if (first >= 0.0 && second >= 0.0)
+            {
+                return 0.5 * (first + second);
+            }
+            if (first <= 0.0 && second <= 0.0)
+            {
+                return 0.0;
+            }
+            double positive = std::max(first, second);
+            return 0.5 * positive * positive / (positive - std::min(first, second));
+        };
+
+        const std::vector<double>& rates = level.rates;
+        std::size_t nodes = rates.size();
+        for (std::size_t column = firstColumn; column < columns; ++column)
+        {
+            double previous = 0.0;
+            for (std::size_t node = 0; node < nodes; ++node)
+            {
+                double payoff = level.values[node * columns + column];
+                double weight = 0.0;
+                double integral = 0.0;
+                if (node > 0)
+                {
+                    double halfWidth = 0.5 * (rates[node] - rates[node - 1]);
+                    integral += halfWidth * segmentAverage(0.5 * (previous + payoff), payoff);
+                    weight += halfWidth;
+                }
+                if (node + 1 < nodes)
+                {
+                    double halfWidth = 0.5 * (rates[node + 1] - rates[node]);
+                    integral += halfWidth * segmentAverage(payoff, 0.5 * (payoff + level.values[(node + 1) * columns + column]));
+                    weight += halfWidth;
+                }
+                level.values[node * columns + column] = integral / weight;
+                previous = payoff;
+            }
+        }
+    }
+
+    static double exerciseValue(const BondOption& option, const double& bondPrice)
+    {
+        return std::max(option.call ? bondPrice - option.strike : option.strike - bondPrice, 0.0);
+    }
+
+    FiniteDifferenceSettings settings;
+    std::vector<Level> levels;
+};
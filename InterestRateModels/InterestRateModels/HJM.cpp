@@ -1,95 +1,117 @@
 #include <iostream>
-#include <cmath>
 #include <vector>
-#include <random>
-#include <fstream>
+
+#include "CsvWriter.h"
+#include "HeathJarrowMortonEngine.h"
+#include "ResultFile.h"
 
 /*
  Simulates the Heath-Jarrow-Morton (HJM) model.
  
- @param driftTerm The drift term of the HJM model.
- @param volatility The volatility of the HJM model.
+ Every path evolves the whole forward curve on the maturity grid, driven by
+ its own increments for each volatility factor. The drift follows from the
+ volatilities through the HJM no-arbitrage condition.
+
+ @param initialForwardCurve The initial forward curve f(0, T) of the HJM model.
+ @param maturities The maturity grid of the HJM model.
+ @param factors The volatility factors of the HJM model.
  @param timeHorizon The time horizon of the HJM model.
  @param timeStep The time step of the HJM model.
  @param numberOfPaths The number of paths to simulate.
- @param outputPath The path to the output CSV file.
+ @param seed The seed of the random number stream.
+ @param outputFormat The format of the output file.
+ @param outputPath The path to the output file.
  */
 void simulateHeathJarrowMortonModel(
-    const double& driftTerm,
-    const double& volatility,
+    const TimeCurve& initialForwardCurve,
+    const std::vector<double>& maturities,
+    const std::vector<HeathJarrowMortonFactor>& factors,
     const double& timeHorizon,
     const double& timeStep,
     const int& numberOfPaths,
+    const std::uint64_t& seed,
+    const OutputFormat& outputFormat,
     const std::string& outputPath) 
 {
-    // Set up random number generation
-    std::random_device randomDevice;
-    std::mt19937 randomGenerator(randomDevice());
-    std::normal_distribution<double> standardNormalDistribution(0.0, 1.0);
+    // Set up the model
+    HeathJarrowMortonModel model;
+    model.initialForwardCurve = initialForwardCurve;
+    model.maturities = maturities;
+    model.factors = factors;
 
-    // Calculate the number of time steps
-    int numberOfTimeSteps = static_cast<int>(timeHorizon / timeStep);
+    // Simulate the forward curves of every path
+    ForwardCurveStore forwardCurveStore = simulateForwardCurves(model, timeHorizon, timeStep, numberOfPaths, seed);
+    INTEREST_RATE_MODELS_PROFILE_SCOPE("output");
 
-    // Initialize vectors to store time and forward rate values
-    std::vector<double> timeValues(numberOfTimeSteps + 1);
-    std::vector<std::vector<double>> forwardRateValues(numberOfPaths, std::vector<double>(numberOfTimeSteps + 1));
-
-    // Simulate the HJM model
-    for (int i = 1; i <= numberOfTimeSteps; ++i) 
+    // Output the results to a binary result file
+    if (outputFormat == OutputFormat::Binary)
     {
-        // Update time
-        timeValues[i] = i * timeStep;
-
-        // Generate a random increment
-        double randomIncrement = standardNormalDistribution(randomGenerator);
-
-        // Update the forward rate using the HJM SDE
-        for (int path = 0; path < numberOfPaths; ++path) 
+        std::vector<ResultParameter> parameters;
+        for (std::size_t factor = 0; factor < factors.size(); ++factor)
         {
-            forwardRateValues[path][i] = forwardRateValues[path][i - 1] + driftTerm * timeStep + volatility * std::sqrt(timeStep) * randomIncrement;
+            parameters.push_back({ "volatility" + std::to_string(factor), factors[factor].volatility });
+            parameters.push_back({ "decayRate" + std::to_string(factor), factors[factor].decayRate });
         }
+        writeResultFile(outputPath, "HeathJarrowMorton", parameters, seed, forwardCurveStore);
+        return;
     }
 
-    // Output the results to a CSV file
-    std::ofstream outputFile(outputPath);
-    outputFile << "Time";
-    for (int path = 0; path < numberOfPaths; ++path) 
+    // Output the results to a CSV file, one curve per row
+    CsvWriter csvWriter(outputPath);
+    csvWriter.writeField("Time");
+    csvWriter.writeField("Path");
+    for (double maturity : forwardCurveStore.maturities) 
     {
-        outputFile << ",ForwardRate" << path + 1;
+        csvWriter.writeField("ForwardRate", maturity);
     }
-    outputFile << "\n";
-    for (int i = 0; i <= numberOfTimeSteps; ++i) 
+    csvWriter.endRow();
+    for (int i = 0; i < forwardCurveStore.numberOfRecords(); ++i) 
     {
-        outputFile << timeValues[i];
         for (int path = 0; path < numberOfPaths; ++path) 
         {
-            outputFile << "," << forwardRateValues[path][i];
+            csvWriter.writeField(forwardCurveStore.timeValues[i]);
+            csvWriter.writeField(path + 1);
+            const double* forwardCurve = forwardCurveStore.curve(i, path);
+            for (int maturity = 0; maturity < forwardCurveStore.numberOfMaturities; ++maturity) 
+            {
+                csvWriter.writeField(forwardCurve[maturity]);
+            }
+            csvWriter.endRow();
         }
-        outputFile << "\n";
     }
-    outputFile.close();
+    csvWriter.close();
 }
 
 int main() 
 {
     // Parameters for the HJM model
-    double driftTerm = 0.1;
-    double volatility = 0.02;
+    TimeCurve initialForwardCurve = TimeCurve::constant(0.03);
+    std::vector<double> maturities = { 0.25, 0.5, 1.0, 2.0, 3.0, 5.0, 7.0, 10.0 };
+    std::vector<HeathJarrowMortonFactor> factors = { { 0.01, 0.0 }, { 0.015, 0.5 } };
     double timeHorizon = 1.0;
     double timeStep = 0.01;
+    std::uint64_t seed = 42;
     int numberOfPaths = 5;
-    std::string outputPath = "hjm_simulation.csv";
+    std::uint64_t numberOfValues = (static_cast<std::uint64_t>(timeHorizon / timeStep) + 1) * numberOfPaths * maturities.size();
+    OutputFormat outputFormat = defaultOutputFormat(numberOfValues);
+    std::string outputPath = outputFileName("hjm_simulation", outputFormat);
 
     // Simulate the HJM model
     simulateHeathJarrowMortonModel(
-        driftTerm,
-        volatility,
+        initialForwardCurve,
+        maturities,
+        factors,
         timeHorizon,
         timeStep,
         numberOfPaths,
+        seed,
+        outputFormat,
         outputPath);
 
     std::cout << "Simulation completed. Results saved to " << outputPath << std::endl;
 
+    // Write the profiling report, if built with INTEREST_RATE_MODELS_PROFILING
+    INTEREST_RATE_MODELS_PROFILE_REPORT("hjm_profile.json", true);
+
     return 0;
 }
\ No newline at end of file
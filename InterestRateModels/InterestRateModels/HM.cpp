@@ -1,78 +1,48 @@
 #include <iostream>
-#include <cmath>
 #include <vector>
-#include <random>
-#include <fstream>
+
+#include "ShortRateSimulation.h"
 
 /*
  Simulates the Hull and White model.
  
  @param initialInterestRate The initial interest rate of the Hull and White model.
- @param thetaValues The deterministic function of time for the Hull and White model.
- @param alphaValues The deterministic function of time for the Hull and White model.
- @param sigmaValues The deterministic function of time for the Hull and White model.
+ @param thetaCurve The deterministic function of time for the Hull and White model.
+ @param alphaCurve The deterministic function of time for the Hull and White model.
+ @param sigmaCurve The deterministic function of time for the Hull and White model.
  @param timeHorizon The time horizon of the Hull and White model.
  @param timeStep The time step of the Hull and White model.
- @param outputPath The path to the output CSV file.
+ @param seed The seed of the random number stream.
+ @param outputFormat The format of the output file.
+ @param outputPath The path to the output file.
  */
 void simulateHullAndWhiteModel(
     const double& initialInterestRate,
-    const std::vector<double>& thetaValues,
-    const std::vector<double>& alphaValues,
-    const std::vector<double>& sigmaValues,
+    const TimeCurve& thetaCurve,
+    const TimeCurve& alphaCurve,
+    const TimeCurve& sigmaCurve,
     const double& timeHorizon,
     const double& timeStep,
+    const std::uint64_t& seed,
+    const OutputFormat& outputFormat,
     const std::string& outputPath) 
 {
-    // Set up random number generation
-    std::random_device randomDevice;
-    std::mt19937 randomGenerator(randomDevice());
-    std::normal_distribution<double> standardNormalDistribution(0.0, 1.0);
-
-    // Calculate the number of time steps
-    int numberOfTimeSteps = static_cast<int>(timeHorizon / timeStep);
-
-    // Initialize vectors to store time and interest rate values
-    std::vector<double> timeValues(numberOfTimeSteps + 1);
-    std::vector<double> interestRateValues(numberOfTimeSteps + 1);
-
-    // Initialize the initial interest rate
-    interestRateValues[0] = initialInterestRate;
-
-    // Simulate the Hull and White model
-    for (int i = 1; i <= numberOfTimeSteps; ++i) 
+    // Simulate a single path of the Hull and White model and write it out
+    HullWhiteModel model{ thetaCurve, alphaCurve, sigmaCurve, initialInterestRate };
+    std::vector<ResultParameter> parameters = { { "initialInterestRate", initialInterestRate } };
+    for (std::size_t knot = 0; knot < thetaCurve.values.size(); ++knot)
     {
-        // Update time
-        timeValues[i] = i * timeStep;
-
-        // Generate random increments
-        double randomIncrement = standardNormalDistribution(randomGenerator);
-
-        // Calculate the integral terms for the explicit solution
-        double integral1 = 0.0;
-        double integral2 = 0.0;
-        double integral3 = 0.0;
-
-        for (int j = 0; j < i; ++j) 
-        {
-            double u = j * timeStep;
-            integral1 += alphaValues[j] * timeStep;
-            integral2 += thetaValues[j] * std::exp(-integral1);
-            integral3 += sigmaValues[j] * std::exp(-integral1) * randomIncrement;
-        }
-
-        // Update the interest rate using the Hull and White SDE
-        interestRateValues[i] = initialInterestRate * std::exp(-integral1) + integral2 + integral3;
+        parameters.push_back({ "theta" + std::to_string(knot), thetaCurve.values[knot] });
     }
-
-    // Output the results to a CSV file
-    std::ofstream outputFile(outputPath);
-    outputFile << "Time,InterestRate\n";
-    for (int i = 0; i <= numberOfTimeSteps; ++i) 
+    for (std::size_t knot = 0; knot < alphaCurve.values.size(); ++knot)
     {
-        outputFile << timeValues[i] << "," << interestRateValues[i] << "\n";
+        parameters.push_back({ "alpha" + std::to_string(knot), alphaCurve.values[knot] });
     }
-    outputFile.close();
+    for (std::size_t knot = 0; knot < sigmaCurve.values.size(); ++knot)
+    {
+        parameters.push_back({ "sigma" + std::to_string(knot), sigmaCurve.values[knot] });
+    }
+    simulateShortRatePath(model, "HullAndWhite", parameters, timeHorizon, timeStep, seed, outputFormat, outputPath);
 }
 
 int main() 
@@ -82,21 +52,34 @@ int main()
     std::vector<double> thetaValues = { 0.03, 0.02, 0.025 };  // Replace with the desired deterministic function of time
     std::vector<double> alphaValues = { 0.01, 0.015, 0.012 };  // Replace with the desired deterministic function of time
     std::vector<double> sigmaValues = { 0.01, 0.015, 0.02 };    // Replace with the desired deterministic function of time
+    std::vector<double> curveTimes = { 0.0, 1.0 / 3.0, 2.0 / 3.0 };  // Times from which each value applies
     double timeHorizon = 1.0;
     double timeStep = 0.01;
-    std::string outputPath = "hull_and_white_simulation.csv";
+    std::uint64_t seed = 42;
+    OutputFormat outputFormat = defaultOutputFormat(static_cast<std::uint64_t>(timeHorizon / timeStep) + 1);
+    std::string outputPath = outputFileName("hull_and_white_simulation", outputFormat);
+
+    // Hold each value piecewise constant from its time onwards
+    TimeCurve thetaCurve{ curveTimes, thetaValues, CurveInterpolation::PiecewiseConstant };
+    TimeCurve alphaCurve{ curveTimes, alphaValues, CurveInterpolation::PiecewiseConstant };
+    TimeCurve sigmaCurve{ curveTimes, sigmaValues, CurveInterpolation::PiecewiseConstant };
 
     // Simulate the Hull and White model
     simulateHullAndWhiteModel(
         initialInterestRate,
-        thetaValues,
-        alphaValues,
-        sigmaValues,
+        thetaCurve,
+        alphaCurve,
+        sigmaCurve,
         timeHorizon,
         timeStep,
+        seed,
+        outputFormat,
         outputPath);
 
     std::cout << "Simulation completed. Results saved to " << outputPath << std::endl;
 
+    // Write the profiling report, if built with INTEREST_RATE_MODELS_PROFILING
+    INTEREST_RATE_MODELS_PROFILE_REPORT("hm_profile.json", true);
+
     return 0;
 }
\ No newline at end of file
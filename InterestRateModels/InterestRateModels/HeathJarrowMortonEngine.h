@@ -0,0 +1,617 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CounterRandom.h"
+#include "IncrementSource.h"
+#include "Profiling.h"
+#include "SimdMath.h"
+#include "SimulationContext.h"
+#include "ThreadPool.h"
+#include "TimeCurve.h"
+
+/*
+ Multi-factor Heath-Jarrow-Morton simulation of whole forward curves.
+
+ The state of a path is the forward curve f(t, T_j) on a fixed grid of
+ maturities T_j. Under the risk-neutral measure each forward moves as
+
+   df(t, T) = alpha(t, T) dt + sum_k sigma_k(t, T) dW_k(t)
+
+ with the no-arbitrage drift alpha(t, T) = sum_k sigma_k(t, T) * int_t^T sigma_k(t, u) du.
+ A forward whose maturity has passed is frozen at its last value, which is
+ the short rate observed at that maturity.
+ */
+
+/*
+ One volatility factor, sigma_k(t, T) = volatility * exp(-decayRate * (T - t)).
+
+ A decay rate of zero moves the whole curve in parallel (Ho-Lee); a positive
+ decay rate moves the short end more than the long end (Hull-White).
+ */
+struct HeathJarrowMortonFactor
+{
+    double volatility;
+    double decayRate;
+
+    /*
+     Returns the volatility of the forward with the given time to maturity.
+
+     @param timeToMaturity The time to maturity, at least zero.
+     */
+    double volatilityAt(const double& timeToMaturity) const
+    {
+        return volatility * std::exp(-decayRate * timeToMaturity);
+    }
+
+    /*
+     Returns this factor's share of the no-arbitrage drift, sigma(tau) * int_0^tau sigma(u) du.
+
+     @param timeToMaturity The time to maturity, at least zero.
+     */
+    double driftAt(const double& timeToMaturity) const
+    {
+        if (decayRate == 0.0)
+        {
+            return volatility * volatility * timeToMaturity;
+        }
+        double decay = std::exp(-decayRate * timeToMaturity);
+        return volatility * volatility * decay * (1.0 - decay) / decayRate;
+    }
+};
+
+/*
+ The inputs of a Heath-Jarrow-Morton simulation.
+ */
+struct HeathJarrowMortonModel
+{
+    TimeCurve initialForwardCurve;                  // f(0, T) as a function of T
+    std::vector<double> maturities;                 // the maturity grid T_j, in increasing order
+    std::vector<HeathJarrowMortonFactor> factors;   // the volatility factors
+};
+
+/*
+ Simulated forward curves, stored contiguously with the maturity index running fastest.
+
+ The curve of a path at a recorded step is one run of numberOfMaturities
+ values, the curves of all paths at a step are one slab, and the slabs follow
+ each other in time. Only every recordInterval-th step (and the last step) is
+ recorded, which keeps long daily simulations of many paths within memory.
+ */
+struct ForwardCurveStore
+{
+    int numberOfPaths = 0;
+    int numberOfMaturities = 0;
+    std::vector<double> maturities;
+    std::vector<double> timeValues;
+    std::vector<double> forwardRates;
+
+    /*
+     Returns the number of recorded steps, including the initial curve.
+     */
+    int numberOfRecords() const
+    {
+        return static_cast<int>(timeValues.size());
+    }
+
+    /*
+     Returns the forward curve of a path at a recorded step.
+
+     @param record The index of the recorded step.
+     @param path The index of the path.
+     */
+    double* curve(const int& record, const int& path)
+    {
+        return forwardRates.data() + (static_cast<std::size_t>(record) * numberOfPaths + path) * numberOfMaturities;
+    }
+
+    const double* curve(const int& record, const int& path) const
+    {
+        return forwardRates.data() + (static_cast<std::size_t>(record) * numberOfPaths + path) * numberOfMaturities;
+    }
+
+    /*
+     Returns one forward rate.
+
+     @param record The index of the recorded step.
+     @param path The index of the path.
+     @param maturity The index of the maturity.
+     */
+    double forwardRate(const int& record, const int& path, const int& maturity) const
+    {
+        return curve(record, path)[maturity];
+    }
+
+    // The store is a curve sink for simulateForwardCurves() that keeps every recorded curve
+
+    void beginSimulation(const std::vector<double>& recordTimes, const std::vector<double>& maturityGrid, const int& pathCount, const int&)
+    {
+        numberOfPaths = pathCount;
+        numberOfMaturities = static_cast<int>(maturityGrid.size());
+        maturities = maturityGrid;
+        timeValues = recordTimes;
+        forwardRates.assign(timeValues.size() * static_cast<std::size_t>(numberOfPaths) * numberOfMaturities, 0.0);
+    }
+
+    void observeRecord(const int&, const int& record, const int& firstPath, const double* curves, const int& pathCount)
+    {
+        std::copy(curves, curves + static_cast<std::size_t>(pathCount) * numberOfMaturities, curve(record, firstPath));
+    }
+
+    void endSimulation()
+    {
+    }
+};
+
+// Number of paths simulated together; their curves stay in cache across a step
+constexpr int forwardCurvePathBlockSize = 64;
+
+// Number of maturities updated together by the factor loading kernel
+constexpr int forwardCurveMaturityTileSize = 256;
+
+// Largest decay rate times maturity for which exp(-decayRate * T) is tabulated
+constexpr double forwardCurveMaximumDecayExponent = 600.0;
+
+/*
+ Tabulates exp(-decayRate_k * T_j) for every factor and maturity.
+
+ Since sigma_k(t, T_j) = volatility_k * exp(-decayRate_k * T_j) * exp(decayRate_k * t),
+ the step coefficients then need one exponential per factor instead of one
+ per factor and maturity. Factors whose exponent would underflow are marked
+ with a negative entry and evaluated directly.
+
+ @param model The model.
+ @param maturityDecays Receives the table, numberOfMaturities values per factor.
+ */
+inline void tabulateForwardCurveMaturityDecays(const HeathJarrowMortonModel& model, double* maturityDecays)
+{
+    std::size_t numberOfMaturities = model.maturities.size();
+    double lastMaturity = model.maturities.empty() ? 0.0 : model.maturities.back();
+    for (std::size_t factor = 0; factor < model.factors.size(); ++factor)
+    {
+        double decayRate = model.factors[factor].decayRate;
+        bool tabulated = std::abs(decayRate) * lastMaturity <= forwardCurveMaximumDecayExponent;
+        for (std::size_t maturity = 0; maturity < numberOfMaturities; ++maturity)
+        {
+            maturityDecays[factor * numberOfMaturities + maturity] = tabulated ? std::exp(-decayRate * model.maturities[maturity]) : -1.0;
+        }
+    }
+}
+
+/*
+ Returns the table of exp(-b_k T_j) described above.
+
+ @param model The model.
+ @return The table, numberOfMaturities values per factor.
+ */
+inline std::vector<double> tabulateForwardCurveMaturityDecays(const HeathJarrowMortonModel& model)
+{
+    std::vector<double> maturityDecays(model.factors.size() * model.maturities.size());
+    tabulateForwardCurveMaturityDecays(model, maturityDecays.data());
+    return maturityDecays;
+}
+
+/*
+ Computes the drift and the factor loadings of every maturity for one step.
+
+ @param model The model.
+ @param maturityDecays The table from tabulateForwardCurveMaturityDecays().
+ @param startTime The start of the step.
+ @param timeStep The length of the step.
+ @param drifts Receives alpha(t, T_j) * timeStep for every maturity.
+ @param loadings Receives sigma_k(t, T_j) * sqrt(timeStep), numberOfMaturities values per factor.
+ */
+inline void computeForwardCurveStepCoefficients(
+    const HeathJarrowMortonModel& model,
+    const double* maturityDecays,
+    const double& startTime,
+    const double& timeStep,
+    double* drifts,
+    double* loadings)
+{
+    int numberOfMaturities = static_cast<int>(model.maturities.size());
+    double squareRootTimeStep = std::sqrt(timeStep);
+    std::fill(drifts, drifts + numberOfMaturities, 0.0);
+    if (numberOfMaturities == 0)
+    {
+        return;
+    }
+
+    // Matured forwards no longer move
+    int firstLiveMaturity = static_cast<int>(std::upper_bound(model.maturities.begin(), model.maturities.end(), startTime) - model.maturities.begin());
+
+    for (std::size_t factor = 0; factor < model.factors.size(); ++factor)
+    {
+        const HeathJarrowMortonFactor& volatilityFactor = model.factors[factor];
+        const double* factorDecays = maturityDecays + factor * numberOfMaturities;
+        double* factorLoadings = loadings + factor * numberOfMaturities;
+        std::fill(factorLoadings, factorLoadings + firstLiveMaturity, 0.0);
+
+        if (factorDecays[0] < 0.0 || volatilityFactor.decayRate == 0.0)
+        {
+            for (int maturity = firstLiveMaturity; maturity < numberOfMaturities; ++maturity)
+            {
+                double timeToMaturity = model.maturities[maturity] - startTime;
+                factorLoadings[maturity] = volatilityFactor.volatilityAt(timeToMaturity) * squareRootTimeStep;
+                drifts[maturity] += volatilityFactor.driftAt(timeToMaturity) * timeStep;
+            }
+            continue;
+        }
+
+        // decay = exp(-decayRate * (T_j - t)), drift = volatility^2 * decay * (1 - decay) / decayRate
+        double growth = std::exp(volatilityFactor.decayRate * startTime);
+        double loadingScale = volatilityFactor.volatility * squareRootTimeStep;
+        double driftScale = volatilityFactor.volatility * volatilityFactor.volatility / volatilityFactor.decayRate * timeStep;
+        for (int maturity = firstLiveMaturity; maturity < numberOfMaturities; ++maturity)
+        {
+            double decay = factorDecays[maturity] * growth;
+            factorLoadings[maturity] = loadingScale * decay;
+            drifts[maturity] += driftScale * decay * (1.0 - decay);
+        }
+    }
+}
+
+#if defined(INTEREST_RATE_MODELS_X86_SIMD)
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+INTEREST_RATE_MODELS_TARGET_AVX2 inline int applyForwardCurveLoadingsAvx2(
+    double* curve,
+    const int& firstMaturity,
+    const int& lastMaturity,
+    const int& numberOfMaturities,
+    const double* drifts,
+    const double* loadings,
+    const int& numberOfFactors,
+    const double* normals)
+{
+    int maturity = firstMaturity;
+    for (; maturity + 4 <= lastMaturity; maturity += 4)
+    {
+        __m256d forwardRates = _mm256_add_pd(_mm256_loadu_pd(curve + maturity), _mm256_loadu_pd(drifts + maturity));
+        for (int factor = 0; factor < numberOfFactors; ++factor)
+        {
+            __m256d factorLoadings = _mm256_loadu_pd(loadings + static_cast<std::size_t>(factor) * numberOfMaturities + maturity);
+            forwardRates = _mm256_fmadd_pd(_mm256_set1_pd(normals[factor]), factorLoadings, forwardRates);
+        }
+        _mm256_storeu_pd(curve + maturity, forwardRates);
+    }
+    return maturity;
+}
+
+INTEREST_RATE_MODELS_TARGET_AVX512 inline int applyForwardCurveLoadingsAvx512(
+    double* curve,
+    const int& firstMaturity,
+    const int& lastMaturity,
+    const int& numberOfMaturities,
+    const double* drifts,
+    const double* loadings,
+    const int& numberOfFactors,
+    const double* normals)
+{
+    int maturity = firstMaturity;
+    for (; maturity + 8 <= lastMaturity; maturity += 8)
+    {
+        __m512d forwardRates = _mm512_add_pd(_mm512_loadu_pd(curve + maturity), _mm512_loadu_pd(drifts + maturity));
+        for (int factor = 0; factor < numberOfFactors; ++factor)
+        {
+            __m512d factorLoadings = _mm512_loadu_pd(loadings + static_cast<std::size_t>(factor) * numberOfMaturities + maturity);
+            forwardRates = _mm512_fmadd_pd(_mm512_set1_pd(normals[factor]), factorLoadings, forwardRates);
+        }
+        _mm512_storeu_pd(curve + maturity, forwardRates);
+    }
+    return maturity;
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+/*
+ Advances the forward curves of a block of paths across one step.
+
+ This is the update F += 1 * drift^T + Z * L, where F is the block of curves
+ (paths x maturities), Z the normals (paths x factors) and L the loadings
+ (factors x maturities). The maturities are processed in tiles so that the
+ loadings of a tile stay in cache while every path of the block goes past,
+ and each forward is loaded and stored once whatever the number of factors.
+
+ @param curves The curves of the block, one run of numberOfMaturities values per path.
+ @param numberOfPaths The number of paths in the block.
+ @param numberOfMaturities The number of maturities.
+ @param drifts The drift of every maturity over the step.
+ @param loadings The loadings, numberOfMaturities values per factor.
+ @param numberOfFactors The number of factors.
+ @param normals The normals, one row of numberOfPaths values per factor.
+ @param pathNormals Scratch space for the numberOfFactors normals of one path.
+ */
+inline void applyForwardCurveLoadings(
+    double* curves,
+    const int& numberOfPaths,
+    const int& numberOfMaturities,
+    const double* drifts,
+    const double* loadings,
+    const int& numberOfFactors,
+    const double* const* normals,
+    double* pathNormals)
+{
+    SimdLevel level = activeSimdLevel();
+    for (int tileStart = 0; tileStart < numberOfMaturities; tileStart += forwardCurveMaturityTileSize)
+    {
+        int tileEnd = std::min(numberOfMaturities, tileStart + forwardCurveMaturityTileSize);
+        for (int path = 0; path < numberOfPaths; ++path)
+        {
+            double* curve = curves + static_cast<std::size_t>(path) * numberOfMaturities;
+            for (int factor = 0; factor < numberOfFactors; ++factor)
+            {
+                pathNormals[factor] = normals[factor][path];
+            }
+
+            int maturity = tileStart;
+#if defined(INTEREST_RATE_MODELS_X86_SIMD)
+            if (level == SimdLevel::Avx512)
+            {
+                maturity = applyForwardCurveLoadingsAvx512(curve, maturity, tileEnd, numberOfMaturities, drifts, loadings, numberOfFactors, pathNormals);
+            }
+            else if (level == SimdLevel::Avx2)
+            {
+                maturity = applyForwardCurveLoadingsAvx2(curve, maturity, tileEnd, numberOfMaturities, drifts, loadings, numberOfFactors, pathNormals);
+            }
+#else
+            (void)level;
+#endif
+            for (; maturity < tileEnd; ++maturity)
+            {
+                double forwardRate = curve[maturity] + drifts[maturity];
+                for (int factor = 0; factor < numberOfFactors; ++factor)
+                {
+                    forwardRate += pathNormals[factor] * loadings[static_cast<std::size_t>(factor) * numberOfMaturities + maturity];
+                }
+                curve[maturity] = forwardRate;
+            }
+        }
+    }
+}
+
+/*
+ Simulates forward curves with an Euler scheme, spreading blocks of paths over a thread pool.
+
+ The increments of every factor come from an increment source (see
+ IncrementSource.h), asked for numberOfFactors factors. The curves at the initial step, every recordInterval-th step and
+ the last step are handed to a sink, which provides
+   beginSimulation(recordTimes, maturities, numberOfPaths, numberOfThreads)
+   observeRecord(threadIndex, recordIndex, firstPath, curves, numberOfPaths)
+   endSimulation()
+ with the same threading rules as the sinks of simulatePaths().
+
+ @param model The model.
+ @param timeHorizon The time horizon of the simulation.
+ @param timeStep The time step of the simulation.
+ @param numberOfPaths The number of paths to simulate.
+ @param incrementSource The source of the standard normal increments.
+ @param recordInterval The number of steps between recorded curves.
+ @param sink Receives the recorded curves, for example a ForwardCurveStore.
+ @param context The thread pool and the buffers reused between calls.
+ */
+template <typename IncrementSource, typename Sink>
+void simulateForwardCurves(
+    const HeathJarrowMortonModel& model,
+    const double& timeHorizon,
+    const double& timeStep,
+    const int& numberOfPaths,
+    IncrementSource& incrementSource,
+    const int& recordInterval,
+    Sink& sink,
+    SimulationContext& context)
+{
+    INTEREST_RATE_MODELS_PROFILE_SCOPE("simulate");
+    context.beginSimulation();
+    ThreadPool& threadPool = context.threadPool;
+    BufferArena& arena = context.arena;
+
+    // Calculate the number of time steps
+    int numberOfTimeSteps = static_cast<int>(timeHorizon / timeStep);
+    int numberOfMaturities = static_cast<int>(model.maturities.size());
+    int numberOfFactors = static_cast<int>(model.factors.size());
+    int interval = std::max(1, recordInterval);
+
+    // Record the initial curve, every interval-th step and the last step
+    int* recordOfStep = arena.allocate<int>(static_cast<std::size_t>(numberOfTimeSteps) + 1);
+    std::vector<double>& recordTimes = context.recordTimes;
+    recordTimes.clear();
+    for (int i = 0; i <= numberOfTimeSteps; ++i)
+    {
+        recordOfStep[i] = -1;
+        if (i % interval == 0 || i == numberOfTimeSteps)
+        {
+            recordOfStep[i] = static_cast<int>(recordTimes.size());
+            recordTimes.push_back(i * timeStep);
+        }
+    }
+    sink.beginSimulation(recordTimes, model.maturities, numberOfPaths, threadPool.numberOfThreads());
+    incrementSource.prepare(numberOfTimeSteps, numberOfFactors, forwardCurvePathBlockSize, threadPool.numberOfThreads());
+
+    double* maturityDecays = arena.allocate<double>(static_cast<std::size_t>(numberOfFactors) * numberOfMaturities);
+    tabulateForwardCurveMaturityDecays(model, maturityDecays);
+    double* initialCurve = arena.allocate<double>(static_cast<std::size_t>(numberOfMaturities));
+    for (int maturity = 0; maturity < numberOfMaturities; ++maturity)
+    {
+        initialCurve[maturity] = model.initialForwardCurve.valueAt(model.maturities[maturity]);
+    }
+
+    // Per-thread scratch: the block's curves, one path's normals, the drifts and the loadings, a cache line apart
+    std::size_t curveScratchSize = static_cast<std::size_t>(forwardCurvePathBlockSize) * numberOfMaturities;
+    std::size_t normalScratchSize = static_cast<std::size_t>(numberOfFactors);
+    std::size_t coefficientScratchSize = static_cast<std::size_t>(1 + numberOfFactors) * numberOfMaturities;
+    std::size_t doublesPerLine = arenaBufferAlignment / sizeof(double);
+    std::size_t threadScratchSize = (curveScratchSize + normalScratchSize + coefficientScratchSize + doublesPerLine - 1) / doublesPerLine * doublesPerLine;
+    double* scratch = arena.allocate<double>(static_cast<std::size_t>(threadPool.numberOfThreads()) * threadScratchSize);
+    const double** normalRows = arena.allocate<const double*>(static_cast<std::size_t>(threadPool.numberOfThreads()) * numberOfFactors);
+
+    auto simulateBlock = [&](int blockIndex, int threadIndex)
+    {
+        int firstPath = blockIndex * forwardCurvePathBlockSize;
+        int blockPaths = std::min(forwardCurvePathBlockSize, numberOfPaths - firstPath);
+        double* curves = scratch + static_cast<std::size_t>(threadIndex) * threadScratchSize;
+        double* pathNormals = curves + curveScratchSize;
+        double* drifts = pathNormals + normalScratchSize;
+        double* loadings = drifts + numberOfMaturities;
+        const double** factorNormals = normalRows + static_cast<std::size_t>(threadIndex) * numberOfFactors;
+        INTEREST_RATE_MODELS_PROFILE_LAP_BEGIN(lapTimer);
+        INTEREST_RATE_MODELS_PROFILE_COUNT(Paths, blockPaths);
+        INTEREST_RATE_MODELS_PROFILE_COUNT(Steps, static_cast<std::uint64_t>(blockPaths) * numberOfTimeSteps);
+        incrementSource.beginBlock(threadIndex, firstPath, blockPaths);
+        INTEREST_RATE_MODELS_PROFILE_LAP(lapTimer, "increments");
+
+        // Start every path from the initial curve
+        for (int path = 0; path < blockPaths; ++path)
+        {
+            std::copy(initialCurve, initialCurve + numberOfMaturities, curves + static_cast<std::size_t>(path) * numberOfMaturities);
+        }
+        sink.observeRecord(threadIndex, 0, firstPath, curves, blockPaths);
+        INTEREST_RATE_MODELS_PROFILE_LAP(lapTimer, "sink");
+
+        for (int i = 1; i <= numberOfTimeSteps; ++i)
+        {
+            // Fetch the increments of every factor for this step
+            for (int factor = 0; factor < numberOfFactors; ++factor)
+            {
+                factorNormals[factor] = incrementSource.increments(threadIndex, i, factor);
+            }
+            INTEREST_RATE_MODELS_PROFILE_LAP(lapTimer, "increments");
+
+            // Evaluate the coefficients at the start of the step and move the curves
+            computeForwardCurveStepCoefficients(model, maturityDecays, (i - 1) * timeStep, timeStep, drifts, loadings);
+            applyForwardCurveLoadings(curves, blockPaths, numberOfMaturities, drifts, loadings, numberOfFactors, factorNormals, pathNormals);
+            INTEREST_RATE_MODELS_PROFILE_LAP(lapTimer, "advance");
+
+            if (recordOfStep[i] >= 0)
+            {
+                sink.observeRecord(threadIndex, recordOfStep[i], firstPath, curves, blockPaths);
+                INTEREST_RATE_MODELS_PROFILE_LAP(lapTimer, "sink");
+            }
+        }
+    };
+
+    int numberOfBlocks = (numberOfPaths + forwardCurvePathBlockSize - 1) / forwardCurvePathBlockSize;
+    threadPool.parallelFor(numberOfBlocks, simulateBlock);
+    sink.endSimulation();
+}
+
+/*
+ Simulates forward curves with a fresh context on a thread pool.
+
+ @param model The model.
+ @param timeHorizon The time horizon of the simulation.
+ @param timeStep The time step of the simulation.
+ @param numberOfPaths The number of paths to simulate.
+ @param incrementSource The source of the standard normal increments.
+ @param recordInterval The number of steps between recorded curves.
+ @param sink Receives the recorded curves, for example a ForwardCurveStore.
+ @param threadPool The pool to run the path blocks on.
+ */
+template <typename IncrementSource, typename Sink>
+void simulateForwardCurves(
+    const HeathJarrowMortonModel& model,
+    const double& timeHorizon,
+    const double& timeStep,
+    const int& numberOfPaths,
+    IncrementSource& incrementSource,
+    const int& recordInterval,
+    Sink& sink,
+    ThreadPool& threadPool)
+{
+    SimulationContext context(threadPool);
+    simulateForwardCurves(model, timeHorizon, timeStep, numberOfPaths, incrementSource, recordInterval, sink, context);
+}
+
+/*
+ Simulates forward curves with pseudo-random increments.
+
+ Factor k of a path draws its increments from substream k of the path's
+ counter-based stream, so the results do not depend on the number of
+ threads.
+
+ @param model The model.
+ @param timeHorizon The time horizon of the simulation.
+ @param timeStep The time step of the simulation.
+ @param numberOfPaths The number of paths to simulate.
+ @param seed The seed of the random number streams.
+ @param recordInterval The number of steps between recorded curves.
+ @param sink Receives the recorded curves, for example a ForwardCurveStore.
+ @param threadPool The pool to run the path blocks on.
+ */
+template <typename Sink>
+void simulateForwardCurves(
+    const HeathJarrowMortonModel& model,
+    const double& timeHorizon,
+    const double& timeStep,
+    const int& numberOfPaths,
+    const std::uint64_t& seed,
+    const int& recordInterval,
+    Sink& sink,
+    ThreadPool& threadPool = defaultThreadPool())
+{
+    CounterIncrementSource incrementSource(seed);
+    simulateForwardCurves(model, timeHorizon, timeStep, numberOfPaths, incrementSource, recordInterval, sink, threadPool);
+}
+
+/*
+ Simulates forward curves with pseudo-random increments, reusing the buffers of a context.
+
+ Once the sink and context have held a run this large, a call into a
+ reused ForwardCurveStore makes no heap allocations.
+
+ @param model The model.
+ @param timeHorizon The time horizon of the simulation.
+ @param timeStep The time step of the simulation.
+ @param numberOfPaths The number of paths to simulate.
+ @param seed The seed of the random number streams.
+ @param recordInterval The number of steps between recorded curves.
+ @param sink Receives the recorded curves, for example a ForwardCurveStore.
+ @param context The thread pool and the buffers reused between calls.
+ */
+template <typename Sink>
+void simulateForwardCurves(
+    const HeathJarrowMortonModel& model,
+    const double& timeHorizon,
+    const double& timeStep,
+    const int& numberOfPaths,
+    const std::uint64_t& seed,
+    const int& recordInterval,
+    Sink& sink,
+    SimulationContext& context)
+{
+    simulateForwardCurves(model, timeHorizon, timeStep, numberOfPaths, context.counterIncrementSource(seed), recordInterval, sink, context);
+}
+
+/*
+ Simulates forward curves and returns them, recording every step.
+
+ @param model The model.
+ @param timeHorizon The time horizon of the simulation.
+ @param timeStep The time step of the simulation.
+ @param numberOfPaths The number of paths to simulate.
+ @param seed The seed of the random number streams.
+ @return The simulated curves.
+ */
+inline ForwardCurveStore simulateForwardCurves(
+    const HeathJarrowMortonModel& model,
+    const double& timeHorizon,
+    const double& timeStep,
+    const int& numberOfPaths,
+    const std::uint64_t& seed)
+{
+    ForwardCurveStore forwardCurveStore;
+    simulateForwardCurves(model, timeHorizon, timeStep, numberOfPaths, seed, 1, forwardCurveStore);
+    return forwardCurveStore;
+}
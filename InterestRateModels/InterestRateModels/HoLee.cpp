@@ -1,8 +1,7 @@
 #include <iostream>
-#include <cmath>
 #include <vector>
-#include <random>
-#include <fstream>
+
+#include "ShortRateSimulation.h"
 
 /*
  Simulates the Ho and Lee model.
@@ -11,7 +10,9 @@
  @param volatility The volatility of the Ho and Lee model.
  @param timeHorizon The time horizon of the Ho and Lee model.
  @param timeStep The time step of the Ho and Lee model.
- @param outputPath The path to the output CSV file.
+ @param seed The seed of the random number streams.
+ @param outputFormat The format of the output file.
+ @param outputPath The path to the output file.
  */
 
 void simulateHoAndLeeModel(
@@ -19,44 +20,17 @@ void simulateHoAndLeeModel(
     const double& volatility,
     const double& timeHorizon,
     const double& timeStep,
+    const std::uint64_t& seed,
+    const OutputFormat& outputFormat,
     const std::string& outputPath) 
 {
-    // Set up random number generation
-    std::random_device randomDevice;
-    std::mt19937 randomGenerator(randomDevice());
-    std::normal_distribution<double> standardNormalDistribution(0.0, 1.0);
-
-    // Calculate the number of time steps
-    int numberOfTimeSteps = static_cast<int>(timeHorizon / timeStep);
-
-    // Initialize vectors to store time and interest rate values
-    std::vector<double> timeValues(numberOfTimeSteps + 1);
-    std::vector<double> interestRateValues(numberOfTimeSteps + 1);
-
-    // Initialize the initial interest rate
-    interestRateValues[0] = 0.0;
-
-    // Simulate the Ho and Lee model
-    for (int i = 1; i <= numberOfTimeSteps; ++i) 
-    {
-        // Update time
-        timeValues[i] = i * timeStep;
-
-        // Generate a random increment
-        double randomIncrement = standardNormalDistribution(randomGenerator);
-
-        // Update the interest rate using the Ho and Lee SDE
-        interestRateValues[i] = interestRateValues[i - 1] + driftTerm * timeValues[i] * timeStep + volatility * std::sqrt(timeStep) * randomIncrement;
-    }
-
-    // Output the results to a CSV file
-    std::ofstream outputFile(outputPath);
-    outputFile << "Time,InterestRate\n";
-    for (int i = 0; i <= numberOfTimeSteps; ++i) 
-    {
-        outputFile << timeValues[i] << "," << interestRateValues[i] << "\n";
-    }
-    outputFile.close();
+    // Simulate a single path of the Ho and Lee model and write it out
+    HoAndLeeModel model{ driftTerm, volatility, 0.0 };
+    std::vector<ResultParameter> parameters = {
+        { "driftTerm", driftTerm },
+        { "volatility", volatility }
+    };
+    simulateShortRatePath(model, "HoAndLee", parameters, timeHorizon, timeStep, seed, outputFormat, outputPath);
 }
 
 int main() 
@@ -66,7 +40,9 @@ int main()
     double volatility = 0.01;
     double timeHorizon = 1.0;
     double timeStep = 0.01;
-    std::string outputPath = "ho_and_lee_simulation.csv";
+    std::uint64_t seed = 42;
+    OutputFormat outputFormat = defaultOutputFormat(static_cast<std::uint64_t>(timeHorizon / timeStep) + 1);
+    std::string outputPath = outputFileName("ho_and_lee_simulation", outputFormat);
 
     // Simulate the Ho and Lee model
     simulateHoAndLeeModel(
@@ -74,9 +50,14 @@ int main()
         volatility,
         timeHorizon,
         timeStep,
+        seed,
+        outputFormat,
         outputPath);
 
     std::cout << "Simulation completed. Results saved to " << outputPath << std::endl;
 
+    // Write the profiling report, if built with INTEREST_RATE_MODELS_PROFILING
+    INTEREST_RATE_MODELS_PROFILE_REPORT("holee_profile.json", true);
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "BrownianBridge.h"
+#include "CounterRandom.h"
+#include "NormalGenerator.h"
+#include "Profiling.h"
+#include "SobolSequence.h"
+
+/*
+ Sources of the standard normal increments that drive the path engines.
+
+ An engine simulates paths in blocks and asks its source for the increments
+ of a block one step at a time. A source provides
+   prepare(numberOfTimeSteps, numberOfFactors, maximumBlockPaths, numberOfThreads)
+   beginBlock(threadIndex, firstPath, numberOfPaths)
+   increments(threadIndex, stepIndex, factor)
+ increments() returns one standard normal per path of the block for step
+ stepIndex (1..numberOfTimeSteps) and the given factor. Within a block the
+ engine asks for the steps in increasing order, and for every factor of a
+ step before moving on. The returned row stays valid until the next call
+ for the same thread and factor.
+ */
+
+/*
+ Pseudo-random increments from the counter-based Philox streams.
+
+ Factor k of a path uses substream k of the path's stream, and each pair of
+ steps is drawn in one pass over the block, so the increments do not depend
+ on how the paths are split into blocks or threads. They are keyed by the
+ step, so a block may also start at a later step, as when paths resume from
+ a checkpoint, and still see the increments of an uninterrupted run.
+ */
+class CounterIncrementSource
+{
+public:
+    /*
+     @param sourceSeed The seed of the random number streams.
+     */
+    explicit CounterIncrementSource(const std::uint64_t& sourceSeed)
+        : seed(sourceSeed)
+    {
+    }
+
+    /*
+     Switches to the streams of another seed, keeping the buffers.
+
+     @param sourceSeed The seed of the random number streams.
+     */
+    void reseed(const std::uint64_t& sourceSeed)
+    {
+        seed = sourceSeed;
+    }
+
+    void prepare(const int&, const int& sourceFactors, const int& sourceBlockPaths, const int& numberOfThreads)
+    {
+        numberOfFactors = sourceFactors;
+        maximumBlockPaths = sourceBlockPaths;
+        threadSize = static_cast<std::size_t>(2) * numberOfFactors * maximumBlockPaths;
+        scratch.resize(static_cast<std::size_t>(numberOfThreads) * threadSize);
+        blocks.resize(static_cast<std::size_t>(numberOfThreads));
+    }
+
+    void beginBlock(const int& threadIndex, const int& firstPath, const int& numberOfPaths)
+    {
+        blocks[threadIndex].firstPath = firstPath;
+        blocks[threadIndex].numberOfPaths = numberOfPaths;
+        blocks[threadIndex].pairIndex = -1;
+    }
+
+    const double* increments(const int& threadIndex, const int& stepIndex, const int& factor)
+    {
+        Block& block = blocks[threadIndex];
+        double* evenIncrements = scratch.data() + static_cast<std::size_t>(threadIndex) * threadSize + static_cast<std::size_t>(2 * factor) * maximumBlockPaths;
+        double* oddIncrements = evenIncrements + maximumBlockPaths;
+
+        // Generate increments for this step and the next in one pass; a block
+        // resumed at an odd step generates the pair it starts in
+        int incrementIndex = stepIndex - 1;
+        if (incrementIndex % 2 == 0 || block.pairIndex != incrementIndex / 2)
+        {
+            INTEREST_RATE_MODELS_PROFILE_COUNT(RandomDraws, 2 * block.numberOfPaths);
+            fillIncrementPair(seed, static_cast<std::uint32_t>(factor), static_cast<std::uint32_t>(incrementIndex / 2), static_cast<std::uint64_t>(block.firstPath), block.numberOfPaths, evenIncrements, oddIncrements);
+            if (factor == numberOfFactors - 1)
+            {
+                block.pairIndex = incrementIndex / 2;
+            }
+        }
+        return incrementIndex % 2 == 0 ? evenIncrements : oddIncrements;
+    }
+
+private:
+    struct Block
+    {
+        int firstPath = 0;
+        int numberOfPaths = 0;
+        int pairIndex = -1;  // the pair of steps whose increments were generated last
+    };
+
+    std::uint64_t seed;
+    int numberOfFactors = 0;
+    int maximumBlockPaths = 0;
+    std::size_t threadSize = 0;
+    std::vector<double> scratch;
+    std::vector<Block> blocks;
+};
+
+/*
+ Quasi-random increments from scrambled Sobol points and a Brownian bridge.
+
+ Path p is Sobol point p, with one dimension per step and factor: the
+ Brownian bridge of factor k takes its normals, most important first, from
+ dimensions k, numberOfFactors + k, 2 numberOfFactors + k, ..., so every
+ factor gets leading dimensions. The whole block is built in beginBlock(),
+ which keeps numberOfTimeSteps * numberOfFactors rows of increments per
+ thread; with very fine grids it pays to use a coarser one or an exact
+ scheme. The same path index always gets the same point, so the results do
+ not depend on the number of threads.
+
+ Auxiliary draws of exact schemes still come from the counter-based streams.
+ */
+class SobolIncrementSource
+{
+public:
+    /*
+     @param scrambleSeed The seed of the scrambling; each seed gives an independent randomized replicate.
+     @param scrambled Whether to scramble the points. Unscrambled runs skip point zero, which maps to an infinite normal.
+     */
+    explicit SobolIncrementSource(const std::uint64_t& scrambleSeed, const bool& scrambled = true)
+        : seed(scrambleSeed), scramble(scrambled)
+    {
+    }
+
+    void prepare(const int& numberOfTimeSteps, const int& sourceFactors, const int& sourceBlockPaths, const int& numberOfThreads)
+    {
+        numberOfSteps = numberOfTimeSteps;
+        numberOfFactors = sourceFactors;
+        maximumBlockPaths = sourceBlockPaths;
+
+        int numberOfDimensions = numberOfSteps * numberOfFactors;
+        if (sequence.dimensions() != numberOfDimensions)
+        {
+            sequence = SobolSequence(numberOfDimensions);
+        }
+        if (bridge.steps() != numberOfSteps)
+        {
+            bridge = BrownianBridge(numberOfSteps);
+        }
+        dimensionSeeds.resize(static_cast<std::size_t>(numberOfDimensions));
+        for (int dimension = 0; dimension < numberOfDimensions; ++dimension)
+        {
+            dimensionSeeds[dimension] = static_cast<std::uint32_t>(sobolHash(seed ^ sobolHash(static_cast<std::uint64_t>(dimension))));
+        }
+
+        // The first points of every dimension, enough to cover an aligned block
+        prefixSize = 1;
+        while (prefixSize < maximumBlockPaths)
+        {
+            prefixSize *= 2;
+        }
+        prefixCoordinates.resize(static_cast<std::size_t>(numberOfDimensions) * prefixSize);
+        for (int dimension = 0; dimension < numberOfDimensions; ++dimension)
+        {
+            sequence.fillCoordinates(dimension, 0, prefixSize, prefixCoordinates.data() + static_cast<std::size_t>(dimension) * prefixSize);
+        }
+
+        threadSize = static_cast<std::size_t>(numberOfDimensions) * maximumBlockPaths;
+        scratch.resize(static_cast<std::size_t>(numberOfThreads) * threadSize);
+        coordinates.resize(static_cast<std::size_t>(numberOfThreads) * maximumBlockPaths);
+    }
+
+    void beginBlock(const int& threadIndex, const int& firstPath, const int& numberOfPaths)
+    {
+        double* rows = scratch.data() + static_cast<std::size_t>(threadIndex) * threadSize;
+        std::uint32_t* blockCoordinates = coordinates.data() + static_cast<std::size_t>(threadIndex) * maximumBlockPaths;
+        std::uint64_t firstIndex = static_cast<std::uint64_t>(firstPath) + (scramble ? 0 : 1);
+        bool alignedBlock = firstIndex % static_cast<std::uint64_t>(prefixSize) == 0 && numberOfPaths <= prefixSize;
+        INTEREST_RATE_MODELS_PROFILE_COUNT(RandomDraws, static_cast<std::uint64_t>(numberOfFactors) * numberOfSteps * numberOfPaths);
+
+        for (int factor = 0; factor < numberOfFactors; ++factor)
+        {
+            double* factorRows = rows + static_cast<std::size_t>(factor) * numberOfSteps * maximumBlockPaths;
+            for (int constructionStep = 0; constructionStep < numberOfSteps; ++constructionStep)
+            {
+                // Place the normals of each construction step in the row of the point it fixes
+                int dimension = constructionStep * numberOfFactors + factor;
+                double* row = factorRows + static_cast<std::size_t>(bridge.pointOf(constructionStep)) * maximumBlockPaths;
+                if (alignedBlock)
+                {
+                    // The Gray code is linear, so point firstIndex + k is point firstIndex XOR point k
+                    std::uint32_t firstCoordinate;
+                    sequence.fillCoordinates(dimension, firstIndex, 1, &firstCoordinate);
+                    const std::uint32_t* prefix = prefixCoordinates.data() + static_cast<std::size_t>(dimension) * prefixSize;
+                    fillSobolUniforms(prefix, firstCoordinate, dimensionSeeds[dimension], scramble, numberOfPaths, row);
+                }
+                else
+                {
+                    sequence.fillCoordinates(dimension, firstIndex, numberOfPaths, blockCoordinates);
+                    fillSobolUniforms(blockCoordinates, 0, dimensionSeeds[dimension], scramble, numberOfPaths, row);
+                }
+                uniformsToStandardNormals(row, static_cast<std::size_t>(numberOfPaths));
+            }
+            bridge.buildIncrements(factorRows, static_cast<std::size_t>(maximumBlockPaths), numberOfPaths);
+        }
+    }
+
+    const double* increments(const int& threadIndex, const int& stepIndex, const int& factor)
+    {
+        std::size_t row = static_cast<std::size_t>(factor) * numberOfSteps + static_cast<std::size_t>(stepIndex - 1);
+        return scratch.data() + static_cast<std::size_t>(threadIndex) * threadSize + row * maximumBlockPaths;
+    }
+
+private:
+    std::uint64_t seed;
+    bool scramble;
+    int numberOfSteps = 0;
+    int numberOfFactors = 0;
+    int maximumBlockPaths = 0;
+    SobolSequence sequence;
+    BrownianBridge bridge;
+    std::vector<std::uint32_t> dimensionSeeds;
+    int prefixSize = 1;
+    std::vector<std::uint32_t> prefixCoordinates;
+    std::size_t threadSize = 0;
+    std::vector<double> scratch;
+    std::vector<std::uint32_t> coordinates;
+};
@@ -0,0 +1,359 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+#include "SimdMath.h"
+
+/*
+ Bulk conversion of uniforms to standard normal variates.
+
+ Normals are produced by the inverse normal CDF (Wichura's algorithm AS241,
+ accurate to about 1e-16), which maps one uniform to one normal with no
+ rejection. That keeps the draw count fixed, which the counter-based streams
+ and quasi-random points rely on.
+
+ Arrays are converted 4 or 8 values at a time with AVX2 or AVX-512 when the
+ CPU has them: the central rational approximation is applied to every lane,
+ and the tail approximation (about 15% of draws, which need a log and a
+ square root) only when a vector contains a tail lane. The scalar fallback
+ converts in two passes with the same split.
+ */
+
+/*
+ Rational approximation of the inverse normal CDF for |uniform - 0.5| <= 0.425.
+
+ @param centredUniform The uniform minus 0.5.
+ @return The standard normal quantile.
+ */
+inline double inverseStandardNormalCentral(const double& centredUniform)
+{
+    double r = 0.180625 - centredUniform * centredUniform;
+    double numerator = ((((((2.5090809287301226727e+3 * r + 3.3430575583588128105e+4) * r
+        + 6.7265770927008700853e+4) * r + 4.5921953931549871457e+4) * r
+        + 1.3731693765509461125e+4) * r + 1.9715909503065514427e+3) * r
+        + 1.3314166789178437745e+2) * r + 3.3871328727963666080e0;
+    double denominator = ((((((5.2264952788528545610e+3 * r + 2.8729085735721942674e+4) * r
+        + 3.9307895800092710610e+4) * r + 2.1213794301586595867e+4) * r
+        + 5.3941960214247511077e+3) * r + 6.8718700749205790830e+2) * r
+        + 4.2313330701600911252e+1) * r + 1.0;
+    return centredUniform * numerator / denominator;
+}
+
+/*
+ Inverse normal CDF in the tails, |uniform - 0.5| > 0.425.
+
+ @param uniform A uniform in (0, 1).
+ @return The standard normal quantile.
+ */
+inline double inverseStandardNormalTail(const double& uniform)
+{
+    double centredUniform = uniform - 0.5;
+    double r = std::sqrt(-std::log(centredUniform < 0.0 ? uniform : 1.0 - uniform));
+    double quantile;
+    if (r <= 5.0)
+    {
+        r -= 1.6;
+        double numerator = ((((((7.74545014278341407640e-4 * r + 2.27238449892691845833e-2) * r
+            + 2.41780725177450611770e-1) * r + 1.27045825245236838258e0) * r
+            + 3.64784832476320460504e0) * r + 5.76949722146069140550e0) * r
+            + 4.63033784615654529590e0) * r + 1.42343711074968357734e0;
+        double denominator = ((((((1.05075007164441684324e-9 * r + 5.47593808499534494600e-4) * r
+            + 1.51986665636164571966e-2) * r + 1.48103976427480074590e-1) * r
+            + 6.89767334985100004550e-1) * r + 1.67638483018380384940e0) * r
+            + 2.05319162663775882187e0) * r + 1.0;
+        quantile = numerator / denominator;
+    }
+    else
+    {
+        r -= 5.0;
+        double numerator = ((((((2.01033439929228813265e-7 * r + 2.71155556874348757815e-5) * r
+            + 1.24266094738807843860e-3) * r + 2.65321895265761230930e-2) * r
+            + 2.96560571828504891230e-1) * r + 1.78482653991729133580e0) * r
+            + 5.46378491116411436990e0) * r + 6.65790464350110377720e0;
+        double denominator = ((((((2.04426310338993978564e-15 * r + 1.42151175831644588870e-7) * r
+            + 1.84631831751005468180e-5) * r + 7.86869131145613259100e-4) * r
+            + 1.48753612908506148525e-2) * r + 1.36929880922735805310e-1) * r
+            + 5.99832206555887937690e-1) * r + 1.0;
+        quantile = numerator / denominator;
+    }
+    return centredUniform < 0.0 ? -quantile : quantile;
+}
+
+/*
+ Inverse of the standard normal CDF.
+
+ @param uniform A uniform in (0, 1).
+ @return The standard normal quantile of the uniform.
+ */
+inline double inverseStandardNormal(const double& uniform)
+{
+    double centredUniform = uniform - 0.5;
+    if (std::abs(centredUniform) <= 0.425)
+    {
+        return inverseStandardNormalCentral(centredUniform);
+    }
+    return inverseStandardNormalTail(uniform);
+}
+
+// Number of values converted per pass; the uniforms of a chunk are kept on the stack
+constexpr std::size_t normalChunkSize = 256;
+
+/*
+ Scalar conversion of uniforms in (0, 1) to standard normals in place.
+
+ The first pass applies the central approximation to every element without
+ branching, so the compiler can vectorize it; the second pass redoes the
+ tail elements.
+
+ @param values The uniforms, overwritten with the normals.
+ @param count The number of values.
+ */
+inline void uniformsToStandardNormalsScalar(double* values, const std::size_t& count)
+{
+    double uniforms[normalChunkSize];
+    for (std::size_t chunkStart = 0; chunkStart < count; chunkStart += normalChunkSize)
+    {
+        std::size_t chunkCount = count - chunkStart < normalChunkSize ? count - chunkStart : normalChunkSize;
+        double* chunkValues = values + chunkStart;
+
+        // Central approximation everywhere, written so the loop vectorizes
+        bool hasTail = false;
+        for (std::size_t i = 0; i < chunkCount; ++i)
+        {
+            uniforms[i] = chunkValues[i];
+            double centredUniform = uniforms[i] - 0.5;
+            hasTail |= std::abs(centredUniform) > 0.425;
+            chunkValues[i] = inverseStandardNormalCentral(centredUniform);
+        }
+
+        // Redo the tail elements with the log-based approximations
+        if (hasTail)
+        {
+            for (std::size_t i = 0; i < chunkCount; ++i)
+            {
+                if (std::abs(uniforms[i] - 0.5) > 0.425)
+                {
+                    chunkValues[i] = inverseStandardNormalTail(uniforms[i]);
+                }
+            }
+        }
+    }
+}
+
+#if defined(INTEREST_RATE_MODELS_X86_SIMD)
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// Below this tail probability (r > 5) the far-tail approximation is needed
+constexpr double inverseNormalFarTailProbability = 1.3887943864964021e-11;
+
+INTEREST_RATE_MODELS_TARGET_AVX2 inline __m256d inverseStandardNormalCentralAvx2(__m256d centredUniform)
+{
+    __m256d r = _mm256_fnmadd_pd(centredUniform, centredUniform, _mm256_set1_pd(0.180625));
+    __m256d numerator = _mm256_set1_pd(2.5090809287301226727e+3);
+    numerator = _mm256_fmadd_pd(numerator, r, _mm256_set1_pd(3.3430575583588128105e+4));
+    numerator = _mm256_fmadd_pd(numerator, r, _mm256_set1_pd(6.7265770927008700853e+4));
+    numerator = _mm256_fmadd_pd(numerator, r, _mm256_set1_pd(4.5921953931549871457e+4));
+    numerator = _mm256_fmadd_pd(numerator, r, _mm256_set1_pd(1.3731693765509461125e+4));
+    numerator = _mm256_fmadd_pd(numerator, r, _mm256_set1_pd(1.9715909503065514427e+3));
+    numerator = _mm256_fmadd_pd(numerator, r, _mm256_set1_pd(1.3314166789178437745e+2));
+    numerator = _mm256_fmadd_pd(numerator, r, _mm256_set1_pd(3.3871328727963666080e0));
+    __m256d denominator = _mm256_set1_pd(5.2264952788528545610e+3);
+    denominator = _mm256_fmadd_pd(denominator, r, _mm256_set1_pd(2.8729085735721942674e+4));
+    denominator = _mm256_fmadd_pd(denominator, r, _mm256_set1_pd(3.9307895800092710610e+4));
+    denominator = _mm256_fmadd_pd(denominator, r, _mm256_set1_pd(2.1213794301586595867e+4));
+    denominator = _mm256_fmadd_pd(denominator, r, _mm256_set1_pd(5.3941960214247511077e+3));
+    denominator = _mm256_fmadd_pd(denominator, r, _mm256_set1_pd(6.8718700749205790830e+2));
+    denominator = _mm256_fmadd_pd(denominator, r, _mm256_set1_pd(4.2313330701600911252e+1));
+    denominator = _mm256_fmadd_pd(denominator, r, _mm256_set1_pd(1.0));
+    return _mm256_div_pd(_mm256_mul_pd(centredUniform, numerator), denominator);
+}
+
+INTEREST_RATE_MODELS_TARGET_AVX2 inline __m256d inverseStandardNormalTailAvx2(__m256d tailProbability)
+{
+    // Quantile magnitude for tail probabilities down to exp(-25)
+    __m256d r = _mm256_sub_pd(_mm256_sqrt_pd(_mm256_sub_pd(_mm256_setzero_pd(), logAvx2(tailProbability))), _mm256_set1_pd(1.6));
+    __m256d numerator = _mm256_set1_pd(7.74545014278341407640e-4);
+    numerator = _mm256_fmadd_pd(numerator, r, _mm256_set1_pd(2.27238449892691845833e-2));
+    numerator = _mm256_fmadd_pd(numerator, r, _mm256_set1_pd(2.41780725177450611770e-1));
+    numerator = _mm256_fmadd_pd(numerator, r, _mm256_set1_pd(1.27045825245236838258e0));
+    numerator = _mm256_fmadd_pd(numerator, r, _mm256_set1_pd(3.64784832476320460504e0));
+    numerator = _mm256_fmadd_pd(numerator, r, _mm256_set1_pd(5.76949722146069140550e0));
+    numerator = _mm256_fmadd_pd(numerator, r, _mm256_set1_pd(4.63033784615654529590e0));
+    numerator = _mm256_fmadd_pd(numerator, r, _mm256_set1_pd(1.42343711074968357734e0));
+    __m256d denominator = _mm256_set1_pd(1.05075007164441684324e-9);
+    denominator = _mm256_fmadd_pd(denominator, r, _mm256_set1_pd(5.47593808499534494600e-4));
+    denominator = _mm256_fmadd_pd(denominator, r, _mm256_set1_pd(1.51986665636164571966e-2));
+    denominator = _mm256_fmadd_pd(denominator, r, _mm256_set1_pd(1.48103976427480074590e-1));
+    denominator = _mm256_fmadd_pd(denominator, r, _mm256_set1_pd(6.89767334985100004550e-1));
+    denominator = _mm256_fmadd_pd(denominator, r, _mm256_set1_pd(1.67638483018380384940e0));
+    denominator = _mm256_fmadd_pd(denominator, r, _mm256_set1_pd(2.05319162663775882187e0));
+    denominator = _mm256_fmadd_pd(denominator, r, _mm256_set1_pd(1.0));
+    return _mm256_div_pd(numerator, denominator);
+}
+
+INTEREST_RATE_MODELS_TARGET_AVX2 inline std::size_t uniformsToStandardNormalsAvx2(double* values, const std::size_t& count)
+{
+    __m256d signMask = _mm256_set1_pd(-0.0);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256d uniform = _mm256_loadu_pd(values + i);
+        __m256d centredUniform = _mm256_sub_pd(uniform, _mm256_set1_pd(0.5));
+        __m256d quantile = inverseStandardNormalCentralAvx2(centredUniform);
+
+        __m256d tailLanes = _mm256_cmp_pd(_mm256_andnot_pd(signMask, centredUniform), _mm256_set1_pd(0.425), _CMP_GT_OQ);
+        if (_mm256_movemask_pd(tailLanes) != 0)
+        {
+            // Tail lanes take the magnitude from the tail probability and the sign from the uniform
+            __m256d lowerTail = _mm256_cmp_pd(centredUniform, _mm256_setzero_pd(), _CMP_LT_OQ);
+            __m256d tailProbability = _mm256_blendv_pd(_mm256_sub_pd(_mm256_set1_pd(1.0), uniform), uniform, lowerTail);
+            __m256d tailQuantile = _mm256_or_pd(inverseStandardNormalTailAvx2(tailProbability), _mm256_and_pd(signMask, centredUniform));
+            quantile = _mm256_blendv_pd(quantile, tailQuantile, tailLanes);
+
+            // Far tails go through the scalar formula
+            int farTailLanes = _mm256_movemask_pd(_mm256_and_pd(tailLanes,
+                _mm256_cmp_pd(tailProbability, _mm256_set1_pd(inverseNormalFarTailProbability), _CMP_LT_OQ)));
+            if (farTailLanes != 0)
+            {
+                double uniforms[4];
+                double quantiles[4];
+                _mm256_storeu_pd(uniforms, uniform);
+                _mm256_storeu_pd(quantiles, quantile);
+                for (int lane = 0; lane < 4; ++lane)
+                {
+                    if ((farTailLanes & (1 << lane)) != 0)
+                    {
+                        quantiles[lane] = inverseStandardNormalTail(uniforms[lane]);
+                    }
+                }
+                quantile = _mm256_loadu_pd(quantiles);
+            }
+        }
+        _mm256_storeu_pd(values + i, quantile);
+    }
+    return i;
+}
+
+INTEREST_RATE_MODELS_TARGET_AVX512 inline __m512d inverseStandardNormalCentralAvx512(__m512d centredUniform)
+{
+    __m512d r = _mm512_fnmadd_pd(centredUniform, centredUniform, _mm512_set1_pd(0.180625));
+    __m512d numerator = _mm512_set1_pd(2.5090809287301226727e+3);
+    numerator = _mm512_fmadd_pd(numerator, r, _mm512_set1_pd(3.3430575583588128105e+4));
+    numerator = _mm512_fmadd_pd(numerator, r, _mm512_set1_pd(6.7265770927008700853e+4));
+    numerator = _mm512_fmadd_pd(numerator, r, _mm512_set1_pd(4.5921953931549871457e+4));
+    numerator = _mm512_fmadd_pd(numerator, r, _mm512_set1_pd(1.3731693765509461125e+4));
+    numerator = _mm512_fmadd_pd(numerator, r, _mm512_set1_pd(1.9715909503065514427e+3));
+    numerator = _mm512_fmadd_pd(numerator, r, _mm512_set1_pd(1.3314166789178437745e+2));
+    numerator = _mm512_fmadd_pd(numerator, r, _mm512_set1_pd(3.3871328727963666080e0));
+    __m512d denominator = _mm512_set1_pd(5.2264952788528545610e+3);
+    denominator = _mm512_fmadd_pd(denominator, r, _mm512_set1_pd(2.8729085735721942674e+4));
+    denominator = _mm512_fmadd_pd(denominator, r, _mm512_set1_pd(3.9307895800092710610e+4));
+    denominator = _mm512_fmadd_pd(denominator, r, _mm512_set1_pd(2.1213794301586595867e+4));
+    denominator = _mm512_fmadd_pd(denominator, r, _mm512_set1_pd(5.3941960214247511077e+3));
+    denominator = _mm512_fmadd_pd(denominator, r, _mm512_set1_pd(6.8718700749205790830e+2));
+    denominator = _mm512_fmadd_pd(denominator, r, _mm512_set1_pd(4.2313330701600911252e+1));
+    denominator = _mm512_fmadd_pd(denominator, r, _mm512_set1_pd(1.0));
+    return _mm512_div_pd(_mm512_mul_pd(centredUniform, numerator), denominator);
+}
+
+INTEREST_RATE_MODELS_TARGET_AVX512 inline __m512d inverseStandardNormalTailAvx512(__m512d tailProbability)
+{
+    // Quantile magnitude for tail probabilities down to exp(-25)
+    __m512d r = _mm512_sub_pd(_mm512_sqrt_pd(_mm512_sub_pd(_mm512_setzero_pd(), logAvx512(tailProbability))), _mm512_set1_pd(1.6));
+    __m512d numerator = _mm512_set1_pd(7.74545014278341407640e-4);
+    numerator = _mm512_fmadd_pd(numerator, r, _mm512_set1_pd(2.27238449892691845833e-2));
+    numerator = _mm512_fmadd_pd(numerator, r, _mm512_set1_pd(2.41780725177450611770e-1));
+    numerator = _mm512_fmadd_pd(numerator, r, _mm512_set1_pd(1.27045825245236838258e0));
+    numerator = _mm512_fmadd_pd(numerator, r, _mm512_set1_pd(3.64784832476320460504e0));
+    numerator = _mm512_fmadd_pd(numerator, r, _mm512_set1_pd(5.76949722146069140550e0));
+    numerator = _mm512_fmadd_pd(numerator, r, _mm512_set1_pd(4.63033784615654529590e0));
+    numerator = _mm512_fmadd_pd(numerator, r, _mm512_set1_pd(1.42343711074968357734e0));
+    __m512d denominator = _mm512_set1_pd(1.05075007164441684324e-9);
+    denominator = _mm512_fmadd_pd(denominator, r, _mm512_set1_pd(5.47593808499534494600e-4));
+    denominator = _mm512_fmadd_pd(denominator, r, _mm512_set1_pd(1.51986665636164571966e-2));
+    denominator = _mm512_fmadd_pd(denominator, r, _mm512_set1_pd(1.48103976427480074590e-1));
+    denominator = _mm512_fmadd_pd(denominator, r, _mm512_set1_pd(6.89767334985100004550e-1));
+    denominator = _mm512_fmadd_pd(denominator, r, _mm512_set1_pd(1.67638483018380384940e0));
+    denominator = _mm512_fmadd_pd(denominator, r, _mm512_set1_pd(2.05319162663775882187e0));
+    denominator = _mm512_fmadd_pd(denominator, r, _mm512_set1_pd(1.0));
+    return _mm512_div_pd(numerator, denominator);
+}
+
+INTEREST_RATE_MODELS_TARGET_AVX512 inline std::size_t uniformsToStandardNormalsAvx512(double* values, const std::size_t& count)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m512d uniform = _mm512_loadu_pd(values + i);
+        __m512d centredUniform = _mm512_sub_pd(uniform, _mm512_set1_pd(0.5));
+        __m512d quantile = inverseStandardNormalCentralAvx512(centredUniform);
+
+        __mmask8 tailLanes = _mm512_cmp_pd_mask(_mm512_abs_pd(centredUniform), _mm512_set1_pd(0.425), _CMP_GT_OQ);
+        if (tailLanes != 0)
+        {
+            // Tail lanes take the magnitude from the tail probability and the sign from the uniform
+            __mmask8 lowerTail = _mm512_cmp_pd_mask(centredUniform, _mm512_setzero_pd(), _CMP_LT_OQ);
+            __m512d tailProbability = _mm512_mask_blend_pd(lowerTail, _mm512_sub_pd(_mm512_set1_pd(1.0), uniform), uniform);
+            __m512d tailQuantile = inverseStandardNormalTailAvx512(tailProbability);
+            tailQuantile = _mm512_mask_sub_pd(tailQuantile, lowerTail, _mm512_setzero_pd(), tailQuantile);
+            quantile = _mm512_mask_blend_pd(tailLanes, quantile, tailQuantile);
+
+            // Far tails go through the scalar formula
+            __mmask8 farTailLanes = tailLanes
+                & _mm512_cmp_pd_mask(tailProbability, _mm512_set1_pd(inverseNormalFarTailProbability), _CMP_LT_OQ);
+            if (farTailLanes != 0)
+            {
+                double uniforms[8];
+                double quantiles[8];
+                _mm512_storeu_pd(uniforms, uniform);
+                _mm512_storeu_pd(quantiles, quantile);
+                for (int lane = 0; lane < 8; ++lane)
+                {
+                    if ((farTailLanes & (1 << lane)) != 0)
+                    {
+                        quantiles[lane] = inverseStandardNormalTail(uniforms[lane]);
+                    }
+                }
+                quantile = _mm512_loadu_pd(quantiles);
+            }
+        }
+        _mm512_storeu_pd(values + i, quantile);
+    }
+    return i;
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+/*
+ Converts an array of uniforms in (0, 1) to standard normals in place.
+
+ @param values The uniforms, overwritten with the normals.
+ @param count The number of values.
+ */
+inline void uniformsToStandardNormals(double* values, const std::size_t& count)
+{
+    std::size_t converted = 0;
+
+#if defined(INTEREST_RATE_MODELS_X86_SIMD)
+    SimdLevel simdLevel = activeSimdLevel();
+    if (simdLevel == SimdLevel::Avx512)
+    {
+        converted = uniformsToStandardNormalsAvx512(values, count);
+    }
+    else if (simdLevel == SimdLevel::Avx2)
+    {
+        converted = uniformsToStandardNormalsAvx2(values, count);
+    }
+#endif
+
+    uniformsToStandardNormalsScalar(values + converted, count - converted);
+}
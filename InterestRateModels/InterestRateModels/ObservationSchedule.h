@@ -0,0 +1,368 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "PathEngine.h"
+#include "SimulationContext.h"
+#include "ThreadPool.h"
+
+/*
+ Sparse observation of short-rate paths.
+
+ The engine steps at the fine time step, but consumers usually need the
+ rates on a few dozen dates such as month ends or coupon dates. An
+ ObservationSchedule names those dates, and an ObservedPathStore keeps the
+ rates of every path on them only, so a daily 30-year run of many paths
+ holds 361 monthly rows instead of 7561.
+
+ The schedule can also name checkpoint dates, at which the store keeps the
+ rate of every path as a PathCheckpoint. resumeObservedPaths() continues
+ from one to a later horizon, with the same increments as an uninterrupted
+ run, so extending a simulation only simulates the new steps.
+ */
+
+/*
+ The dates whose rates a simulation keeps.
+ */
+struct ObservationSchedule
+{
+    std::vector<double> observationTimes;  // dates whose rates are stored
+    std::vector<double> checkpointTimes;   // dates at which the state of every path is kept to resume from
+
+    /*
+     Returns a schedule observing every interval from zero up to the horizon,
+     and at the horizon itself.
+
+     @param interval The time between observations.
+     @param timeHorizon The last observation date.
+     */
+    static ObservationSchedule every(const double& interval, const double& timeHorizon)
+    {
+        if (interval <= 0.0)
+        {
+            throw std::runtime_error("The observation interval must be positive");
+        }
+        ObservationSchedule schedule;
+        int numberOfIntervals = static_cast<int>(std::floor(timeHorizon / interval + 1e-9));
+        for (int observation = 0; observation <= numberOfIntervals; ++observation)
+        {
+            schedule.observationTimes.push_back(observation * interval);
+        }
+        if (timeHorizon - numberOfIntervals * interval > 1e-9 * interval)
+        {
+            schedule.observationTimes.push_back(timeHorizon);
+        }
+        return schedule;
+    }
+
+    /*
+     Returns the last observation or checkpoint date.
+     */
+    double timeHorizon() const
+    {
+        double horizon = 0.0;
+        for (const double& time : observationTimes)
+        {
+            horizon = std::max(horizon, time);
+        }
+        for (const double& time : checkpointTimes)
+        {
+            horizon = std::max(horizon, time);
+        }
+        return horizon;
+    }
+};
+
+/*
+ Stores the rates of a batch of paths on the dates of a schedule.
+
+ Dates are rounded to the nearest step of the simulation grid and stored in
+ increasing order, time-major like a PathStore: the rate of path p at the
+ k-th stored date lives at rateValues[k * numberOfPaths + p].
+ */
+struct ObservedPathStore
+{
+    ObservationSchedule schedule;
+    int firstStep = 0;  // the step the simulation starts from; earlier dates are not stored
+    int numberOfPaths = 0;
+    double timeStep = 0.0;
+    std::vector<double> timeValues;  // the stored dates, on the grid
+    std::vector<int> stepIndices;    // the grid step of each stored date
+    std::vector<double> rateValues;
+    std::vector<PathCheckpoint> checkpoints;
+
+    ObservedPathStore() = default;
+
+    /*
+     @param observationSchedule The dates to store and to checkpoint.
+     */
+    explicit ObservedPathStore(const ObservationSchedule& observationSchedule)
+        : schedule(observationSchedule)
+    {
+    }
+
+    int numberOfObservations() const
+    {
+        return static_cast<int>(timeValues.size());
+    }
+
+    double* ratesAtObservation(const int& observation)
+    {
+        return rateValues.data() + static_cast<std::size_t>(observation) * static_cast<std::size_t>(numberOfPaths);
+    }
+
+    const double* ratesAtObservation(const int& observation) const
+    {
+        return rateValues.data() + static_cast<std::size_t>(observation) * static_cast<std::size_t>(numberOfPaths);
+    }
+
+    double& rate(const int& observation, const int& pathIndex)
+    {
+        return ratesAtObservation(observation)[pathIndex];
+    }
+
+    const double& rate(const int& observation, const int& pathIndex) const
+    {
+        return ratesAtObservation(observation)[pathIndex];
+    }
+
+    /*
+     Returns the latest checkpoint at or before a time.
+
+     @param time The time to resume from.
+     */
+    const PathCheckpoint& checkpointAt(const double& time) const
+    {
+        const PathCheckpoint* latest = nullptr;
+        for (const PathCheckpoint& checkpoint : checkpoints)
+        {
+            if (checkpoint.time <= time + 0.5 * timeStep && (latest == nullptr || checkpoint.time > latest->time))
+            {
+                latest = &checkpoint;
+            }
+        }
+        if (latest == nullptr)
+        {
+            throw std::runtime_error("No checkpoint at or before the requested time");
+        }
+        return *latest;
+    }
+
+    /*
+     Appends the dates and checkpoints of a later run of the same paths, such
+     as one resumed from this store's last checkpoint. Dates the store already
+     holds are skipped.
+
+     @param later The store of the later run.
+     */
+    void append(const ObservedPathStore& later)
+    {
+        if (later.numberOfPaths != numberOfPaths || later.timeStep != timeStep)
+        {
+            throw std::runtime_error("Only runs of the same paths on the same grid can be appended");
+        }
+        int lastStep = stepIndices.empty() ? -1 : stepIndices.back();
+        for (int observation = 0; observation < later.numberOfObservations(); ++observation)
+        {
+            if (later.stepIndices[observation] > lastStep)
+            {
+                timeValues.push_back(later.timeValues[observation]);
+                stepIndices.push_back(later.stepIndices[observation]);
+                rateValues.insert(rateValues.end(), later.ratesAtObservation(observation), later.ratesAtObservation(observation) + numberOfPaths);
+            }
+        }
+        for (const PathCheckpoint& checkpoint : later.checkpoints)
+        {
+            bool known = std::any_of(checkpoints.begin(), checkpoints.end(), [&](const PathCheckpoint& existing) { return existing.stepIndex == checkpoint.stepIndex; });
+            if (!known)
+            {
+                checkpoints.push_back(checkpoint);
+            }
+        }
+    }
+
+    // The store is a path sink for simulatePaths() that keeps the scheduled dates
+
+    void beginSimulation(const std::vector<double>& simulationTimeValues, const int& pathCount, const int&)
+    {
+        int numberOfTimeSteps = static_cast<int>(simulationTimeValues.size()) - 1;
+        numberOfPaths = pathCount;
+        timeStep = numberOfTimeSteps > 0 ? simulationTimeValues[1] - simulationTimeValues[0] : 0.0;
+
+        // Mark the grid steps of the dates from the first step on
+        rowOfStep.assign(simulationTimeValues.size(), -1);
+        checkpointOfStep.assign(simulationTimeValues.size(), -1);
+        auto stepOf = [&](const double& time)
+        {
+            return timeStep > 0.0 ? static_cast<int>(std::lround(time / timeStep)) : 0;
+        };
+        for (const double& time : schedule.observationTimes)
+        {
+            int step = stepOf(time);
+            if (step >= firstStep && step <= numberOfTimeSteps)
+            {
+                rowOfStep[step] = 0;
+            }
+        }
+        for (const double& time : schedule.checkpointTimes)
+        {
+            int step = stepOf(time);
+            if (step >= firstStep && step <= numberOfTimeSteps)
+            {
+                checkpointOfStep[step] = 0;
+            }
+        }
+
+        // Number the marked steps in time order
+        timeValues.clear();
+        stepIndices.clear();
+        checkpoints.clear();
+        for (int step = firstStep; step <= numberOfTimeSteps; ++step)
+        {
+            if (rowOfStep[step] == 0)
+            {
+                rowOfStep[step] = static_cast<int>(timeValues.size());
+                timeValues.push_back(simulationTimeValues[step]);
+                stepIndices.push_back(step);
+            }
+            if (checkpointOfStep[step] == 0)
+            {
+                checkpointOfStep[step] = static_cast<int>(checkpoints.size());
+                PathCheckpoint checkpoint;
+                checkpoint.timeStep = timeStep;
+                checkpoint.stepIndex = step;
+                checkpoint.time = simulationTimeValues[step];
+                checkpoint.rates.resize(static_cast<std::size_t>(pathCount));
+                checkpoints.push_back(checkpoint);
+            }
+        }
+        rateValues.resize(timeValues.size() * static_cast<std::size_t>(pathCount));
+    }
+
+    void observeStep(const int&, const int& stepIndex, const int& firstPath, const double* rates, const int& pathCount)
+    {
+        int row = rowOfStep[stepIndex];
+        if (row >= 0)
+        {
+            std::copy(rates, rates + pathCount, ratesAtObservation(row) + firstPath);
+        }
+        int checkpoint = checkpointOfStep[stepIndex];
+        if (checkpoint >= 0)
+        {
+            std::copy(rates, rates + pathCount, checkpoints[checkpoint].rates.data() + firstPath);
+        }
+    }
+
+    void endSimulation()
+    {
+    }
+
+private:
+    std::vector<int> rowOfStep;         // the stored date of each grid step, or -1
+    std::vector<int> checkpointOfStep;  // the checkpoint of each grid step, or -1
+};
+
+/*
+ Simulates pseudo-random short-rate paths and stores them on the dates of the store's schedule.
+
+ The horizon is the last date of the schedule.
+
+ @param model The short-rate model to simulate, possibly wrapped in a scheme.
+ @param timeStep The time step of the simulation.
+ @param numberOfPaths The number of paths to simulate.
+ @param seed The seed of the random number streams.
+ @param store The store that receives the scheduled dates and checkpoints. Its buffers are reused between calls.
+ @param context The thread pool and the buffers reused between calls.
+ */
+template <typename Model>
+void simulateObservedPaths(
+    const Model& model,
+    const double& timeStep,
+    const int& numberOfPaths,
+    const std::uint64_t& seed,
+    ObservedPathStore& store,
+    SimulationContext& context)
+{
+    // Extend the horizon by half a step so that the last date is on the grid
+    store.firstStep = 0;
+    simulatePaths(model, store.schedule.timeHorizon() + 0.5 * timeStep, timeStep, numberOfPaths, seed, store, context);
+    for (PathCheckpoint& checkpoint : store.checkpoints)
+    {
+        checkpoint.seed = seed;
+    }
+}
+
+/*
+ Simulates pseudo-random short-rate paths on a thread pool and stores them on the dates of the store's schedule.
+
+ @param model The short-rate model to simulate, possibly wrapped in a scheme.
+ @param timeStep The time step of the simulation.
+ @param numberOfPaths The number of paths to simulate.
+ @param seed The seed of the random number streams.
+ @param store The store that receives the scheduled dates and checkpoints.
+ @param threadPool The threads that simulate the path blocks.
+ */
+template <typename Model>
+void simulateObservedPaths(
+    const Model& model,
+    const double& timeStep,
+    const int& numberOfPaths,
+    const std::uint64_t& seed,
+    ObservedPathStore& store,
+    ThreadPool& threadPool = defaultThreadPool())
+{
+    SimulationContext context(threadPool);
+    simulateObservedPaths(model, timeStep, numberOfPaths, seed, store, context);
+}
+
+/*
+ Continues paths from a checkpoint to the last date of the store's schedule,
+ storing the scheduled dates and checkpoints from the checkpoint on.
+
+ The stored rates are bit-identical to those of simulateObservedPaths() over
+ the whole horizon with the checkpoint's seed and time step. To extend a run,
+ resume from its last checkpoint into a new store and append() that to it.
+
+ @param model The short-rate model that was simulated, possibly wrapped in a scheme.
+ @param checkpoint The state to resume from.
+ @param store The store that receives the scheduled dates and checkpoints.
+ @param context The thread pool and the buffers reused between calls.
+ */
+template <typename Model>
+void resumeObservedPaths(
+    const Model& model,
+    const PathCheckpoint& checkpoint,
+    ObservedPathStore& store,
+    SimulationContext& context)
+{
+    store.firstStep = checkpoint.stepIndex;
+    resumePaths(model, checkpoint, store.schedule.timeHorizon() + 0.5 * checkpoint.timeStep, store, context);
+    for (PathCheckpoint& storedCheckpoint : store.checkpoints)
+    {
+        storedCheckpoint.seed = checkpoint.seed;
+    }
+}
+
+/*
+ Continues paths from a checkpoint on a thread pool.
+
+ @param model The short-rate model that was simulated, possibly wrapped in a scheme.
+ @param checkpoint The state to resume from.
+ @param store The store that receives the scheduled dates and checkpoints.
+ @param threadPool The threads that simulate the path blocks.
+ */
+template <typename Model>
+void resumeObservedPaths(
+    const Model& model,
+    const PathCheckpoint& checkpoint,
+    ObservedPathStore& store,
+    ThreadPool& threadPool = defaultThreadPool())
+{
+    SimulationContext context(threadPool);
+    resumeObservedPaths(model, checkpoint, store, context);
+}
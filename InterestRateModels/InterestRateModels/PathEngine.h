@@ -0,0 +1,496 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "CounterRandom.h"
+#include "IncrementSource.h"
+#include "Profiling.h"
+#include "SimulationContext.h"
+#include "ThreadPool.h"
+
+// Number of paths simulated together by one thread
+constexpr int pathBlockSize = 1024;
+
+/*
+ Describes one step of a simulation grid.
+
+ Models receive this when they are asked to advance a rate, so that models
+ which depend on calendar time (Ho-Lee, Hull-White) can see where they are.
+ */
+struct TimeStep
+{
+    int stepIndex = 0;              // Index of the step being taken, 1..numberOfTimeSteps
+    double startTime = 0.0;         // Time at the start of the step
+    double endTime = 0.0;           // Time at the end of the step
+    double length = 0.0;            // Length of the step
+    double squareRootLength = 0.0;  // Square root of the step length
+    std::uint64_t seed = 0;         // Seed of the simulation, for models that need auxiliary draws
+    std::uint64_t firstPath = 0;    // Index of the first path in the row being advanced
+};
+
+/*
+ Stores a batch of simulated short-rate paths in a structure-of-arrays layout.
+
+ The rates are stored time-major in one contiguous buffer: all paths at time
+ step i sit next to each other, so the rate of path p at step i lives at
+ rateValues[i * numberOfPaths + p]. Advancing every path by one step then
+ walks two adjacent rows, which keeps the inner loop cache- and
+ vectorization-friendly.
+ */
+struct PathStore
+{
+    int numberOfPaths = 0;
+    int numberOfTimeSteps = 0;
+    double timeStep = 0.0;
+    std::vector<double> timeValues;
+    std::vector<double> rateValues;
+
+    /*
+     Resizes the store for a new batch, reusing the existing allocation where possible.
+
+     @param pathCount The number of paths in the batch.
+     @param timeStepCount The number of time steps per path.
+     @param stepLength The length of each time step.
+     */
+    void resize(const int& pathCount, const int& timeStepCount, const double& stepLength)
+    {
+        numberOfPaths = pathCount;
+        numberOfTimeSteps = timeStepCount;
+        timeStep = stepLength;
+        timeValues.assign(static_cast<std::size_t>(timeStepCount) + 1, 0.0);
+        rateValues.resize((static_cast<std::size_t>(timeStepCount) + 1) * static_cast<std::size_t>(pathCount));
+    }
+
+    double* ratesAtStep(const int& stepIndex)
+    {
+        return rateValues.data() + static_cast<std::size_t>(stepIndex) * static_cast<std::size_t>(numberOfPaths);
+    }
+
+    const double* ratesAtStep(const int& stepIndex) const
+    {
+        return rateValues.data() + static_cast<std::size_t>(stepIndex) * static_cast<std::size_t>(numberOfPaths);
+    }
+
+    double& rate(const int& stepIndex, const int& pathIndex)
+    {
+        return ratesAtStep(stepIndex)[pathIndex];
+    }
+
+    const double& rate(const int& stepIndex, const int& pathIndex) const
+    {
+        return ratesAtStep(stepIndex)[pathIndex];
+    }
+
+    // The store is a path sink for simulatePaths() that keeps every rate
+
+    void beginSimulation(const std::vector<double>& simulationTimeValues, const int& pathCount, const int&)
+    {
+        int timeStepCount = static_cast<int>(simulationTimeValues.size()) - 1;
+        resize(pathCount, timeStepCount, timeStepCount > 0 ? simulationTimeValues[1] - simulationTimeValues[0] : 0.0);
+        timeValues = simulationTimeValues;
+    }
+
+    void observeStep(const int&, const int& stepIndex, const int& firstPath, const double* rates, const int& pathCount)
+    {
+        std::copy(rates, rates + pathCount, ratesAtStep(stepIndex) + firstPath);
+    }
+
+    void endSimulation()
+    {
+    }
+};
+
+/*
+ The state of a batch of short-rate paths at one step of its grid, from
+ which the simulation can resume. A one-factor path is its rate; the
+ increments of later steps come from the counter-based streams of the seed.
+ */
+struct PathCheckpoint
+{
+    std::uint64_t seed = 0;
+    double timeStep = 0.0;
+    int stepIndex = 0;
+    double time = 0.0;
+    std::vector<double> rates;  // one per path
+
+    int numberOfPaths() const
+    {
+        return static_cast<int>(rates.size());
+    }
+};
+
+/*
+ Simulates one block of paths on the calling thread and hands each step to a sink.
+
+ This is the work of one task of simulatePaths(), for engines that schedule
+ blocks themselves (see ScenarioSweep.h). The increment source must have been
+ prepared for blocks of pathBlockSize paths and the sink begun.
+
+ @param model The short-rate model to simulate, possibly wrapped in a scheme.
+ @param timeValues The time grid, starting at zero.
+ @param timeStep The time step of the simulation.
+ @param firstPath The index of the first path of the block.
+ @param blockPaths The number of paths in the block, at most pathBlockSize.
+ @param seed The seed of the auxiliary random number streams of models with exact schemes.
+ @param incrementSource The source of the standard normal increments.
+ @param sink The sink that receives the simulated rates.
+ @param threadIndex The index of the calling thread, passed on to the source and sink.
+ @param scratch Space for two rows of pathBlockSize rates.
+ @param firstStep The step the paths start from, zero for the initial rate.
+ @param firstRates The rates of the block at firstStep, or nullptr to start every path at the initial rate.
+ */
+template <typename Model, typename IncrementSource, typename Sink>
+void simulatePathBlock(
+    const Model& model,
+    const std::vector<double>& timeValues,
+    const double& timeStep,
+    const int& firstPath,
+    const int& blockPaths,
+    const std::uint64_t& seed,
+    IncrementSource& incrementSource,
+    Sink& sink,
+    const int& threadIndex,
+    double* scratch,
+    const int& firstStep = 0,
+    const double* firstRates = nullptr)
+{
+    INTEREST_RATE_MODELS_PROFILE_LAP_BEGIN(lapTimer);
+    int numberOfTimeSteps = static_cast<int>(timeValues.size()) - 1;
+    double* previousRates = scratch;
+    double* currentRates = scratch + pathBlockSize;
+    INTEREST_RATE_MODELS_PROFILE_COUNT(Paths, blockPaths);
+    INTEREST_RATE_MODELS_PROFILE_COUNT(Steps, static_cast<std::uint64_t>(blockPaths) * (numberOfTimeSteps - firstStep));
+    incrementSource.beginBlock(threadIndex, firstPath, blockPaths);
+    INTEREST_RATE_MODELS_PROFILE_LAP(lapTimer, "increments");
+
+    // Set every path to the initial interest rate, or to its rate at the first step
+    for (int path = 0; path < blockPaths; ++path)
+    {
+        currentRates[path] = firstRates != nullptr ? firstRates[path] : model.initialInterestRate;
+    }
+    sink.observeStep(threadIndex, firstStep, firstPath, currentRates, blockPaths);
+    INTEREST_RATE_MODELS_PROFILE_LAP(lapTimer, "sink");
+
+    TimeStep step;
+    step.length = timeStep;
+    step.squareRootLength = std::sqrt(timeStep);
+    step.seed = seed;
+    step.firstPath = static_cast<std::uint64_t>(firstPath);
+
+    // Simulate the block one time step at a time
+    for (int i = firstStep + 1; i <= numberOfTimeSteps; ++i)
+    {
+        step.stepIndex = i;
+        step.startTime = timeValues[i - 1];
+        step.endTime = timeValues[i];
+
+        const double* randomIncrements = incrementSource.increments(threadIndex, i, 0);
+        INTEREST_RATE_MODELS_PROFILE_LAP(lapTimer, "increments");
+
+        // Advance every path in the block across the step
+        std::swap(previousRates, currentRates);
+        advancePaths(model, step, previousRates, randomIncrements, currentRates, blockPaths);
+        INTEREST_RATE_MODELS_PROFILE_LAP(lapTimer, "advance");
+        sink.observeStep(threadIndex, i, firstPath, currentRates, blockPaths);
+        INTEREST_RATE_MODELS_PROFILE_LAP(lapTimer, "sink");
+    }
+}
+
+/*
+ Simulates short-rate paths for any model in ShortRateModels.h and hands each step to a sink.
+
+ Paths are split into fixed blocks of pathBlockSize paths, and the blocks are
+ spread over the thread pool. Within a block all paths are advanced together
+ one time step at a time: a row of standard normal increments is drawn for
+ the step, then the model's advancePaths() (see SdeSchemes.h) is applied
+ across the row. Only the rows
+ of the current step are kept; what happens to them is up to the sink.
+
+ The increments come from an increment source (see IncrementSource.h).
+ With the counter-based source each path draws from its own stream keyed by
+ (seed, path index), so the result is bit-identical for any number of
+ threads; SobolIncrementSource drives the same models with quasi-random
+ points instead.
+
+ A sink provides
+   beginSimulation(timeValues, numberOfPaths, numberOfThreads)
+   observeStep(threadIndex, stepIndex, firstPath, rates, numberOfPaths)
+   endSimulation()
+ observeStep() is called from the worker threads, for step 0 (the initial
+ rates) through numberOfTimeSteps of every block in order; threadIndex lets
+ the sink keep per-thread state without locking. endSimulation() runs on the
+ calling thread once every block is done.
+
+ The time grid and scratch rows live in the context, so repeated calls with
+ the same context, increment source and sink do not allocate.
+
+ @param model The short-rate model to simulate, possibly wrapped in a scheme.
+ @param timeHorizon The time horizon of the simulation.
+ @param timeStep The time step of the simulation.
+ @param numberOfPaths The number of paths to simulate.
+ @param seed The seed of the auxiliary random number streams of models with exact schemes.
+ @param incrementSource The source of the standard normal increments.
+ @param sink The sink that receives the simulated rates.
+ @param context The thread pool and the buffers reused between calls.
+ */
+template <typename Model, typename IncrementSource, typename Sink>
+void simulatePaths(
+    const Model& model,
+    const double& timeHorizon,
+    const double& timeStep,
+    const int& numberOfPaths,
+    const std::uint64_t& seed,
+    IncrementSource& incrementSource,
+    Sink& sink,
+    SimulationContext& context)
+{
+    INTEREST_RATE_MODELS_PROFILE_SCOPE("simulate");
+    context.beginSimulation();
+    ThreadPool& threadPool = context.threadPool;
+
+    // Calculate the number of time steps and the time grid
+    int numberOfTimeSteps = static_cast<int>(timeHorizon / timeStep);
+    std::vector<double>& timeValues = context.timeValues;
+    timeValues.resize(static_cast<std::size_t>(numberOfTimeSteps) + 1);
+    timeValues[0] = 0.0;
+    for (int i = 1; i <= numberOfTimeSteps; ++i)
+    {
+        timeValues[i] = i * timeStep;
+    }
+    sink.beginSimulation(timeValues, numberOfPaths, threadPool.numberOfThreads());
+    incrementSource.prepare(numberOfTimeSteps, 1, pathBlockSize, threadPool.numberOfThreads());
+
+    // Per thread: two rows of rates
+    double* scratch = context.arena.allocate<double>(static_cast<std::size_t>(threadPool.numberOfThreads()) * 2 * pathBlockSize);
+
+    auto simulateBlock = [&](int blockIndex, int threadIndex)
+    {
+        int firstPath = blockIndex * pathBlockSize;
+        int blockPaths = std::min(pathBlockSize, numberOfPaths - firstPath);
+        double* threadScratch = scratch + static_cast<std::size_t>(threadIndex) * 2 * pathBlockSize;
+        simulatePathBlock(model, timeValues, timeStep, firstPath, blockPaths, seed, incrementSource, sink, threadIndex, threadScratch);
+    };
+
+    int numberOfBlocks = (numberOfPaths + pathBlockSize - 1) / pathBlockSize;
+    threadPool.parallelFor(numberOfBlocks, simulateBlock);
+    sink.endSimulation();
+}
+
+/*
+ Continues pseudo-random short-rate paths from a checkpoint and hands each step to a sink.
+
+ The grid is that of the checkpoint, extended to the new horizon, and each
+ path starts from its checkpointed rate at the checkpointed step. The sink
+ is begun with the whole grid but only sees the steps from the checkpoint
+ on. The increments and any auxiliary draws are keyed by the step, so the
+ steps after the checkpoint are bit-identical to those of one run over the
+ whole horizon with the same seed. Sinks that accumulate along each path,
+ such as PathStatisticsSink and BondPricingSink, start from the first step
+ a block is given, so their discounting runs from the checkpoint.
+
+ @param model The short-rate model that was simulated, possibly wrapped in a scheme.
+ @param checkpoint The state to resume from.
+ @param timeHorizon The new time horizon, at or after the checkpoint.
+ @param sink The sink that receives the simulated rates.
+ @param context The thread pool and the buffers reused between calls.
+ */
+template <typename Model, typename Sink>
+void resumePaths(
+    const Model& model,
+    const PathCheckpoint& checkpoint,
+    const double& timeHorizon,
+    Sink& sink,
+    SimulationContext& context)
+{
+    INTEREST_RATE_MODELS_PROFILE_SCOPE("simulate");
+    context.beginSimulation();
+    ThreadPool& threadPool = context.threadPool;
+    int numberOfPaths = checkpoint.numberOfPaths();
+
+    // The checkpoint's grid, extended to the new horizon
+    int numberOfTimeSteps = static_cast<int>(timeHorizon / checkpoint.timeStep);
+    if (checkpoint.timeStep <= 0.0 || numberOfTimeSteps < checkpoint.stepIndex)
+    {
+        throw std::runtime_error("Cannot resume a simulation before its checkpoint");
+    }
+    std::vector<double>& timeValues = context.timeValues;
+    timeValues.resize(static_cast<std::size_t>(numberOfTimeSteps) + 1);
+    timeValues[0] = 0.0;
+    for (int i = 1; i <= numberOfTimeSteps; ++i)
+    {
+        timeValues[i] = i * checkpoint.timeStep;
+    }
+    CounterIncrementSource& incrementSource = context.counterIncrementSource(checkpoint.seed);
+    sink.beginSimulation(timeValues, numberOfPaths, threadPool.numberOfThreads());
+    incrementSource.prepare(numberOfTimeSteps, 1, pathBlockSize, threadPool.numberOfThreads());
+
+    // Per thread: two rows of rates
+    double* scratch = context.arena.allocate<double>(static_cast<std::size_t>(threadPool.numberOfThreads()) * 2 * pathBlockSize);
+
+    auto simulateBlock = [&](int blockIndex, int threadIndex)
+    {
+        int firstPath = blockIndex * pathBlockSize;
+        int blockPaths = std::min(pathBlockSize, numberOfPaths - firstPath);
+        double* threadScratch = scratch + static_cast<std::size_t>(threadIndex) * 2 * pathBlockSize;
+        simulatePathBlock(model, timeValues, checkpoint.timeStep, firstPath, blockPaths, checkpoint.seed, incrementSource, sink, threadIndex, threadScratch,
+            checkpoint.stepIndex, checkpoint.rates.data() + firstPath);
+    };
+
+    int numberOfBlocks = (numberOfPaths + pathBlockSize - 1) / pathBlockSize;
+    threadPool.parallelFor(numberOfBlocks, simulateBlock);
+    sink.endSimulation();
+}
+
+/*
+ Simulates short-rate paths with a fresh context on a thread pool.
+
+ @param model The short-rate model to simulate, possibly wrapped in a scheme.
+ @param timeHorizon The time horizon of the simulation.
+ @param timeStep The time step of the simulation.
+ @param numberOfPaths The number of paths to simulate.
+ @param seed The seed of the auxiliary random number streams of models with exact schemes.
+ @param incrementSource The source of the standard normal increments.
+ @param sink The sink that receives the simulated rates.
+ @param threadPool The threads that simulate the path blocks.
+ */
+template <typename Model, typename IncrementSource, typename Sink>
+void simulatePaths(
+    const Model& model,
+    const double& timeHorizon,
+    const double& timeStep,
+    const int& numberOfPaths,
+    const std::uint64_t& seed,
+    IncrementSource& incrementSource,
+    Sink& sink,
+    ThreadPool& threadPool)
+{
+    SimulationContext context(threadPool);
+    simulatePaths(model, timeHorizon, timeStep, numberOfPaths, seed, incrementSource, sink, context);
+}
+
+/*
+ Simulates short-rate paths with pseudo-random increments and hands each step to a sink.
+
+ @param model The short-rate model to simulate.
+ @param timeHorizon The time horizon of the simulation.
+ @param timeStep The time step of the simulation.
+ @param numberOfPaths The number of paths to simulate.
+ @param seed The seed of the random number streams.
+ @param sink The sink that receives the simulated rates.
+ @param threadPool The threads that simulate the path blocks.
+ */
+template <typename Model, typename Sink>
+void simulatePaths(
+    const Model& model,
+    const double& timeHorizon,
+    const double& timeStep,
+    const int& numberOfPaths,
+    const std::uint64_t& seed,
+    Sink& sink,
+    ThreadPool& threadPool = defaultThreadPool())
+{
+    CounterIncrementSource incrementSource(seed);
+    simulatePaths(model, timeHorizon, timeStep, numberOfPaths, seed, incrementSource, sink, threadPool);
+}
+
+/*
+ Simulates short-rate paths with pseudo-random increments, reusing the buffers of a context.
+
+ @param model The short-rate model to simulate.
+ @param timeHorizon The time horizon of the simulation.
+ @param timeStep The time step of the simulation.
+ @param numberOfPaths The number of paths to simulate.
+ @param seed The seed of the random number streams.
+ @param sink The sink that receives the simulated rates.
+ @param context The thread pool and the buffers reused between calls.
+ */
+template <typename Model, typename Sink>
+void simulatePaths(
+    const Model& model,
+    const double& timeHorizon,
+    const double& timeStep,
+    const int& numberOfPaths,
+    const std::uint64_t& seed,
+    Sink& sink,
+    SimulationContext& context)
+{
+    simulatePaths(model, timeHorizon, timeStep, numberOfPaths, seed, context.counterIncrementSource(seed), sink, context);
+}
+
+/*
+ Simulates a batch of short-rate paths into a store.
+
+ @param model The short-rate model to simulate.
+ @param timeHorizon The time horizon of the simulation.
+ @param timeStep The time step of the simulation.
+ @param numberOfPaths The number of paths to simulate.
+ @param seed The seed of the random number streams.
+ @param pathStore The store that receives the simulated paths. Its buffers are reused between calls.
+ @param threadPool The threads that simulate the path blocks.
+ */
+template <typename Model>
+void simulatePathBatch(
+    const Model& model,
+    const double& timeHorizon,
+    const double& timeStep,
+    const int& numberOfPaths,
+    const std::uint64_t& seed,
+    PathStore& pathStore,
+    ThreadPool& threadPool = defaultThreadPool())
+{
+    simulatePaths(model, timeHorizon, timeStep, numberOfPaths, seed, pathStore, threadPool);
+}
+
+/*
+ Simulates a batch of short-rate paths into a store, reusing the buffers of a context.
+
+ Once the store and context have held a batch this large, the call makes no heap allocations.
+
+ @param model The short-rate model to simulate.
+ @param timeHorizon The time horizon of the simulation.
+ @param timeStep The time step of the simulation.
+ @param numberOfPaths The number of paths to simulate.
+ @param seed The seed of the random number streams.
+ @param pathStore The store that receives the simulated paths. Its buffers are reused between calls.
+ @param context The thread pool and the buffers reused between calls.
+ */
+template <typename Model>
+void simulatePathBatch(
+    const Model& model,
+    const double& timeHorizon,
+    const double& timeStep,
+    const int& numberOfPaths,
+    const std::uint64_t& seed,
+    PathStore& pathStore,
+    SimulationContext& context)
+{
+    simulatePaths(model, timeHorizon, timeStep, numberOfPaths, seed, pathStore, context);
+}
+
+/*
+ Simulates a batch of short-rate paths into a freshly allocated store.
+
+ @param model The short-rate model to simulate.
+ @param timeHorizon The time horizon of the simulation.
+ @param timeStep The time step of the simulation.
+ @param numberOfPaths The number of paths to simulate.
+ @param seed The seed of the random number streams.
+ @return The simulated paths.
+ */
+template <typename Model>
+PathStore simulatePathBatch(
+    const Model& model,
+    const double& timeHorizon,
+    const double& timeStep,
+    const int& numberOfPaths,
+    const std::uint64_t& seed)
+{
+    PathStore pathStore;
+    simulatePathBatch(model, timeHorizon, timeStep, numberOfPaths, seed, pathStore);
+    return pathStore;
+}
@@ -0,0 +1,373 @@
+#pragma once
+
+/*
+ Hot-path instrumentation: phase timers and counters, reported as JSON.
+
+ Everything here compiles to nothing unless INTEREST_RATE_MODELS_PROFILING
+ is defined (for example with -DINTEREST_RATE_MODELS_PROFILING), so the
+ macros can stay in the engines. When it is defined:
+
+   INTEREST_RATE_MODELS_PROFILE_SCOPE("phase")
+       times the rest of the enclosing scope as the named phase.
+   INTEREST_RATE_MODELS_PROFILE_LAP_BEGIN(timer)
+   INTEREST_RATE_MODELS_PROFILE_LAP(timer, "phase")
+       split a loop body into consecutive phases: each lap charges the time
+       since the previous lap (or the beginning) to the named phase, with
+       one clock read per lap. For loops too tight for scoped timers.
+   INTEREST_RATE_MODELS_PROFILE_COUNT(Counter, amount)
+       adds to one of the counters of ProfileCounter.
+   INTEREST_RATE_MODELS_PROFILE_REPORT(path, perThread)
+       writes the report, with a breakdown per thread if perThread is true.
+
+ Every thread accumulates into its own slots, so recording takes no locks
+ and shares no cache lines; the report sums the slots. The clock is the
+ time stamp counter on x86-64, converted to seconds against steady_clock
+ over the run, and steady_clock elsewhere. Phase times are inclusive and
+ summed over threads, so with several threads they can exceed the wall time.
+ */
+
+#if defined(INTEREST_RATE_MODELS_PROFILING)
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+enum class ProfileCounter
+{
+    Paths,
+    Steps,  // path steps: one per path per time step
+    RandomDraws,
+    BytesWritten,
+    Count
+};
+
+inline const char* profileCounterName(const int& counter)
+{
+    static const char* const names[] = { "paths", "steps", "randomDraws", "bytesWritten" };
+    return names[counter];
+}
+
+// The most phases a run can name
+constexpr int maximumProfilePhases = 64;
+
+inline std::uint64_t profileTicks()
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+/*
+ The slots of one thread. Only the owning thread writes them, so the
+ atomics are read and written separately rather than incremented.
+ */
+struct alignas(64) ThreadProfile
+{
+    struct Phase
+    {
+        std::atomic<std::uint64_t> calls{ 0 };
+        std::atomic<std::uint64_t> ticks{ 0 };
+    };
+
+    int threadNumber = 0;
+    std::array<Phase, maximumProfilePhases> phases;
+    std::array<std::atomic<std::uint64_t>, static_cast<int>(ProfileCounter::Count)> counters{};
+
+    void addPhase(const int& phase, const std::uint64_t& elapsedTicks)
+    {
+        Phase& totals = phases[phase];
+        totals.calls.store(totals.calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        totals.ticks.store(totals.ticks.load(std::memory_order_relaxed) + elapsedTicks, std::memory_order_relaxed);
+    }
+
+    void addCount(const ProfileCounter& counter, const std::uint64_t& amount)
+    {
+        std::atomic<std::uint64_t>& total = counters[static_cast<int>(counter)];
+        total.store(total.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+};
+
+/*
+ The phase names and the slots of every thread that has recorded anything.
+ */
+class Profiler
+{
+public:
+    Profiler()
+        : startTime(std::chrono::steady_clock::now()), startTicks(profileTicks())
+    {
+    }
+
+    /*
+     Returns the index of a phase, registering its name the first time.
+     */
+    int phaseIndex(const char* name)
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (std::size_t phase = 0; phase < phaseNames.size(); ++phase)
+        {
+            if (phaseNames[phase] == name)
+            {
+                return static_cast<int>(phase);
+            }
+        }
+        if (phaseNames.size() == static_cast<std::size_t>(maximumProfilePhases))
+        {
+            throw std::runtime_error("More than " + std::to_string(maximumProfilePhases) + " profiling phases");
+        }
+        phaseNames.push_back(name);
+        return static_cast<int>(phaseNames.size()) - 1;
+    }
+
+    /*
+     Returns the slots of the calling thread.
+     */
+    ThreadProfile& threadProfile()
+    {
+        thread_local ThreadProfile* profile = nullptr;
+        if (profile == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            threads.push_back(std::make_unique<ThreadProfile>());
+            profile = threads.back().get();
+            profile->threadNumber = static_cast<int>(threads.size()) - 1;
+        }
+        return *profile;
+    }
+
+    /*
+     Writes the report as one JSON object.
+
+     @param output The stream to write to.
+     @param perThread Whether to add the phases and counters of every thread.
+     */
+    void writeReport(std::ostream& output, const bool& perThread)
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        double secondsPerTick = wallSeconds / static_cast<double>(std::max<std::uint64_t>(1, profileTicks() - startTicks));
+
+        // Totals over the threads
+        std::vector<std::uint64_t> calls(phaseNames.size(), 0);
+        std::vector<std::uint64_t> ticks(phaseNames.size(), 0);
+        std::vector<std::uint64_t> counters(static_cast<std::size_t>(ProfileCounter::Count), 0);
+        for (const std::unique_ptr<ThreadProfile>& profile : threads)
+        {
+            for (std::size_t phase = 0; phase < phaseNames.size(); ++phase)
+            {
+                calls[phase] += profile->phases[phase].calls.load(std::memory_order_relaxed);
+                ticks[phase] += profile->phases[phase].ticks.load(std::memory_order_relaxed);
+            }
+            for (std::size_t counter = 0; counter < counters.size(); ++counter)
+            {
+                counters[counter] += profile->counters[counter].load(std::memory_order_relaxed);
+            }
+        }
+
+        output << "{\n  \"wallSeconds\": " << wallSeconds << ",\n  \"threads\": " << threads.size() << ",\n";
+        writePhases(output, calls, ticks, secondsPerTick, "  ");
+        output << ",\n";
+        writeCounters(output, counters, "  ");
+        if (perThread)
+        {
+            output << ",\n  \"perThread\": [";
+            for (std::size_t thread = 0; thread < threads.size(); ++thread)
+            {
+                const ThreadProfile& profile = *threads[thread];
+                std::vector<std::uint64_t> threadCalls(phaseNames.size());
+                std::vector<std::uint64_t> threadTicks(phaseNames.size());
+                std::vector<std::uint64_t> threadCounters(counters.size());
+                for (std::size_t phase = 0; phase < phaseNames.size(); ++phase)
+                {
+                    threadCalls[phase] = profile.phases[phase].calls.load(std::memory_order_relaxed);
+                    threadTicks[phase] = profile.phases[phase].ticks.load(std::memory_order_relaxed);
+                }
+                for (std::size_t counter = 0; counter < counters.size(); ++counter)
+                {
+                    threadCounters[counter] = profile.counters[counter].load(std::memory_order_relaxed);
+                }
+                output << (thread == 0 ? "\n" : ",\n") << "    {\n      \"thread\": " << profile.threadNumber << ",\n";
+                writePhases(output, threadCalls, threadTicks, secondsPerTick, "      ");
+                output << ",\n";
+                writeCounters(output, threadCounters, "      ");
+                output << "\n    }";
+            }
+            output << "\n  ]";
+        }
+        output << "\n}\n";
+    }
+
+private:
+    static void writeJsonString(std::ostream& output, const std::string& text)
+    {
+        output << '"';
+        for (char character : text)
+        {
+            if (character == '"' || character == '\\')
+            {
+                output << '\\';
+            }
+            output << character;
+        }
+        output << '"';
+    }
+
+    void writePhases(std::ostream& output, const std::vector<std::uint64_t>& calls, const std::vector<std::uint64_t>& ticks, const double& secondsPerTick,
+        const std::string& indent) const
+    {
+        output << indent << "\"phases\": [";
+        bool first = true;
+        for (std::size_t phase = 0; phase < phaseNames.size(); ++phase)
+        {
+            if (calls[phase] == 0)
+            {
+                continue;
+            }
+            output << (first ? "\n" : ",\n") << indent << "  { \"name\": ";
+            writeJsonString(output, phaseNames[phase]);
+            output << ", \"calls\": " << calls[phase] << ", \"seconds\": " << ticks[phase] * secondsPerTick << " }";
+            first = false;
+        }
+        output << (first ? "]" : "\n" + indent + "]");
+    }
+
+    static void writeCounters(std::ostream& output, const std::vector<std::uint64_t>& counters, const std::string& indent)
+    {
+        output << indent << "\"counters\": { ";
+        for (std::size_t counter = 0; counter < counters.size(); ++counter)
+        {
+            output << (counter == 0 ? "" : ", ") << '"' << profileCounterName(static_cast<int>(counter)) << "\": " << counters[counter];
+        }
+        output << " }";
+    }
+
+    std::chrono::steady_clock::time_point startTime;
+    std::uint64_t startTicks;
+    std::mutex registryMutex;
+    std::vector<std::string> phaseNames;
+    std::vector<std::unique_ptr<ThreadProfile>> threads;
+};
+
+/*
+ Returns the profiler of the process.
+ */
+inline Profiler& profiler()
+{
+    static Profiler instance;
+    return instance;
+}
+
+/*
+ Charges the lifetime of the timer to a phase.
+ */
+class ScopedProfileTimer
+{
+public:
+    explicit ScopedProfileTimer(const int& profilePhase)
+        : profile(profiler().threadProfile()), phase(profilePhase), startTicks(profileTicks())
+    {
+    }
+
+    ~ScopedProfileTimer()
+    {
+        profile.addPhase(phase, profileTicks() - startTicks);
+    }
+
+    ScopedProfileTimer(const ScopedProfileTimer&) = delete;
+    ScopedProfileTimer& operator=(const ScopedProfileTimer&) = delete;
+
+private:
+    ThreadProfile& profile;
+    int phase;
+    std::uint64_t startTicks;
+};
+
+/*
+ Splits a stretch of code into consecutive phases with one clock read per lap.
+ */
+class ProfileLapTimer
+{
+public:
+    ProfileLapTimer()
+        : profile(profiler().threadProfile()), lastTicks(profileTicks())
+    {
+    }
+
+    // Charges the time since the last lap to a phase
+    void lap(const int& phase)
+    {
+        std::uint64_t ticks = profileTicks();
+        profile.addPhase(phase, ticks - lastTicks);
+        lastTicks = ticks;
+    }
+
+private:
+    ThreadProfile& profile;
+    std::uint64_t lastTicks;
+};
+
+/*
+ Writes the profiling report to a file.
+
+ @param path The path of the JSON file.
+ @param perThread Whether to add the phases and counters of every thread.
+ */
+inline void writeProfileReport(const std::string& path, const bool& perThread = false)
+{
+    std::ofstream output(path);
+    if (!output)
+    {
+        throw std::runtime_error("Cannot create " + path);
+    }
+    profiler().writeReport(output, perThread);
+}
+
+#define INTEREST_RATE_MODELS_PROFILE_CONCATENATE_INNER(first, second) first##second
+#define INTEREST_RATE_MODELS_PROFILE_CONCATENATE(first, second) INTEREST_RATE_MODELS_PROFILE_CONCATENATE_INNER(first, second)
+
+#define INTEREST_RATE_MODELS_PROFILE_SCOPE(name) \
+    static const int INTEREST_RATE_MODELS_PROFILE_CONCATENATE(profilePhase, __LINE__) = profiler().phaseIndex(name); \
+    ScopedProfileTimer INTEREST_RATE_MODELS_PROFILE_CONCATENATE(profileTimer, __LINE__)(INTEREST_RATE_MODELS_PROFILE_CONCATENATE(profilePhase, __LINE__))
+
+#define INTEREST_RATE_MODELS_PROFILE_LAP_BEGIN(timer) ProfileLapTimer timer
+
+#define INTEREST_RATE_MODELS_PROFILE_LAP(timer, name) \
+    do \
+    { \
+        static const int profilePhase = profiler().phaseIndex(name); \
+        timer.lap(profilePhase); \
+    } while (false)
+
+#define INTEREST_RATE_MODELS_PROFILE_COUNT(counter, amount) \
+    profiler().threadProfile().addCount(ProfileCounter::counter, static_cast<std::uint64_t>(amount))
+
+#define INTEREST_RATE_MODELS_PROFILE_REPORT(path, perThread) writeProfileReport(path, perThread)
+
+#else
+
+#define INTEREST_RATE_MODELS_PROFILE_SCOPE(name)
+#define INTEREST_RATE_MODELS_PROFILE_LAP_BEGIN(timer)
+#define INTEREST_RATE_MODELS_PROFILE_LAP(timer, name) ((void)0)
+#define INTEREST_RATE_MODELS_PROFILE_COUNT(counter, amount) ((void)0)
+#define INTEREST_RATE_MODELS_PROFILE_REPORT(path, perThread) ((void)0)
+
+#endif
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cmath>
+
+#include "CounterRandom.h"
+
+/*
+ Samplers for the non-normal distributions needed by exact transitions.
+
+ All samplers draw from a CounterRandomStream, so the draws of a path stay
+ reproducible however the paths are spread over threads. Rejection samplers
+ use a variable number of draws; give them a substream of their own so the
+ per-step increments are not disturbed.
+ */
+
+/*
+ Samples a Gamma(shape, 1) variate (Marsaglia and Tsang, 2000).
+
+ @param stream The stream to draw from.
+ @param shape The shape parameter, greater than zero.
+ @return The gamma variate.
+ */
+inline double sampleGamma(CounterRandomStream& stream, const double& shape)
+{
+    // Boost shapes below one: Gamma(a) = Gamma(a + 1) * U^(1 / a)
+    if (shape < 1.0)
+    {
+        double boosted = sampleGamma(stream, shape + 1.0);
+        return boosted * std::pow(stream.nextUniform(), 1.0 / shape);
+    }
+
+    double d = shape - 1.0 / 3.0;
+    double c = 1.0 / std::sqrt(9.0 * d);
+    while (true)
+    {
+        double normal = stream.nextStandardNormal();
+        double v = 1.0 + c * normal;
+        if (v <= 0.0)
+        {
+            continue;
+        }
+        v = v * v * v;
+        double uniform = stream.nextUniform();
+        double normalSquared = normal * normal;
+        if (uniform < 1.0 - 0.0331 * normalSquared * normalSquared)
+        {
+            return d * v;
+        }
+        if (std::log(uniform) < 0.5 * normalSquared + d * (1.0 - v + std::log(v)))
+        {
+            return d * v;
+        }
+    }
+}
+
+/*
+ Samples a Poisson variate.
+
+ Small means use inversion by sequential search; larger means use Hormann's
+ transformed rejection (PTRS), whose cost does not grow with the mean.
+
+ @param stream The stream to draw from.
+ @param mean The mean of the distribution, at least zero.
+ @return The Poisson variate.
+ */
+inline long long samplePoisson(CounterRandomStream& stream, const double& mean)
+{
+    if (mean <= 0.0)
+    {
+        return 0;
+    }
+
+    if (mean < 10.0)
+    {
+        double uniform = stream.nextUniform();
+        double probability = std::exp(-mean);
+        double cumulative = probability;
+        long long count = 0;
+        while (uniform > cumulative && probability > 0.0)
+        {
+            ++count;
+            probability *= mean / static_cast<double>(count);
+            cumulative += probability;
+        }
+        return count;
+    }
+
+    double squareRootMean = std::sqrt(mean);
+    double logMean = std::log(mean);
+    double b = 0.931 + 2.53 * squareRootMean;
+    double a = -0.059 + 0.02483 * b;
+    double inverseAlpha = 1.1239 + 1.1328 / (b - 3.4);
+    double acceptanceBound = 0.9277 - 3.6224 / (b - 2.0);
+    while (true)
+    {
+        double u = stream.nextUniform() - 0.5;
+        double v = stream.nextUniform();
+        double us = 0.5 - std::abs(u);
+        double k = std::floor((2.0 * a / us + b) * u + mean + 0.43);
+        if (us >= 0.07 && v <= acceptanceBound)
+        {
+            return static_cast<long long>(k);
+        }
+        if (k < 0.0 || (us < 0.013 && v > us))
+        {
+            continue;
+        }
+        if (std::log(v) + std::log(inverseAlpha) - std::log(a / (us * us) + b)
+            <= -mean + k * logMean - std::lgamma(k + 1.0))
+        {
+            return static_cast<long long>(k);
+        }
+    }
+}
+
+/*
+ Samples a chi-square variate with possibly fractional degrees of freedom.
+
+ @param stream The stream to draw from.
+ @param degreesOfFreedom The degrees of freedom, at least zero.
+ @return The chi-square variate.
+ */
+inline double sampleChiSquare(CounterRandomStream& stream, const double& degreesOfFreedom)
+{
+    if (degreesOfFreedom <= 0.0)
+    {
+        return 0.0;
+    }
+    return 2.0 * sampleGamma(stream, 0.5 * degreesOfFreedom);
+}
+
+/*
+ Samples a noncentral chi-square variate.
+
+ With more than one degree of freedom the variate is split as
+ (Z + sqrt(noncentrality))^2 plus a central chi-square with one degree of
+ freedom fewer, which reuses the caller's normal. Otherwise it is drawn as a
+ Poisson mixture of central chi-squares.
+
+ @param stream The stream for the additional draws.
+ @param standardNormal A standard normal to use for the noncentral part.
+ @param degreesOfFreedom The degrees of freedom, greater than zero.
+ @param noncentrality The noncentrality parameter, at least zero.
+ @return The noncentral chi-square variate.
+ */
+inline double sampleNoncentralChiSquare(
+    CounterRandomStream& stream,
+    const double& standardNormal,
+    const double& degreesOfFreedom,
+    const double& noncentrality)
+{
+    if (degreesOfFreedom > 1.0)
+    {
+        double shifted = standardNormal + std::sqrt(noncentrality);
+        return shifted * shifted + sampleChiSquare(stream, degreesOfFreedom - 1.0);
+    }
+
+    long long poissonCount = samplePoisson(stream, 0.5 * noncentrality);
+    return sampleChiSquare(stream, degreesOfFreedom + 2.0 * static_cast<double>(poissonCount));
+}
@@ -0,0 +1,740 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "HeathJarrowMortonEngine.h"
+#include "ObservationSchedule.h"
+#include "PathEngine.h"
+
+/*
+ Binary result files, written and read through memory mappings.
+
+ A result file holds the values of numberOfPaths paths at numberOfDates
+ dates, with valuesPerPath values per path and date (one short rate, or one
+ forward per maturity). The layout is
+
+   header                  ResultFileHeader
+   parameters              numberOfParameters x ResultFileParameter
+   time grid               numberOfDates x float64
+   maturity grid           numberOfMaturities x float64 (HJM only)
+   data                    one column per date, numberOfPaths x valuesPerPath values
+
+ All integers and floats are little-endian and the data starts on a 64-byte
+ boundary, so a reader can map the file and use the columns in place.
+ */
+
+enum class OutputFormat
+{
+    Csv,    // human-readable text
+    Binary  // memory-mapped result file
+};
+
+enum class ResultValueType : std::uint32_t
+{
+    Float64 = 0,
+    Float32 = 1
+};
+
+// Runs with more values than this are written in binary by default
+constexpr std::uint64_t binaryOutputThreshold = 1000000;
+
+/*
+ Returns the output format to use when the caller has no preference.
+
+ @param numberOfValues The number of simulated values to write.
+ */
+inline OutputFormat defaultOutputFormat(const std::uint64_t& numberOfValues)
+{
+    return numberOfValues > binaryOutputThreshold ? OutputFormat::Binary : OutputFormat::Csv;
+}
+
+/*
+ Returns the output file name for a base name and a format.
+
+ @param baseName The file name without extension.
+ @param outputFormat The output format.
+ */
+inline std::string outputFileName(const std::string& baseName, const OutputFormat& outputFormat)
+{
+    return baseName + (outputFormat == OutputFormat::Csv ? ".csv" : ".irm");
+}
+
+/*
+ A named model parameter stored in a result file.
+ */
+struct ResultParameter
+{
+    std::string name;
+    double value;
+};
+
+constexpr char resultFileMagic[8] = { 'I', 'R', 'M', 'R', 'E', 'S', 'U', 'L' };
+constexpr std::uint32_t resultFileVersion = 1;
+
+struct ResultFileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t valueType;
+    std::uint64_t seed;
+    std::uint64_t numberOfDates;
+    std::uint64_t numberOfPaths;
+    std::uint64_t valuesPerPath;
+    std::uint64_t numberOfParameters;
+    std::uint64_t numberOfMaturities;
+    std::uint64_t parameterOffset;
+    std::uint64_t timeGridOffset;
+    std::uint64_t maturityGridOffset;
+    std::uint64_t dataOffset;
+    char model[64];
+};
+
+struct ResultFileParameter
+{
+    char name[56];
+    double value;
+};
+
+/*
+ A file mapped into memory, read-only or read-write.
+
+ Failures to open, size or map the file throw std::runtime_error.
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+
+    ~MappedFile()
+    {
+        close();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /*
+     Creates or truncates a file of the given size and maps it for writing.
+
+     @param path The path of the file.
+     @param size The size of the file in bytes.
+     */
+    void createForWriting(const std::string& path, const std::size_t& size)
+    {
+        close();
+#if defined(_WIN32)
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE)
+        {
+            throw std::runtime_error("Cannot create " + path);
+        }
+        mapHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READWRITE, static_cast<DWORD>(static_cast<std::uint64_t>(size) >> 32), static_cast<DWORD>(size), nullptr);
+        if (mapHandle == nullptr)
+        {
+            close();
+            throw std::runtime_error("Cannot map " + path);
+        }
+        mappedData = static_cast<unsigned char*>(MapViewOfFile(mapHandle, FILE_MAP_WRITE, 0, 0, size));
+#else
+        fileDescriptor = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fileDescriptor < 0)
+        {
+            throw std::runtime_error("Cannot create " + path);
+        }
+        if (::ftruncate(fileDescriptor, static_cast<off_t>(size)) != 0)
+        {
+            close();
+            throw std::runtime_error("Cannot resize " + path);
+        }
+        void* mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+        mappedData = mapping == MAP_FAILED ? nullptr : static_cast<unsigned char*>(mapping);
+#endif
+        if (mappedData == nullptr)
+        {
+            close();
+            throw std::runtime_error("Cannot map " + path);
+        }
+        mappedSize = size;
+    }
+
+    /*
+     Maps an existing file for reading.
+
+     @param path The path of the file.
+     */
+    void openForReading(const std::string& path)
+    {
+        close();
+#if defined(_WIN32)
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE)
+        {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        LARGE_INTEGER fileSize;
+        GetFileSizeEx(fileHandle, &fileSize);
+        std::size_t size = static_cast<std::size_t>(fileSize.QuadPart);
+        mapHandle = size == 0 ? nullptr : CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapHandle != nullptr)
+        {
+            mappedData = static_cast<unsigned char*>(MapViewOfFile(mapHandle, FILE_MAP_READ, 0, 0, 0));
+        }
+#else
+        fileDescriptor = ::open(path.c_str(), O_RDONLY);
+        if (fileDescriptor < 0)
+        {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        struct stat fileStatus;
+        ::fstat(fileDescriptor, &fileStatus);
+        std::size_t size = static_cast<std::size_t>(fileStatus.st_size);
+        if (size > 0)
+        {
+            void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+            mappedData = mapping == MAP_FAILED ? nullptr : static_cast<unsigned char*>(mapping);
+        }
+#endif
+        if (mappedData == nullptr)
+        {
+            close();
+            throw std::runtime_error("Cannot map " + path);
+        }
+        mappedSize = size;
+    }
+
+    /*
+     Unmaps and closes the file. Written pages reach the file through the page cache.
+     */
+    void close()
+    {
+#if defined(_WIN32)
+        if (mappedData != nullptr)
+        {
+            UnmapViewOfFile(mappedData);
+        }
+        if (mapHandle != nullptr)
+        {
+            CloseHandle(mapHandle);
+        }
+        if (fileHandle != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(fileHandle);
+        }
+        mapHandle = nullptr;
+        fileHandle = INVALID_HANDLE_VALUE;
+#else
+        if (mappedData != nullptr)
+        {
+            ::munmap(mappedData, mappedSize);
+        }
+        if (fileDescriptor >= 0)
+        {
+            ::close(fileDescriptor);
+        }
+        fileDescriptor = -1;
+#endif
+        mappedData = nullptr;
+        mappedSize = 0;
+    }
+
+    unsigned char* data()
+    {
+        return mappedData;
+    }
+
+    const unsigned char* data() const
+    {
+        return mappedData;
+    }
+
+    std::size_t size() const
+    {
+        return mappedSize;
+    }
+
+private:
+#if defined(_WIN32)
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mapHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+    unsigned char* mappedData = nullptr;
+    std::size_t mappedSize = 0;
+};
+
+/*
+ Everything in a result file except the data.
+ */
+struct ResultFileDescription
+{
+    std::string model;
+    std::vector<ResultParameter> parameters;
+    std::uint64_t seed = 0;
+    ResultValueType valueType = ResultValueType::Float64;
+    std::vector<double> timeValues;
+    std::vector<double> maturities;
+    std::uint64_t numberOfPaths = 0;
+};
+
+/*
+ Writes a result file through a writable mapping.
+
+ The file is sized and its header written on construction; the columns are
+ then filled in any order, from any number of threads as long as they write
+ disjoint ranges.
+ */
+class ResultFileWriter
+{
+public:
+    /*
+     Creates the file.
+
+     @param path The path of the file.
+     @param description The header contents and dimensions.
+     */
+    ResultFileWriter(const std::string& path, const ResultFileDescription& description)
+    {
+        ResultFileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, resultFileMagic, sizeof(header.magic));
+        header.version = resultFileVersion;
+        header.valueType = static_cast<std::uint32_t>(description.valueType);
+        header.seed = description.seed;
+        header.numberOfDates = description.timeValues.size();
+        header.numberOfPaths = description.numberOfPaths;
+        header.valuesPerPath = std::max<std::uint64_t>(1, description.maturities.size());
+        header.numberOfParameters = description.parameters.size();
+        header.numberOfMaturities = description.maturities.size();
+        std::strncpy(header.model, description.model.c_str(), sizeof(header.model) - 1);
+
+        header.parameterOffset = sizeof(ResultFileHeader);
+        header.timeGridOffset = header.parameterOffset + header.numberOfParameters * sizeof(ResultFileParameter);
+        header.maturityGridOffset = header.timeGridOffset + header.numberOfDates * sizeof(double);
+        header.dataOffset = (header.maturityGridOffset + header.numberOfMaturities * sizeof(double) + 63) / 64 * 64;
+
+        valueType = description.valueType;
+        columnLength = header.numberOfPaths * header.valuesPerPath;
+        std::uint64_t valueSize = valueType == ResultValueType::Float64 ? sizeof(double) : sizeof(float);
+        mappedFile.createForWriting(path, static_cast<std::size_t>(header.dataOffset + header.numberOfDates * columnLength * valueSize));
+
+        INTEREST_RATE_MODELS_PROFILE_COUNT(BytesWritten, mappedFile.size());
+        unsigned char* fileData = mappedFile.data();
+        std::memcpy(fileData, &header, sizeof(header));
+        for (std::size_t parameter = 0; parameter < description.parameters.size(); ++parameter)
+        {
+            ResultFileParameter fileParameter;
+            std::memset(&fileParameter, 0, sizeof(fileParameter));
+            std::strncpy(fileParameter.name, description.parameters[parameter].name.c_str(), sizeof(fileParameter.name) - 1);
+            fileParameter.value = description.parameters[parameter].value;
+            std::memcpy(fileData + header.parameterOffset + parameter * sizeof(ResultFileParameter), &fileParameter, sizeof(fileParameter));
+        }
+        std::memcpy(fileData + header.timeGridOffset, description.timeValues.data(), header.numberOfDates * sizeof(double));
+        std::memcpy(fileData + header.maturityGridOffset, description.maturities.data(), header.numberOfMaturities * sizeof(double));
+        columnData = fileData + header.dataOffset;
+    }
+
+    /*
+     Writes a run of values into the column of a date, converting to float32 if needed.
+
+     @param dateIndex The index of the date.
+     @param firstValue The position of the first value within the column.
+     @param values The values to write.
+     @param numberOfValues The number of values to write.
+     */
+    void writeValues(const std::uint64_t& dateIndex, const std::uint64_t& firstValue, const double* values, const std::size_t& numberOfValues)
+    {
+        std::uint64_t position = dateIndex * columnLength + firstValue;
+        if (valueType == ResultValueType::Float64)
+        {
+            std::memcpy(columnData + position * sizeof(double), values, numberOfValues * sizeof(double));
+            return;
+        }
+        float* destination = reinterpret_cast<float*>(columnData) + position;
+        for (std::size_t value = 0; value < numberOfValues; ++value)
+        {
+            destination[value] = static_cast<float>(values[value]);
+        }
+    }
+
+    /*
+     Unmaps the file. Called by the destructor if not called before.
+     */
+    void close()
+    {
+        mappedFile.close();
+    }
+
+private:
+    MappedFile mappedFile;
+    unsigned char* columnData = nullptr;
+    std::uint64_t columnLength = 0;
+    ResultValueType valueType = ResultValueType::Float64;
+};
+
+/*
+ Reads a result file through a read-only mapping, without copying the data.
+ */
+class ResultFileReader
+{
+public:
+    /*
+     Maps the file and checks its header.
+
+     Every section the header points to must lie within the file and be
+     aligned for its values, so the accessors can return pointers into the
+     mapping. A header whose sizes overflow or point past the end of the
+     file throws std::runtime_error.
+
+     @param path The path of the file.
+     */
+    explicit ResultFileReader(const std::string& path)
+    {
+        mappedFile.openForReading(path);
+        if (mappedFile.size() < sizeof(ResultFileHeader))
+        {
+            throw std::runtime_error(path + " is not a result file");
+        }
+        std::memcpy(&header, mappedFile.data(), sizeof(header));
+        if (std::memcmp(header.magic, resultFileMagic, sizeof(header.magic)) != 0 || header.version != resultFileVersion)
+        {
+            throw std::runtime_error(path + " is not a result file");
+        }
+        if ((valueType() != ResultValueType::Float64 && valueType() != ResultValueType::Float32)
+            || header.valuesPerPath != std::max<std::uint64_t>(1, header.numberOfMaturities))
+        {
+            throw std::runtime_error(path + " has a malformed header");
+        }
+
+        std::uint64_t fileSize = mappedFile.size();
+        if (!sectionFits(header.parameterOffset, header.numberOfParameters, sizeof(ResultFileParameter), fileSize)
+            || !sectionFits(header.timeGridOffset, header.numberOfDates, sizeof(double), fileSize)
+            || !sectionFits(header.maturityGridOffset, header.numberOfMaturities, sizeof(double), fileSize)
+            || header.timeGridOffset % alignof(double) != 0 || header.maturityGridOffset % alignof(double) != 0)
+        {
+            throw std::runtime_error(path + " has a section outside the file");
+        }
+
+        std::uint64_t valueSize = valueType() == ResultValueType::Float64 ? sizeof(double) : sizeof(float);
+        std::uint64_t numberOfValues = 0;
+        std::uint64_t columnSize = 0;
+        if (!multiplyWithoutOverflow(header.numberOfPaths, header.valuesPerPath, numberOfValues)
+            || !multiplyWithoutOverflow(numberOfValues, valueSize, columnSize) || header.dataOffset % alignof(double) != 0)
+        {
+            throw std::runtime_error(path + " has a malformed header");
+        }
+        if (!sectionFits(header.dataOffset, header.numberOfDates, columnSize, fileSize))
+        {
+            throw std::runtime_error(path + " is truncated");
+        }
+    }
+
+    std::string model() const
+    {
+        return std::string(header.model, strnlen(header.model, sizeof(header.model)));
+    }
+
+    std::uint64_t seed() const
+    {
+        return header.seed;
+    }
+
+    ResultValueType valueType() const
+    {
+        return static_cast<ResultValueType>(header.valueType);
+    }
+
+    std::uint64_t numberOfDates() const
+    {
+        return header.numberOfDates;
+    }
+
+    std::uint64_t numberOfPaths() const
+    {
+        return header.numberOfPaths;
+    }
+
+    std::uint64_t valuesPerPath() const
+    {
+        return header.valuesPerPath;
+    }
+
+    std::uint64_t numberOfMaturities() const
+    {
+        return header.numberOfMaturities;
+    }
+
+    /*
+     Returns the number of values in the column of a date.
+     */
+    std::uint64_t columnLength() const
+    {
+        return header.numberOfPaths * header.valuesPerPath;
+    }
+
+    const double* timeValues() const
+    {
+        return reinterpret_cast<const double*>(mappedFile.data() + header.timeGridOffset);
+    }
+
+    const double* maturities() const
+    {
+        return reinterpret_cast<const double*>(mappedFile.data() + header.maturityGridOffset);
+    }
+
+    /*
+     Returns the model parameters stored in the file.
+     */
+    std::vector<ResultParameter> parameters() const
+    {
+        std::vector<ResultParameter> result;
+        for (std::uint64_t parameter = 0; parameter < header.numberOfParameters; ++parameter)
+        {
+            ResultFileParameter fileParameter;
+            std::memcpy(&fileParameter, mappedFile.data() + header.parameterOffset + parameter * sizeof(ResultFileParameter), sizeof(fileParameter));
+            result.push_back({ std::string(fileParameter.name, strnlen(fileParameter.name, sizeof(fileParameter.name))), fileParameter.value });
+        }
+        return result;
+    }
+
+    /*
+     Returns the column of a date in a float64 file, in place.
+
+     @param dateIndex The index of the date.
+     */
+    const double* float64Column(const std::uint64_t& dateIndex) const
+    {
+        return reinterpret_cast<const double*>(mappedFile.data() + header.dataOffset) + dateIndex * columnLength();
+    }
+
+    /*
+     Returns the column of a date in a float32 file, in place.
+
+     @param dateIndex The index of the date.
+     */
+    const float* float32Column(const std::uint64_t& dateIndex) const
+    {
+        return reinterpret_cast<const float*>(mappedFile.data() + header.dataOffset) + dateIndex * columnLength();
+    }
+
+    /*
+     Returns one value, whatever the value type of the file.
+
+     @param dateIndex The index of the date.
+     @param path The index of the path.
+     @param valueIndex The index of the value within the path (the maturity for HJM files).
+     */
+    double value(const std::uint64_t& dateIndex, const std::uint64_t& path, const std::uint64_t& valueIndex = 0) const
+    {
+        std::uint64_t position = path * header.valuesPerPath + valueIndex;
+        if (valueType() == ResultValueType::Float64)
+        {
+            return float64Column(dateIndex)[position];
+        }
+        return float32Column(dateIndex)[position];
+    }
+
+private:
+    /*
+     Multiplies two sizes, returning false instead if the product overflows.
+     */
+    static bool multiplyWithoutOverflow(const std::uint64_t& left, const std::uint64_t& right, std::uint64_t& product)
+    {
+        if (right != 0 && left > std::numeric_limits<std::uint64_t>::max() / right)
+        {
+            return false;
+        }
+        product = left * right;
+        return true;
+    }
+
+    /*
+     Returns whether count elements of elementSize bytes starting at offset lie within the file.
+     */
+    static bool sectionFits(const std::uint64_t& offset, const std::uint64_t& count, const std::uint64_t& elementSize, const std::uint64_t& fileSize)
+    {
+        std::uint64_t length = 0;
+        return multiplyWithoutOverflow(count, elementSize, length) && offset <= fileSize && length <= fileSize - offset;
+    }
+
+    MappedFile mappedFile;
+    ResultFileHeader header;
+};
+
+/*
+ Writes a batch of short-rate paths to a result file, one column per time step.
+
+ @param path The path of the file.
+ @param model The name of the model.
+ @param parameters The model parameters.
+ @param seed The seed of the simulation.
+ @param pathStore The simulated paths.
+ @param valueType The type to store the rates as.
+ */
+inline void writeResultFile(
+    const std::string& path,
+    const std::string& model,
+    const std::vector<ResultParameter>& parameters,
+    const std::uint64_t& seed,
+    const PathStore& pathStore,
+    const ResultValueType& valueType = ResultValueType::Float64)
+{
+    INTEREST_RATE_MODELS_PROFILE_SCOPE("resultFile");
+    ResultFileDescription description;
+    description.model = model;
+    description.parameters = parameters;
+    description.seed = seed;
+    description.valueType = valueType;
+    description.timeValues = pathStore.timeValues;
+    description.numberOfPaths = static_cast<std::uint64_t>(pathStore.numberOfPaths);
+
+    // The store is time-major, so every column is one contiguous copy
+    ResultFileWriter writer(path, description);
+    for (int i = 0; i <= pathStore.numberOfTimeSteps; ++i)
+    {
+        writer.writeValues(static_cast<std::uint64_t>(i), 0, pathStore.ratesAtStep(i), static_cast<std::size_t>(pathStore.numberOfPaths));
+    }
+}
+
+/*
+ Writes short-rate paths observed on a schedule to a result file, one column per stored date.
+
+ @param path The path of the file.
+ @param model The name of the model.
+ @param parameters The model parameters.
+ @param seed The seed of the simulation.
+ @param observedPathStore The simulated paths on their scheduled dates.
+ @param valueType The type to store the rates as.
+ */
+inline void writeResultFile(
+    const std::string& path,
+    const std::string& model,
+    const std::vector<ResultParameter>& parameters,
+    const std::uint64_t& seed,
+    const ObservedPathStore& observedPathStore,
+    const ResultValueType& valueType = ResultValueType::Float64)
+{
+    INTEREST_RATE_MODELS_PROFILE_SCOPE("resultFile");
+    ResultFileDescription description;
+    description.model = model;
+    description.parameters = parameters;
+    description.seed = seed;
+    description.valueType = valueType;
+    description.timeValues = observedPathStore.timeValues;
+    description.numberOfPaths = static_cast<std::uint64_t>(observedPathStore.numberOfPaths);
+
+    ResultFileWriter writer(path, description);
+    for (int observation = 0; observation < observedPathStore.numberOfObservations(); ++observation)
+    {
+        writer.writeValues(static_cast<std::uint64_t>(observation), 0, observedPathStore.ratesAtObservation(observation), static_cast<std::size_t>(observedPathStore.numberOfPaths));
+    }
+}
+
+/*
+ Writes a checkpoint to a result file with a single date, so that a later
+ process can resume the paths. The time step is stored as an extra
+ parameter named "timeStep" after the model parameters.
+
+ @param path The path of the file.
+ @param model The name of the model.
+ @param parameters The model parameters.
+ @param checkpoint The checkpoint to write.
+ */
+inline void writeCheckpointFile(
+    const std::string& path,
+    const std::string& model,
+    const std::vector<ResultParameter>& parameters,
+    const PathCheckpoint& checkpoint)
+{
+    ResultFileDescription description;
+    description.model = model;
+    description.parameters = parameters;
+    description.parameters.push_back({ "timeStep", checkpoint.timeStep });
+    description.seed = checkpoint.seed;
+    description.timeValues = { checkpoint.time };
+    description.numberOfPaths = static_cast<std::uint64_t>(checkpoint.numberOfPaths());
+
+    ResultFileWriter writer(path, description);
+    writer.writeValues(0, 0, checkpoint.rates.data(), checkpoint.rates.size());
+}
+
+/*
+ Reads a checkpoint written by writeCheckpointFile().
+
+ @param path The path of the file.
+ */
+inline PathCheckpoint readCheckpointFile(const std::string& path)
+{
+    ResultFileReader reader(path);
+    std::vector<ResultParameter> parameters = reader.parameters();
+    if (reader.numberOfDates() != 1 || reader.valuesPerPath() != 1 || reader.valueType() != ResultValueType::Float64
+        || parameters.empty() || parameters.back().name != "timeStep" || parameters.back().value <= 0.0)
+    {
+        throw std::runtime_error(path + " is not a checkpoint file");
+    }
+
+    PathCheckpoint checkpoint;
+    checkpoint.seed = reader.seed();
+    checkpoint.timeStep = parameters.back().value;
+    checkpoint.time = reader.timeValues()[0];
+    checkpoint.stepIndex = static_cast<int>(std::lround(checkpoint.time / checkpoint.timeStep));
+    const double* rates = reader.float64Column(0);
+    checkpoint.rates.assign(rates, rates + reader.numberOfPaths());
+    return checkpoint;
+}
+
+/*
+ Writes simulated forward curves to a result file, one column per recorded step.
+
+ @param path The path of the file.
+ @param model The name of the model.
+ @param parameters The model parameters.
+ @param seed The seed of the simulation.
+ @param forwardCurveStore The simulated curves.
+ @param valueType The type to store the forwards as.
+ */
+inline void writeResultFile(
+    const std::string& path,
+    const std::string& model,
+    const std::vector<ResultParameter>& parameters,
+    const std::uint64_t& seed,
+    const ForwardCurveStore& forwardCurveStore,
+    const ResultValueType& valueType = ResultValueType::Float64)
+{
+    INTEREST_RATE_MODELS_PROFILE_SCOPE("resultFile");
+    ResultFileDescription description;
+    description.model = model;
+    description.parameters = parameters;
+    description.seed = seed;
+    description.valueType = valueType;
+    description.timeValues = forwardCurveStore.timeValues;
+    description.maturities = forwardCurveStore.maturities;
+    description.numberOfPaths = static_cast<std::uint64_t>(forwardCurveStore.numberOfPaths);
+
+    ResultFileWriter writer(path, description);
+    std::size_t columnLength = static_cast<std::size_t>(forwardCurveStore.numberOfPaths) * forwardCurveStore.numberOfMaturities;
+    for (int record = 0; record < forwardCurveStore.numberOfRecords(); ++record)
+    {
+        writer.writeValues(static_cast<std::uint64_t>(record), 0, forwardCurveStore.curve(record, 0), columnLength);
+    }
+}
@@ -0,0 +1,674 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CsvWriter.h"
+#include "PathEngine.h"
+#include "ShortRateModels.h"
+#include "StreamingStatistics.h"
+
+/*
+ Parameter sweeps: many scenarios of the short-rate models run in one process.
+
+ A sweep specification is a text file of "key values..." lines; # starts a
+ comment. Each "model" line opens a section whose scenarios are every
+ combination of its parameter values:
+
+     seed 42
+     output ckls_stress.csv
+     horizon 5
+     step 0.01
+     paths 65536
+     model CKLS
+     scheme milstein
+     driftTerm 0.01
+     meanReversionRate 0.1 0.2 0.5
+     elasticity 0.5:1.5:5
+     volatility 0.01 0.02 0.05
+     initialInterestRate 0.05
+
+ A value written start:end:count stands for count evenly spaced values from
+ start to end. horizon, step, paths and scheme (euler, milstein or exact)
+ given before the first model apply to every section that does not set
+ them. Every parameter of the model must be given, with the names of its
+ fields in ShortRateModels.h. The models are Vasicek, CIR, CKLS, CEV and
+ HoLee; exact schemes are available for Vasicek, CIR and HoLee.
+
+ Every scenario uses the same seed, so scenarios differ only through their
+ parameters (common random numbers).
+ */
+
+enum class SweepScheme
+{
+    Euler,
+    Milstein,
+    Exact
+};
+
+struct SweepParameter
+{
+    std::string name;
+    std::vector<double> values;
+};
+
+/*
+ One model section of a sweep specification.
+ */
+struct SweepModel
+{
+    std::string model;
+    SweepScheme scheme = SweepScheme::Euler;
+    double timeHorizon = 1.0;
+    double timeStep = 0.01;
+    int numberOfPaths = 10000;
+
+    // In the order of the fields of the model
+    std::vector<SweepParameter> parameters;
+};
+
+struct SweepSpecification
+{
+    std::uint64_t seed = 42;
+    std::string outputPath = "sweep_results.csv";
+    std::vector<SweepModel> models;
+};
+
+/*
+ One parameter set of one model section.
+ */
+struct SweepScenario
+{
+    int modelIndex = 0;
+
+    // One value per parameter of the section
+    std::vector<double> values;
+};
+
+/*
+ Returns the parameter names of a sweep model, in the order of its fields.
+ */
+inline const std::vector<std::string>& sweepParameterNames(const std::string& model)
+{
+    static const std::vector<std::string> vasicek = { "meanReversionSpeed", "longTermInterestRate", "volatility", "initialInterestRate" };
+    static const std::vector<std::string> coxIngersollRoss = { "meanReversionLevel", "meanReversionRate", "volatility", "initialInterestRate" };
+    static const std::vector<std::string> chanKarolyiLongstaffSanders = { "driftTerm", "meanReversionRate", "elasticity", "volatility", "initialInterestRate" };
+    static const std::vector<std::string> constantElasticityVariance = { "meanReversionRate", "driftTerm", "elasticity", "volatility", "initialInterestRate" };
+    static const std::vector<std::string> hoAndLee = { "driftTerm", "volatility", "initialInterestRate" };
+    if (model == "Vasicek")
+    {
+        return vasicek;
+    }
+    if (model == "CIR")
+    {
+        return coxIngersollRoss;
+    }
+    if (model == "CKLS")
+    {
+        return chanKarolyiLongstaffSanders;
+    }
+    if (model == "CEV")
+    {
+        return constantElasticityVariance;
+    }
+    if (model == "HoLee")
+    {
+        return hoAndLee;
+    }
+    throw std::runtime_error("Unknown sweep model " + model);
+}
+
+inline bool sweepModelHasExactScheme(const std::string& model)
+{
+    return model == "Vasicek" || model == "CIR" || model == "HoLee";
+}
+
+inline const char* sweepSchemeName(const SweepScheme& scheme)
+{
+    switch (scheme)
+    {
+    case SweepScheme::Milstein:
+        return "milstein";
+    case SweepScheme::Exact:
+        return "exact";
+    default:
+        return "euler";
+    }
+}
+
+// Parses a number of a sweep specification, naming the line if it is not one
+inline double parseSweepNumber(const std::string& text, const int& lineNumber)
+{
+    double value = 0.0;
+    const char* end = text.data() + text.size();
+    std::from_chars_result parsed = std::from_chars(text.data(), end, value);
+    if (parsed.ec != std::errc() || parsed.ptr != end)
+    {
+        throw std::runtime_error("Line " + std::to_string(lineNumber) + " of the sweep: \"" + text + "\" is not a number");
+    }
+    return value;
+}
+
+// The largest grid and run a section may ask for, so that a request cannot exhaust the memory or the int step counts
+constexpr double sweepMaximumTimeSteps = 1e7;
+constexpr double sweepMaximumPathSteps = 1e11;
+
+// Checks a finished model section and puts its parameters in the order of the model's fields
+inline void finishSweepModel(SweepModel& sweepModel)
+{
+    const std::vector<std::string>& names = sweepParameterNames(sweepModel.model);
+    std::vector<SweepParameter> orderedParameters;
+    for (const std::string& name : names)
+    {
+        auto parameter = std::find_if(sweepModel.parameters.begin(), sweepModel.parameters.end(),
+            [&](const SweepParameter& candidate) { return candidate.name == name; });
+        if (parameter == sweepModel.parameters.end())
+        {
+            throw std::runtime_error("The " + sweepModel.model + " sweep is missing " + name);
+        }
+        orderedParameters.push_back(*parameter);
+    }
+    if (sweepModel.scheme == SweepScheme::Exact && !sweepModelHasExactScheme(sweepModel.model))
+    {
+        throw std::runtime_error(sweepModel.model + " has no exact scheme");
+    }
+    if (!(sweepModel.timeHorizon > 0.0) || !(sweepModel.timeStep > 0.0) || sweepModel.timeStep > sweepModel.timeHorizon || sweepModel.numberOfPaths <= 0)
+    {
+        throw std::runtime_error("The " + sweepModel.model + " sweep needs a positive horizon, step and number of paths");
+    }
+    double numberOfTimeSteps = sweepModel.timeHorizon / sweepModel.timeStep;
+    if (!std::isfinite(sweepModel.timeHorizon) || !std::isfinite(numberOfTimeSteps) || numberOfTimeSteps > sweepMaximumTimeSteps
+        || numberOfTimeSteps * sweepModel.numberOfPaths > sweepMaximumPathSteps)
+    {
+        throw std::runtime_error("The " + sweepModel.model + " sweep is too large: at most " + std::to_string(static_cast<long long>(sweepMaximumTimeSteps))
+            + " steps and " + std::to_string(static_cast<long long>(sweepMaximumPathSteps)) + " path steps");
+    }
+    sweepModel.parameters = orderedParameters;
+}
+
+/*
+ Reads a sweep specification.
+
+ @param path The path of the specification file.
+ */
+inline SweepSpecification readSweepSpecification(const std::string& path)
+{
+    std::ifstream input(path);
+    if (!input)
+    {
+        throw std::runtime_error("Cannot open " + path);
+    }
+
+    SweepSpecification specification;
+    SweepModel defaults;
+    SweepModel* current = &defaults;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(input, line))
+    {
+        ++lineNumber;
+        line = line.substr(0, line.find('#'));
+        std::istringstream tokens(line);
+        std::string key;
+        if (!(tokens >> key))
+        {
+            continue;
+        }
+        std::vector<std::string> values;
+        for (std::string value; tokens >> value;)
+        {
+            values.push_back(value);
+        }
+        if (values.empty())
+        {
+            throw std::runtime_error("Line " + std::to_string(lineNumber) + " of the sweep has no value for " + key);
+        }
+
+        if (key == "seed")
+        {
+            specification.seed = static_cast<std::uint64_t>(parseSweepNumber(values[0], lineNumber));
+        }
+        else if (key == "output")
+        {
+            specification.outputPath = values[0];
+        }
+        else if (key == "model")
+        {
+            if (current != &defaults)
+            {
+                finishSweepModel(*current);
+            }
+            sweepParameterNames(values[0]);
+            specification.models.push_back(defaults);
+            current = &specification.models.back();
+            current->model = values[0];
+        }
+        else if (key == "scheme")
+        {
+            if (values[0] != "euler" && values[0] != "milstein" && values[0] != "exact")
+            {
+                throw std::runtime_error("Line " + std::to_string(lineNumber) + " of the sweep: unknown scheme " + values[0]);
+            }
+            current->scheme = values[0] == "exact" ? SweepScheme::Exact : values[0] == "milstein" ? SweepScheme::Milstein : SweepScheme::Euler;
+        }
+        else if (key == "horizon")
+        {
+            current->timeHorizon = parseSweepNumber(values[0], lineNumber);
+        }
+        else if (key == "step")
+        {
+            current->timeStep = parseSweepNumber(values[0], lineNumber);
+        }
+        else if (key == "paths")
+        {
+            current->numberOfPaths = static_cast<int>(parseSweepNumber(values[0], lineNumber));
+        }
+        else
+        {
+            // Anything else is a parameter of the current model
+            if (current == &defaults)
+            {
+                throw std::runtime_error("Line " + std::to_string(lineNumber) + " of the sweep sets " + key + " before any model");
+            }
+            const std::vector<std::string>& names = sweepParameterNames(current->model);
+            if (std::find(names.begin(), names.end(), key) == names.end())
+            {
+                throw std::runtime_error("Line " + std::to_string(lineNumber) + " of the sweep: " + current->model + " has no parameter " + key);
+            }
+            for (const SweepParameter& parameter : current->parameters)
+            {
+                if (parameter.name == key)
+                {
+                    throw std::runtime_error("Line " + std::to_string(lineNumber) + " of the sweep sets " + key + " twice");
+                }
+            }
+
+            SweepParameter parameter;
+            parameter.name = key;
+            for (const std::string& value : values)
+            {
+                std::size_t firstColon = value.find(':');
+                if (firstColon == std::string::npos)
+                {
+                    parameter.values.push_back(parseSweepNumber(value, lineNumber));
+                    continue;
+                }
+
+                // start:end:count
+                std::size_t secondColon = value.find(':', firstColon + 1);
+                if (secondColon == std::string::npos)
+                {
+                    throw std::runtime_error("Line " + std::to_string(lineNumber) + " of the sweep: a range is written start:end:count");
+                }
+                double start = parseSweepNumber(value.substr(0, firstColon), lineNumber);
+                double end = parseSweepNumber(value.substr(firstColon + 1, secondColon - firstColon - 1), lineNumber);
+                int count = static_cast<int>(parseSweepNumber(value.substr(secondColon + 1), lineNumber));
+                if (count < 1)
+                {
+                    throw std::runtime_error("Line " + std::to_string(lineNumber) + " of the sweep: a range needs at least one value");
+                }
+                for (int i = 0; i < count; ++i)
+                {
+                    parameter.values.push_back(count == 1 ? start : start + (end - start) * i / (count - 1));
+                }
+            }
+            current->parameters.push_back(parameter);
+        }
+    }
+    if (current != &defaults)
+    {
+        finishSweepModel(*current);
+    }
+    if (specification.models.empty())
+    {
+        throw std::runtime_error(path + " defines no model");
+    }
+    return specification;
+}
+
+/*
+ Returns every scenario of a sweep, section by section, with the last parameter varying fastest.
+ */
+inline std::vector<SweepScenario> expandSweep(const SweepSpecification& specification)
+{
+    std::vector<SweepScenario> scenarios;
+    for (std::size_t modelIndex = 0; modelIndex < specification.models.size(); ++modelIndex)
+    {
+        const std::vector<SweepParameter>& parameters = specification.models[modelIndex].parameters;
+        std::vector<std::size_t> positions(parameters.size(), 0);
+        while (true)
+        {
+            SweepScenario scenario;
+            scenario.modelIndex = static_cast<int>(modelIndex);
+            for (std::size_t i = 0; i < parameters.size(); ++i)
+            {
+                scenario.values.push_back(parameters[i].values[positions[i]]);
+            }
+            scenarios.push_back(scenario);
+
+            // Advance the positions like an odometer
+            std::size_t i = parameters.size();
+            while (i > 0 && ++positions[i - 1] == parameters[i - 1].values.size())
+            {
+                positions[i - 1] = 0;
+                --i;
+            }
+            if (i == 0)
+            {
+                break;
+            }
+        }
+    }
+    return scenarios;
+}
+
+// Calls function with the model wrapped in the requested scheme
+template <bool HasExactScheme, typename Model, typename Function>
+void withSweepScheme(const Model& model, const SweepScheme& scheme, const Function& function)
+{
+    if constexpr (HasExactScheme)
+    {
+        if (scheme == SweepScheme::Exact)
+        {
+            function(ExactScheme<Model>{ model });
+            return;
+        }
+    }
+    if (scheme == SweepScheme::Milstein)
+    {
+        function(MilsteinScheme<Model>{ model });
+        return;
+    }
+    function(model);
+}
+
+/*
+ Builds the model of a scenario and calls function with it, wrapped in the
+ scheme of its section. Common CKLS and CEV elasticities are specialized.
+
+ @param sweepModel The section of the scenario.
+ @param values The parameter values of the scenario.
+ @param function The function to call with the model.
+ */
+template <typename Function>
+void withSweepModel(const SweepModel& sweepModel, const std::vector<double>& values, const Function& function)
+{
+    const double* v = values.data();
+    if (sweepModel.model == "Vasicek")
+    {
+        withSweepScheme<true>(VasicekModel{ v[0], v[1], v[2], v[3] }, sweepModel.scheme, function);
+    }
+    else if (sweepModel.model == "CIR")
+    {
+        withSweepScheme<true>(CoxIngersollRossModel{ v[0], v[1], v[2], v[3] }, sweepModel.scheme, function);
+    }
+    else if (sweepModel.model == "CKLS")
+    {
+        withSpecializedElasticity(ChanKarolyiLongstaffSandersModel{ v[0], v[1], v[2], v[3], v[4] }, [&](const auto& model)
+        {
+            withSweepScheme<false>(model, sweepModel.scheme, function);
+        });
+    }
+    else if (sweepModel.model == "CEV")
+    {
+        withSpecializedElasticity(ConstantElasticityVarianceModel{ v[0], v[1], v[2], v[3], v[4] }, [&](const auto& model)
+        {
+            withSweepScheme<false>(model, sweepModel.scheme, function);
+        });
+    }
+    else
+    {
+        withSweepScheme<true>(HoAndLeeModel{ v[0], v[1], v[2] }, sweepModel.scheme, function);
+    }
+}
+
+/*
+ What a sweep reports for a scenario, or for one block of its paths.
+ */
+struct ScenarioSummary
+{
+    RunningMoments terminalRate;
+    RunningMoments discountFactor;  // exp(-int_0^T r ds), whose mean is the bond price
+    double lowestRate = std::numeric_limits<double>::infinity();
+    double highestRate = -std::numeric_limits<double>::infinity();
+
+    void merge(const ScenarioSummary& other)
+    {
+        terminalRate.merge(other.terminalRate);
+        discountFactor.merge(other.discountFactor);
+        lowestRate = std::min(lowestRate, other.lowestRate);
+        highestRate = std::max(highestRate, other.highestRate);
+    }
+};
+
+/*
+ Path sink for one block of a scenario, which summarizes it as it is simulated.
+ */
+class ScenarioBlockSink
+{
+public:
+    ScenarioBlockSink()
+        : previousRates(pathBlockSize), discountIntegrals(pathBlockSize)
+    {
+    }
+
+    /*
+     Starts a block.
+
+     @param blockTimeValues The time grid of the scenario.
+     @param blockSummary Receives the summary of the block.
+     */
+    void beginBlock(const std::vector<double>& blockTimeValues, ScenarioSummary& blockSummary)
+    {
+        timeValues = &blockTimeValues;
+        summary = &blockSummary;
+    }
+
+    void observeStep(const int&, const int& stepIndex, const int&, const double* rates, const int& numberOfPaths)
+    {
+        // Accumulate the discount integral with the trapezoidal rule
+        if (stepIndex == 0)
+        {
+            std::fill(discountIntegrals.begin(), discountIntegrals.end(), 0.0);
+        }
+        else
+        {
+            double halfStep = 0.5 * ((*timeValues)[stepIndex] - (*timeValues)[stepIndex - 1]);
+            for (int path = 0; path < numberOfPaths; ++path)
+            {
+                discountIntegrals[path] += halfStep * (previousRates[path] + rates[path]);
+            }
+        }
+        std::copy(rates, rates + numberOfPaths, previousRates.begin());
+        for (int path = 0; path < numberOfPaths; ++path)
+        {
+            summary->lowestRate = std::min(summary->lowestRate, rates[path]);
+            summary->highestRate = std::max(summary->highestRate, rates[path]);
+        }
+
+        if (stepIndex + 1 == static_cast<int>(timeValues->size()))
+        {
+            summary->terminalRate.add(rates, static_cast<std::size_t>(numberOfPaths));
+            for (int path = 0; path < numberOfPaths; ++path)
+            {
+                discountIntegrals[path] = std::exp(-discountIntegrals[path]);
+            }
+            summary->discountFactor.add(discountIntegrals.data(), static_cast<std::size_t>(numberOfPaths));
+        }
+    }
+
+private:
+    const std::vector<double>* timeValues = nullptr;
+    ScenarioSummary* summary = nullptr;
+    std::vector<double> previousRates;
+    std::vector<double> discountIntegrals;
+};
+
+/*
+ Runs every scenario of a sweep and returns their summaries.
+
+ Each scenario is split into blocks of pathBlockSize paths, and every
+ (scenario, block) pair of the whole sweep is one task of a single parallel
+ loop, so threads that finish cheap scenarios move straight on to the blocks
+ of expensive ones. Tasks are handed out most expensive first (by steps
+ times paths), which keeps the longest tasks away from the end of the run.
+ The blocks of a scenario are merged in path order, so the summaries do not
+ depend on the number of threads. Sections with the same step and number of
+ steps share one time grid, so a batch of similar requests holds one grid.
+
+ @param specification The sweep.
+ @param scenarios The scenarios of the sweep, from expandSweep().
+ @param threadPool The threads that run the tasks.
+ */
+inline std::vector<ScenarioSummary> runSweep(
+    const SweepSpecification& specification,
+    const std::vector<SweepScenario>& scenarios,
+    ThreadPool& threadPool = defaultThreadPool())
+{
+    INTEREST_RATE_MODELS_PROFILE_SCOPE("sweep");
+
+    // The time grid of every section, built once for each distinct step and number of steps
+    std::vector<std::vector<double>> timeGrids;
+    std::map<std::pair<double, int>, std::size_t> gridOfStep;
+    std::vector<std::size_t> gridOfModel;
+    int largestNumberOfTimeSteps = 0;
+    for (const SweepModel& sweepModel : specification.models)
+    {
+        int numberOfTimeSteps = static_cast<int>(sweepModel.timeHorizon / sweepModel.timeStep);
+        auto grid = gridOfStep.emplace(std::make_pair(sweepModel.timeStep, numberOfTimeSteps), timeGrids.size());
+        if (grid.second)
+        {
+            timeGrids.emplace_back(static_cast<std::size_t>(numberOfTimeSteps) + 1, 0.0);
+            for (int i = 1; i <= numberOfTimeSteps; ++i)
+            {
+                timeGrids.back()[i] = i * sweepModel.timeStep;
+            }
+        }
+        gridOfModel.push_back(grid.first->second);
+        largestNumberOfTimeSteps = std::max(largestNumberOfTimeSteps, numberOfTimeSteps);
+    }
+    std::vector<const std::vector<double>*> timeValues;
+    for (const std::size_t& grid : gridOfModel)
+    {
+        timeValues.push_back(&timeGrids[grid]);
+    }
+
+    // One task per block of every scenario, in scenario and path order
+    struct SweepTask
+    {
+        int scenarioIndex = 0;
+        int firstPath = 0;
+        int blockPaths = 0;
+        double cost = 0.0;
+    };
+    std::vector<SweepTask> tasks;
+    std::vector<std::size_t> firstTaskOfScenario;
+    for (std::size_t scenarioIndex = 0; scenarioIndex < scenarios.size(); ++scenarioIndex)
+    {
+        int modelIndex = scenarios[scenarioIndex].modelIndex;
+        int numberOfPaths = specification.models[modelIndex].numberOfPaths;
+        firstTaskOfScenario.push_back(tasks.size());
+        for (int firstPath = 0; firstPath < numberOfPaths; firstPath += pathBlockSize)
+        {
+            SweepTask task;
+            task.scenarioIndex = static_cast<int>(scenarioIndex);
+            task.firstPath = firstPath;
+            task.blockPaths = std::min(pathBlockSize, numberOfPaths - firstPath);
+            task.cost = static_cast<double>(timeValues[modelIndex]->size() - 1) * task.blockPaths;
+            tasks.push_back(task);
+        }
+    }
+    firstTaskOfScenario.push_back(tasks.size());
+
+    // Hand out the most expensive tasks first
+    std::vector<int> taskOrder(tasks.size());
+    for (std::size_t i = 0; i < taskOrder.size(); ++i)
+    {
+        taskOrder[i] = static_cast<int>(i);
+    }
+    std::stable_sort(taskOrder.begin(), taskOrder.end(), [&](const int& first, const int& second) { return tasks[first].cost > tasks[second].cost; });
+
+    // Per thread: a sink and two rows of rates
+    int numberOfThreads = threadPool.numberOfThreads();
+    CounterIncrementSource incrementSource(specification.seed);
+    incrementSource.prepare(largestNumberOfTimeSteps, 1, pathBlockSize, numberOfThreads);
+    std::vector<ScenarioBlockSink> sinks(static_cast<std::size_t>(numberOfThreads));
+    std::vector<double> scratch(static_cast<std::size_t>(numberOfThreads) * 2 * pathBlockSize);
+    std::vector<ScenarioSummary> taskSummaries(tasks.size());
+
+    auto runTask = [&](int orderIndex, int threadIndex)
+    {
+        int taskIndex = taskOrder[orderIndex];
+        const SweepTask& task = tasks[taskIndex];
+        const SweepScenario& scenario = scenarios[task.scenarioIndex];
+        const SweepModel& sweepModel = specification.models[scenario.modelIndex];
+        ScenarioBlockSink& sink = sinks[threadIndex];
+        sink.beginBlock(*timeValues[scenario.modelIndex], taskSummaries[taskIndex]);
+        double* threadScratch = scratch.data() + static_cast<std::size_t>(threadIndex) * 2 * pathBlockSize;
+        withSweepModel(sweepModel, scenario.values, [&](const auto& model)
+        {
+            simulatePathBlock(model, *timeValues[scenario.modelIndex], sweepModel.timeStep, task.firstPath, task.blockPaths, specification.seed,
+                incrementSource, sink, threadIndex, threadScratch);
+        });
+    };
+    threadPool.parallelFor(static_cast<int>(tasks.size()), runTask);
+
+    // Merge the blocks of each scenario in path order
+    std::vector<ScenarioSummary> summaries(scenarios.size());
+    for (std::size_t scenarioIndex = 0; scenarioIndex < scenarios.size(); ++scenarioIndex)
+    {
+        for (std::size_t taskIndex = firstTaskOfScenario[scenarioIndex]; taskIndex < firstTaskOfScenario[scenarioIndex + 1]; ++taskIndex)
+        {
+            summaries[scenarioIndex].merge(taskSummaries[taskIndex]);
+        }
+    }
+    return summaries;
+}
+
+/*
+ Writes the summaries of a sweep to one CSV file, a row per scenario.
+
+ @param outputPath The path to the output CSV file.
+ @param specification The sweep.
+ @param scenarios The scenarios of the sweep.
+ @param summaries The summary of every scenario.
+ */
+inline void writeSweepResults(
+    const std::string& outputPath,
+    const SweepSpecification& specification,
+    const std::vector<SweepScenario>& scenarios,
+    const std::vector<ScenarioSummary>& summaries)
+{
+    CsvWriter csvWriter(outputPath);
+    csvWriter.writeRow("Scenario", "Model", "Scheme", "Parameters", "Horizon", "Paths", "MeanTerminalRate", "TerminalRateStandardDeviation",
+        "LowestRate", "HighestRate", "BondPrice", "BondPriceStandardError");
+    for (std::size_t scenarioIndex = 0; scenarioIndex < scenarios.size(); ++scenarioIndex)
+    {
+        const SweepScenario& scenario = scenarios[scenarioIndex];
+        const SweepModel& sweepModel = specification.models[scenario.modelIndex];
+        const ScenarioSummary& summary = summaries[scenarioIndex];
+
+        // Parameters as name=value pairs separated by spaces
+        std::string parameters;
+        for (std::size_t i = 0; i < scenario.values.size(); ++i)
+        {
+            char number[32];
+            std::to_chars_result formatted = std::to_chars(number, number + sizeof(number), scenario.values[i]);
+            parameters += (i == 0 ? "" : " ") + sweepModel.parameters[i].name + "=" + std::string(number, formatted.ptr);
+        }
+        csvWriter.writeRow(static_cast<int>(scenarioIndex), sweepModel.model, sweepSchemeName(sweepModel.scheme), parameters, sweepModel.timeHorizon,
+            sweepModel.numberOfPaths, summary.terminalRate.mean, summary.terminalRate.standardDeviation(), summary.lowestRate, summary.highestRate,
+            summary.discountFactor.mean, summary.discountFactor.standardError());
+    }
+    csvWriter.close();
+}
@@ -0,0 +1,518 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+#include "PathEngine.h"
+
+/*
+ Discretization schemes for one-factor short-rate SDEs
+   dr = drift(t, r) dt + diffusion(t, r) dW.
+
+ A model is a small policy type that holds its parameters and provides
+   drift(time, interestRate)
+   diffusion(time, interestRate)
+   diffusionDerivative(time, interestRate, diffusion)
+                                                 d diffusion / dr, for Milstein
+ and optionally
+   static constexpr bool additiveNoise = true     the diffusion does not depend on r
+   static constexpr bool nonNegativeRates = true  rates are floored at zero after every step
+   exactTransition(startTime, stepLength)        the transition sampled by ExactScheme<>
+ diffusionDerivative() also receives the value of diffusion() at the same
+ point, so power-law models get the derivative without a second power.
+ Additive-noise models need no diffusionDerivative().
+
+ The scheme is a template parameter that wraps the model: EulerScheme<>,
+ MilsteinScheme<>, AdaptiveScheme<> and ExactScheme<> derive from it and
+ are built from it, e.g. MilsteinScheme<CoxIngersollRossModel>{ model }. A
+ bare model steps with Euler. Everything the engine calls is a template, so
+ each model and scheme pair compiles to its own loop over a row of paths
+ with the drift and diffusion inlined.
+ */
+
+/*
+ x^(Numerator / Denominator) for an exponent known at compile time.
+
+ Integer powers are products and halves are square roots, so for example
+ x^(1/2) is std::sqrt(x) and x^(3/2) is x * std::sqrt(x). Exponents with
+ other denominators fall back to std::pow.
+ */
+template <int Numerator, int Denominator>
+inline double rationalPower(const double& x)
+{
+    static_assert(Denominator > 0, "The denominator of the exponent must be positive");
+
+    if constexpr (Numerator == 0)
+    {
+        return 1.0;
+    }
+    else if constexpr (Numerator < 0)
+    {
+        return 1.0 / rationalPower<-Numerator, Denominator>(x);
+    }
+    else if constexpr (Denominator == 1)
+    {
+        return Numerator == 1 ? x : x * rationalPower<Numerator - 1, 1>(x);
+    }
+    else if constexpr (Numerator % Denominator == 0)
+    {
+        return rationalPower<Numerator / Denominator, 1>(x);
+    }
+    else if constexpr (Numerator > Denominator)
+    {
+        // Split off the integer part of the exponent
+        return rationalPower<Numerator / Denominator, 1>(x) * rationalPower<Numerator % Denominator, Denominator>(x);
+    }
+    else if constexpr (Numerator % 2 == 0 && Denominator % 2 == 0)
+    {
+        return rationalPower<Numerator / 2, Denominator / 2>(x);
+    }
+    else if constexpr (Denominator == 2)
+    {
+        return std::sqrt(x);
+    }
+    else if constexpr (Denominator % 2 == 0)
+    {
+        // x^(n / 2m) = sqrt(x)^(n / m)
+        return rationalPower<Numerator, Denominator / 2>(std::sqrt(x));
+    }
+    else
+    {
+        return std::pow(x, static_cast<double>(Numerator) / Denominator);
+    }
+}
+
+/*
+ Elasticity policies for the models whose diffusion is a power of the rate.
+
+ GeneralElasticity evaluates the powers with std::pow and the model's
+ elasticity. RationalElasticity<Numerator, Denominator> fixes the elasticity
+ at compile time and ignores the runtime value, so only use it through
+ withSpecializedElasticity() or with a matching elasticity.
+ */
+struct GeneralElasticity
+{
+    // rate^elasticity
+    static double power(const double& rate, const double& elasticity)
+    {
+        return std::pow(rate, elasticity);
+    }
+
+    // rate^(elasticity / 2)
+    static double halfPower(const double& rate, const double& elasticity)
+    {
+        return std::pow(rate, elasticity / 2.0);
+    }
+
+    // rate^(elasticity - 1)
+    static double powerMinusOne(const double& rate, const double& elasticity)
+    {
+        return std::pow(rate, elasticity - 1.0);
+    }
+};
+
+template <int Numerator, int Denominator>
+struct RationalElasticity
+{
+    static constexpr double value = static_cast<double>(Numerator) / Denominator;
+
+    static double power(const double& rate, const double&)
+    {
+        return rationalPower<Numerator, Denominator>(rate);
+    }
+
+    static double halfPower(const double& rate, const double&)
+    {
+        return rationalPower<Numerator, 2 * Denominator>(rate);
+    }
+
+    static double powerMinusOne(const double& rate, const double&)
+    {
+        return rationalPower<Numerator - Denominator, Denominator>(rate);
+    }
+};
+
+/*
+ Calls function with the model specialized for its elasticity when that is
+ one of the common exponents 0, 1/2, 1, 3/2 and 2, and with the general
+ model otherwise. The specialized models replace std::pow with products and
+ square roots.
+
+ @param model The model with a GeneralElasticity.
+ @param function Called with the specialized model; every specialization must return the same type.
+ @return The result of function.
+ */
+template <template <typename> class BasicModel, typename Function>
+decltype(auto) withSpecializedElasticity(const BasicModel<GeneralElasticity>& model, Function&& function)
+{
+    if (model.elasticity == 0.0)
+    {
+        return function(model.template withElasticity<RationalElasticity<0, 1>>());
+    }
+    if (model.elasticity == 0.5)
+    {
+        return function(model.template withElasticity<RationalElasticity<1, 2>>());
+    }
+    if (model.elasticity == 1.0)
+    {
+        return function(model.template withElasticity<RationalElasticity<1, 1>>());
+    }
+    if (model.elasticity == 1.5)
+    {
+        return function(model.template withElasticity<RationalElasticity<3, 2>>());
+    }
+    if (model.elasticity == 2.0)
+    {
+        return function(model.template withElasticity<RationalElasticity<2, 1>>());
+    }
+    return function(model);
+}
+
+/*
+ True for models that declare additiveNoise = true.
+ */
+template <typename Model, typename = void>
+struct HasAdditiveNoise : std::false_type
+{
+};
+
+template <typename Model>
+struct HasAdditiveNoise<Model, std::enable_if_t<Model::additiveNoise>> : std::true_type
+{
+};
+
+/*
+ True for models that declare nonNegativeRates = true.
+ */
+template <typename Model, typename = void>
+struct HasNonNegativeRates : std::false_type
+{
+};
+
+template <typename Model>
+struct HasNonNegativeRates<Model, std::enable_if_t<Model::nonNegativeRates>> : std::true_type
+{
+};
+
+/*
+ Applies the model's constraint on the rate at the end of a step.
+ */
+template <typename Model>
+inline double constrainRate(const double& interestRate)
+{
+    if constexpr (HasNonNegativeRates<Model>::value)
+    {
+        return std::max(0.0, interestRate);
+    }
+    else
+    {
+        return interestRate;
+    }
+}
+
+/*
+ One Euler-Maruyama step: r + drift(t, r) h + diffusion(t, r) sqrt(h) Z,
+ with the coefficients taken at the start of the step.
+
+ @param model The model to step.
+ @param step The time step being taken.
+ @param interestRate The rate at the start of the step.
+ @param randomIncrement The standard normal increment of the step.
+ @return The rate at the end of the step.
+ */
+template <typename Model>
+inline double eulerStep(const Model& model, const TimeStep& step, const double& interestRate, const double& randomIncrement)
+{
+    return constrainRate<Model>(interestRate +
+        model.drift(step.startTime, interestRate) * step.length +
+        model.diffusion(step.startTime, interestRate) * step.squareRootLength * randomIncrement);
+}
+
+/*
+ One Milstein step: the Euler step plus 0.5 diffusion diffusion' h (Z^2 - 1),
+ which raises the strong order from 0.5 to 1 for state-dependent diffusions.
+ With additive noise the correction vanishes and this is the Euler step.
+
+ @param model The model to step.
+ @param step The time step being taken.
+ @param interestRate The rate at the start of the step.
+ @param randomIncrement The standard normal increment of the step.
+ @return The rate at the end of the step.
+ */
+template <typename Model>
+inline double milsteinStep(const Model& model, const TimeStep& step, const double& interestRate, const double& randomIncrement)
+{
+    if constexpr (HasAdditiveNoise<Model>::value)
+    {
+        return eulerStep(model, step, interestRate, randomIncrement);
+    }
+    else
+    {
+        double diffusion = model.diffusion(step.startTime, interestRate);
+        double correction = 0.5 * diffusion * model.diffusionDerivative(step.startTime, interestRate, diffusion) * step.length * (randomIncrement * randomIncrement - 1.0);
+        return constrainRate<Model>(interestRate +
+            model.drift(step.startTime, interestRate) * step.length +
+            diffusion * step.squareRootLength * randomIncrement + correction);
+    }
+}
+
+/*
+ Drives a model with Euler steps, which is also what the bare model does.
+ */
+template <typename Model>
+struct EulerScheme : Model
+{
+};
+
+/*
+ Drives a model with Milstein steps.
+ */
+template <typename Model>
+struct MilsteinScheme : Model
+{
+};
+
+/*
+ Drives a model with Milstein steps whose length adapts to the local error.
+
+ Each step of the grid is compared with two half steps along the same
+ Brownian path, whose midpoint is drawn from the Brownian bridge. Where the
+ two differ by more than tolerance * sqrt(length), or the halves leave the
+ domain of the model, each half is refined the same way, up to
+ maximumRefinements times. Local errors of that size add up to a global
+ error of the order of tolerance * sqrt(horizon). Steps then shrink only
+ where the diffusion is steep, such as near zero for CKLS and CEV, and stay
+ at the grid spacing elsewhere. The grid increments are those of the increment
+ source. The bridge draw of every node of the refinement tree has its own
+ counter in substream stepIndex of the path's stream, so the Brownian path
+ depends neither on the tolerance nor on the blocks or threads, and runs
+ with different tolerances can be compared path by path.
+
+ Construct it from the model and the error control, e.g.
+ AdaptiveScheme<ChanKarolyiLongstaffSandersModel>{ { model }, 1e-4, 8 }.
+ */
+template <typename Model>
+struct AdaptiveScheme : Model
+{
+    double tolerance = 1e-4;        // Allowed local error per square root of unit time
+    int maximumRefinements = 8;     // Steps are at least the grid step / 2^maximumRefinements
+};
+
+/*
+ Returns the standard normal Brownian bridge draw of the midpoint of a node
+ of the refinement tree of AdaptiveMilsteinStepper.
+
+ The steps of a grid step form a binary tree: the grid step is node 1 and
+ the halves of node k are nodes 2k and 2k + 1. The midpoint of node k is
+ drawn from uniform k % 2 of counter block k / 2 of the path's bridge
+ substream, so the two halves of a node share one block. With the draw N
+ of its midpoint, the halves of a step with standard normal increment Z
+ have the increments (Z + N) / sqrt(2) and (Z - N) / sqrt(2).
+
+ @param bridgeStream The substream of the path that holds the Brownian bridge draws.
+ @param node The node of the step in the tree, from 1.
+ */
+inline double bridgeMidpointNormal(const CounterRandomStream& bridgeStream, const std::uint32_t& node)
+{
+    double uniforms[2];
+    counterUniformPair(bridgeStream.seed, bridgeStream.pathIndex, bridgeStream.substream, node / 2, uniforms[0], uniforms[1]);
+    return inverseStandardNormal(uniforms[node % 2]);
+}
+
+/*
+ Advances rates across grid steps with adaptive Milstein steps (see AdaptiveScheme).
+
+ The steps of a grid step are refined along the tree of bridgeMidpointNormal().
+ */
+template <typename Model>
+class AdaptiveMilsteinStepper
+{
+public:
+    /*
+     @param stepperModel The model to step.
+     @param stepperTolerance The allowed local error per square root of unit time.
+     @param stepperRefinements The number of times a grid step may be halved.
+     */
+    AdaptiveMilsteinStepper(const Model& stepperModel, const double& stepperTolerance, const int& stepperRefinements)
+        : model(stepperModel), tolerance(stepperTolerance), maximumRefinements(stepperRefinements)
+    {
+    }
+
+    /*
+     Advances one rate across a grid step.
+
+     @param step The grid step.
+     @param interestRate The rate at the start of the step.
+     @param randomIncrement The standard normal increment of the grid step.
+     @param bridgeStream The substream of the path that holds the Brownian bridge draws.
+     @return The rate at the end of the step.
+     */
+    double advance(const TimeStep& step, const double& interestRate, const double& randomIncrement, const CounterRandomStream& bridgeStream)
+    {
+        double wholeRate = milsteinStep(model, step, interestRate, randomIncrement);
+        if (maximumRefinements <= 0)
+        {
+            ++substeps;
+            return wholeRate;
+        }
+        return refine(step, interestRate, randomIncrement, wholeRate, bridgeMidpointNormal(bridgeStream, 1), 1, maximumRefinements, bridgeStream);
+    }
+
+    // The number of Milstein steps taken so far
+    long long substepCount() const
+    {
+        return substeps;
+    }
+
+private:
+    /*
+     Compares a step with its two halves and keeps or refines the halves.
+
+     @param step The step.
+     @param interestRate The rate at the start of the step.
+     @param randomIncrement The standard normal increment of the step.
+     @param wholeRate The rate at the end of one Milstein step across it.
+     @param midpointNormal The bridge draw of its midpoint.
+     @param node The node of the step in the tree.
+     @param refinements The number of times the step may still be halved, at least one.
+     @param bridgeStream The substream of the path that holds the Brownian bridge draws.
+     @return The rate at the end of the step.
+     */
+    double refine(
+        const TimeStep& step,
+        const double& interestRate,
+        const double& randomIncrement,
+        const double& wholeRate,
+        const double& midpointNormal,
+        const std::uint32_t& node,
+        const int& refinements,
+        const CounterRandomStream& bridgeStream)
+    {
+        const double halfSquareRoot = 0.70710678118654752440;
+
+        // With the bridge the halves have standard normal increments (Z + N) / sqrt(2) and (Z - N) / sqrt(2)
+        TimeStep firstHalf = step;
+        firstHalf.length = 0.5 * step.length;
+        firstHalf.squareRootLength = halfSquareRoot * step.squareRootLength;
+        firstHalf.endTime = step.startTime + firstHalf.length;
+        TimeStep secondHalf = firstHalf;
+        secondHalf.startTime = firstHalf.endTime;
+        secondHalf.endTime = step.endTime;
+        double firstIncrement = halfSquareRoot * (randomIncrement + midpointNormal);
+        double secondIncrement = halfSquareRoot * (randomIncrement - midpointNormal);
+
+        double midpointRate = milsteinStep(model, firstHalf, interestRate, firstIncrement);
+        double endRate = milsteinStep(model, secondHalf, midpointRate, secondIncrement);
+
+        // Keep the halves if they agree with the whole step and stay where the model is defined (the
+        // powers of CEV are not for negative rates), or if they cannot be split further
+        bool inDomain = endRate >= 0.0 || std::isfinite(model.diffusion(secondHalf.endTime, endRate));
+        if (refinements == 1 || (std::abs(endRate - wholeRate) <= tolerance * step.squareRootLength && inDomain))
+        {
+            substeps += 2;
+            return endRate;
+        }
+
+        midpointRate = refine(firstHalf, interestRate, firstIncrement, midpointRate, bridgeMidpointNormal(bridgeStream, 2 * node), 2 * node, refinements - 1, bridgeStream);
+        double secondWholeRate = milsteinStep(model, secondHalf, midpointRate, secondIncrement);
+        return refine(secondHalf, midpointRate, secondIncrement, secondWholeRate, bridgeMidpointNormal(bridgeStream, 2 * node + 1), 2 * node + 1, refinements - 1,
+            bridgeStream);
+    }
+
+    const Model& model;
+    double tolerance;
+    int maximumRefinements;
+    long long substeps = 0;
+};
+
+/*
+ Drives a model with its exact transition instead of a discretized step, so
+ a step can be as long as the spacing of the observation dates.
+
+ Construct it from the model, e.g. ExactScheme<VasicekModel>{ vasicekModel }.
+ Only models with an exactTransition() can be used.
+ */
+template <typename Model>
+struct ExactScheme : Model
+{
+};
+
+/*
+ Advances one rate by one step with the scheme of the model.
+ */
+template <typename Model>
+inline double advanceRate(const Model& model, const TimeStep& step, const double& interestRate, const double& randomIncrement)
+{
+    return eulerStep(model, step, interestRate, randomIncrement);
+}
+
+template <typename Model>
+inline double advanceRate(const MilsteinScheme<Model>& model, const TimeStep& step, const double& interestRate, const double& randomIncrement)
+{
+    return milsteinStep(static_cast<const Model&>(model), step, interestRate, randomIncrement);
+}
+
+/*
+ Advances a row of paths by one time step.
+
+ This generic version applies advanceRate() to every path. Models with a
+ vectorized kernel or a transition shared by the whole row provide a
+ non-template overload, which the engine picks up in its place.
+
+ @param model The short-rate model to simulate, possibly wrapped in a scheme.
+ @param step The time step being taken.
+ @param previousRates The rates at the start of the step.
+ @param randomIncrements One standard normal increment per path.
+ @param currentRates Receives the rates at the end of the step.
+ @param numberOfPaths The number of paths in the row.
+ */
+template <typename Model>
+void advancePaths(
+    const Model& model,
+    const TimeStep& step,
+    const double* previousRates,
+    const double* randomIncrements,
+    double* currentRates,
+    const int& numberOfPaths)
+{
+    for (int path = 0; path < numberOfPaths; ++path)
+    {
+        currentRates[path] = advanceRate(model, step, previousRates[path], randomIncrements[path]);
+    }
+}
+
+template <typename Model>
+void advancePaths(
+    const AdaptiveScheme<Model>& model,
+    const TimeStep& step,
+    const double* previousRates,
+    const double* randomIncrements,
+    double* currentRates,
+    const int& numberOfPaths)
+{
+    AdaptiveMilsteinStepper<Model> stepper(model, model.tolerance, model.maximumRefinements);
+    for (int path = 0; path < numberOfPaths; ++path)
+    {
+        CounterRandomStream bridgeStream(step.seed, step.firstPath + static_cast<std::uint64_t>(path), static_cast<std::uint32_t>(step.stepIndex));
+        currentRates[path] = stepper.advance(step, previousRates[path], randomIncrements[path], bridgeStream);
+    }
+}
+
+template <typename Model>
+void advancePaths(
+    const ExactScheme<Model>& model,
+    const TimeStep& step,
+    const double* previousRates,
+    const double* randomIncrements,
+    double* currentRates,
+    const int& numberOfPaths)
+{
+    // One transition serves every path in the row
+    auto transition = model.exactTransition(step.startTime, step.length);
+    for (int path = 0; path < numberOfPaths; ++path)
+    {
+        currentRates[path] = transition.sample(previousRates[path], randomIncrements[path]);
+    }
+}
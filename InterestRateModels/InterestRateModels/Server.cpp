@@ -0,0 +1,46 @@
+#include <iostream>
+#include <csignal>
+#include <string>
+
+#include "SimulationServer.h"
+
+SimulationServer* runningServer = nullptr;
+
+// Stops the server on SIGINT or SIGTERM
+void stopServer(int)
+{
+    if (runningServer != nullptr)
+    {
+        runningServer->stop();
+    }
+}
+
+/*
+ Serves simulation requests until interrupted.
+
+ @param socketPath The path of the Unix domain socket (see SimulationServer.h).
+ */
+void serveSimulations(const std::string& socketPath)
+{
+    SimulationServer server(socketPath);
+    runningServer = &server;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+
+    std::cout << "Listening on " << socketPath << " with " << defaultThreadPool().numberOfThreads() << " threads" << std::endl;
+    server.run();
+    runningServer = nullptr;
+
+    std::cout << "Answered " << server.numberOfRequests() << " requests in " << server.numberOfBatches() << " batches" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    // Serve on the given socket, or on irm_server.sock in the working directory
+    serveSimulations(argc > 1 ? argv[1] : "irm_server.sock");
+
+    // Write the profiling report, if built with INTEREST_RATE_MODELS_PROFILING
+    INTEREST_RATE_MODELS_PROFILE_REPORT("server_profile.json", true);
+
+    return 0;
+}
\ No newline at end of file
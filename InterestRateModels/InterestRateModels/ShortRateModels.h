@@ -0,0 +1,358 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+#include "PathEngine.h"
+#include "RandomVariates.h"
+#include "SdeSchemes.h"
+#include "TimeCurve.h"
+
+/*
+ One-factor short-rate models that can be driven by the path engine.
+
+ Each model is a policy type (see SdeSchemes.h): it holds its parameters and
+ gives the drift and diffusion of its SDE at a time and rate, and the scheme
+ that wraps it decides how a step is taken. The engine applies the step
+ across every path in a batch, so the update must not depend on any other
+ path.
+
+ Hull-White always steps with the exact Gaussian transition of its
+ coefficients frozen over the step, which costs O(1) per step.
+
+ Vasicek, CIR and Ho-Lee also know their exact transition distributions.
+ Wrapping them in ExactScheme<> samples those instead of taking Euler steps,
+ so a step can be as long as the spacing of the observation dates.
+ */
+
+/*
+ Exact Gaussian transition over one step:
+ r(t + h) = decay * r(t) + shift + standardDeviation * Z.
+ */
+struct GaussianTransition
+{
+    double decay = 1.0;
+    double shift = 0.0;
+    double standardDeviation = 0.0;
+
+    double sample(const double& interestRate, const double& randomIncrement) const
+    {
+        return decay * interestRate + shift + standardDeviation * randomIncrement;
+    }
+};
+
+/*
+ Exact square-root diffusion transition over one step:
+ r(t + h) = scale * X, with X noncentral chi-square with degreesOfFreedom degrees of
+ freedom and noncentrality decay * r(t) / scale.
+ */
+struct NoncentralChiSquareTransition
+{
+    double scale = 0.0;
+    double degreesOfFreedom = 0.0;
+    double decay = 1.0;
+    double mean = 0.0;
+
+    double sample(const double& interestRate, const double& randomIncrement, CounterRandomStream& auxiliaryStream) const
+    {
+        double startRate = std::max(0.0, interestRate);
+
+        // Without volatility the rate follows its deterministic mean path
+        if (scale <= 0.0)
+        {
+            return mean + decay * (startRate - mean);
+        }
+        double noncentrality = decay * startRate / scale;
+        return scale * sampleNoncentralChiSquare(auxiliaryStream, randomIncrement, degreesOfFreedom, noncentrality);
+    }
+};
+
+/*
+ Vasicek model: dr = meanReversionSpeed * (longTermInterestRate - r) dt + volatility dW.
+ */
+struct VasicekModel
+{
+    static constexpr bool additiveNoise = true;
+
+    double meanReversionSpeed = 0.0;
+    double longTermInterestRate = 0.0;
+    double volatility = 0.0;
+    double initialInterestRate = 0.0;
+
+    double drift(const double&, const double& interestRate) const
+    {
+        return meanReversionSpeed * (longTermInterestRate - interestRate);
+    }
+
+    double diffusion(const double&, const double&) const
+    {
+        return volatility;
+    }
+
+    /*
+     Returns the exact transition over a step of the given length.
+     */
+    GaussianTransition exactTransition(const double&, const double& stepLength) const
+    {
+        GaussianTransition transition;
+        transition.decay = std::exp(-meanReversionSpeed * stepLength);
+        transition.shift = -longTermInterestRate * std::expm1(-meanReversionSpeed * stepLength);
+        double varianceFactor = meanReversionSpeed != 0.0
+            ? -std::expm1(-2.0 * meanReversionSpeed * stepLength) / (2.0 * meanReversionSpeed)
+            : stepLength;
+        transition.standardDeviation = volatility * std::sqrt(varianceFactor);
+        return transition;
+    }
+};
+
+/*
+ Cox-Ingersoll-Ross model: dr = meanReversionRate * (meanReversionLevel - r) dt + volatility sqrt(r) dW.
+ Rates are truncated at zero after every step.
+ */
+struct CoxIngersollRossModel
+{
+    static constexpr bool nonNegativeRates = true;
+
+    double meanReversionLevel = 0.0;
+    double meanReversionRate = 0.0;
+    double volatility = 0.0;
+    double initialInterestRate = 0.0;
+
+    double drift(const double&, const double& interestRate) const
+    {
+        return meanReversionRate * (meanReversionLevel - interestRate);
+    }
+
+    double diffusion(const double&, const double& interestRate) const
+    {
+        return volatility * std::sqrt(std::max(0.0, interestRate));
+    }
+
+    double diffusionDerivative(const double&, const double&, const double& diffusion) const
+    {
+        // d volatility sqrt(r) / dr = volatility^2 / (2 volatility sqrt(r))
+        return diffusion > 0.0 ? 0.5 * volatility * volatility / diffusion : 0.0;
+    }
+
+    /*
+     Returns the exact transition over a step of the given length.
+     The sampled rates are non-negative without any truncation.
+     */
+    NoncentralChiSquareTransition exactTransition(const double&, const double& stepLength) const
+    {
+        NoncentralChiSquareTransition transition;
+        double variance = volatility * volatility;
+        double growthFactor = meanReversionRate != 0.0
+            ? -std::expm1(-meanReversionRate * stepLength) / meanReversionRate
+            : stepLength;
+        transition.scale = variance * growthFactor / 4.0;
+        transition.degreesOfFreedom = variance > 0.0 ? 4.0 * meanReversionRate * meanReversionLevel / variance : 0.0;
+        transition.decay = std::exp(-meanReversionRate * stepLength);
+        transition.mean = meanReversionLevel;
+        return transition;
+    }
+};
+
+/*
+ Chan-Karolyi-Longstaff-Sanders model: dr = (driftTerm - meanReversionRate * r) dt + volatility |r|^elasticity dW.
+
+ The Elasticity policy evaluates the power; ChanKarolyiLongstaffSandersModel
+ uses std::pow, and withSpecializedElasticity() picks a compiled exponent.
+ */
+template <typename Elasticity = GeneralElasticity>
+struct BasicChanKarolyiLongstaffSandersModel
+{
+    double driftTerm = 0.0;
+    double meanReversionRate = 0.0;
+    double elasticity = 0.0;
+    double volatility = 0.0;
+    double initialInterestRate = 0.0;
+
+    double drift(const double&, const double& interestRate) const
+    {
+        return driftTerm - meanReversionRate * interestRate;
+    }
+
+    double diffusion(const double&, const double& interestRate) const
+    {
+        return volatility * Elasticity::power(std::abs(interestRate), elasticity);
+    }
+
+    double diffusionDerivative(const double&, const double& interestRate, const double& diffusion) const
+    {
+        // d|r|^e / dr = e |r|^e / r
+        return interestRate != 0.0 ? elasticity * diffusion / interestRate : 0.0;
+    }
+
+    template <typename OtherElasticity>
+    BasicChanKarolyiLongstaffSandersModel<OtherElasticity> withElasticity() const
+    {
+        return { driftTerm, meanReversionRate, elasticity, volatility, initialInterestRate };
+    }
+};
+
+using ChanKarolyiLongstaffSandersModel = BasicChanKarolyiLongstaffSandersModel<>;
+
+/*
+ Constant Elasticity of Variance model:
+ dr = (driftTerm * r^(elasticity - 1) + meanReversionRate * r) dt + volatility r^(elasticity / 2) dW.
+
+ The Elasticity policy evaluates the powers; ConstantElasticityVarianceModel
+ uses std::pow, and withSpecializedElasticity() picks compiled exponents.
+ */
+template <typename Elasticity = GeneralElasticity>
+struct BasicConstantElasticityVarianceModel
+{
+    double meanReversionRate = 0.0;
+    double driftTerm = 0.0;
+    double elasticity = 0.0;
+    double volatility = 0.0;
+    double initialInterestRate = 0.0;
+
+    double drift(const double&, const double& interestRate) const
+    {
+        return driftTerm * Elasticity::powerMinusOne(interestRate, elasticity) + meanReversionRate * interestRate;
+    }
+
+    double diffusion(const double&, const double& interestRate) const
+    {
+        return volatility * Elasticity::halfPower(interestRate, elasticity);
+    }
+
+    double diffusionDerivative(const double&, const double& interestRate, const double& diffusion) const
+    {
+        // d r^(e / 2) / dr = (e / 2) r^(e / 2) / r
+        return interestRate != 0.0 ? 0.5 * elasticity * diffusion / interestRate : 0.0;
+    }
+
+    template <typename OtherElasticity>
+    BasicConstantElasticityVarianceModel<OtherElasticity> withElasticity() const
+    {
+        return { meanReversionRate, driftTerm, elasticity, volatility, initialInterestRate };
+    }
+};
+
+using ConstantElasticityVarianceModel = BasicConstantElasticityVarianceModel<>;
+
+/*
+ Ho and Lee model: dr = driftTerm * t dt + volatility dW, started from zero.
+ */
+struct HoAndLeeModel
+{
+    static constexpr bool additiveNoise = true;
+
+    double driftTerm = 0.0;
+    double volatility = 0.0;
+    double initialInterestRate = 0.0;
+
+    double drift(const double& time, const double&) const
+    {
+        return driftTerm * time;
+    }
+
+    double diffusion(const double&, const double&) const
+    {
+        return volatility;
+    }
+
+    /*
+     Returns the exact transition over a step starting at the given time.
+     */
+    GaussianTransition exactTransition(const double& startTime, const double& stepLength) const
+    {
+        GaussianTransition transition;
+        transition.shift = driftTerm * stepLength * (startTime + 0.5 * stepLength);
+        transition.standardDeviation = volatility * std::sqrt(stepLength);
+        return transition;
+    }
+};
+
+/*
+ Hull-White model: dr = (theta(t) - alpha(t) r) dt + sigma(t) dW.
+
+ theta, alpha and sigma are curves on their own time grids. Over each step
+ they are frozen at the step midpoint, and the rate moves with the exact
+ Ornstein-Uhlenbeck transition for those values. That carries the
+ integrals of the explicit solution forward one step at a time, so a path
+ costs O(1) per step and the step count is unrelated to the curve grids.
+ */
+struct HullWhiteModel
+{
+    static constexpr bool additiveNoise = true;
+
+    TimeCurve theta;
+    TimeCurve alpha;
+    TimeCurve sigma;
+    double initialInterestRate = 0.0;
+
+    double drift(const double& time, const double& interestRate) const
+    {
+        return theta.valueAt(time) - alpha.valueAt(time) * interestRate;
+    }
+
+    double diffusion(const double& time, const double&) const
+    {
+        return sigma.valueAt(time);
+    }
+
+    /*
+     Returns the transition over a step starting at the given time.
+     */
+    GaussianTransition exactTransition(const double& startTime, const double& stepLength) const
+    {
+        double midpoint = startTime + 0.5 * stepLength;
+        double meanReversion = alpha.valueAt(midpoint);
+        double volatility = sigma.valueAt(midpoint);
+
+        // Integrals of exp(-alpha (t + h - s)) and its square over the step
+        double growthFactor = stepLength;
+        double varianceFactor = stepLength;
+        if (meanReversion != 0.0)
+        {
+            growthFactor = -std::expm1(-meanReversion * stepLength) / meanReversion;
+            varianceFactor = -std::expm1(-2.0 * meanReversion * stepLength) / (2.0 * meanReversion);
+        }
+
+        GaussianTransition transition;
+        transition.decay = std::exp(-meanReversion * stepLength);
+        transition.shift = theta.valueAt(midpoint) * growthFactor;
+        transition.standardDeviation = volatility * std::sqrt(varianceFactor);
+        return transition;
+    }
+};
+
+inline void advancePaths(
+    const HullWhiteModel& model,
+    const TimeStep& step,
+    const double* previousRates,
+    const double* randomIncrements,
+    double* currentRates,
+    const int& numberOfPaths)
+{
+    // One set of coefficients serves every path in the row
+    GaussianTransition transition = model.exactTransition(step.startTime, step.length);
+    for (int path = 0; path < numberOfPaths; ++path)
+    {
+        currentRates[path] = transition.sample(previousRates[path], randomIncrements[path]);
+    }
+}
+
+inline void advancePaths(
+    const ExactScheme<CoxIngersollRossModel>& model,
+    const TimeStep& step,
+    const double* previousRates,
+    const double* randomIncrements,
+    double* currentRates,
+    const int& numberOfPaths)
+{
+    NoncentralChiSquareTransition transition = model.exactTransition(step.startTime, step.length);
+    for (int path = 0; path < numberOfPaths; ++path)
+    {
+        // The chi-square draws come from a substream of their own for each step
+        CounterRandomStream auxiliaryStream(step.seed, step.firstPath + static_cast<std::uint64_t>(path), static_cast<std::uint32_t>(step.stepIndex));
+        currentRates[path] = transition.sample(previousRates[path], randomIncrements[path], auxiliaryStream);
+    }
+}
+
+// Vectorized advancePaths overloads for the CKLS and CEV models
+#include "SimdKernels.h"
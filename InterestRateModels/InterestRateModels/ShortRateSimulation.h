@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CsvWriter.h"
+#include "ObservationSchedule.h"
+#include "ResultFile.h"
+#include "ShortRateModels.h"
+
+/*
+ Simulates a single path of a short-rate model and writes it out, which is
+ what every short-rate program does with its model.
+
+ @param model The short-rate model to simulate, possibly wrapped in a scheme.
+ @param modelName The name of the model in a binary result file.
+ @param parameters The model parameters for a binary result file.
+ @param timeHorizon The time horizon of the simulation.
+ @param timeStep The time step of the simulation.
+ @param seed The seed of the random number streams.
+ @param outputFormat The format of the output file.
+ @param outputPath The path to the output file.
+ */
+template <typename Model>
+void simulateShortRatePath(
+    const Model& model,
+    const std::string& modelName,
+    const std::vector<ResultParameter>& parameters,
+    const double& timeHorizon,
+    const double& timeStep,
+    const std::uint64_t& seed,
+    const OutputFormat& outputFormat,
+    const std::string& outputPath)
+{
+    PathStore pathStore = simulatePathBatch(model, timeHorizon, timeStep, 1, seed);
+    INTEREST_RATE_MODELS_PROFILE_SCOPE("output");
+
+    // Output the results to a binary result file
+    if (outputFormat == OutputFormat::Binary)
+    {
+        writeResultFile(outputPath, modelName, parameters, seed, pathStore);
+        return;
+    }
+
+    // Output the results to a CSV file
+    CsvWriter csvWriter(outputPath);
+    csvWriter.writeRow("Time", "InterestRate");
+    for (int i = 0; i <= pathStore.numberOfTimeSteps; ++i)
+    {
+        csvWriter.writeRow(pathStore.timeValues[i], pathStore.rate(i, 0));
+    }
+    csvWriter.close();
+}
+
+/*
+ Simulates a single path of a short-rate model at the fine time step and
+ writes it out on the dates of a schedule only.
+
+ @param model The short-rate model to simulate, possibly wrapped in a scheme.
+ @param modelName The name of the model in a binary result file.
+ @param parameters The model parameters for a binary result file.
+ @param schedule The dates to write; the horizon is the last of them.
+ @param timeStep The time step of the simulation.
+ @param seed The seed of the random number streams.
+ @param outputFormat The format of the output file.
+ @param outputPath The path to the output file.
+ */
+template <typename Model>
+void simulateShortRatePath(
+    const Model& model,
+    const std::string& modelName,
+    const std::vector<ResultParameter>& parameters,
+    const ObservationSchedule& schedule,
+    const double& timeStep,
+    const std::uint64_t& seed,
+    const OutputFormat& outputFormat,
+    const std::string& outputPath)
+{
+    ObservedPathStore observedPathStore(schedule);
+    simulateObservedPaths(model, timeStep, 1, seed, observedPathStore);
+    INTEREST_RATE_MODELS_PROFILE_SCOPE("output");
+
+    // Output the results to a binary result file
+    if (outputFormat == OutputFormat::Binary)
+    {
+        writeResultFile(outputPath, modelName, parameters, seed, observedPathStore);
+        return;
+    }
+
+    // Output the results to a CSV file
+    CsvWriter csvWriter(outputPath);
+    csvWriter.writeRow("Time", "InterestRate");
+    for (int observation = 0; observation < observedPathStore.numberOfObservations(); ++observation)
+    {
+        csvWriter.writeRow(observedPathStore.timeValues[observation], observedPathStore.rate(observation, 0));
+    }
+    csvWriter.close();
+}
@@ -0,0 +1,450 @@
+#pragma once
+
+#include "ShortRateModels.h"
+#include "SimdMath.h"
+
+/*
+ Vectorized Euler and Milstein step kernels for the CKLS and CEV models.
+
+ Both models spend most of their time in std::pow. These kernels advance 4
+ (AVX2) or 8 (AVX-512) paths per instruction, computing pow(x, a) as
+ exp(a * log(x)) with polynomial log and exp approximations that are accurate
+ to a few units in the last place for rates of the size the models visit;
+ the rounding of a * log(x) adds about |a * log(x)| ulps, which only matters
+ for rates far outside that range. Checks/SimdKernelCheck.cpp compares them
+ with the scalar steps. CEV needs two powers of the same rate, so it shares a
+ single log between them.
+
+ Lanes whose rate falls outside the range the approximations handle (zero,
+ negative or non-finite rates, or powers that would overflow) are recomputed
+ with the scalar eulerStep() or milsteinStep(), so special values match the
+ scalar code exactly. The Milstein correction reuses the power of the
+ diffusion, so it costs a division and a few multiplications per path.
+
+ The kernels serve the general-elasticity models, bare or wrapped in
+ EulerScheme<> or MilsteinScheme<>. Models specialized by withSpecializedElasticity() take the
+ generic loop instead, where the powers are products and square roots.
+ */
+
+// The scalar step of the kernels, for the tail of a row and the lanes they do not cover
+template <bool Milstein, typename Model>
+inline double scalarStep(const Model& model, const TimeStep& step, const double& interestRate, const double& randomIncrement)
+{
+    if constexpr (Milstein)
+    {
+        return milsteinStep(model, step, interestRate, randomIncrement);
+    }
+    else
+    {
+        return eulerStep(model, step, interestRate, randomIncrement);
+    }
+}
+
+#if defined(INTEREST_RATE_MODELS_X86_SIMD)
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+template <bool Milstein>
+INTEREST_RATE_MODELS_TARGET_AVX2 inline int advanceChanKarolyiLongstaffSandersPathsAvx2(
+    const ChanKarolyiLongstaffSandersModel& model,
+    const TimeStep& step,
+    const double* previousRates,
+    const double* randomIncrements,
+    double* currentRates,
+    const int& numberOfPaths)
+{
+    __m256d driftTerm = _mm256_set1_pd(model.driftTerm);
+    __m256d meanReversionRate = _mm256_set1_pd(model.meanReversionRate);
+    __m256d elasticity = _mm256_set1_pd(model.elasticity);
+    __m256d volatility = _mm256_set1_pd(model.volatility);
+    __m256d timeStep = _mm256_set1_pd(step.length);
+    __m256d squareRootTimeStep = _mm256_set1_pd(step.squareRootLength);
+
+    int path = 0;
+    for (; path + 4 <= numberOfPaths; path += 4)
+    {
+        __m256d interestRate = _mm256_loadu_pd(previousRates + path);
+        __m256d randomIncrement = _mm256_loadu_pd(randomIncrements + path);
+
+        // |r|^elasticity = exp(elasticity * log|r|)
+        __m256d absoluteRate = _mm256_andnot_pd(_mm256_set1_pd(-0.0), interestRate);
+        __m256d exponent = _mm256_mul_pd(elasticity, logAvx2(absoluteRate));
+        __m256d power = expAvx2(exponent);
+
+        // Update the interest rate using the CKLS SDE
+        __m256d drift = _mm256_mul_pd(_mm256_sub_pd(driftTerm, _mm256_mul_pd(meanReversionRate, interestRate)), timeStep);
+        __m256d diffusion = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(volatility, power), squareRootTimeStep), randomIncrement);
+        __m256d nextRate = _mm256_add_pd(_mm256_add_pd(interestRate, drift), diffusion);
+        if constexpr (Milstein)
+        {
+            // 0.5 sigma(r) sigma'(r) h (Z^2 - 1), with sigma'(r) = elasticity sigma(r) / r
+            __m256d diffusionCoefficient = _mm256_mul_pd(volatility, power);
+            __m256d derivative = _mm256_div_pd(_mm256_mul_pd(elasticity, diffusionCoefficient), interestRate);
+            __m256d squaredIncrement = _mm256_sub_pd(_mm256_mul_pd(randomIncrement, randomIncrement), _mm256_set1_pd(1.0));
+            __m256d correction = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(0.5), diffusionCoefficient), derivative), _mm256_mul_pd(timeStep, squaredIncrement));
+            nextRate = _mm256_add_pd(nextRate, correction);
+        }
+        _mm256_storeu_pd(currentRates + path, nextRate);
+
+        // Recompute lanes the approximations do not cover with the scalar formula
+        __m256d valid = _mm256_and_pd(inLogRangeAvx2(absoluteRate), inExpRangeAvx2(exponent));
+        int validLanes = _mm256_movemask_pd(valid);
+        if (validLanes != 0xF)
+        {
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                if ((validLanes & (1 << lane)) == 0)
+                {
+                    currentRates[path + lane] = scalarStep<Milstein>(model, step, previousRates[path + lane], randomIncrements[path + lane]);
+                }
+            }
+        }
+    }
+    return path;
+}
+
+template <bool Milstein>
+INTEREST_RATE_MODELS_TARGET_AVX512 inline int advanceChanKarolyiLongstaffSandersPathsAvx512(
+    const ChanKarolyiLongstaffSandersModel& model,
+    const TimeStep& step,
+    const double* previousRates,
+    const double* randomIncrements,
+    double* currentRates,
+    const int& numberOfPaths)
+{
+    __m512d driftTerm = _mm512_set1_pd(model.driftTerm);
+    __m512d meanReversionRate = _mm512_set1_pd(model.meanReversionRate);
+    __m512d elasticity = _mm512_set1_pd(model.elasticity);
+    __m512d volatility = _mm512_set1_pd(model.volatility);
+    __m512d timeStep = _mm512_set1_pd(step.length);
+    __m512d squareRootTimeStep = _mm512_set1_pd(step.squareRootLength);
+
+    int path = 0;
+    for (; path + 8 <= numberOfPaths; path += 8)
+    {
+        __m512d interestRate = _mm512_loadu_pd(previousRates + path);
+        __m512d randomIncrement = _mm512_loadu_pd(randomIncrements + path);
+
+        // |r|^elasticity = exp(elasticity * log|r|)
+        __m512d absoluteRate = _mm512_abs_pd(interestRate);
+        __m512d exponent = _mm512_mul_pd(elasticity, logAvx512(absoluteRate));
+        __m512d power = expAvx512(exponent);
+
+        // Update the interest rate using the CKLS SDE
+        __m512d drift = _mm512_mul_pd(_mm512_sub_pd(driftTerm, _mm512_mul_pd(meanReversionRate, interestRate)), timeStep);
+        __m512d diffusion = _mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(volatility, power), squareRootTimeStep), randomIncrement);
+        __m512d nextRate = _mm512_add_pd(_mm512_add_pd(interestRate, drift), diffusion);
+        if constexpr (Milstein)
+        {
+            // 0.5 sigma(r) sigma'(r) h (Z^2 - 1), with sigma'(r) = elasticity sigma(r) / r
+            __m512d diffusionCoefficient = _mm512_mul_pd(volatility, power);
+            __m512d derivative = _mm512_div_pd(_mm512_mul_pd(elasticity, diffusionCoefficient), interestRate);
+            __m512d squaredIncrement = _mm512_sub_pd(_mm512_mul_pd(randomIncrement, randomIncrement), _mm512_set1_pd(1.0));
+            __m512d correction = _mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(0.5), diffusionCoefficient), derivative), _mm512_mul_pd(timeStep, squaredIncrement));
+            nextRate = _mm512_add_pd(nextRate, correction);
+        }
+        _mm512_storeu_pd(currentRates + path, nextRate);
+
+        // Recompute lanes the approximations do not cover with the scalar formula
+        __mmask8 validLanes = inLogRangeAvx512(absoluteRate) & inExpRangeAvx512(exponent);
+        if (validLanes != 0xFF)
+        {
+            for (int lane = 0; lane < 8; ++lane)
+            {
+                if ((validLanes & (1 << lane)) == 0)
+                {
+                    currentRates[path + lane] = scalarStep<Milstein>(model, step, previousRates[path + lane], randomIncrements[path + lane]);
+                }
+            }
+        }
+    }
+    return path;
+}
+
+template <bool Milstein>
+INTEREST_RATE_MODELS_TARGET_AVX2 inline int advanceConstantElasticityVariancePathsAvx2(
+    const ConstantElasticityVarianceModel& model,
+    const TimeStep& step,
+    const double* previousRates,
+    const double* randomIncrements,
+    double* currentRates,
+    const int& numberOfPaths)
+{
+    __m256d meanReversionRate = _mm256_set1_pd(model.meanReversionRate);
+    __m256d driftTerm = _mm256_set1_pd(model.driftTerm);
+    __m256d driftElasticity = _mm256_set1_pd(model.elasticity - 1.0);
+    __m256d diffusionElasticity = _mm256_set1_pd(model.elasticity / 2.0);
+    __m256d volatility = _mm256_set1_pd(model.volatility);
+    __m256d timeStep = _mm256_set1_pd(step.length);
+    __m256d squareRootTimeStep = _mm256_set1_pd(step.squareRootLength);
+
+    int path = 0;
+    for (; path + 4 <= numberOfPaths; path += 4)
+    {
+        __m256d interestRate = _mm256_loadu_pd(previousRates + path);
+        __m256d randomIncrement = _mm256_loadu_pd(randomIncrements + path);
+
+        // Both powers share one log of the rate
+        __m256d logRate = logAvx2(interestRate);
+        __m256d driftExponent = _mm256_mul_pd(driftElasticity, logRate);
+        __m256d diffusionExponent = _mm256_mul_pd(diffusionElasticity, logRate);
+        __m256d driftPower = expAvx2(driftExponent);
+        __m256d diffusionPower = expAvx2(diffusionExponent);
+
+        // Update the interest rate using the CEV SDE
+        __m256d drift = _mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(driftTerm, driftPower), _mm256_mul_pd(meanReversionRate, interestRate)), timeStep);
+        __m256d diffusion = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(volatility, diffusionPower), squareRootTimeStep), randomIncrement);
+        __m256d nextRate = _mm256_add_pd(_mm256_add_pd(interestRate, drift), diffusion);
+        if constexpr (Milstein)
+        {
+            // 0.5 sigma(r) sigma'(r) h (Z^2 - 1), with sigma'(r) = (elasticity / 2) sigma(r) / r
+            __m256d diffusionCoefficient = _mm256_mul_pd(volatility, diffusionPower);
+            __m256d derivative = _mm256_div_pd(_mm256_mul_pd(diffusionElasticity, diffusionCoefficient), interestRate);
+            __m256d squaredIncrement = _mm256_sub_pd(_mm256_mul_pd(randomIncrement, randomIncrement), _mm256_set1_pd(1.0));
+            __m256d correction = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(0.5), diffusionCoefficient), derivative), _mm256_mul_pd(timeStep, squaredIncrement));
+            nextRate = _mm256_add_pd(nextRate, correction);
+        }
+        _mm256_storeu_pd(currentRates + path, nextRate);
+
+        // Recompute lanes the approximations do not cover with the scalar formula
+        __m256d valid = _mm256_and_pd(inLogRangeAvx2(interestRate),
+            _mm256_and_pd(inExpRangeAvx2(driftExponent), inExpRangeAvx2(diffusionExponent)));
+        int validLanes = _mm256_movemask_pd(valid);
+        if (validLanes != 0xF)
+        {
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                if ((validLanes & (1 << lane)) == 0)
+                {
+                    currentRates[path + lane] = scalarStep<Milstein>(model, step, previousRates[path + lane], randomIncrements[path + lane]);
+                }
+            }
+        }
+    }
+    return path;
+}
+
+template <bool Milstein>
+INTEREST_RATE_MODELS_TARGET_AVX512 inline int advanceConstantElasticityVariancePathsAvx512(
+    const ConstantElasticityVarianceModel& model,
+    const TimeStep& step,
+    const double* previousRates,
+    const double* randomIncrements,
+    double* currentRates,
+    const int& numberOfPaths)
+{
+    __m512d meanReversionRate = _mm512_set1_pd(model.meanReversionRate);
+    __m512d driftTerm = _mm512_set1_pd(model.driftTerm);
+    __m512d driftElasticity = _mm512_set1_pd(model.elasticity - 1.0);
+    __m512d diffusionElasticity = _mm512_set1_pd(model.elasticity / 2.0);
+    __m512d volatility = _mm512_set1_pd(model.volatility);
+    __m512d timeStep = _mm512_set1_pd(step.length);
+    __m512d squareRootTimeStep = _mm512_set1_pd(step.squareRootLength);
+
+    int path = 0;
+    for (; path + 8 <= numberOfPaths; path += 8)
+    {
+        __m512d interestRate = _mm512_loadu_pd(previousRates + path);
+        __m512d randomIncrement = _mm512_loadu_pd(randomIncrements + path);
+
+        // Both powers share one log of the rate
+        __m512d logRate = logAvx512(interestRate);
+        __m512d driftExponent = _mm512_mul_pd(driftElasticity, logRate);
+        __m512d diffusionExponent = _mm512_mul_pd(diffusionElasticity, logRate);
+        __m512d driftPower = expAvx512(driftExponent);
+        __m512d diffusionPower = expAvx512(diffusionExponent);
+
+        // Update the interest rate using the CEV SDE
+        __m512d drift = _mm512_mul_pd(_mm512_add_pd(_mm512_mul_pd(driftTerm, driftPower), _mm512_mul_pd(meanReversionRate, interestRate)), timeStep);
+        __m512d diffusion = _mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(volatility, diffusionPower), squareRootTimeStep), randomIncrement);
+        __m512d nextRate = _mm512_add_pd(_mm512_add_pd(interestRate, drift), diffusion);
+        if constexpr (Milstein)
+        {
+            // 0.5 sigma(r) sigma'(r) h (Z^2 - 1), with sigma'(r) = (elasticity / 2) sigma(r) / r
+            __m512d diffusionCoefficient = _mm512_mul_pd(volatility, diffusionPower);
+            __m512d derivative = _mm512_div_pd(_mm512_mul_pd(diffusionElasticity, diffusionCoefficient), interestRate);
+            __m512d squaredIncrement = _mm512_sub_pd(_mm512_mul_pd(randomIncrement, randomIncrement), _mm512_set1_pd(1.0));
+            __m512d correction = _mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(0.5), diffusionCoefficient), derivative), _mm512_mul_pd(timeStep, squaredIncrement));
+            nextRate = _mm512_add_pd(nextRate, correction);
+        }
+        _mm512_storeu_pd(currentRates + path, nextRate);
+
+        // Recompute lanes the approximations do not cover with the scalar formula
+        __mmask8 validLanes = inLogRangeAvx512(interestRate) & inExpRangeAvx512(driftExponent) & inExpRangeAvx512(diffusionExponent);
+        if (validLanes != 0xFF)
+        {
+            for (int lane = 0; lane < 8; ++lane)
+            {
+                if ((validLanes & (1 << lane)) == 0)
+                {
+                    currentRates[path + lane] = scalarStep<Milstein>(model, step, previousRates[path + lane], randomIncrements[path + lane]);
+                }
+            }
+        }
+    }
+    return path;
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+/*
+ Advances a row of CKLS paths by one time step using the requested instruction set.
+ Milstein selects the Milstein step instead of the Euler step.
+
+ @param simdLevel The instruction set to use. Levels the build does not support fall back to scalar.
+ @param model The CKLS model.
+ @param step The time step being taken.
+ @param previousRates The rates at the start of the step.
+ @param randomIncrements One standard normal increment per path.
+ @param currentRates Receives the rates at the end of the step.
+ @param numberOfPaths The number of paths in the row.
+ */
+template <bool Milstein = false>
+inline void advanceChanKarolyiLongstaffSandersPaths(
+    const SimdLevel& simdLevel,
+    const ChanKarolyiLongstaffSandersModel& model,
+    const TimeStep& step,
+    const double* previousRates,
+    const double* randomIncrements,
+    double* currentRates,
+    const int& numberOfPaths)
+{
+    int path = 0;
+
+#if defined(INTEREST_RATE_MODELS_X86_SIMD)
+    if (simdLevel == SimdLevel::Avx512)
+    {
+        path = advanceChanKarolyiLongstaffSandersPathsAvx512<Milstein>(model, step, previousRates, randomIncrements, currentRates, numberOfPaths);
+    }
+    else if (simdLevel == SimdLevel::Avx2)
+    {
+        path = advanceChanKarolyiLongstaffSandersPathsAvx2<Milstein>(model, step, previousRates, randomIncrements, currentRates, numberOfPaths);
+    }
+#else
+    (void)simdLevel;
+#endif
+
+    // Finish the remaining paths with the scalar formula
+    for (; path < numberOfPaths; ++path)
+    {
+        currentRates[path] = scalarStep<Milstein>(model, step, previousRates[path], randomIncrements[path]);
+    }
+}
+
+/*
+ Advances a row of CEV paths by one time step using the requested instruction set.
+ Milstein selects the Milstein step instead of the Euler step.
+
+ @param simdLevel The instruction set to use. Levels the build does not support fall back to scalar.
+ @param model The CEV model.
+ @param step The time step being taken.
+ @param previousRates The rates at the start of the step.
+ @param randomIncrements One standard normal increment per path.
+ @param currentRates Receives the rates at the end of the step.
+ @param numberOfPaths The number of paths in the row.
+ */
+template <bool Milstein = false>
+inline void advanceConstantElasticityVariancePaths(
+    const SimdLevel& simdLevel,
+    const ConstantElasticityVarianceModel& model,
+    const TimeStep& step,
+    const double* previousRates,
+    const double* randomIncrements,
+    double* currentRates,
+    const int& numberOfPaths)
+{
+    int path = 0;
+
+#if defined(INTEREST_RATE_MODELS_X86_SIMD)
+    if (simdLevel == SimdLevel::Avx512)
+    {
+        path = advanceConstantElasticityVariancePathsAvx512<Milstein>(model, step, previousRates, randomIncrements, currentRates, numberOfPaths);
+    }
+    else if (simdLevel == SimdLevel::Avx2)
+    {
+        path = advanceConstantElasticityVariancePathsAvx2<Milstein>(model, step, previousRates, randomIncrements, currentRates, numberOfPaths);
+    }
+#else
+    (void)simdLevel;
+#endif
+
+    // Finish the remaining paths with the scalar formula
+    for (; path < numberOfPaths; ++path)
+    {
+        currentRates[path] = scalarStep<Milstein>(model, step, previousRates[path], randomIncrements[path]);
+    }
+}
+
+// Path engine overloads: CKLS and CEV rows go through the dispatched kernels
+inline void advancePaths(
+    const ChanKarolyiLongstaffSandersModel& model,
+    const TimeStep& step,
+    const double* previousRates,
+    const double* randomIncrements,
+    double* currentRates,
+    const int& numberOfPaths)
+{
+    advanceChanKarolyiLongstaffSandersPaths(activeSimdLevel(), model, step, previousRates, randomIncrements, currentRates, numberOfPaths);
+}
+
+inline void advancePaths(
+    const ConstantElasticityVarianceModel& model,
+    const TimeStep& step,
+    const double* previousRates,
+    const double* randomIncrements,
+    double* currentRates,
+    const int& numberOfPaths)
+{
+    advanceConstantElasticityVariancePaths(activeSimdLevel(), model, step, previousRates, randomIncrements, currentRates, numberOfPaths);
+}
+
+inline void advancePaths(
+    const EulerScheme<ChanKarolyiLongstaffSandersModel>& model,
+    const TimeStep& step,
+    const double* previousRates,
+    const double* randomIncrements,
+    double* currentRates,
+    const int& numberOfPaths)
+{
+    advanceChanKarolyiLongstaffSandersPaths(activeSimdLevel(), model, step, previousRates, randomIncrements, currentRates, numberOfPaths);
+}
+
+inline void advancePaths(
+    const EulerScheme<ConstantElasticityVarianceModel>& model,
+    const TimeStep& step,
+    const double* previousRates,
+    const double* randomIncrements,
+    double* currentRates,
+    const int& numberOfPaths)
+{
+    advanceConstantElasticityVariancePaths(activeSimdLevel(), model, step, previousRates, randomIncrements, currentRates, numberOfPaths);
+}
+
+inline void advancePaths(
+    const MilsteinScheme<ChanKarolyiLongstaffSandersModel>& model,
+    const TimeStep& step,
+    const double* previousRates,
+    const double* randomIncrements,
+    double* currentRates,
+    const int& numberOfPaths)
+{
+    advanceChanKarolyiLongstaffSandersPaths<true>(activeSimdLevel(), model, step, previousRates, randomIncrements, currentRates, numberOfPaths);
+}
+
+inline void advancePaths(
+    const MilsteinScheme<ConstantElasticityVarianceModel>& model,
+    const TimeStep& step,
+    const double* previousRates,
+    const double* randomIncrements,
+    double* currentRates,
+    const int& numberOfPaths)
+{
+    advanceConstantElasticityVariancePaths<true>(activeSimdLevel(), model, step, previousRates, randomIncrements, currentRates, numberOfPaths);
+}
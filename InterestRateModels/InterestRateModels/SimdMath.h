@@ -0,0 +1,292 @@
+#pragma once
+
+#include <cfloat>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+/*
+ Runtime SIMD dispatch and vectorized elementary functions.
+
+ The instruction set is chosen once at runtime from the CPU. Setting the
+ environment variable INTEREST_RATE_MODELS_SIMD to "scalar", "avx2" or
+ "avx512" caps the level that will be used.
+
+ logAvx2/expAvx2 and their AVX-512 counterparts are polynomial
+ approximations accurate to a few units in the last place for positive
+ normal inputs and |y| <= simdExponentLimit. Callers check the range with
+ the inLogRange/inExpRange helpers and recompute other lanes with the
+ scalar functions.
+ */
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define INTEREST_RATE_MODELS_X86_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define INTEREST_RATE_MODELS_TARGET_AVX2
+#define INTEREST_RATE_MODELS_TARGET_AVX512
+#else
+#define INTEREST_RATE_MODELS_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define INTEREST_RATE_MODELS_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#endif
+
+enum class SimdLevel
+{
+    Scalar,
+    Avx2,
+    Avx512
+};
+
+/*
+ Detects the widest instruction set supported by both the CPU and the operating system.
+
+ @return The detected SIMD level.
+ */
+inline SimdLevel detectSimdLevel()
+{
+    SimdLevel detectedLevel = SimdLevel::Scalar;
+
+#if defined(INTEREST_RATE_MODELS_X86_SIMD)
+#if defined(_MSC_VER)
+    int cpuInfo[4];
+    __cpuid(cpuInfo, 1);
+    bool hasFma = (cpuInfo[2] & (1 << 12)) != 0;
+    bool hasOsXsave = (cpuInfo[2] & (1 << 27)) != 0;
+    if (hasOsXsave)
+    {
+        unsigned long long enabledState = _xgetbv(0);
+        __cpuidex(cpuInfo, 7, 0);
+        bool hasAvx2 = (cpuInfo[1] & (1 << 5)) != 0;
+        bool hasAvx512 = (cpuInfo[1] & (1 << 16)) != 0;
+        if (hasAvx2 && hasFma && (enabledState & 0x6) == 0x6)
+        {
+            detectedLevel = SimdLevel::Avx2;
+        }
+        if (hasAvx512 && detectedLevel == SimdLevel::Avx2 && (enabledState & 0xE6) == 0xE6)
+        {
+            detectedLevel = SimdLevel::Avx512;
+        }
+    }
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        detectedLevel = SimdLevel::Avx2;
+    }
+    if (detectedLevel == SimdLevel::Avx2 && __builtin_cpu_supports("avx512f"))
+    {
+        detectedLevel = SimdLevel::Avx512;
+    }
+#endif
+#endif
+
+    // Allow the level to be capped from the environment
+    const char* requestedLevel = std::getenv("INTEREST_RATE_MODELS_SIMD");
+    if (requestedLevel != nullptr)
+    {
+        if (std::strcmp(requestedLevel, "scalar") == 0)
+        {
+            detectedLevel = SimdLevel::Scalar;
+        }
+        else if (std::strcmp(requestedLevel, "avx2") == 0 && detectedLevel == SimdLevel::Avx512)
+        {
+            detectedLevel = SimdLevel::Avx2;
+        }
+    }
+
+    return detectedLevel;
+}
+
+/*
+ Returns the SIMD level used by the path engine, detected on first use.
+ */
+inline SimdLevel activeSimdLevel()
+{
+    static const SimdLevel level = detectSimdLevel();
+    return level;
+}
+
+#if defined(INTEREST_RATE_MODELS_X86_SIMD)
+
+// GCC 12 reports a spurious uninitialized value inside its own AVX-512 shift intrinsics
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// Split of ln(2) into a high part with few mantissa bits and a low correction
+constexpr double simdLogTwoHigh = 6.93145751953125E-1;
+constexpr double simdLogTwoLow = 1.42860682030941723212E-6;
+constexpr double simdLogTwoE = 1.44269504088896340736;
+constexpr double simdSquareRootTwo = 1.41421356237309504880;
+
+// Adding this to a small integer-valued double places the integer in the low mantissa bits
+constexpr double simdExponentMagic = 4503599627370496.0 + 1023.0;
+
+// Largest |y| for which exp(y) is computed by the vector path
+constexpr double simdExponentLimit = 708.0;
+
+INTEREST_RATE_MODELS_TARGET_AVX2 inline __m256d logAvx2(__m256d x)
+{
+    // Split x into mantissa in [sqrt(1/2), sqrt(2)) and a binary exponent
+    __m256i bits = _mm256_castpd_si256(x);
+    __m256d exponent = _mm256_sub_pd(
+        _mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 52), _mm256_set1_epi64x(0x4330000000000000LL))),
+        _mm256_set1_pd(simdExponentMagic));
+    __m256d mantissa = _mm256_castsi256_pd(_mm256_or_si256(
+        _mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL)),
+        _mm256_set1_epi64x(0x3FF0000000000000LL)));
+    __m256d large = _mm256_cmp_pd(mantissa, _mm256_set1_pd(simdSquareRootTwo), _CMP_GT_OQ);
+    mantissa = _mm256_blendv_pd(mantissa, _mm256_mul_pd(mantissa, _mm256_set1_pd(0.5)), large);
+    exponent = _mm256_add_pd(exponent, _mm256_and_pd(large, _mm256_set1_pd(1.0)));
+
+    // log(m) = 2 atanh(f) with f = (m - 1) / (m + 1), |f| <= 0.172
+    __m256d one = _mm256_set1_pd(1.0);
+    __m256d f = _mm256_div_pd(_mm256_sub_pd(mantissa, one), _mm256_add_pd(mantissa, one));
+    __m256d f2 = _mm256_mul_pd(f, f);
+    __m256d series = _mm256_set1_pd(1.0 / 23.0);
+    series = _mm256_fmadd_pd(series, f2, _mm256_set1_pd(1.0 / 21.0));
+    series = _mm256_fmadd_pd(series, f2, _mm256_set1_pd(1.0 / 19.0));
+    series = _mm256_fmadd_pd(series, f2, _mm256_set1_pd(1.0 / 17.0));
+    series = _mm256_fmadd_pd(series, f2, _mm256_set1_pd(1.0 / 15.0));
+    series = _mm256_fmadd_pd(series, f2, _mm256_set1_pd(1.0 / 13.0));
+    series = _mm256_fmadd_pd(series, f2, _mm256_set1_pd(1.0 / 11.0));
+    series = _mm256_fmadd_pd(series, f2, _mm256_set1_pd(1.0 / 9.0));
+    series = _mm256_fmadd_pd(series, f2, _mm256_set1_pd(1.0 / 7.0));
+    series = _mm256_fmadd_pd(series, f2, _mm256_set1_pd(1.0 / 5.0));
+    series = _mm256_fmadd_pd(series, f2, _mm256_set1_pd(1.0 / 3.0));
+    __m256d twoF = _mm256_add_pd(f, f);
+    __m256d logMantissa = _mm256_fmadd_pd(_mm256_mul_pd(twoF, f2), series, twoF);
+
+    // log(x) = exponent * ln(2) + log(m)
+    __m256d result = _mm256_fmadd_pd(exponent, _mm256_set1_pd(simdLogTwoLow), logMantissa);
+    return _mm256_fmadd_pd(exponent, _mm256_set1_pd(simdLogTwoHigh), result);
+}
+
+INTEREST_RATE_MODELS_TARGET_AVX2 inline __m256d expAvx2(__m256d y)
+{
+    // Reduce y = n ln(2) + r with |r| <= ln(2) / 2
+    __m256d n = _mm256_round_pd(_mm256_mul_pd(y, _mm256_set1_pd(simdLogTwoE)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_fnmadd_pd(n, _mm256_set1_pd(simdLogTwoHigh), y);
+    r = _mm256_fnmadd_pd(n, _mm256_set1_pd(simdLogTwoLow), r);
+
+    // Taylor series of exp(r) through r^13
+    __m256d series = _mm256_set1_pd(1.0 / 6227020800.0);
+    series = _mm256_fmadd_pd(series, r, _mm256_set1_pd(1.0 / 479001600.0));
+    series = _mm256_fmadd_pd(series, r, _mm256_set1_pd(1.0 / 39916800.0));
+    series = _mm256_fmadd_pd(series, r, _mm256_set1_pd(1.0 / 3628800.0));
+    series = _mm256_fmadd_pd(series, r, _mm256_set1_pd(1.0 / 362880.0));
+    series = _mm256_fmadd_pd(series, r, _mm256_set1_pd(1.0 / 40320.0));
+    series = _mm256_fmadd_pd(series, r, _mm256_set1_pd(1.0 / 5040.0));
+    series = _mm256_fmadd_pd(series, r, _mm256_set1_pd(1.0 / 720.0));
+    series = _mm256_fmadd_pd(series, r, _mm256_set1_pd(1.0 / 120.0));
+    series = _mm256_fmadd_pd(series, r, _mm256_set1_pd(1.0 / 24.0));
+    series = _mm256_fmadd_pd(series, r, _mm256_set1_pd(1.0 / 6.0));
+    series = _mm256_fmadd_pd(series, r, _mm256_set1_pd(0.5));
+    series = _mm256_fmadd_pd(series, r, _mm256_set1_pd(1.0));
+    series = _mm256_fmadd_pd(series, r, _mm256_set1_pd(1.0));
+
+    // Scale by 2^n by building the exponent field directly
+    __m256i scaleBits = _mm256_slli_epi64(_mm256_castpd_si256(_mm256_add_pd(n, _mm256_set1_pd(simdExponentMagic))), 52);
+    return _mm256_mul_pd(series, _mm256_castsi256_pd(scaleBits));
+}
+
+INTEREST_RATE_MODELS_TARGET_AVX2 inline __m256d inLogRangeAvx2(__m256d x)
+{
+    return _mm256_and_pd(
+        _mm256_cmp_pd(x, _mm256_set1_pd(DBL_MIN), _CMP_GE_OQ),
+        _mm256_cmp_pd(x, _mm256_set1_pd(DBL_MAX), _CMP_LE_OQ));
+}
+
+INTEREST_RATE_MODELS_TARGET_AVX2 inline __m256d inExpRangeAvx2(__m256d y)
+{
+    __m256d absoluteY = _mm256_andnot_pd(_mm256_set1_pd(-0.0), y);
+    return _mm256_cmp_pd(absoluteY, _mm256_set1_pd(simdExponentLimit), _CMP_LE_OQ);
+}
+
+INTEREST_RATE_MODELS_TARGET_AVX512 inline __m512d logAvx512(__m512d x)
+{
+    // Split x into mantissa in [sqrt(1/2), sqrt(2)) and a binary exponent
+    __m512i bits = _mm512_castpd_si512(x);
+    __m512d exponent = _mm512_sub_pd(
+        _mm512_castsi512_pd(_mm512_or_si512(_mm512_srli_epi64(bits, 52), _mm512_set1_epi64(0x4330000000000000LL))),
+        _mm512_set1_pd(simdExponentMagic));
+    __m512d mantissa = _mm512_castsi512_pd(_mm512_or_si512(
+        _mm512_and_si512(bits, _mm512_set1_epi64(0x000FFFFFFFFFFFFFLL)),
+        _mm512_set1_epi64(0x3FF0000000000000LL)));
+    __mmask8 large = _mm512_cmp_pd_mask(mantissa, _mm512_set1_pd(simdSquareRootTwo), _CMP_GT_OQ);
+    mantissa = _mm512_mask_mul_pd(mantissa, large, mantissa, _mm512_set1_pd(0.5));
+    exponent = _mm512_mask_add_pd(exponent, large, exponent, _mm512_set1_pd(1.0));
+
+    // log(m) = 2 atanh(f) with f = (m - 1) / (m + 1), |f| <= 0.172
+    __m512d one = _mm512_set1_pd(1.0);
+    __m512d f = _mm512_div_pd(_mm512_sub_pd(mantissa, one), _mm512_add_pd(mantissa, one));
+    __m512d f2 = _mm512_mul_pd(f, f);
+    __m512d series = _mm512_set1_pd(1.0 / 23.0);
+    series = _mm512_fmadd_pd(series, f2, _mm512_set1_pd(1.0 / 21.0));
+    series = _mm512_fmadd_pd(series, f2, _mm512_set1_pd(1.0 / 19.0));
+    series = _mm512_fmadd_pd(series, f2, _mm512_set1_pd(1.0 / 17.0));
+    series = _mm512_fmadd_pd(series, f2, _mm512_set1_pd(1.0 / 15.0));
+    series = _mm512_fmadd_pd(series, f2, _mm512_set1_pd(1.0 / 13.0));
+    series = _mm512_fmadd_pd(series, f2, _mm512_set1_pd(1.0 / 11.0));
+    series = _mm512_fmadd_pd(series, f2, _mm512_set1_pd(1.0 / 9.0));
+    series = _mm512_fmadd_pd(series, f2, _mm512_set1_pd(1.0 / 7.0));
+    series = _mm512_fmadd_pd(series, f2, _mm512_set1_pd(1.0 / 5.0));
+    series = _mm512_fmadd_pd(series, f2, _mm512_set1_pd(1.0 / 3.0));
+    __m512d twoF = _mm512_add_pd(f, f);
+    __m512d logMantissa = _mm512_fmadd_pd(_mm512_mul_pd(twoF, f2), series, twoF);
+
+    // log(x) = exponent * ln(2) + log(m)
+    __m512d result = _mm512_fmadd_pd(exponent, _mm512_set1_pd(simdLogTwoLow), logMantissa);
+    return _mm512_fmadd_pd(exponent, _mm512_set1_pd(simdLogTwoHigh), result);
+}
+
+INTEREST_RATE_MODELS_TARGET_AVX512 inline __m512d expAvx512(__m512d y)
+{
+    // Reduce y = n ln(2) + r with |r| <= ln(2) / 2
+    __m512d n = _mm512_roundscale_pd(_mm512_mul_pd(y, _mm512_set1_pd(simdLogTwoE)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m512d r = _mm512_fnmadd_pd(n, _mm512_set1_pd(simdLogTwoHigh), y);
+    r = _mm512_fnmadd_pd(n, _mm512_set1_pd(simdLogTwoLow), r);
+
+    // Taylor series of exp(r) through r^13
+    __m512d series = _mm512_set1_pd(1.0 / 6227020800.0);
+    series = _mm512_fmadd_pd(series, r, _mm512_set1_pd(1.0 / 479001600.0));
+    series = _mm512_fmadd_pd(series, r, _mm512_set1_pd(1.0 / 39916800.0));
+    series = _mm512_fmadd_pd(series, r, _mm512_set1_pd(1.0 / 3628800.0));
+    series = _mm512_fmadd_pd(series, r, _mm512_set1_pd(1.0 / 362880.0));
+    series = _mm512_fmadd_pd(series, r, _mm512_set1_pd(1.0 / 40320.0));
+    series = _mm512_fmadd_pd(series, r, _mm512_set1_pd(1.0 / 5040.0));
+    series = _mm512_fmadd_pd(series, r, _mm512_set1_pd(1.0 / 720.0));
+    series = _mm512_fmadd_pd(series, r, _mm512_set1_pd(1.0 / 120.0));
+    series = _mm512_fmadd_pd(series, r, _mm512_set1_pd(1.0 / 24.0));
+    series = _mm512_fmadd_pd(series, r, _mm512_set1_pd(1.0 / 6.0));
+    series = _mm512_fmadd_pd(series, r, _mm512_set1_pd(0.5));
+    series = _mm512_fmadd_pd(series, r, _mm512_set1_pd(1.0));
+    series = _mm512_fmadd_pd(series, r, _mm512_set1_pd(1.0));
+
+    // Scale by 2^n by building the exponent field directly
+    __m512i scaleBits = _mm512_slli_epi64(_mm512_castpd_si512(_mm512_add_pd(n, _mm512_set1_pd(simdExponentMagic))), 52);
+    return _mm512_mul_pd(series, _mm512_castsi512_pd(scaleBits));
+}
+
+INTEREST_RATE_MODELS_TARGET_AVX512 inline __mmask8 inLogRangeAvx512(__m512d x)
+{
+    return _mm512_cmp_pd_mask(x, _mm512_set1_pd(DBL_MIN), _CMP_GE_OQ)
+        & _mm512_cmp_pd_mask(x, _mm512_set1_pd(DBL_MAX), _CMP_LE_OQ);
+}
+
+INTEREST_RATE_MODELS_TARGET_AVX512 inline __mmask8 inExpRangeAvx512(__m512d y)
+{
+    return _mm512_cmp_pd_mask(_mm512_abs_pd(y), _mm512_set1_pd(simdExponentLimit), _CMP_LE_OQ);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include "IncrementSource.h"
+#include "ThreadPool.h"
+
+// Alignment of every buffer handed out by a BufferArena, one cache line
+constexpr std::size_t arenaBufferAlignment = 64;
+
+// Blocks of at least this size are aligned to it and offered to the kernel as huge pages
+constexpr std::size_t arenaHugePageSize = static_cast<std::size_t>(2) << 20;
+
+/*
+ A bump allocator for the scratch buffers of one simulation at a time.
+
+ Buffers are carved out of a few large blocks and all released together by
+ reset(). A reset after a simulation that needed more than one block
+ replaces them with a single block of their combined size, so once the
+ largest simulation has run every later one fits in one block and reset()
+ only rewinds an offset. Blocks keep their pages, which are faulted in once.
+
+ Every buffer is aligned to a cache line, so per-thread slices that are
+ allocated separately never share one.
+ */
+class BufferArena
+{
+public:
+    BufferArena() = default;
+
+    ~BufferArena()
+    {
+        releaseBlocks();
+    }
+
+    BufferArena(const BufferArena&) = delete;
+    BufferArena& operator=(const BufferArena&) = delete;
+
+    /*
+     Returns uninitialized space for count values of a trivial type.
+
+     @param count The number of values.
+     */
+    template <typename Value>
+    Value* allocate(const std::size_t& count)
+    {
+        std::size_t size = roundUp(std::max<std::size_t>(count * sizeof(Value), 1), arenaBufferAlignment);
+        if (blocks.empty() || blocks.back().used + size > blocks.back().size)
+        {
+            std::size_t lastSize = blocks.empty() ? 0 : blocks.back().size;
+            addBlock(std::max(size, 2 * lastSize));
+        }
+        Block& block = blocks.back();
+        Value* buffer = reinterpret_cast<Value*>(block.data + block.used);
+        block.used += size;
+        return buffer;
+    }
+
+    /*
+     Releases every buffer at once.
+     */
+    void reset()
+    {
+        if (blocks.size() > 1)
+        {
+            // Coalesce, so the next simulation of this size fits in one block
+            std::size_t totalSize = 0;
+            for (const Block& block : blocks)
+            {
+                totalSize += block.size;
+            }
+            releaseBlocks();
+            addBlock(totalSize);
+        }
+        if (!blocks.empty())
+        {
+            blocks.back().used = 0;
+        }
+    }
+
+    /*
+     Returns the number of bytes held by the arena.
+     */
+    std::size_t capacity() const
+    {
+        std::size_t totalSize = 0;
+        for (const Block& block : blocks)
+        {
+            totalSize += block.size;
+        }
+        return totalSize;
+    }
+
+private:
+    struct Block
+    {
+        unsigned char* data = nullptr;
+        std::size_t size = 0;
+        std::size_t used = 0;
+    };
+
+    static std::size_t roundUp(const std::size_t& size, const std::size_t& alignment)
+    {
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
+    void addBlock(const std::size_t& minimumSize)
+    {
+        std::size_t alignment = minimumSize >= arenaHugePageSize ? arenaHugePageSize : arenaBufferAlignment;
+        std::size_t size = roundUp(minimumSize, alignment);
+#if defined(_WIN32)
+        void* data = _aligned_malloc(size, alignment);
+#else
+        void* data = nullptr;
+        if (posix_memalign(&data, alignment, size) != 0)
+        {
+            data = nullptr;
+        }
+#endif
+        if (data == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if (alignment == arenaHugePageSize)
+        {
+            madvise(data, size, MADV_HUGEPAGE);
+        }
+#endif
+        Block block;
+        block.data = static_cast<unsigned char*>(data);
+        block.size = size;
+        blocks.push_back(block);
+    }
+
+    void releaseBlocks()
+    {
+        for (Block& block : blocks)
+        {
+#if defined(_WIN32)
+            _aligned_free(block.data);
+#else
+            std::free(block.data);
+#endif
+        }
+        blocks.clear();
+    }
+
+    std::vector<Block> blocks;
+};
+
+/*
+ Everything the path engines allocate per call, kept between calls.
+
+ Passing the same context to repeated simulatePaths(), simulatePathBatch()
+ or simulateForwardCurves() calls reuses its arena, time grids and
+ pseudo-random increment buffers, so once the largest call has run, a call
+ into a reused PathStore or ForwardCurveStore makes no heap allocations.
+ A context serves one simulation at a time.
+ */
+class SimulationContext
+{
+public:
+    /*
+     @param pool The threads that simulate the path blocks.
+     */
+    explicit SimulationContext(ThreadPool& pool = defaultThreadPool())
+        : threadPool(pool)
+    {
+    }
+
+    SimulationContext(const SimulationContext&) = delete;
+    SimulationContext& operator=(const SimulationContext&) = delete;
+
+    /*
+     Starts a simulation: releases the buffers of the previous one.
+     */
+    void beginSimulation()
+    {
+        arena.reset();
+    }
+
+    /*
+     Returns the pseudo-random increment source, reseeded.
+
+     @param seed The seed of the random number streams.
+     */
+    CounterIncrementSource& counterIncrementSource(const std::uint64_t& seed)
+    {
+        incrementSource.reseed(seed);
+        return incrementSource;
+    }
+
+    ThreadPool& threadPool;
+    BufferArena arena;
+
+    // Grids handed to sinks, which take them as vectors
+    std::vector<double> timeValues;
+    std::vector<double> recordTimes;
+
+private:
+    CounterIncrementSource incrementSource{ 0 };
+};
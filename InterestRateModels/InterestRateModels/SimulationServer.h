@@ -0,0 +1,799 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "ScenarioSweep.h"
+
+// Platforms without MSG_NOSIGNAL report a closed peer through SIGPIPE instead
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/*
+ A resident simulation server on a Unix domain socket, and its client.
+
+ The server keeps its thread pool running between requests, so a request
+ costs only its own simulation: no process start, no file output. A request
+ names a short-rate model, its parameters, the grid, the number of paths,
+ the seed and the outputs wanted; the reply carries those outputs as
+ float64 values. Requests that arrive together, on one connection or many,
+ are run as one batch: each becomes a section of a sweep and runSweep()
+ (ScenarioSweep.h) spreads the path blocks of the whole batch over the pool.
+ Requests with different seeds run as one sweep per seed. A batch holds at
+ most serverMaximumBatchRequests requests and serverMaximumBatchPathSteps
+ path steps; the requests beyond them wait for the next batch.
+
+ Messages are in the byte order of the host, since both ends share it:
+
+   request    magic, requestId, model, scheme, outputs, numberOfParameters,
+              numberOfPaths, reserved (uint32 each), seed (uint64),
+              timeHorizon, timeStep, parameters (float64 each)
+   reply      magic, requestId, status, payloadSize (uint32 each), payload
+
+ The model is an index into serverModelNames() and the parameters are in
+ the order of sweepParameterNames(). A reply with status serverStatusOk
+ carries payloadSize / 8 float64 values: the mean and standard deviation
+ of the terminal rate and the lowest and highest rate if the statistics
+ were asked for, then the bond price and its standard error if the bond
+ price was. Any other status carries an error message. A malformed request
+ closes the connection.
+
+ Requires POSIX sockets.
+ */
+
+constexpr std::uint32_t serverRequestMagic = 0x51524d49;  // "IRMQ"
+constexpr std::uint32_t serverReplyMagic = 0x52524d49;    // "IRMR"
+constexpr std::size_t serverRequestHeaderSize = 56;
+constexpr std::size_t serverReplyHeaderSize = 16;
+constexpr std::uint32_t serverMaximumParameters = 8;
+constexpr std::size_t serverMaximumPendingReplies = std::size_t{ 1 } << 24;  // bytes of replies a connection may leave unread
+constexpr std::size_t serverMaximumPendingInput = std::size_t{ 1 } << 20;    // bytes of requests read from a connection but not yet run
+constexpr std::size_t serverMaximumBatchRequests = 1024;
+constexpr double serverMaximumBatchPathSteps = 1e10;  // a larger request still runs, in a batch of its own
+constexpr double serverMaximumBatchTimeSteps = 2e7;   // bounds the time grids a batch allocates
+
+// The outputs a request can ask for, as bits
+constexpr std::uint32_t serverOutputStatistics = 1;
+constexpr std::uint32_t serverOutputBondPrice = 2;
+
+constexpr std::uint32_t serverStatusOk = 0;
+constexpr std::uint32_t serverStatusInvalidRequest = 1;
+
+inline const std::vector<std::string>& serverModelNames()
+{
+    static const std::vector<std::string> names = { "Vasicek", "CIR", "CKLS", "CEV", "HoLee" };
+    return names;
+}
+
+struct ServerRequest
+{
+    std::uint32_t requestId = 0;
+    std::uint32_t model = 0;
+    SweepScheme scheme = SweepScheme::Euler;
+    std::uint32_t outputs = serverOutputStatistics | serverOutputBondPrice;
+    int numberOfPaths = 10000;
+    std::uint64_t seed = 42;
+    double timeHorizon = 1.0;
+    double timeStep = 0.01;
+
+    // In the order of sweepParameterNames()
+    std::vector<double> parameters;
+};
+
+struct ServerReply
+{
+    std::uint32_t requestId = 0;
+    std::uint32_t status = serverStatusOk;
+    std::vector<double> values;
+    std::string message;
+};
+
+// Appends a value to a message in the byte order of the host
+template <typename Value>
+void appendServerValue(std::vector<unsigned char>& bytes, const Value& value)
+{
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(&value);
+    bytes.insert(bytes.end(), data, data + sizeof(Value));
+}
+
+template <typename Value>
+Value readServerValue(const unsigned char* bytes, const std::size_t& offset)
+{
+    Value value;
+    std::memcpy(&value, bytes + offset, sizeof(Value));
+    return value;
+}
+
+/*
+ Appends a request to a message buffer.
+ */
+inline void encodeServerRequest(const ServerRequest& request, std::vector<unsigned char>& bytes)
+{
+    appendServerValue(bytes, serverRequestMagic);
+    appendServerValue(bytes, request.requestId);
+    appendServerValue(bytes, request.model);
+    appendServerValue(bytes, static_cast<std::uint32_t>(request.scheme));
+    appendServerValue(bytes, request.outputs);
+    appendServerValue(bytes, static_cast<std::uint32_t>(request.parameters.size()));
+    appendServerValue(bytes, static_cast<std::int32_t>(request.numberOfPaths));
+    appendServerValue(bytes, std::uint32_t{ 0 });
+    appendServerValue(bytes, request.seed);
+    appendServerValue(bytes, request.timeHorizon);
+    appendServerValue(bytes, request.timeStep);
+    for (const double& parameter : request.parameters)
+    {
+        appendServerValue(bytes, parameter);
+    }
+}
+
+/*
+ Decodes the request at the start of a buffer.
+
+ @param bytes The buffer.
+ @param size The number of bytes in the buffer.
+ @param request Receives the request.
+ @return The size of the request, or 0 if the buffer does not hold all of it yet.
+ */
+inline std::size_t decodeServerRequest(const unsigned char* bytes, const std::size_t& size, ServerRequest& request)
+{
+    if (size < serverRequestHeaderSize)
+    {
+        return 0;
+    }
+    std::uint32_t scheme = readServerValue<std::uint32_t>(bytes, 12);
+    std::uint32_t numberOfParameters = readServerValue<std::uint32_t>(bytes, 20);
+    if (readServerValue<std::uint32_t>(bytes, 0) != serverRequestMagic || scheme > static_cast<std::uint32_t>(SweepScheme::Exact)
+        || numberOfParameters > serverMaximumParameters)
+    {
+        throw std::runtime_error("Malformed simulation request");
+    }
+    std::size_t requestSize = serverRequestHeaderSize + numberOfParameters * sizeof(double);
+    if (size < requestSize)
+    {
+        return 0;
+    }
+    request.requestId = readServerValue<std::uint32_t>(bytes, 4);
+    request.model = readServerValue<std::uint32_t>(bytes, 8);
+    request.scheme = static_cast<SweepScheme>(scheme);
+    request.outputs = readServerValue<std::uint32_t>(bytes, 16);
+    request.numberOfPaths = readServerValue<std::int32_t>(bytes, 24);
+    request.seed = readServerValue<std::uint64_t>(bytes, 32);
+    request.timeHorizon = readServerValue<double>(bytes, 40);
+    request.timeStep = readServerValue<double>(bytes, 48);
+    request.parameters.resize(numberOfParameters);
+    for (std::uint32_t i = 0; i < numberOfParameters; ++i)
+    {
+        request.parameters[i] = readServerValue<double>(bytes, serverRequestHeaderSize + i * sizeof(double));
+    }
+    return requestSize;
+}
+
+/*
+ Appends a reply to a message buffer.
+ */
+inline void encodeServerReply(const ServerReply& reply, std::vector<unsigned char>& bytes)
+{
+    bool ok = reply.status == serverStatusOk;
+    std::size_t payloadSize = ok ? reply.values.size() * sizeof(double) : reply.message.size();
+    appendServerValue(bytes, serverReplyMagic);
+    appendServerValue(bytes, reply.requestId);
+    appendServerValue(bytes, reply.status);
+    appendServerValue(bytes, static_cast<std::uint32_t>(payloadSize));
+    if (ok)
+    {
+        for (const double& value : reply.values)
+        {
+            appendServerValue(bytes, value);
+        }
+    }
+    else
+    {
+        bytes.insert(bytes.end(), reply.message.begin(), reply.message.end());
+    }
+}
+
+// Sends a whole buffer, returning false if the connection has gone
+inline bool sendServerMessage(const int& socketHandle, const unsigned char* bytes, const std::size_t& size)
+{
+    std::size_t sent = 0;
+    while (sent < size)
+    {
+        ssize_t result = ::send(socketHandle, bytes + sent, size - sent, MSG_NOSIGNAL);
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result <= 0)
+        {
+            return false;
+        }
+        sent += static_cast<std::size_t>(result);
+    }
+    return true;
+}
+
+// Fills the address of a Unix domain socket
+inline sockaddr_un serverSocketAddress(const std::string& socketPath)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path))
+    {
+        throw std::runtime_error("The socket path " + socketPath + " is too long");
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    return address;
+}
+
+/*
+ Checks a request and turns it into a sweep section with one scenario.
+
+ @param request The request.
+ @param sweepModel Receives the section.
+ @throws std::runtime_error naming what is wrong with the request.
+ */
+inline void makeServerSweepModel(const ServerRequest& request, SweepModel& sweepModel)
+{
+    const std::vector<std::string>& modelNames = serverModelNames();
+    if (request.model >= modelNames.size())
+    {
+        throw std::runtime_error("Unknown model " + std::to_string(request.model));
+    }
+    sweepModel.model = modelNames[request.model];
+    sweepModel.scheme = request.scheme;
+    sweepModel.timeHorizon = request.timeHorizon;
+    sweepModel.timeStep = request.timeStep;
+    sweepModel.numberOfPaths = request.numberOfPaths;
+    sweepModel.parameters.clear();
+    const std::vector<std::string>& names = sweepParameterNames(sweepModel.model);
+    if (request.parameters.size() != names.size())
+    {
+        throw std::runtime_error(sweepModel.model + " takes " + std::to_string(names.size()) + " parameters");
+    }
+    for (std::size_t i = 0; i < names.size(); ++i)
+    {
+        sweepModel.parameters.push_back(SweepParameter{ names[i], { request.parameters[i] } });
+    }
+    finishSweepModel(sweepModel);
+}
+
+/*
+ Returns the path steps and time steps a request costs a batch, or zero for
+ a request that will be rejected before it is simulated.
+ */
+inline std::pair<double, double> serverRequestCost(const ServerRequest& request)
+{
+    double numberOfTimeSteps = request.timeHorizon / request.timeStep;
+    double pathSteps = numberOfTimeSteps * request.numberOfPaths;
+    if (!(numberOfTimeSteps > 0.0) || !(pathSteps > 0.0) || numberOfTimeSteps > sweepMaximumTimeSteps || pathSteps > sweepMaximumPathSteps)
+    {
+        return { 0.0, 0.0 };
+    }
+    return { pathSteps, numberOfTimeSteps };
+}
+
+/*
+ Runs a batch of requests and returns a reply to each.
+
+ Each valid request becomes a section of a sweep; requests that share a
+ seed run as one sweep, whose path blocks share one parallel loop. Invalid
+ requests, and the requests of a sweep that fails, get an error reply.
+
+ @param requests The requests.
+ @param threadPool The threads that run the simulations.
+ */
+inline std::vector<ServerReply> runServerBatch(const std::vector<ServerRequest>& requests, ThreadPool& threadPool = defaultThreadPool())
+{
+    INTEREST_RATE_MODELS_PROFILE_SCOPE("serverBatch");
+    std::vector<ServerReply> replies(requests.size());
+    std::map<std::uint64_t, SweepSpecification> specifications;
+    std::map<std::uint64_t, std::vector<std::size_t>> requestsOfSeed;
+    for (std::size_t i = 0; i < requests.size(); ++i)
+    {
+        replies[i].requestId = requests[i].requestId;
+        SweepModel sweepModel;
+        try
+        {
+            makeServerSweepModel(requests[i], sweepModel);
+        }
+        catch (const std::exception& error)
+        {
+            replies[i].status = serverStatusInvalidRequest;
+            replies[i].message = error.what();
+            continue;
+        }
+        SweepSpecification& specification = specifications[requests[i].seed];
+        specification.seed = requests[i].seed;
+        specification.models.push_back(sweepModel);
+        requestsOfSeed[requests[i].seed].push_back(i);
+    }
+
+    for (auto& [seed, specification] : specifications)
+    {
+        const std::vector<std::size_t>& requestIndices = requestsOfSeed[seed];
+        std::vector<SweepScenario> scenarios(requestIndices.size());
+        for (std::size_t k = 0; k < requestIndices.size(); ++k)
+        {
+            scenarios[k].modelIndex = static_cast<int>(k);
+            scenarios[k].values = requests[requestIndices[k]].parameters;
+        }
+        std::vector<ScenarioSummary> summaries;
+        try
+        {
+            summaries = runSweep(specification, scenarios, threadPool);
+        }
+        catch (const std::exception& error)
+        {
+            // The requests were checked, but a failed sweep must not take the server down
+            for (const std::size_t& requestIndex : requestIndices)
+            {
+                replies[requestIndex].status = serverStatusInvalidRequest;
+                replies[requestIndex].message = error.what();
+            }
+            continue;
+        }
+        for (std::size_t k = 0; k < requestIndices.size(); ++k)
+        {
+            const ScenarioSummary& summary = summaries[k];
+            ServerReply& reply = replies[requestIndices[k]];
+            std::uint32_t outputs = requests[requestIndices[k]].outputs;
+            if (outputs & serverOutputStatistics)
+            {
+                reply.values.insert(reply.values.end(),
+                    { summary.terminalRate.mean, summary.terminalRate.standardDeviation(), summary.lowestRate, summary.highestRate });
+            }
+            if (outputs & serverOutputBondPrice)
+            {
+                reply.values.insert(reply.values.end(), { summary.discountFactor.mean, summary.discountFactor.standardError() });
+            }
+        }
+    }
+    return replies;
+}
+
+/*
+ The server. run() serves until stop() is called, which may happen from
+ another thread or a signal handler.
+ */
+class SimulationServer
+{
+public:
+    /*
+     Binds the socket. A stale socket file at the path is replaced.
+
+     @param path The path of the Unix domain socket.
+     @param pool The threads that run the simulations.
+     */
+    explicit SimulationServer(const std::string& path, ThreadPool& pool = defaultThreadPool())
+        : socketPath(path), threadPool(pool)
+    {
+        sockaddr_un address = serverSocketAddress(socketPath);
+        if (::pipe(wakePipe) != 0)
+        {
+            throw std::runtime_error("Cannot create the wake-up pipe of the server");
+        }
+        listenSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenSocket < 0)
+        {
+            closeHandles();
+            throw std::runtime_error("Cannot create a socket for " + socketPath);
+        }
+        ::unlink(socketPath.c_str());
+        if (::bind(listenSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listenSocket, 128) != 0)
+        {
+            closeHandles();
+            throw std::runtime_error("Cannot listen on " + socketPath);
+        }
+    }
+
+    ~SimulationServer()
+    {
+        for (Connection& connection : connections)
+        {
+            ::close(connection.socketHandle);
+        }
+        closeHandles();
+        ::unlink(socketPath.c_str());
+    }
+
+    SimulationServer(const SimulationServer&) = delete;
+    SimulationServer& operator=(const SimulationServer&) = delete;
+
+    /*
+     Accepts connections and answers requests until stop() is called.
+
+     Every pass reads what has arrived on every connection, up to
+     serverMaximumPendingInput bytes each, then takes complete requests from
+     the connections in turn until the batch is full, runs them as one batch
+     and queues the replies. Requests that did not fit stay queued for the
+     next pass, and a connection whose queue is full is not read until it
+     drains, so a client that floods the server is held back by its socket.
+     Replies are sent without blocking, so a client that reads slowly only
+     delays itself; one that leaves too much unread is disconnected.
+     */
+    void run()
+    {
+        std::vector<pollfd> pollHandles;
+        std::vector<ServerRequest> batch;
+        std::vector<std::size_t> batchConnections;
+        while (!stopping.load())
+        {
+            // Requests left over from a full batch run without waiting for more input
+            bool requestsQueued = false;
+            pollHandles.clear();
+            pollHandles.push_back(pollfd{ wakePipe[0], POLLIN, 0 });
+            pollHandles.push_back(pollfd{ listenSocket, POLLIN, 0 });
+            for (const Connection& connection : connections)
+            {
+                bool reading = !connection.ended && connection.input.size() < serverMaximumPendingInput;
+                short events = static_cast<short>((reading ? POLLIN : 0) | (connection.output.empty() ? 0 : POLLOUT));
+                pollHandles.push_back(pollfd{ connection.socketHandle, events, 0 });
+                requestsQueued = requestsQueued || hasCompleteRequest(connection);
+            }
+            if (::poll(pollHandles.data(), static_cast<nfds_t>(pollHandles.size()), requestsQueued ? 0 : -1) < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw std::runtime_error("Polling the server sockets failed");
+            }
+            if (pollHandles[0].revents != 0)
+            {
+                break;
+            }
+
+            // Read from the connections polled, then take a batch of their requests
+            for (std::size_t i = 2; i < pollHandles.size(); ++i)
+            {
+                if (pollHandles[i].revents & (POLLIN | POLLHUP | POLLERR))
+                {
+                    readInput(connections[i - 2]);
+                }
+            }
+            takeRequests(batch, batchConnections);
+
+            if (!batch.empty())
+            {
+                std::vector<ServerReply> replies = runServerBatch(batch, threadPool);
+                for (std::size_t i = 0; i < replies.size(); ++i)
+                {
+                    encodeServerReply(replies[i], connections[batchConnections[i]].output);
+                }
+                batchCount.fetch_add(1);
+                requestCount.fetch_add(batch.size());
+                largestBatchSize.store(std::max<std::uint64_t>(largestBatchSize.load(), batch.size()));
+                batch.clear();
+                batchConnections.clear();
+            }
+
+            // Send what each connection will take, close the connections that ended once their requests are run and replies sent, then accept new ones
+            auto finished = [](const Connection& connection) { return connection.ended && connection.output.empty() && !hasCompleteRequest(connection); };
+            for (Connection& connection : connections)
+            {
+                sendReplies(connection);
+                if (finished(connection))
+                {
+                    ::close(connection.socketHandle);
+                }
+            }
+            connections.erase(std::remove_if(connections.begin(), connections.end(), finished), connections.end());
+            if (pollHandles[1].revents & POLLIN)
+            {
+                acceptConnection();
+            }
+        }
+    }
+
+    /*
+     Makes run() return. Safe to call from a signal handler.
+     */
+    void stop()
+    {
+        stopping.store(true);
+        char wake = 0;
+        ssize_t written = ::write(wakePipe[1], &wake, 1);
+        (void)written;
+    }
+
+    // The number of batches run, of requests answered in them and of requests in the largest one
+    std::uint64_t numberOfBatches() const
+    {
+        return batchCount.load();
+    }
+
+    std::uint64_t numberOfRequests() const
+    {
+        return requestCount.load();
+    }
+
+    std::uint64_t largestBatch() const
+    {
+        return largestBatchSize.load();
+    }
+
+private:
+    struct Connection
+    {
+        int socketHandle = -1;
+        std::vector<unsigned char> input;
+        std::vector<unsigned char> output;  // replies not sent yet
+        bool ended = false;
+    };
+
+    void acceptConnection()
+    {
+        int socketHandle = ::accept(listenSocket, nullptr, nullptr);
+        if (socketHandle >= 0)
+        {
+            connections.push_back(Connection{ socketHandle, {}, {}, false });
+        }
+    }
+
+    // Sends as much of a connection's queued replies as its socket takes without blocking; drops the replies of a connection that has gone or reads too slowly
+    void sendReplies(Connection& connection)
+    {
+        std::size_t sent = 0;
+        while (sent < connection.output.size())
+        {
+            ssize_t result = ::send(connection.socketHandle, connection.output.data() + sent, connection.output.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (result < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                break;
+            }
+            if (result <= 0)
+            {
+                sent = connection.output.size();
+                connection.ended = true;
+                break;
+            }
+            sent += static_cast<std::size_t>(result);
+        }
+        connection.output.erase(connection.output.begin(), connection.output.begin() + sent);
+        if (connection.output.size() > serverMaximumPendingReplies)
+        {
+            connection.output.clear();
+            connection.ended = true;
+        }
+    }
+
+    // Returns whether a connection's input holds a complete request; a malformed one counts, so that takeRequests() ends the connection
+    static bool hasCompleteRequest(const Connection& connection)
+    {
+        ServerRequest request;
+        try
+        {
+            return decodeServerRequest(connection.input.data(), connection.input.size(), request) > 0;
+        }
+        catch (const std::exception&)
+        {
+            return true;
+        }
+    }
+
+    // Reads what has arrived on a connection, up to serverMaximumPendingInput bytes of input; marks it ended at the end of the stream
+    void readInput(Connection& connection)
+    {
+        unsigned char buffer[65536];
+        while (!connection.ended && connection.input.size() < serverMaximumPendingInput)
+        {
+            std::size_t room = std::min(sizeof(buffer), serverMaximumPendingInput - connection.input.size());
+            ssize_t received = ::recv(connection.socketHandle, buffer, room, MSG_DONTWAIT);
+            if (received > 0)
+            {
+                connection.input.insert(connection.input.end(), buffer, buffer + received);
+                continue;
+            }
+            if (received < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                break;
+            }
+            connection.ended = true;
+        }
+    }
+
+    /*
+     Takes complete requests from the connections, one from each in turn,
+     until none is left or the batch is full. The first request always fits,
+     so a request larger than a batch runs on its own. A malformed request
+     ends its connection and drops the rest of its input.
+     */
+    void takeRequests(std::vector<ServerRequest>& batch, std::vector<std::size_t>& batchConnections)
+    {
+        std::vector<std::size_t> offsets(connections.size(), 0);
+        double pathSteps = 0.0;
+        double timeSteps = 0.0;
+        bool full = false;
+        bool taken = true;
+        while (taken && !full)
+        {
+            taken = false;
+            for (std::size_t index = 0; index < connections.size() && !full; ++index)
+            {
+                Connection& connection = connections[index];
+                ServerRequest request;
+                std::size_t requestSize = 0;
+                try
+                {
+                    requestSize = decodeServerRequest(connection.input.data() + offsets[index], connection.input.size() - offsets[index], request);
+                }
+                catch (const std::exception&)
+                {
+                    connection.ended = true;
+                    connection.input.clear();
+                    offsets[index] = 0;
+                    continue;
+                }
+                if (requestSize == 0)
+                {
+                    continue;
+                }
+                std::pair<double, double> cost = serverRequestCost(request);
+                if (!batch.empty() && (batch.size() == serverMaximumBatchRequests || pathSteps + cost.first > serverMaximumBatchPathSteps
+                    || timeSteps + cost.second > serverMaximumBatchTimeSteps))
+                {
+                    full = true;
+                    break;
+                }
+                batch.push_back(request);
+                batchConnections.push_back(index);
+                offsets[index] += requestSize;
+                pathSteps += cost.first;
+                timeSteps += cost.second;
+                taken = true;
+            }
+        }
+        for (std::size_t index = 0; index < connections.size(); ++index)
+        {
+            connections[index].input.erase(connections[index].input.begin(), connections[index].input.begin() + offsets[index]);
+        }
+    }
+
+    void closeHandles()
+    {
+        for (int handle : { listenSocket, wakePipe[0], wakePipe[1] })
+        {
+            if (handle >= 0)
+            {
+                ::close(handle);
+            }
+        }
+        listenSocket = wakePipe[0] = wakePipe[1] = -1;
+    }
+
+    std::string socketPath;
+    ThreadPool& threadPool;
+    int listenSocket = -1;
+    int wakePipe[2] = { -1, -1 };
+    std::vector<Connection> connections;
+    std::atomic<bool> stopping{ false };
+    std::atomic<std::uint64_t> batchCount{ 0 };
+    std::atomic<std::uint64_t> requestCount{ 0 };
+    std::atomic<std::uint64_t> largestBatchSize{ 0 };
+};
+
+/*
+ A connection to a simulation server. Requests may be pipelined: send
+ several, then receive their replies in order.
+ */
+class SimulationClient
+{
+public:
+    /*
+     @param socketPath The path of the server's socket.
+     */
+    explicit SimulationClient(const std::string& socketPath)
+    {
+        sockaddr_un address = serverSocketAddress(socketPath);
+        socketHandle = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (socketHandle < 0 || ::connect(socketHandle, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            if (socketHandle >= 0)
+            {
+                ::close(socketHandle);
+            }
+            throw std::runtime_error("Cannot connect to " + socketPath);
+        }
+    }
+
+    ~SimulationClient()
+    {
+        ::close(socketHandle);
+    }
+
+    SimulationClient(const SimulationClient&) = delete;
+    SimulationClient& operator=(const SimulationClient&) = delete;
+
+    void send(const ServerRequest& request)
+    {
+        requestBytes.clear();
+        encodeServerRequest(request, requestBytes);
+        if (!sendServerMessage(socketHandle, requestBytes.data(), requestBytes.size()))
+        {
+            throw std::runtime_error("The simulation server closed the connection");
+        }
+    }
+
+    /*
+     Waits for the next reply.
+     */
+    ServerReply receive()
+    {
+        unsigned char header[serverReplyHeaderSize];
+        receiveBytes(header, sizeof(header));
+        if (readServerValue<std::uint32_t>(header, 0) != serverReplyMagic)
+        {
+            throw std::runtime_error("Malformed reply from the simulation server");
+        }
+        ServerReply reply;
+        reply.requestId = readServerValue<std::uint32_t>(header, 4);
+        reply.status = readServerValue<std::uint32_t>(header, 8);
+        std::uint32_t payloadSize = readServerValue<std::uint32_t>(header, 12);
+        if (reply.status == serverStatusOk)
+        {
+            reply.values.resize(payloadSize / sizeof(double));
+            receiveBytes(reinterpret_cast<unsigned char*>(reply.values.data()), payloadSize);
+        }
+        else
+        {
+            reply.message.resize(payloadSize);
+            receiveBytes(reinterpret_cast<unsigned char*>(&reply.message[0]), payloadSize);
+        }
+        return reply;
+    }
+
+    /*
+     Sends a request and waits for its reply.
+     */
+    ServerReply simulate(const ServerRequest& request)
+    {
+        send(request);
+        return receive();
+    }
+
+private:
+    void receiveBytes(unsigned char* bytes, const std::size_t& size)
+    {
+        std::size_t received = 0;
+        while (received < size)
+        {
+            ssize_t result = ::recv(socketHandle, bytes + received, size - received, 0);
+            if (result < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (result <= 0)
+            {
+                throw std::runtime_error("The simulation server closed the connection");
+            }
+            received += static_cast<std::size_t>(result);
+        }
+    }
+
+    int socketHandle = -1;
+    std::vector<unsigned char> requestBytes;
+};
@@ -0,0 +1,458 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "SimdMath.h"
+
+/*
+ Sobol low-discrepancy points with hash-based Owen scrambling.
+
+ A Sobol point is a vector of 32-bit fractions, one per dimension. Dimension
+ d has 32 direction numbers V[d][b], and point n is the XOR of the direction
+ numbers selected by the bits of the Gray code of n, so consecutive points
+ differ by a single XOR. The first dimension is the van der Corput sequence.
+ Dimensions 2 to 19 use the primitive polynomials and initial direction
+ numbers of Joe and Kuo (new-joe-kuo-6.21201). Later dimensions take the
+ following primitive polynomials in order of degree with initial direction
+ numbers drawn from a fixed hash, which keeps every dimension a valid Sobol
+ sequence; with a Brownian bridge the leading dimensions carry most of the
+ variance anyway.
+
+ Scrambling applies a random nested uniform permutation to the binary digits
+ of each coordinate, seeded per dimension (Burley's hash-based version of
+ Owen scrambling). It keeps the stratification of the points and makes every
+ seed an independent, unbiased replicate of the estimate.
+ */
+
+// Number of bits in each coordinate, which also bounds the number of points at 2^32
+constexpr int sobolBits = 32;
+
+// Number of dimensions available, as many as there are primitive polynomials up to degree 18
+constexpr int sobolMaximumDimensions = 21201;
+
+/*
+ One dimension of Joe and Kuo's table.
+ */
+struct SobolDirectionEntry
+{
+    int degree;                       // Degree s of the primitive polynomial
+    std::uint32_t coefficients;       // Inner coefficients a of the polynomial, highest degree first
+    std::uint32_t initialNumbers[6];  // Initial direction numbers m_1..m_s
+};
+
+// Dimensions 2 to 19: every primitive polynomial of degree 1 to 6
+const SobolDirectionEntry sobolJoeKuoDirections[] = {
+    { 1, 0, { 1 } },
+    { 2, 1, { 1, 3 } },
+    { 3, 1, { 1, 3, 1 } },
+    { 3, 2, { 1, 1, 1 } },
+    { 4, 1, { 1, 1, 3, 3 } },
+    { 4, 4, { 1, 3, 5, 13 } },
+    { 5, 2, { 1, 1, 5, 5, 17 } },
+    { 5, 4, { 1, 1, 5, 5, 5 } },
+    { 5, 7, { 1, 1, 7, 11, 19 } },
+    { 5, 11, { 1, 1, 5, 1, 1 } },
+    { 5, 13, { 1, 1, 1, 3, 11 } },
+    { 5, 14, { 1, 3, 5, 5, 31 } },
+    { 6, 1, { 1, 3, 3, 9, 7, 49 } },
+    { 6, 13, { 1, 1, 1, 15, 21, 21 } },
+    { 6, 16, { 1, 3, 1, 13, 27, 49 } },
+    { 6, 19, { 1, 1, 1, 15, 7, 5 } },
+    { 6, 22, { 1, 3, 1, 15, 13, 25 } },
+    { 6, 25, { 1, 1, 5, 5, 19, 61 } }
+};
+
+/*
+ Mixes a 64-bit value into a well-distributed 64-bit hash (the SplitMix64 finalizer).
+ */
+inline std::uint64_t sobolHash(std::uint64_t value)
+{
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+/*
+ Multiplies two polynomials over GF(2) modulo a polynomial.
+
+ @param left The first factor, of degree below the modulus.
+ @param right The second factor, of degree below the modulus.
+ @param modulus The modulus, including its leading term.
+ @param degree The degree of the modulus.
+ @return The product reduced modulo the modulus.
+ */
+inline std::uint32_t multiplyPolynomialsModulo(std::uint32_t left, std::uint32_t right, const std::uint32_t& modulus, const int& degree)
+{
+    std::uint32_t product = 0;
+    while (right != 0)
+    {
+        if ((right & 1u) != 0)
+        {
+            product ^= left;
+        }
+        right >>= 1;
+        left <<= 1;
+        if (((left >> degree) & 1u) != 0)
+        {
+            left ^= modulus;
+        }
+    }
+    return product;
+}
+
+/*
+ Checks whether x^s + a_1 x^(s-1) + ... + a_(s-1) x + 1 is primitive over GF(2).
+
+ The polynomial is primitive when x has multiplicative order 2^s - 1 modulo
+ it, that is when x^(2^s - 1) is one and x^((2^s - 1) / q) is not for any
+ prime factor q of 2^s - 1.
+
+ @param degree The degree s.
+ @param coefficients The inner coefficients a, highest degree first.
+ @return Whether the polynomial is primitive.
+ */
+inline bool isPrimitivePolynomial(const int& degree, const std::uint32_t& coefficients)
+{
+    if (degree == 1)
+    {
+        return coefficients == 0;
+    }
+    std::uint32_t modulus = (1u << degree) | (coefficients << 1) | 1u;
+    std::uint32_t order = (1u << degree) - 1u;
+
+    auto powerOfX = [&](std::uint32_t exponent)
+    {
+        std::uint32_t result = 1u;
+        std::uint32_t base = 2u;
+        while (exponent != 0)
+        {
+            if ((exponent & 1u) != 0)
+            {
+                result = multiplyPolynomialsModulo(result, base, modulus, degree);
+            }
+            base = multiplyPolynomialsModulo(base, base, modulus, degree);
+            exponent >>= 1;
+        }
+        return result;
+    };
+
+    if (powerOfX(order) != 1u)
+    {
+        return false;
+    }
+    std::uint32_t remaining = order;
+    for (std::uint32_t factor = 2; factor * factor <= remaining; ++factor)
+    {
+        if (remaining % factor == 0)
+        {
+            if (powerOfX(order / factor) == 1u)
+            {
+                return false;
+            }
+            while (remaining % factor == 0)
+            {
+                remaining /= factor;
+            }
+        }
+    }
+    return remaining == 1 || powerOfX(order / remaining) != 1u;
+}
+
+/*
+ Reverses the order of the bits of a 32-bit value.
+ */
+inline std::uint32_t reverseBits(std::uint32_t value)
+{
+    value = ((value >> 1) & 0x55555555u) | ((value & 0x55555555u) << 1);
+    value = ((value >> 2) & 0x33333333u) | ((value & 0x33333333u) << 2);
+    value = ((value >> 4) & 0x0F0F0F0Fu) | ((value & 0x0F0F0F0Fu) << 4);
+    value = ((value >> 8) & 0x00FF00FFu) | ((value & 0x00FF00FFu) << 8);
+    return (value >> 16) | (value << 16);
+}
+
+/*
+ Owen-scrambles a Sobol coordinate.
+
+ With the bits reversed, every step below flips a bit only as a function
+ of the bits after it in the original order, which makes the whole a nested
+ permutation of the binary digits: points in the same dyadic interval stay
+ together, so the stratification survives.
+
+ @param value The coordinate as a 32-bit fraction.
+ @param seed The seed of the permutation for this dimension.
+ @return The scrambled coordinate.
+ */
+inline std::uint32_t scrambleSobolValue(const std::uint32_t& value, const std::uint32_t& seed)
+{
+    std::uint32_t reversed = reverseBits(value);
+    reversed += seed;
+    reversed ^= reversed * 0x6C50B47Cu;
+    reversed ^= reversed * 0xB82F1E52u;
+    reversed ^= reversed * 0xC7AFE638u;
+    reversed ^= reversed * 0x8D22F6E6u;
+    return reverseBits(reversed);
+}
+
+// Scale that maps a 32-bit fraction to [0, 1)
+constexpr double sobolCoordinateScale = 1.0 / 4294967296.0;
+
+#if defined(INTEREST_RATE_MODELS_X86_SIMD)
+
+/*
+ Reverses the bits of every 32-bit lane: the bytes are reversed with a
+ shuffle and the bits of each byte through a nibble lookup.
+ */
+INTEREST_RATE_MODELS_TARGET_AVX2 inline __m256i reverseBitsAvx2(__m256i value)
+{
+    __m256i byteOrder = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    __m256i reversedNibbles = _mm256_setr_epi8(
+        0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF,
+        0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF);
+    __m256i nibbleMask = _mm256_set1_epi8(0x0F);
+    value = _mm256_shuffle_epi8(value, byteOrder);
+    __m256i lowNibbles = _mm256_and_si256(value, nibbleMask);
+    __m256i highNibbles = _mm256_and_si256(_mm256_srli_epi16(value, 4), nibbleMask);
+    return _mm256_or_si256(
+        _mm256_slli_epi16(_mm256_shuffle_epi8(reversedNibbles, lowNibbles), 4),
+        _mm256_shuffle_epi8(reversedNibbles, highNibbles));
+}
+
+/*
+ Vectorized fillSobolUniforms(), eight coordinates at a time. The output is
+ bit-identical to the scalar loop.
+ */
+INTEREST_RATE_MODELS_TARGET_AVX2 inline int fillSobolUniformsAvx2(
+    const std::uint32_t* coordinates,
+    const std::uint32_t& offset,
+    const std::uint32_t& seed,
+    const bool& scramble,
+    const int& numberOfPoints,
+    double* uniforms)
+{
+    __m256i offsetBits = _mm256_set1_epi32(static_cast<int>(offset));
+    __m256i seedBits = _mm256_set1_epi32(static_cast<int>(seed));
+    __m256i multiplier0 = _mm256_set1_epi32(static_cast<int>(0x6C50B47Cu));
+    __m256i multiplier1 = _mm256_set1_epi32(static_cast<int>(0xB82F1E52u));
+    __m256i multiplier2 = _mm256_set1_epi32(static_cast<int>(0xC7AFE638u));
+    __m256i multiplier3 = _mm256_set1_epi32(static_cast<int>(0x8D22F6E6u));
+    __m256i signBit = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+    __m256d cellCentre = _mm256_set1_pd(2147483648.0 + 0.5);
+    __m256d scale = _mm256_set1_pd(sobolCoordinateScale);
+
+    int point = 0;
+    for (; point + 8 <= numberOfPoints; point += 8)
+    {
+        __m256i value = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(coordinates + point)), offsetBits);
+        if (scramble)
+        {
+            value = _mm256_add_epi32(reverseBitsAvx2(value), seedBits);
+            value = _mm256_xor_si256(value, _mm256_mullo_epi32(value, multiplier0));
+            value = _mm256_xor_si256(value, _mm256_mullo_epi32(value, multiplier1));
+            value = _mm256_xor_si256(value, _mm256_mullo_epi32(value, multiplier2));
+            value = _mm256_xor_si256(value, _mm256_mullo_epi32(value, multiplier3));
+            value = reverseBitsAvx2(value);
+        }
+
+        // Convert as signed integers with the sign bit flipped, then shift back by 2^31
+        __m256i signedValue = _mm256_xor_si256(value, signBit);
+        __m256d low = _mm256_cvtepi32_pd(_mm256_castsi256_si128(signedValue));
+        __m256d high = _mm256_cvtepi32_pd(_mm256_extracti128_si256(signedValue, 1));
+        _mm256_storeu_pd(uniforms + point, _mm256_mul_pd(_mm256_add_pd(low, cellCentre), scale));
+        _mm256_storeu_pd(uniforms + point + 4, _mm256_mul_pd(_mm256_add_pd(high, cellCentre), scale));
+    }
+    return point;
+}
+
+#endif
+
+/*
+ Turns a run of Sobol coordinates into uniforms strictly inside (0, 1).
+
+ Each coordinate is XORed with an offset, optionally scrambled, and mapped to
+ the centre of its 2^-32 cell.
+
+ @param coordinates The coordinates as 32-bit fractions.
+ @param offset The value XORed into every coordinate, zero to use them as they are.
+ @param seed The seed of the scrambling permutation.
+ @param scramble Whether to scramble.
+ @param numberOfPoints The number of coordinates.
+ @param uniforms Receives the uniforms.
+ */
+inline void fillSobolUniforms(
+    const std::uint32_t* coordinates,
+    const std::uint32_t& offset,
+    const std::uint32_t& seed,
+    const bool& scramble,
+    const int& numberOfPoints,
+    double* uniforms)
+{
+    int point = 0;
+
+#if defined(INTEREST_RATE_MODELS_X86_SIMD)
+    if (activeSimdLevel() != SimdLevel::Scalar)
+    {
+        point = fillSobolUniformsAvx2(coordinates, offset, seed, scramble, numberOfPoints, uniforms);
+    }
+#endif
+
+    for (; point < numberOfPoints; ++point)
+    {
+        std::uint32_t value = coordinates[point] ^ offset;
+        if (scramble)
+        {
+            value = scrambleSobolValue(value, seed);
+        }
+        uniforms[point] = (static_cast<double>(value) + 0.5) * sobolCoordinateScale;
+    }
+}
+
+/*
+ The direction numbers of a Sobol sequence and the generation of its points.
+ */
+class SobolSequence
+{
+public:
+    SobolSequence() = default;
+
+    /*
+     Builds the direction numbers of the first dimensions.
+
+     @param dimensionCount The number of dimensions, at most sobolMaximumDimensions.
+     */
+    explicit SobolSequence(const int& dimensionCount)
+        : numberOfDimensions(dimensionCount)
+    {
+        if (dimensionCount < 0 || dimensionCount > sobolMaximumDimensions)
+        {
+            throw std::runtime_error("Sobol sequences support at most " + std::to_string(sobolMaximumDimensions) + " dimensions");
+        }
+        directions.assign(static_cast<std::size_t>(dimensionCount) * sobolBits, 0u);
+        if (dimensionCount == 0)
+        {
+            return;
+        }
+
+        // The first dimension is the van der Corput sequence
+        for (int bit = 0; bit < sobolBits; ++bit)
+        {
+            directions[bit] = 1u << (sobolBits - 1 - bit);
+        }
+
+        int tableSize = static_cast<int>(sizeof(sobolJoeKuoDirections) / sizeof(sobolJoeKuoDirections[0]));
+        int degree = sobolJoeKuoDirections[tableSize - 1].degree;
+        std::uint32_t coefficients = (1u << (degree - 1)) - 1u;
+        std::uint32_t initialNumbers[sobolBits];
+        for (int dimension = 1; dimension < dimensionCount; ++dimension)
+        {
+            if (dimension <= tableSize)
+            {
+                const SobolDirectionEntry& entry = sobolJoeKuoDirections[dimension - 1];
+                for (int i = 0; i < entry.degree; ++i)
+                {
+                    initialNumbers[i] = entry.initialNumbers[i];
+                }
+                initializeDimension(dimension, entry.degree, entry.coefficients, initialNumbers);
+                continue;
+            }
+
+            // Move on to the next primitive polynomial
+            do
+            {
+                if (++coefficients == (1u << (degree - 1)))
+                {
+                    ++degree;
+                    coefficients = 0;
+                }
+            } while (!isPrimitivePolynomial(degree, coefficients));
+
+            // Odd initial numbers m_i < 2^i from a fixed hash of the dimension
+            std::uint64_t hash = sobolHash(static_cast<std::uint64_t>(dimension));
+            for (int i = 0; i < degree; ++i)
+            {
+                hash = sobolHash(hash);
+                initialNumbers[i] = (static_cast<std::uint32_t>(hash) & ((1u << (i + 1)) - 1u)) | 1u;
+            }
+            initializeDimension(dimension, degree, coefficients, initialNumbers);
+        }
+    }
+
+    int dimensions() const
+    {
+        return numberOfDimensions;
+    }
+
+    /*
+     Computes one coordinate of a run of consecutive points.
+
+     @param dimension The dimension of the coordinate.
+     @param firstIndex The index of the first point, counted from zero.
+     @param numberOfPoints The number of points; firstIndex + numberOfPoints must not exceed 2^32.
+     @param values Receives the coordinates as 32-bit fractions.
+     */
+    void fillCoordinates(const int& dimension, const std::uint64_t& firstIndex, const int& numberOfPoints, std::uint32_t* values) const
+    {
+        if (firstIndex + static_cast<std::uint64_t>(numberOfPoints) > (1ull << sobolBits))
+        {
+            throw std::runtime_error("Sobol sequences support at most 2^32 points");
+        }
+        const std::uint32_t* directionNumbers = directions.data() + static_cast<std::size_t>(dimension) * sobolBits;
+
+        // Point firstIndex directly from the Gray code of its index
+        std::uint64_t grayCode = firstIndex ^ (firstIndex >> 1);
+        std::uint32_t value = 0;
+        for (int bit = 0; grayCode != 0; ++bit, grayCode >>= 1)
+        {
+            if ((grayCode & 1u) != 0)
+            {
+                value ^= directionNumbers[bit];
+            }
+        }
+
+        // The Gray codes of consecutive indices differ in the lowest set bit of the next index
+        for (int point = 0; point < numberOfPoints; ++point)
+        {
+            values[point] = value;
+            std::uint64_t nextIndex = firstIndex + static_cast<std::uint64_t>(point) + 1;
+            int bit = 0;
+            while ((nextIndex & 1u) == 0 && bit < sobolBits - 1)
+            {
+                nextIndex >>= 1;
+                ++bit;
+            }
+            value ^= directionNumbers[bit];
+        }
+    }
+
+private:
+    // Fills the direction numbers of a dimension from its polynomial and initial numbers
+    void initializeDimension(const int& dimension, const int& degree, const std::uint32_t& coefficients, const std::uint32_t* initialNumbers)
+    {
+        std::uint32_t* directionNumbers = directions.data() + static_cast<std::size_t>(dimension) * sobolBits;
+        for (int i = 0; i < degree && i < sobolBits; ++i)
+        {
+            directionNumbers[i] = initialNumbers[i] << (sobolBits - 1 - i);
+        }
+        for (int i = degree; i < sobolBits; ++i)
+        {
+            std::uint32_t value = directionNumbers[i - degree] ^ (directionNumbers[i - degree] >> degree);
+            for (int k = 1; k < degree; ++k)
+            {
+                if (((coefficients >> (degree - 1 - k)) & 1u) != 0)
+                {
+                    value ^= directionNumbers[i - k];
+                }
+            }
+            directionNumbers[i] = value;
+        }
+    }
+
+    int numberOfDimensions = 0;
+    std::vector<std::uint32_t> directions;
+};
@@ -0,0 +1,735 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "HeathJarrowMortonEngine.h"
+#include "PathEngine.h"
+
+/*
+ Online statistics over simulated paths.
+
+ These accumulate per-date moments, quantiles and discount factors while the
+ paths are generated, so a run needs memory for its dates rather than for
+ its paths. Every accumulator can be merged with another of the same kind,
+ which lets each thread fill its own and combine them at the end. The merged
+ results match for any number of threads up to rounding.
+ */
+
+/*
+ Count, mean and sum of squared deviations, updated with Welford's method and merged with Chan's formula.
+ */
+struct RunningMoments
+{
+    double count = 0.0;
+    double mean = 0.0;
+    double sumOfSquaredDeviations = 0.0;
+
+    /*
+     Adds one value.
+
+     @param value The value to add.
+     */
+    void add(const double& value)
+    {
+        count += 1.0;
+        double deviation = value - mean;
+        mean += deviation / count;
+        sumOfSquaredDeviations += deviation * (value - mean);
+    }
+
+    /*
+     Adds a batch of values with a two-pass sum over the batch and one merge.
+
+     @param values The values to add.
+     @param numberOfValues The number of values.
+     */
+    void add(const double* values, const std::size_t& numberOfValues)
+    {
+        if (numberOfValues == 0)
+        {
+            return;
+        }
+        RunningMoments batch;
+        batch.count = static_cast<double>(numberOfValues);
+        double sum = 0.0;
+        for (std::size_t value = 0; value < numberOfValues; ++value)
+        {
+            sum += values[value];
+        }
+        batch.mean = sum / batch.count;
+        for (std::size_t value = 0; value < numberOfValues; ++value)
+        {
+            double deviation = values[value] - batch.mean;
+            batch.sumOfSquaredDeviations += deviation * deviation;
+        }
+        merge(batch);
+    }
+
+    /*
+     Merges the values seen by another accumulator into this one.
+
+     @param other The other accumulator.
+     */
+    void merge(const RunningMoments& other)
+    {
+        if (other.count == 0.0)
+        {
+            return;
+        }
+        double combinedCount = count + other.count;
+        double deviation = other.mean - mean;
+        mean += deviation * other.count / combinedCount;
+        sumOfSquaredDeviations += other.sumOfSquaredDeviations + deviation * deviation * count * other.count / combinedCount;
+        count = combinedCount;
+    }
+
+    /*
+     Returns the sample variance.
+     */
+    double variance() const
+    {
+        return count > 1.0 ? sumOfSquaredDeviations / (count - 1.0) : 0.0;
+    }
+
+    double standardDeviation() const
+    {
+        return std::sqrt(variance());
+    }
+
+    /*
+     Returns the standard error of the mean.
+     */
+    double standardError() const
+    {
+        return count > 0.0 ? std::sqrt(variance() / count) : 0.0;
+    }
+};
+
+/*
+ Running means, variances and covariance of a pair of values, mergeable like RunningMoments.
+ */
+struct RunningCovariance
+{
+    double count = 0.0;
+    double meanX = 0.0;
+    double meanY = 0.0;
+    double sumOfSquaredDeviationsX = 0.0;
+    double sumOfSquaredDeviationsY = 0.0;
+    double sumOfCrossDeviations = 0.0;
+
+    /*
+     Adds one pair.
+
+     @param x The first value.
+     @param y The second value.
+     */
+    void add(const double& x, const double& y)
+    {
+        count += 1.0;
+        double deviationX = x - meanX;
+        double deviationY = y - meanY;
+        meanX += deviationX / count;
+        meanY += deviationY / count;
+        sumOfSquaredDeviationsX += deviationX * (x - meanX);
+        sumOfSquaredDeviationsY += deviationY * (y - meanY);
+        sumOfCrossDeviations += deviationX * (y - meanY);
+    }
+
+    /*
+     Merges the pairs seen by another accumulator into this one.
+
+     @param other The other accumulator.
+     */
+    void merge(const RunningCovariance& other)
+    {
+        if (other.count == 0.0)
+        {
+            return;
+        }
+        double combinedCount = count + other.count;
+        double deviationX = other.meanX - meanX;
+        double deviationY = other.meanY - meanY;
+        double weight = count * other.count / combinedCount;
+        meanX += deviationX * other.count / combinedCount;
+        meanY += deviationY * other.count / combinedCount;
+        sumOfSquaredDeviationsX += other.sumOfSquaredDeviationsX + deviationX * deviationX * weight;
+        sumOfSquaredDeviationsY += other.sumOfSquaredDeviationsY + deviationY * deviationY * weight;
+        sumOfCrossDeviations += other.sumOfCrossDeviations + deviationX * deviationY * weight;
+        count = combinedCount;
+    }
+
+    double varianceX() const
+    {
+        return count > 1.0 ? sumOfSquaredDeviationsX / (count - 1.0) : 0.0;
+    }
+
+    double varianceY() const
+    {
+        return count > 1.0 ? sumOfSquaredDeviationsY / (count - 1.0) : 0.0;
+    }
+
+    double covariance() const
+    {
+        return count > 1.0 ? sumOfCrossDeviations / (count - 1.0) : 0.0;
+    }
+};
+
+struct QuantileCentroid
+{
+    double mean;
+    double weight;
+};
+
+/*
+ A mergeable quantile sketch (a merging t-digest with the arcsine scale function).
+
+ The values are summarized by at most about compression centroids. Centroids
+ near the tails hold few values and those near the median many, so extreme
+ quantiles stay accurate. Values are added in sorted batches, which suits
+ the row-at-a-time engine: each batch costs one sort and one linear merge.
+ */
+class QuantileSketch
+{
+public:
+    /*
+     Creates an empty sketch.
+
+     @param sketchCompression The compression; higher keeps more centroids and is more accurate.
+     */
+    explicit QuantileSketch(const double& sketchCompression = 100.0)
+        : compression(sketchCompression)
+    {
+    }
+
+    /*
+     Adds a batch of finite values sorted in increasing order.
+
+     @param values The sorted values, none of them NaN or infinite.
+     @param numberOfValues The number of values.
+     @param scratch Working space, reused between calls.
+     */
+    void addSorted(const double* values, const std::size_t& numberOfValues, std::vector<QuantileCentroid>& scratch)
+    {
+        if (numberOfValues == 0)
+        {
+            return;
+        }
+        minimum = std::min(minimum, values[0]);
+        maximum = std::max(maximum, values[numberOfValues - 1]);
+        totalWeight += static_cast<double>(numberOfValues);
+
+        // Merge the centroids and the batch into one sorted run
+        scratch.clear();
+        std::size_t centroid = 0;
+        std::size_t value = 0;
+        while (centroid < centroids.size() || value < numberOfValues)
+        {
+            if (value == numberOfValues || (centroid < centroids.size() && centroids[centroid].mean <= values[value]))
+            {
+                scratch.push_back(centroids[centroid++]);
+            }
+            else
+            {
+                scratch.push_back({ values[value++], 1.0 });
+            }
+        }
+        compress(scratch);
+    }
+
+    /*
+     Adds a batch of values in any order. NaN and infinite values are skipped.
+
+     @param values The values.
+     @param numberOfValues The number of values.
+     @return The number of values skipped.
+     */
+    std::size_t add(const double* values, const std::size_t& numberOfValues)
+    {
+        std::vector<double> sortedValues(values, values + numberOfValues);
+        auto finiteEnd = std::partition(sortedValues.begin(), sortedValues.end(), [](const double& value) { return std::isfinite(value); });
+        std::sort(sortedValues.begin(), finiteEnd);
+        std::vector<QuantileCentroid> scratch;
+        addSorted(sortedValues.data(), static_cast<std::size_t>(finiteEnd - sortedValues.begin()), scratch);
+        return static_cast<std::size_t>(sortedValues.end() - finiteEnd);
+    }
+
+    /*
+     Merges the values summarized by another sketch into this one.
+
+     @param other The other sketch.
+     @param scratch Working space, reused between calls.
+     */
+    void merge(const QuantileSketch& other, std::vector<QuantileCentroid>& scratch)
+    {
+        if (other.totalWeight == 0.0)
+        {
+            return;
+        }
+        minimum = std::min(minimum, other.minimum);
+        maximum = std::max(maximum, other.maximum);
+        totalWeight += other.totalWeight;
+
+        scratch.resize(centroids.size() + other.centroids.size());
+        std::merge(
+            centroids.begin(), centroids.end(),
+            other.centroids.begin(), other.centroids.end(),
+            scratch.begin(),
+            [](const QuantileCentroid& left, const QuantileCentroid& right) { return left.mean < right.mean; });
+        compress(scratch);
+    }
+
+    /*
+     Estimates a quantile by interpolating between the centroid means.
+
+     @param probability The probability of the quantile, in [0, 1].
+     @return The estimated quantile, or NaN if the sketch is empty.
+     */
+    double quantile(const double& probability) const
+    {
+        if (centroids.empty())
+        {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        if (probability <= 0.0)
+        {
+            return minimum;
+        }
+        if (probability >= 1.0)
+        {
+            return maximum;
+        }
+
+        double target = probability * totalWeight;
+        const QuantileCentroid& first = centroids.front();
+        if (target < 0.5 * first.weight)
+        {
+            return minimum + (first.mean - minimum) * target / (0.5 * first.weight);
+        }
+
+        // Walk the centroid centres until the target falls between two of them
+        double cumulativeWeight = 0.0;
+        for (std::size_t centroid = 0; centroid + 1 < centroids.size(); ++centroid)
+        {
+            const QuantileCentroid& left = centroids[centroid];
+            const QuantileCentroid& right = centroids[centroid + 1];
+            double leftCentre = cumulativeWeight + 0.5 * left.weight;
+            double rightCentre = cumulativeWeight + left.weight + 0.5 * right.weight;
+            if (target <= rightCentre)
+            {
+                return left.mean + (right.mean - left.mean) * (target - leftCentre) / (rightCentre - leftCentre);
+            }
+            cumulativeWeight += left.weight;
+        }
+
+        const QuantileCentroid& last = centroids.back();
+        double lastCentre = totalWeight - 0.5 * last.weight;
+        return last.mean + (maximum - last.mean) * (target - lastCentre) / (0.5 * last.weight);
+    }
+
+    /*
+     Returns the number of values summarized.
+     */
+    double count() const
+    {
+        return totalWeight;
+    }
+
+    std::size_t numberOfCentroids() const
+    {
+        return centroids.size();
+    }
+
+private:
+    // Rebuilds the centroids from a sorted run, merging neighbours while the scale function allows
+    void compress(std::vector<QuantileCentroid>& sortedCentroids)
+    {
+        centroids.clear();
+        if (sortedCentroids.empty())
+        {
+            return;
+        }
+
+        double weightSoFar = 0.0;
+        double weightLimit = totalWeight * nextQuantileLimit(0.0);
+        QuantileCentroid current = sortedCentroids[0];
+        for (std::size_t index = 1; index < sortedCentroids.size(); ++index)
+        {
+            const QuantileCentroid& next = sortedCentroids[index];
+            if (weightSoFar + current.weight + next.weight <= weightLimit)
+            {
+                current.weight += next.weight;
+                current.mean += (next.mean - current.mean) * next.weight / current.weight;
+            }
+            else
+            {
+                centroids.push_back(current);
+                weightSoFar += current.weight;
+                weightLimit = totalWeight * nextQuantileLimit(weightSoFar / totalWeight);
+                current = next;
+            }
+        }
+        centroids.push_back(current);
+    }
+
+    // The quantile one unit of the scale function k(q) = compression / (2 pi) * asin(2q - 1) beyond q
+    double nextQuantileLimit(const double& quantile) const
+    {
+        const double halfPi = 1.5707963267948966;
+        double angle = std::asin(2.0 * quantile - 1.0) + 4.0 * halfPi / compression;
+        if (angle >= halfPi)
+        {
+            return 1.0;
+        }
+        return 0.5 * (std::sin(angle) + 1.0);
+    }
+
+    double compression;
+    double totalWeight = 0.0;
+    double minimum = std::numeric_limits<double>::infinity();
+    double maximum = -std::numeric_limits<double>::infinity();
+    std::vector<QuantileCentroid> centroids;
+};
+
+/*
+ Per-date statistics of a batch of short-rate paths.
+
+ discountFactorMoments[i] summarizes exp(-int_0^{t_i} r(s) ds) over the
+ paths, with the integral taken by the trapezoidal rule on the time grid, so
+ its mean estimates the zero-coupon bond price P(0, t_i).
+
+ rateMoments[i] includes every path, so a rate that became NaN (a CEV path
+ that went negative, say) makes its mean NaN. rateQuantiles[i] sketches
+ only the finite rates, and nonFiniteRateCounts[i] counts the others.
+ */
+struct PathStatistics
+{
+    std::vector<double> timeValues;
+    std::vector<RunningMoments> rateMoments;
+    std::vector<QuantileSketch> rateQuantiles;
+    std::vector<double> nonFiniteRateCounts;
+    std::vector<RunningMoments> discountFactorMoments;
+
+    /*
+     Clears the statistics and sizes them for a time grid.
+
+     @param simulationTimeValues The time grid.
+     @param compression The compression of the quantile sketches.
+     */
+    void reset(const std::vector<double>& simulationTimeValues, const double& compression)
+    {
+        timeValues = simulationTimeValues;
+        rateMoments.assign(timeValues.size(), RunningMoments());
+        rateQuantiles.assign(timeValues.size(), QuantileSketch(compression));
+        nonFiniteRateCounts.assign(timeValues.size(), 0.0);
+        discountFactorMoments.assign(timeValues.size(), RunningMoments());
+    }
+
+    /*
+     Merges the statistics of another batch of paths on the same time grid.
+
+     @param other The other statistics.
+     @param scratch Working space for the quantile sketches.
+     */
+    void merge(const PathStatistics& other, std::vector<QuantileCentroid>& scratch)
+    {
+        for (std::size_t i = 0; i < timeValues.size(); ++i)
+        {
+            rateMoments[i].merge(other.rateMoments[i]);
+            rateQuantiles[i].merge(other.rateQuantiles[i], scratch);
+            nonFiniteRateCounts[i] += other.nonFiniteRateCounts[i];
+            discountFactorMoments[i].merge(other.discountFactorMoments[i]);
+        }
+    }
+
+    int numberOfTimeSteps() const
+    {
+        return static_cast<int>(timeValues.size()) - 1;
+    }
+};
+
+/*
+ A path sink for simulatePaths() that keeps only per-date statistics.
+
+ Each thread updates its own PathStatistics and carries the running
+ discount integral of the paths in its current block; endSimulation() merges
+ the threads into statistics. Memory is O(dates x threads), whatever the
+ number of paths.
+
+ The integral starts at the first step a block is given, so a run resumed
+ with resumePaths() discounts from the checkpoint: its discount factors are
+ 1 at the checkpoint's date, and the dates before it have no statistics.
+ */
+class PathStatisticsSink
+{
+public:
+    /*
+     @param sketchCompression The compression of the quantile sketches; zero skips the quantiles, which saves a sort per row.
+     */
+    explicit PathStatisticsSink(const double& sketchCompression = 200.0)
+        : compression(sketchCompression)
+    {
+    }
+
+    void beginSimulation(const std::vector<double>& timeValues, const int&, const int& numberOfThreads)
+    {
+        statistics.reset(timeValues, compression);
+        threadStates.resize(static_cast<std::size_t>(numberOfThreads));
+        for (ThreadState& threadState : threadStates)
+        {
+            threadState.statistics.reset(timeValues, compression);
+            threadState.previousRates.resize(pathBlockSize);
+            threadState.discountIntegrals.resize(pathBlockSize);
+            threadState.values.resize(pathBlockSize);
+            threadState.lastStep = -1;
+        }
+    }
+
+    void observeStep(const int& threadIndex, const int& stepIndex, const int&, const double* rates, const int& numberOfPaths)
+    {
+        ThreadState& threadState = threadStates[threadIndex];
+        PathStatistics& threadStatistics = threadState.statistics;
+        double* values = threadState.values.data();
+
+        // Accumulate the discount integral with the trapezoidal rule, from the first step of the block
+        bool blockStart = stepIndex == 0 || stepIndex != threadState.lastStep + 1;
+        threadState.lastStep = stepIndex;
+        if (blockStart)
+        {
+            std::fill(threadState.discountIntegrals.begin(), threadState.discountIntegrals.end(), 0.0);
+        }
+        else
+        {
+            double halfStep = 0.5 * (threadStatistics.timeValues[stepIndex] - threadStatistics.timeValues[stepIndex - 1]);
+            for (int path = 0; path < numberOfPaths; ++path)
+            {
+                threadState.discountIntegrals[path] += halfStep * (threadState.previousRates[path] + rates[path]);
+            }
+        }
+        for (int path = 0; path < numberOfPaths; ++path)
+        {
+            values[path] = std::exp(-threadState.discountIntegrals[path]);
+        }
+        threadStatistics.discountFactorMoments[stepIndex].add(values, static_cast<std::size_t>(numberOfPaths));
+        std::copy(rates, rates + numberOfPaths, threadState.previousRates.begin());
+
+        // Rate moments, and quantiles of the finite rates; sorting a NaN is undefined behaviour
+        threadStatistics.rateMoments[stepIndex].add(rates, static_cast<std::size_t>(numberOfPaths));
+        std::copy(rates, rates + numberOfPaths, values);
+        double* finiteEnd = std::partition(values, values + numberOfPaths, [](const double& rate) { return std::isfinite(rate); });
+        threadStatistics.nonFiniteRateCounts[stepIndex] += static_cast<double>(values + numberOfPaths - finiteEnd);
+        if (compression <= 0.0)
+        {
+            return;
+        }
+        std::sort(values, finiteEnd);
+        threadStatistics.rateQuantiles[stepIndex].addSorted(values, static_cast<std::size_t>(finiteEnd - values), threadState.centroidScratch);
+    }
+
+    void endSimulation()
+    {
+        std::vector<QuantileCentroid> scratch;
+        for (const ThreadState& threadState : threadStates)
+        {
+            statistics.merge(threadState.statistics, scratch);
+        }
+    }
+
+    PathStatistics statistics;
+
+private:
+    struct ThreadState
+    {
+        PathStatistics statistics;
+        std::vector<double> previousRates;
+        std::vector<double> discountIntegrals;
+        std::vector<double> values;
+        std::vector<QuantileCentroid> centroidScratch;
+        int lastStep = -1;  // the step last observed, to tell where a block starts
+    };
+
+    double compression;
+    std::vector<ThreadState> threadStates;
+};
+
+/*
+ Simulates short-rate paths and returns their per-date statistics without storing the paths.
+
+ @param model The short-rate model to simulate.
+ @param timeHorizon The time horizon of the simulation.
+ @param timeStep The time step of the simulation.
+ @param numberOfPaths The number of paths to simulate.
+ @param seed The seed of the random number streams.
+ @param sketchCompression The compression of the quantile sketches; zero skips the quantiles.
+ @return The statistics of the paths at every date.
+ */
+template <typename Model>
+PathStatistics simulatePathStatistics(
+    const Model& model,
+    const double& timeHorizon,
+    const double& timeStep,
+    const int& numberOfPaths,
+    const std::uint64_t& seed,
+    const double& sketchCompression = 200.0)
+{
+    PathStatisticsSink sink(sketchCompression);
+    simulatePaths(model, timeHorizon, timeStep, numberOfPaths, seed, sink);
+    return sink.statistics;
+}
+
+/*
+ Per-date, per-maturity moments and, optionally, quantiles of simulated forward curves.
+
+ forwardRateQuantiles has the layout of forwardRateMoments when the sink
+ was given a sketch compression and is empty otherwise. Like the rate
+ quantiles of PathStatistics, the sketches leave out NaN and infinite
+ forwards.
+ */
+struct ForwardCurveStatistics
+{
+    std::vector<double> timeValues;
+    std::vector<double> maturities;
+    std::vector<RunningMoments> forwardRateMoments;  // record-major, maturities.size() per record
+    std::vector<QuantileSketch> forwardRateQuantiles;
+
+    const RunningMoments& moments(const int& record, const int& maturity) const
+    {
+        return forwardRateMoments[static_cast<std::size_t>(record) * maturities.size() + maturity];
+    }
+
+    const QuantileSketch& quantiles(const int& record, const int& maturity) const
+    {
+        return forwardRateQuantiles[static_cast<std::size_t>(record) * maturities.size() + maturity];
+    }
+};
+
+/*
+ A curve sink for simulateForwardCurves() that keeps only the moments, and
+ optionally the quantiles, of every forward.
+
+ Memory is O(dates x maturities x threads), so HJM runs are no longer
+ limited by the number of paths. The quantiles cost a gather and a sort per
+ maturity and record, so they are off unless a compression is given.
+ */
+class ForwardCurveStatisticsSink
+{
+public:
+    /*
+     @param sketchCompression The compression of the quantile sketches; zero, the default, skips the quantiles.
+     */
+    explicit ForwardCurveStatisticsSink(const double& sketchCompression = 0.0)
+        : compression(sketchCompression)
+    {
+    }
+
+    void beginSimulation(const std::vector<double>& recordTimes, const std::vector<double>& maturityGrid, const int&, const int& numberOfThreads)
+    {
+        statistics.timeValues = recordTimes;
+        statistics.maturities = maturityGrid;
+        statistics.forwardRateMoments.assign(recordTimes.size() * maturityGrid.size(), RunningMoments());
+        statistics.forwardRateQuantiles.assign(compression > 0.0 ? recordTimes.size() * maturityGrid.size() : 0, QuantileSketch(compression));
+        threadStates.resize(static_cast<std::size_t>(numberOfThreads));
+        for (ThreadState& threadState : threadStates)
+        {
+            threadState.forwardRateMoments = statistics.forwardRateMoments;
+            threadState.forwardRateQuantiles = statistics.forwardRateQuantiles;
+            threadState.sums.resize(maturityGrid.size());
+            threadState.values.resize(compression > 0.0 ? forwardCurvePathBlockSize : 0);
+        }
+    }
+
+    void observeRecord(const int& threadIndex, const int& record, const int&, const double* curves, const int& numberOfPaths)
+    {
+        ThreadState& threadState = threadStates[threadIndex];
+        std::size_t numberOfMaturities = statistics.maturities.size();
+        if (numberOfPaths == 0 || numberOfMaturities == 0)
+        {
+            return;
+        }
+
+        // Two passes over the block, running along each curve so the access stays contiguous
+        std::fill(threadState.sums.begin(), threadState.sums.end(), 0.0);
+        for (int path = 0; path < numberOfPaths; ++path)
+        {
+            const double* curve = curves + static_cast<std::size_t>(path) * numberOfMaturities;
+            for (std::size_t maturity = 0; maturity < numberOfMaturities; ++maturity)
+            {
+                threadState.sums[maturity] += curve[maturity];
+            }
+        }
+        RunningMoments* recordMoments = threadState.forwardRateMoments.data() + static_cast<std::size_t>(record) * numberOfMaturities;
+        std::vector<RunningMoments>& batch = threadState.batch;
+        batch.assign(numberOfMaturities, RunningMoments());
+        for (std::size_t maturity = 0; maturity < numberOfMaturities; ++maturity)
+        {
+            batch[maturity].count = static_cast<double>(numberOfPaths);
+            batch[maturity].mean = threadState.sums[maturity] / numberOfPaths;
+        }
+        for (int path = 0; path < numberOfPaths; ++path)
+        {
+            const double* curve = curves + static_cast<std::size_t>(path) * numberOfMaturities;
+            for (std::size_t maturity = 0; maturity < numberOfMaturities; ++maturity)
+            {
+                double deviation = curve[maturity] - batch[maturity].mean;
+                batch[maturity].sumOfSquaredDeviations += deviation * deviation;
+            }
+        }
+        for (std::size_t maturity = 0; maturity < numberOfMaturities; ++maturity)
+        {
+            recordMoments[maturity].merge(batch[maturity]);
+        }
+        if (compression <= 0.0)
+        {
+            return;
+        }
+
+        // Gather each maturity across the block and sketch its finite values
+        QuantileSketch* recordQuantiles = threadState.forwardRateQuantiles.data() + static_cast<std::size_t>(record) * numberOfMaturities;
+        double* values = threadState.values.data();
+        for (std::size_t maturity = 0; maturity < numberOfMaturities; ++maturity)
+        {
+            for (int path = 0; path < numberOfPaths; ++path)
+            {
+                values[path] = curves[static_cast<std::size_t>(path) * numberOfMaturities + maturity];
+            }
+            double* finiteEnd = std::partition(values, values + numberOfPaths, [](const double& forwardRate) { return std::isfinite(forwardRate); });
+            std::sort(values, finiteEnd);
+            recordQuantiles[maturity].addSorted(values, static_cast<std::size_t>(finiteEnd - values), threadState.centroidScratch);
+        }
+    }
+
+    void endSimulation()
+    {
+        std::vector<QuantileCentroid> scratch;
+        for (const ThreadState& threadState : threadStates)
+        {
+            for (std::size_t index = 0; index < statistics.forwardRateMoments.size(); ++index)
+            {
+                statistics.forwardRateMoments[index].merge(threadState.forwardRateMoments[index]);
+            }
+            for (std::size_t index = 0; index < statistics.forwardRateQuantiles.size(); ++index)
+            {
+                statistics.forwardRateQuantiles[index].merge(threadState.forwardRateQuantiles[index], scratch);
+            }
+        }
+    }
+
+    ForwardCurveStatistics statistics;
+
+private:
+    struct ThreadState
+    {
+        std::vector<RunningMoments> forwardRateMoments;
+        std::vector<QuantileSketch> forwardRateQuantiles;
+        std::vector<RunningMoments> batch;
+        std::vector<double> sums;
+        std::vector<double> values;
+        std::vector<QuantileCentroid> centroidScratch;
+    };
+
+    double compression;
+    std::vector<ThreadState> threadStates;
+};
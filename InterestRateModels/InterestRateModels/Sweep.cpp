@@ -0,0 +1,43 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "ScenarioSweep.h"
+
+/*
+ Runs a parameter sweep.
+
+ @param specificationPath The path to the sweep specification (see ScenarioSweep.h).
+ */
+void runParameterSweep(const std::string& specificationPath)
+{
+    SweepSpecification specification = readSweepSpecification(specificationPath);
+    std::vector<SweepScenario> scenarios = expandSweep(specification);
+
+    // Run every scenario and write the results to one file
+    auto start = std::chrono::steady_clock::now();
+    std::vector<ScenarioSummary> summaries = runSweep(specification, scenarios);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    writeSweepResults(specification.outputPath, specification, scenarios, summaries);
+
+    std::cout << "Ran " << scenarios.size() << " scenarios in " << seconds << " s on " << defaultThreadPool().numberOfThreads()
+        << " threads. Results saved to " << specification.outputPath << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: Sweep <specification>" << std::endl;
+        return 1;
+    }
+
+    // Run the sweep described by the specification
+    runParameterSweep(argv[1]);
+
+    // Write the profiling report, if built with INTEREST_RATE_MODELS_PROFILING
+    INTEREST_RATE_MODELS_PROFILE_REPORT("sweep_profile.json", true);
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ A fixed set of worker threads that run parallel loops.
+
+ parallelFor() hands out task indices from a shared counter, so faster threads
+ simply take more tasks. The calling thread works alongside the pool and the
+ call returns once every task has finished. Submitting a loop does not
+ allocate: the loop body is passed to the workers by pointer.
+
+ A parallelFor() issued from inside a task runs serially on the calling
+ thread, so engines can be nested without deadlocking the pool.
+ */
+class ThreadPool
+{
+public:
+    /*
+     Starts the pool.
+
+     @param numberOfThreads The total number of threads, including the caller. Zero means one per hardware thread.
+     */
+    explicit ThreadPool(const int& numberOfThreads = 0)
+    {
+        int threadCount = numberOfThreads > 0 ? numberOfThreads : static_cast<int>(std::thread::hardware_concurrency());
+        threadCount = std::max(1, threadCount);
+        for (int threadIndex = 1; threadIndex < threadCount; ++threadIndex)
+        {
+            workers.emplace_back([this, threadIndex]() { workerLoop(threadIndex); });
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            stopping = true;
+        }
+        workAvailable.notify_all();
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /*
+     Returns the number of threads that run tasks, including the caller.
+     */
+    int numberOfThreads() const
+    {
+        return static_cast<int>(workers.size()) + 1;
+    }
+
+    /*
+     Runs body(taskIndex, threadIndex) for every taskIndex in [0, numberOfTasks).
+
+     threadIndex is in [0, numberOfThreads()) and identifies the thread running
+     the task, so the body can use per-thread scratch space. The first
+     exception thrown by a task is rethrown here once all threads have stopped.
+
+     @param numberOfTasks The number of tasks to run.
+     @param body The loop body.
+     */
+    template <typename Body>
+    void parallelFor(const int& numberOfTasks, Body& body)
+    {
+        if (numberOfTasks <= 0)
+        {
+            return;
+        }
+
+        // Nested loops, single tasks and single-threaded pools run inline
+        if (insidePoolTask() || workers.empty() || numberOfTasks == 1)
+        {
+            for (int taskIndex = 0; taskIndex < numberOfTasks; ++taskIndex)
+            {
+                body(taskIndex, 0);
+            }
+            return;
+        }
+
+        std::lock_guard<std::mutex> submitLock(submitMutex);
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            jobInvoke = [](void* context, int taskIndex, int threadIndex) { (*static_cast<Body*>(context))(taskIndex, threadIndex); };
+            jobContext = &body;
+            jobTaskCount = numberOfTasks;
+            nextTask.store(0);
+            firstException = nullptr;
+            activeWorkers = static_cast<int>(workers.size());
+            ++generation;
+        }
+        workAvailable.notify_all();
+
+        runTasks(0);
+
+        std::unique_lock<std::mutex> lock(stateMutex);
+        workFinished.wait(lock, [this]() { return activeWorkers == 0; });
+        if (firstException)
+        {
+            std::exception_ptr exception = firstException;
+            firstException = nullptr;
+            std::rethrow_exception(exception);
+        }
+    }
+
+    template <typename Body>
+    void parallelFor(const int& numberOfTasks, const Body& body)
+    {
+        Body bodyCopy = body;
+        parallelFor(numberOfTasks, bodyCopy);
+    }
+
+private:
+    static bool& insidePoolTask()
+    {
+        static thread_local bool inside = false;
+        return inside;
+    }
+
+    void workerLoop(const int& threadIndex)
+    {
+        std::uint64_t seenGeneration = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(stateMutex);
+                workAvailable.wait(lock, [this, seenGeneration]() { return stopping || generation != seenGeneration; });
+                if (stopping)
+                {
+                    return;
+                }
+                seenGeneration = generation;
+            }
+
+            runTasks(threadIndex);
+
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (--activeWorkers == 0)
+            {
+                workFinished.notify_one();
+            }
+        }
+    }
+
+    void runTasks(const int& threadIndex)
+    {
+        insidePoolTask() = true;
+        while (true)
+        {
+            int taskIndex = nextTask.fetch_add(1);
+            if (taskIndex >= jobTaskCount)
+            {
+                break;
+            }
+            try
+            {
+                jobInvoke(jobContext, taskIndex, threadIndex);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                if (!firstException)
+                {
+                    firstException = std::current_exception();
+                }
+                // Skip the remaining tasks
+                nextTask.store(jobTaskCount);
+            }
+        }
+        insidePoolTask() = false;
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex submitMutex;
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workFinished;
+    std::uint64_t generation = 0;
+    bool stopping = false;
+    int activeWorkers = 0;
+
+    void (*jobInvoke)(void*, int, int) = nullptr;
+    void* jobContext = nullptr;
+    int jobTaskCount = 0;
+    std::atomic<int> nextTask{ 0 };
+    std::exception_ptr firstException;
+};
+
+/*
+ Returns a process-wide pool with one thread per hardware thread.
+ */
+inline ThreadPool& defaultThreadPool()
+{
+    static ThreadPool threadPool;
+    return threadPool;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+/*
+ Deterministic functions of time, such as the theta, alpha and sigma inputs
+ of the Hull-White model.
+ */
+
+enum class CurveInterpolation
+{
+    PiecewiseConstant,  // values[k] holds on [times[k], times[k + 1])
+    Linear              // straight lines between the knots
+};
+
+/*
+ A curve given by its values on its own time grid.
+
+ Both interpolation modes extrapolate flat: before the first knot the curve
+ takes the first value, after the last knot the last value.
+ */
+struct TimeCurve
+{
+    std::vector<double> times;
+    std::vector<double> values;
+    CurveInterpolation interpolation = CurveInterpolation::PiecewiseConstant;
+
+    /*
+     Returns a curve with the same value at every time.
+
+     @param value The value of the curve.
+     */
+    static TimeCurve constant(const double& value)
+    {
+        TimeCurve curve;
+        curve.times = { 0.0 };
+        curve.values = { value };
+        return curve;
+    }
+
+    /*
+     Evaluates the curve.
+
+     @param time The time at which to evaluate the curve.
+     @return The value of the curve at the given time.
+     */
+    double valueAt(const double& time) const
+    {
+        if (values.empty())
+        {
+            return 0.0;
+        }
+        if (time <= times.front())
+        {
+            return values.front();
+        }
+        if (time >= times.back())
+        {
+            return values.back();
+        }
+
+        // Index of the last knot at or before the time
+        std::size_t knot = static_cast<std::size_t>(std::upper_bound(times.begin(), times.end(), time) - times.begin()) - 1;
+        if (interpolation == CurveInterpolation::PiecewiseConstant)
+        {
+            return values[knot];
+        }
+        double weight = (time - times[knot]) / (times[knot + 1] - times[knot]);
+        return values[knot] + weight * (values[knot + 1] - values[knot]);
+    }
+
+    /*
+     Finds how valueAt() weighs the knots at a time: the value is
+     (1 - secondWeight) * values[firstKnot] + secondWeight * values[firstKnot + 1].
+
+     @param time The time at which the curve is evaluated.
+     @param firstKnot Receives the index of the first knot that carries weight.
+     @param secondWeight Receives the weight of the knot after it, zero if it has none.
+     */
+    void knotWeights(const double& time, std::size_t& firstKnot, double& secondWeight) const
+    {
+        firstKnot = 0;
+        secondWeight = 0.0;
+        if (values.empty() || time <= times.front())
+        {
+            return;
+        }
+        if (time >= times.back())
+        {
+            firstKnot = values.size() - 1;
+            return;
+        }
+        firstKnot = static_cast<std::size_t>(std::upper_bound(times.begin(), times.end(), time) - times.begin()) - 1;
+        if (interpolation == CurveInterpolation::Linear)
+        {
+            secondWeight = (time - times[firstKnot]) / (times[firstKnot + 1] - times[firstKnot]);
+        }
+    }
+};
@@ -0,0 +1,434 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "BondPricing.h"
+#include "ShortRateModels.h"
+#include "TimeCurve.h"
+
+/*
+ Recombining trinomial lattices for the Hull-White and Ho-Lee models.
+
+ The lattice is the Hull-White tree for r(t) = shift(t) + x(t), where x is
+ the Ornstein-Uhlenbeck process dx = -a x dt + sigma dW started at zero
+ (a = 0 gives Ho-Lee). Slices are timeStep apart and node j of a slice
+ has x = j * nodeSpacing with nodeSpacing = sqrt(3 V), V the variance of x
+ over one step. Nodes branch to j + 1, j, j - 1 except at |j| = maximumNode,
+ where they branch inwards so the tree stops widening. The probabilities
+ match the mean and variance of x over the step.
+
+ The shifts, which play the role of theta, are fitted to a discount curve by
+ forward induction over the Arrow-Debreu prices, so the lattice reprices
+ every zero-coupon bond on its grid exactly.
+
+ Everything that depends only on the node index (the probabilities times
+ exp(-j nodeSpacing timeStep)) is tabulated once in flat arrays, and each
+ slice adds one discount factor exp(-shift timeStep). A backward step over
+ the interior nodes is then a loop of multiply-adds over contiguous arrays
+ that the compiler vectorizes; only the two edge nodes are handled apart.
+ Value arrays are indexed by j + maximumNode, and two of them are swapped
+ from slice to slice.
+ */
+struct TrinomialLattice
+{
+    double timeStep = 0.0;
+    int numberOfSteps = 0;
+    double meanReversion = 0.0;
+    double volatility = 0.0;
+    double nodeSpacing = 0.0;
+    int maximumNode = 0;
+
+    // Per slice: the shift of the rates and exp(-shift * timeStep)
+    std::vector<double> shifts;
+    std::vector<double> sliceDiscounts;
+
+    // Per node index j + maximumNode: the branch probabilities times exp(-j nodeSpacing timeStep), and the middle target
+    std::vector<double> upWeights;
+    std::vector<double> middleWeights;
+    std::vector<double> downWeights;
+    std::vector<int> middleTargets;
+
+    // The number of nodes of an array of values, 2 maximumNode + 1
+    int width() const
+    {
+        return 2 * maximumNode + 1;
+    }
+
+    // The largest |j| on a slice
+    int sliceExtent(const int& step) const
+    {
+        return std::min(step, maximumNode);
+    }
+
+    double time(const int& step) const
+    {
+        return step * timeStep;
+    }
+
+    // The slice nearest to a time
+    int stepAt(const double& time) const
+    {
+        return static_cast<int>(std::lround(time / timeStep));
+    }
+
+    double rate(const int& step, const int& node) const
+    {
+        return shifts[step] + node * nodeSpacing;
+    }
+};
+
+/*
+ Moves values one slice back: current receives the discounted expectation of next.
+
+ @param lattice The lattice.
+ @param step The slice to fill; next holds slice step + 1.
+ @param next The values on slice step + 1, indexed by j + maximumNode.
+ @param current Receives the values on slice step, indexed likewise.
+ */
+inline void rollBackSlice(const TrinomialLattice& lattice, const int& step, const double* next, double* current)
+{
+    int center = lattice.maximumNode;
+    int extent = lattice.sliceExtent(step);
+    double sliceDiscount = lattice.sliceDiscounts[step];
+    const double* up = lattice.upWeights.data();
+    const double* middle = lattice.middleWeights.data();
+    const double* down = lattice.downWeights.data();
+
+    // Nodes that branch to their neighbours: one contiguous multiply-add loop
+    int first = center - extent;
+    int last = center + extent;
+    int interiorFirst = extent == lattice.maximumNode && extent > 0 ? first + 1 : first;
+    int interiorLast = extent == lattice.maximumNode && extent > 0 ? last - 1 : last;
+    for (int node = interiorFirst; node <= interiorLast; ++node)
+    {
+        current[node] = sliceDiscount * (up[node] * next[node + 1] + middle[node] * next[node] + down[node] * next[node - 1]);
+    }
+
+    // Edge nodes branch inwards
+    if (interiorFirst != first)
+    {
+        for (int node : { first, last })
+        {
+            int target = lattice.middleTargets[node];
+            current[node] = sliceDiscount * (up[node] * next[target + 1] + middle[node] * next[target] + down[node] * next[target - 1]);
+        }
+    }
+}
+
+/*
+ Builds a lattice and fits its shifts to a discount curve.
+
+ @param meanReversion The mean reversion speed a; zero gives Ho-Lee.
+ @param volatility The volatility sigma of the short rate.
+ @param discountFactor The curve to fit, called as discountFactor(T) for P(0, T).
+ @param timeHorizon The time of the last slice.
+ @param numberOfSteps The number of slices after the first.
+ */
+template <typename DiscountFunction>
+TrinomialLattice buildTrinomialLattice(
+    const double& meanReversion,
+    const double& volatility,
+    const DiscountFunction& discountFactor,
+    const double& timeHorizon,
+    const int& numberOfSteps)
+{
+    if (!(timeHorizon > 0.0) || numberOfSteps < 1 || !(volatility > 0.0) || meanReversion < 0.0)
+    {
+        throw std::runtime_error("A lattice needs a positive horizon, steps and volatility and a non-negative mean reversion");
+    }
+
+    TrinomialLattice lattice;
+    lattice.timeStep = timeHorizon / numberOfSteps;
+    lattice.numberOfSteps = numberOfSteps;
+    lattice.meanReversion = meanReversion;
+    lattice.volatility = volatility;
+
+    // Mean and variance of x over one step: E[dx] = M x, Var[dx] = V
+    double dt = lattice.timeStep;
+    double drift = meanReversion > 0.0 ? std::expm1(-meanReversion * dt) : 0.0;
+    double variance = meanReversion > 0.0 ? volatility * volatility * -std::expm1(-2.0 * meanReversion * dt) / (2.0 * meanReversion) : volatility * volatility * dt;
+    lattice.nodeSpacing = std::sqrt(3.0 * variance);
+
+    // Past 0.184 / (a dt) the middle probability of a normal branch would turn negative
+    lattice.maximumNode = drift < 0.0 ? std::min(numberOfSteps, static_cast<int>(std::ceil(0.184 / -drift))) : numberOfSteps;
+
+    int center = lattice.maximumNode;
+    int width = lattice.width();
+    std::vector<double> nodeDiscounts(width);
+    lattice.upWeights.resize(width);
+    lattice.middleWeights.resize(width);
+    lattice.downWeights.resize(width);
+    lattice.middleTargets.resize(width);
+    for (int j = -center; j <= center; ++j)
+    {
+        double jm = j * drift;
+        double up = 1.0 / 6.0 + 0.5 * (jm * jm + jm);
+        double middle = 2.0 / 3.0 - jm * jm;
+        double down = 1.0 / 6.0 + 0.5 * (jm * jm - jm);
+        int target = j;
+        if (j == center && center > 0 && drift < 0.0)
+        {
+            // Branch to j, j - 1, j - 2
+            up = 7.0 / 6.0 + 0.5 * (jm * jm + 3.0 * jm);
+            middle = -1.0 / 3.0 - jm * jm - 2.0 * jm;
+            down = 1.0 / 6.0 + 0.5 * (jm * jm + jm);
+            target = j - 1;
+        }
+        else if (j == -center && center > 0 && drift < 0.0)
+        {
+            // Branch to j + 2, j + 1, j
+            up = 1.0 / 6.0 + 0.5 * (jm * jm - jm);
+            middle = -1.0 / 3.0 - jm * jm + 2.0 * jm;
+            down = 7.0 / 6.0 + 0.5 * (jm * jm - 3.0 * jm);
+            target = j + 1;
+        }
+        nodeDiscounts[j + center] = std::exp(-j * lattice.nodeSpacing * dt);
+        lattice.upWeights[j + center] = up * nodeDiscounts[j + center];
+        lattice.middleWeights[j + center] = middle * nodeDiscounts[j + center];
+        lattice.downWeights[j + center] = down * nodeDiscounts[j + center];
+        lattice.middleTargets[j + center] = target + center;
+    }
+
+    // Forward induction: prices[j] is the Arrow-Debreu price of node j on the current slice
+    lattice.shifts.resize(static_cast<std::size_t>(numberOfSteps) + 1);
+    lattice.sliceDiscounts.resize(static_cast<std::size_t>(numberOfSteps) + 1);
+    std::vector<double> prices(width, 0.0);
+    std::vector<double> nextPrices(width, 0.0);
+    prices[center] = 1.0;
+    for (int step = 0; step <= numberOfSteps; ++step)
+    {
+        // Choose the shift so that the slice reprices the bond maturing one step later
+        int extent = lattice.sliceExtent(step);
+        double discountedSum = 0.0;
+        for (int node = center - extent; node <= center + extent; ++node)
+        {
+            discountedSum += prices[node] * nodeDiscounts[node];
+        }
+        double bondPrice = discountFactor((step + 1) * dt);
+        lattice.shifts[step] = (std::log(discountedSum) - std::log(bondPrice)) / dt;
+        lattice.sliceDiscounts[step] = bondPrice / discountedSum;
+        if (step == numberOfSteps)
+        {
+            break;
+        }
+
+        // Spread the prices over the next slice; the weights already hold the node discounts
+        std::fill(nextPrices.begin(), nextPrices.end(), 0.0);
+        for (int node = center - extent; node <= center + extent; ++node)
+        {
+            double weight = lattice.sliceDiscounts[step] * prices[node];
+            int target = lattice.middleTargets[node];
+            nextPrices[target + 1] += weight * lattice.upWeights[node];
+            nextPrices[target] += weight * lattice.middleWeights[node];
+            nextPrices[target - 1] += weight * lattice.downWeights[node];
+        }
+        std::swap(prices, nextPrices);
+    }
+    return lattice;
+}
+
+/*
+ Builds a Hull-White lattice fitted to a curve of zero rates.
+
+ The lattice needs a constant mean reversion and volatility, so the alpha
+ and sigma curves of the model must each hold a single value; its theta is
+ replaced by the fit.
+
+ @param model The model, for alpha and sigma.
+ @param zeroRates Continuously compounded zero rates by maturity.
+ @param timeHorizon The time of the last slice.
+ @param numberOfSteps The number of slices after the first.
+ */
+inline TrinomialLattice buildTrinomialLattice(const HullWhiteModel& model, const TimeCurve& zeroRates, const double& timeHorizon, const int& numberOfSteps)
+{
+    auto isConstant = [](const TimeCurve& curve)
+    {
+        return !curve.values.empty() && std::all_of(curve.values.begin(), curve.values.end(), [&](const double& value) { return value == curve.values.front(); });
+    };
+    if (!isConstant(model.alpha) || !isConstant(model.sigma))
+    {
+        throw std::runtime_error("A Hull-White lattice needs constant alpha and sigma");
+    }
+    return buildTrinomialLattice(model.alpha.values.front(), model.sigma.values.front(),
+        [&](const double& maturity) { return std::exp(-zeroRates.valueAt(maturity) * maturity); }, timeHorizon, numberOfSteps);
+}
+
+/*
+ Builds a Ho-Lee lattice fitted to a curve of zero rates.
+
+ @param model The model, for its volatility.
+ @param zeroRates Continuously compounded zero rates by maturity.
+ @param timeHorizon The time of the last slice.
+ @param numberOfSteps The number of slices after the first.
+ */
+inline TrinomialLattice buildTrinomialLattice(const HoAndLeeModel& model, const TimeCurve& zeroRates, const double& timeHorizon, const int& numberOfSteps)
+{
+    return buildTrinomialLattice(0.0, model.volatility,
+        [&](const double& maturity) { return std::exp(-zeroRates.valueAt(maturity) * maturity); }, timeHorizon, numberOfSteps);
+}
+
+/*
+ Builds a Ho-Lee lattice fitted to the model's own bond prices, so that it
+ prices like the model as simulated, with its drift driftTerm * t.
+
+ @param model The model.
+ @param timeHorizon The time of the last slice.
+ @param numberOfSteps The number of slices after the first.
+ */
+inline TrinomialLattice buildTrinomialLattice(const HoAndLeeModel& model, const double& timeHorizon, const int& numberOfSteps)
+{
+    return buildTrinomialLattice(0.0, model.volatility, [&](const double& maturity) { return analyticBondPrice(model, maturity); }, timeHorizon, numberOfSteps);
+}
+
+/*
+ Returns the lattice price of the zero-coupon bond maturing at a slice.
+
+ @param lattice The lattice.
+ @param maturity The maturity, rounded to the nearest slice.
+ */
+inline double latticeBondPrice(const TrinomialLattice& lattice, const double& maturity)
+{
+    int maturityStep = lattice.stepAt(maturity);
+    if (maturityStep < 0 || maturityStep > lattice.numberOfSteps)
+    {
+        throw std::runtime_error("The bond matures outside the lattice");
+    }
+    std::vector<double> values(lattice.width(), 1.0);
+    std::vector<double> previousValues(lattice.width(), 0.0);
+    for (int step = maturityStep - 1; step >= 0; --step)
+    {
+        rollBackSlice(lattice, step, values.data(), previousValues.data());
+        std::swap(values, previousValues);
+    }
+    return values[lattice.maximumNode];
+}
+
+/*
+ A Bermudan swaption: the right to enter, on any exercise date, the swap
+ that exchanges a fixed rate for the floating rate until the last payment.
+
+ Exercise dates must be fixed-leg reset dates, so that the floating leg of
+ the swap entered is worth par. The fixed payment at paymentTimes[k] accrues
+ from the previous payment time, or from the first exercise time for k = 0.
+ */
+struct BermudanSwaption
+{
+    double fixedRate = 0.0;
+    double notional = 1.0;
+    bool payer = true;  // the holder would pay fixed
+    std::vector<double> exerciseTimes;
+    std::vector<double> paymentTimes;
+};
+
+/*
+ Returns a swaption exercisable on every reset date of a regular swap.
+
+ @param fixedRate The fixed rate of the swap.
+ @param firstExerciseTime The first exercise date, where the swap starts.
+ @param maturity The last payment date.
+ @param paymentInterval The time between fixed payments.
+ @param payer Whether the holder would pay fixed.
+ */
+inline BermudanSwaption makeBermudanSwaption(
+    const double& fixedRate,
+    const double& firstExerciseTime,
+    const double& maturity,
+    const double& paymentInterval,
+    const bool& payer)
+{
+    BermudanSwaption swaption;
+    swaption.fixedRate = fixedRate;
+    swaption.payer = payer;
+    int numberOfPayments = static_cast<int>(std::lround((maturity - firstExerciseTime) / paymentInterval));
+    for (int payment = 0; payment < numberOfPayments; ++payment)
+    {
+        swaption.exerciseTimes.push_back(firstExerciseTime + payment * paymentInterval);
+        swaption.paymentTimes.push_back(firstExerciseTime + (payment + 1) * paymentInterval);
+    }
+    return swaption;
+}
+
+/*
+ Prices a Bermudan swaption by backward induction.
+
+ Two arrays roll back together: the fixed leg still to be paid, with the
+ notional at the end, and the option. On an exercise date the swap entered
+ is worth notional - fixed leg to a payer and the reverse to a receiver, and
+ the option takes the larger of that and continuing. Dates are rounded to
+ the nearest slice.
+
+ @param lattice The lattice, reaching at least the last payment.
+ @param swaption The swaption.
+ */
+inline double priceBermudanSwaption(const TrinomialLattice& lattice, const BermudanSwaption& swaption)
+{
+    if (swaption.paymentTimes.empty() || swaption.exerciseTimes.empty())
+    {
+        throw std::runtime_error("A Bermudan swaption needs payment and exercise dates");
+    }
+    int lastStep = lattice.stepAt(swaption.paymentTimes.back());
+    if (lastStep > lattice.numberOfSteps)
+    {
+        throw std::runtime_error("The swaption runs past the end of the lattice");
+    }
+
+    // The cash flows and exercises of each slice
+    std::vector<double> fixedPayments(static_cast<std::size_t>(lastStep) + 1, 0.0);
+    std::vector<char> exercisable(static_cast<std::size_t>(lastStep) + 1, 0);
+    double accrualStart = swaption.exerciseTimes.front();
+    for (const double& paymentTime : swaption.paymentTimes)
+    {
+        fixedPayments[lattice.stepAt(paymentTime)] += swaption.notional * swaption.fixedRate * (paymentTime - accrualStart);
+        accrualStart = paymentTime;
+    }
+    fixedPayments[lastStep] += swaption.notional;
+    for (const double& exerciseTime : swaption.exerciseTimes)
+    {
+        int exerciseStep = lattice.stepAt(exerciseTime);
+        if (exerciseStep >= 0 && exerciseStep < lastStep)
+        {
+            exercisable[exerciseStep] = 1;
+        }
+    }
+
+    int width = lattice.width();
+    int center = lattice.maximumNode;
+    std::vector<double> fixedLeg(width, 0.0);
+    std::vector<double> previousFixedLeg(width, 0.0);
+    std::vector<double> option(width, 0.0);
+    std::vector<double> previousOption(width, 0.0);
+    double sign = swaption.payer ? 1.0 : -1.0;
+    for (int step = lastStep; step >= 0; --step)
+    {
+        if (step < lastStep)
+        {
+            rollBackSlice(lattice, step, fixedLeg.data(), previousFixedLeg.data());
+            rollBackSlice(lattice, step, option.data(), previousOption.data());
+            std::swap(fixedLeg, previousFixedLeg);
+            std::swap(option, previousOption);
+        }
+
+        // Exercise before this slice's payment is added: the swap entered starts here
+        int extent = lattice.sliceExtent(step);
+        if (exercisable[step])
+        {
+            for (int node = center - extent; node <= center + extent; ++node)
+            {
+                option[node] = std::max(option[node], sign * (swaption.notional - fixedLeg[node]));
+            }
+        }
+        if (fixedPayments[step] != 0.0)
+        {
+            for (int node = center - extent; node <= center + extent; ++node)
+            {
+                fixedLeg[node] += fixedPayments[step];
+            }
+        }
+    }
+    return option[center];
+}
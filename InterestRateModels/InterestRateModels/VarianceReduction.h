@@ -0,0 +1,375 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "BondPricing.h"
+#include "IncrementSource.h"
+#include "StreamingStatistics.h"
+
+/*
+ Antithetic variates and moment matching for the path engines.
+
+ Both are increment sources that wrap another source (see IncrementSource.h),
+ so they apply to every model the engines simulate, including the HJM
+ forward curves, and combine with either the pseudo-random or the Sobol
+ increments.
+
+ The paths of such a run are no longer independent, so the per-path
+ standard errors of the sinks understate or overstate the error of the
+ estimate. measureVarianceReduction() instead repeats the whole estimate
+ over independent replicates and compares the spread.
+ */
+
+enum class VarianceReduction
+{
+    None,                       // Independent increments
+    Antithetic,                 // Paths in pairs with negated increments
+    MomentMatching,             // Increments of each step rescaled to mean zero and variance one per block
+    AntitheticMomentMatching    // Both
+};
+
+/*
+ Returns the name of a variance reduction technique, for reports.
+ */
+inline const char* varianceReductionName(const VarianceReduction& varianceReduction)
+{
+    switch (varianceReduction)
+    {
+    case VarianceReduction::Antithetic:
+        return "Antithetic";
+    case VarianceReduction::MomentMatching:
+        return "Moment matching";
+    case VarianceReduction::AntitheticMomentMatching:
+        return "Antithetic + moment matching";
+    default:
+        return "None";
+    }
+}
+
+/*
+ Antithetic increments: paths 2k and 2k + 1 are driven by opposite increments.
+
+ The wrapped source is asked for one path per pair, under the pair index, so
+ each pair costs one set of draws. Path blocks start at even paths, which
+ holds for the block sizes of both engines.
+ */
+template <typename BaseSource>
+class AntitheticIncrementSource
+{
+public:
+    /*
+     @param baseSource The source of the increments of the first path of each pair.
+     */
+    explicit AntitheticIncrementSource(const BaseSource& baseSource)
+        : base(baseSource)
+    {
+    }
+
+    void prepare(const int& numberOfTimeSteps, const int& sourceFactors, const int& sourceBlockPaths, const int& numberOfThreads)
+    {
+        base.prepare(numberOfTimeSteps, sourceFactors, (sourceBlockPaths + 1) / 2, numberOfThreads);
+        numberOfFactors = sourceFactors;
+        maximumBlockPaths = sourceBlockPaths;
+        rows.resize(static_cast<std::size_t>(numberOfThreads) * numberOfFactors * maximumBlockPaths);
+        blockPaths.resize(static_cast<std::size_t>(numberOfThreads));
+    }
+
+    void beginBlock(const int& threadIndex, const int& firstPath, const int& numberOfPaths)
+    {
+        base.beginBlock(threadIndex, firstPath / 2, (numberOfPaths + 1) / 2);
+        blockPaths[threadIndex] = numberOfPaths;
+    }
+
+    const double* increments(const int& threadIndex, const int& stepIndex, const int& factor)
+    {
+        const double* pairIncrements = base.increments(threadIndex, stepIndex, factor);
+        double* row = rows.data() + (static_cast<std::size_t>(threadIndex) * numberOfFactors + factor) * maximumBlockPaths;
+        int numberOfPaths = blockPaths[threadIndex];
+        for (int path = 0; path + 1 < numberOfPaths; path += 2)
+        {
+            row[path] = pairIncrements[path / 2];
+            row[path + 1] = -pairIncrements[path / 2];
+        }
+        if (numberOfPaths % 2 != 0)
+        {
+            row[numberOfPaths - 1] = pairIncrements[numberOfPaths / 2];
+        }
+        return row;
+    }
+
+private:
+    BaseSource base;
+    int numberOfFactors = 0;
+    int maximumBlockPaths = 0;
+    std::vector<double> rows;
+    std::vector<int> blockPaths;
+};
+
+/*
+ Moment-matched increments: the increments of each step and factor are
+ shifted and scaled across the block so their sample mean is exactly zero
+ and their sample variance exactly one.
+
+ Blocks have a fixed size, so the result still does not depend on the
+ number of threads. Matching couples the paths of a block, which biases
+ nonlinear estimates by O(1 / block size).
+ */
+template <typename BaseSource>
+class MomentMatchedIncrementSource
+{
+public:
+    /*
+     @param baseSource The source of the increments to match.
+     */
+    explicit MomentMatchedIncrementSource(const BaseSource& baseSource)
+        : base(baseSource)
+    {
+    }
+
+    void prepare(const int& numberOfTimeSteps, const int& sourceFactors, const int& sourceBlockPaths, const int& numberOfThreads)
+    {
+        base.prepare(numberOfTimeSteps, sourceFactors, sourceBlockPaths, numberOfThreads);
+        numberOfFactors = sourceFactors;
+        maximumBlockPaths = sourceBlockPaths;
+        rows.resize(static_cast<std::size_t>(numberOfThreads) * numberOfFactors * maximumBlockPaths);
+        blockPaths.resize(static_cast<std::size_t>(numberOfThreads));
+    }
+
+    void beginBlock(const int& threadIndex, const int& firstPath, const int& numberOfPaths)
+    {
+        base.beginBlock(threadIndex, firstPath, numberOfPaths);
+        blockPaths[threadIndex] = numberOfPaths;
+    }
+
+    const double* increments(const int& threadIndex, const int& stepIndex, const int& factor)
+    {
+        const double* baseIncrements = base.increments(threadIndex, stepIndex, factor);
+        double* row = rows.data() + (static_cast<std::size_t>(threadIndex) * numberOfFactors + factor) * maximumBlockPaths;
+        int numberOfPaths = blockPaths[threadIndex];
+
+        // Two passes for the sample mean and variance of the block
+        double mean = 0.0;
+        for (int path = 0; path < numberOfPaths; ++path)
+        {
+            mean += baseIncrements[path];
+        }
+        mean /= numberOfPaths;
+        double variance = 0.0;
+        for (int path = 0; path < numberOfPaths; ++path)
+        {
+            double deviation = baseIncrements[path] - mean;
+            variance += deviation * deviation;
+        }
+        variance /= numberOfPaths;
+
+        // A single path, or identical increments, cannot be rescaled
+        double scale = variance > 0.0 ? 1.0 / std::sqrt(variance) : 1.0;
+        if (numberOfPaths < 2 || variance <= 0.0)
+        {
+            mean = 0.0;
+        }
+        for (int path = 0; path < numberOfPaths; ++path)
+        {
+            row[path] = (baseIncrements[path] - mean) * scale;
+        }
+        return row;
+    }
+
+private:
+    BaseSource base;
+    int numberOfFactors = 0;
+    int maximumBlockPaths = 0;
+    std::vector<double> rows;
+    std::vector<int> blockPaths;
+};
+
+/*
+ Wraps a source in the requested technique and passes the result to a function.
+
+ @param varianceReduction The technique to apply.
+ @param baseSource The source of the underlying increments.
+ @param function Called with the wrapped source, for example to run simulatePaths() with it.
+ */
+template <typename BaseSource, typename Function>
+void withVarianceReduction(const VarianceReduction& varianceReduction, const BaseSource& baseSource, Function&& function)
+{
+    switch (varianceReduction)
+    {
+    case VarianceReduction::Antithetic:
+    {
+        AntitheticIncrementSource<BaseSource> incrementSource(baseSource);
+        function(incrementSource);
+        break;
+    }
+    case VarianceReduction::MomentMatching:
+    {
+        MomentMatchedIncrementSource<BaseSource> incrementSource(baseSource);
+        function(incrementSource);
+        break;
+    }
+    case VarianceReduction::AntitheticMomentMatching:
+    {
+        MomentMatchedIncrementSource<AntitheticIncrementSource<BaseSource>> incrementSource{ AntitheticIncrementSource<BaseSource>(baseSource) };
+        function(incrementSource);
+        break;
+    }
+    default:
+    {
+        BaseSource incrementSource(baseSource);
+        function(incrementSource);
+        break;
+    }
+    }
+}
+
+/*
+ How one technique did on an estimate, measured over independent replicates.
+ */
+struct VarianceReductionResult
+{
+    VarianceReduction varianceReduction = VarianceReduction::None;
+    double estimate = 0.0;              // the mean of the replicate estimates
+    double estimatorVariance = 0.0;     // the variance of one replicate's estimate
+    double seconds = 0.0;               // the average time of one replicate
+    double varianceRatio = 1.0;         // plain variance over this variance: paths saved for the same error
+    double efficiencyRatio = 1.0;       // plain variance * time over this variance * time: compute saved for the same error
+};
+
+/*
+ Measures every technique on one estimate.
+
+ Each technique runs the estimate numberOfReplicates times with seeds
+ seed + 1, seed + 2, ..., and the variance of the estimates is compared with
+ the plain run's. The efficiency ratio also charges each technique for its
+ run time, so it is the factor by which the compute for a given error drops.
+
+ @param estimate Called as estimate(varianceReduction, replicateSeed), returns one estimate.
+ @param numberOfReplicates The number of replicates per technique, at least two.
+ @param seed The base seed of the replicates.
+ @return One result per technique, plain first.
+ */
+template <typename Estimator>
+std::vector<VarianceReductionResult> measureVarianceReduction(Estimator&& estimate, const int& numberOfReplicates, const std::uint64_t& seed)
+{
+    INTEREST_RATE_MODELS_PROFILE_SCOPE("varianceReduction");
+    const VarianceReduction techniques[] = {
+        VarianceReduction::None,
+        VarianceReduction::Antithetic,
+        VarianceReduction::MomentMatching,
+        VarianceReduction::AntitheticMomentMatching
+    };
+
+    std::vector<VarianceReductionResult> results;
+    for (const VarianceReduction& technique : techniques)
+    {
+        RunningMoments estimates;
+        auto start = std::chrono::steady_clock::now();
+        for (int replicate = 0; replicate < numberOfReplicates; ++replicate)
+        {
+            estimates.add(estimate(technique, seed + 1 + static_cast<std::uint64_t>(replicate)));
+        }
+        auto stop = std::chrono::steady_clock::now();
+
+        VarianceReductionResult result;
+        result.varianceReduction = technique;
+        result.estimate = estimates.mean;
+        result.estimatorVariance = estimates.variance();
+        result.seconds = std::chrono::duration<double>(stop - start).count() / numberOfReplicates;
+        results.push_back(result);
+    }
+
+    for (VarianceReductionResult& result : results)
+    {
+        if (result.estimatorVariance > 0.0 && result.seconds > 0.0)
+        {
+            result.varianceRatio = results[0].estimatorVariance / result.estimatorVariance;
+            result.efficiencyRatio = result.varianceRatio * results[0].seconds / result.seconds;
+        }
+    }
+    return results;
+}
+
+/*
+ Returns the technique that needs the least compute for a given error.
+ */
+inline VarianceReduction bestVarianceReduction(const std::vector<VarianceReductionResult>& results)
+{
+    VarianceReduction best = VarianceReduction::None;
+    double bestEfficiency = 1.0;
+    for (const VarianceReductionResult& result : results)
+    {
+        if (result.efficiencyRatio > bestEfficiency)
+        {
+            best = result.varianceReduction;
+            bestEfficiency = result.efficiencyRatio;
+        }
+    }
+    return best;
+}
+
+/*
+ Measures every technique on the plain Monte Carlo price of a zero-coupon bond.
+
+ @param model The short-rate model to simulate.
+ @param maturity The maturity of the bond.
+ @param timeStep The time step of the simulation.
+ @param numberOfPaths The number of paths per replicate.
+ @param numberOfReplicates The number of replicates per technique.
+ @param seed The base seed of the replicates.
+ @return One result per technique, plain first.
+ */
+template <typename Model>
+std::vector<VarianceReductionResult> measureBondVarianceReduction(
+    const Model& model,
+    const double& maturity,
+    const double& timeStep,
+    const int& numberOfPaths,
+    const int& numberOfReplicates,
+    const std::uint64_t& seed)
+{
+    auto priceBond = [&](const VarianceReduction& varianceReduction, const std::uint64_t& replicateSeed)
+    {
+        BondPricingSink sink({ maturity });
+        withVarianceReduction(varianceReduction, CounterIncrementSource(replicateSeed), [&](auto& incrementSource)
+        {
+            simulatePaths(model, maturity + 0.5 * timeStep, timeStep, numberOfPaths, replicateSeed, incrementSource, sink, defaultThreadPool());
+        });
+        return sink.payoffs[0].meanY;
+    };
+    return measureVarianceReduction(priceBond, numberOfReplicates, seed);
+}
+
+/*
+ Prints a table of variance reduction results.
+
+ @param output The stream to print to.
+ @param title The title of the table, naming the model and the estimate.
+ @param results The results of measureVarianceReduction().
+ */
+inline void printVarianceReductionReport(std::ostream& output, const std::string& title, const std::vector<VarianceReductionResult>& results)
+{
+    std::ios_base::fmtflags flags = output.flags();
+    std::streamsize precision = output.precision();
+
+    output << "Variance reduction: " << title << "\n";
+    output << std::left << std::setw(30) << "  Technique" << std::right << std::setw(14) << "Estimate" << std::setw(14) << "Std error"
+        << std::setw(12) << "Variance" << std::setw(12) << "Compute" << "\n";
+    for (const VarianceReductionResult& result : results)
+    {
+        output << "  " << std::left << std::setw(28) << varianceReductionName(result.varianceReduction) << std::right
+            << std::fixed << std::setprecision(6) << std::setw(14) << result.estimate
+            << std::scientific << std::setprecision(2) << std::setw(14) << std::sqrt(result.estimatorVariance)
+            << std::fixed << std::setprecision(2) << std::setw(11) << result.varianceRatio << "x" << std::setw(11) << result.efficiencyRatio << "x\n";
+    }
+    output << "  Best: " << varianceReductionName(bestVarianceReduction(results)) << "\n";
+
+    output.flags(flags);
+    output.precision(precision);
+}